@@ -182,6 +182,80 @@ private:
   llvm::SmallDenseMap<NodeOp, CorrelationList> nodeCorrelationMap;
 };
 
+/// Producer-consumer graph between the dataflow nodes and buffers of schedules,
+/// where the nodes of a buffer are held in their dominance order. The graph of
+/// each schedule is built lazily when first queried. Once the nodes of a
+/// schedule or their operands are changed, the graph must be updated through
+/// "addNode", "updateNode", "removeNode", or "replaceNode", or dropped through
+/// "invalidate", otherwise the query results are stale.
+class DataflowGraphAnalysis {
+public:
+  explicit DataflowGraphAnalysis(Operation *op) {}
+
+  /// Get the consumer/producer nodes of the given buffer in dominance order.
+  ArrayRef<NodeOp> getConsumers(Value buffer);
+  ArrayRef<NodeOp> getProducers(Value buffer);
+
+  /// Get the consumer/producer nodes of the given buffer except the given node.
+  SmallVector<NodeOp> getConsumersExcept(Value buffer, NodeOp except);
+  SmallVector<NodeOp> getProducersExcept(Value buffer, NodeOp except);
+
+  /// Get the consumer nodes of the given buffer that depend on the given node,
+  /// which is the same as "scalehls::getDependentConsumers".
+  SmallVector<NodeOp> getDependentConsumers(Value buffer, NodeOp node);
+
+  /// Return whether node "a" properly dominates node "b" in the same schedule.
+  bool properlyDominates(NodeOp a, NodeOp b);
+
+  /// Add a node newly created in a schedule into the graph.
+  void addNode(NodeOp node);
+
+  /// Update the edges of the node after its operands are changed.
+  void updateNode(NodeOp node);
+
+  /// Remove the node from the graph. This must be called before the node is
+  /// erased.
+  void removeNode(NodeOp node);
+
+  /// Replace the node with a new node located at the same position, whose
+  /// operands can be different from the original node. This must be called
+  /// before the original node is erased.
+  void replaceNode(NodeOp node, NodeOp newNode);
+
+  /// Drop the graph of the given schedule, or all graphs if the schedule is
+  /// null. Dropped graphs are rebuilt when queried again.
+  void invalidate(ScheduleOp schedule = ScheduleOp());
+
+private:
+  /// The position of a node in the graph is only meaningful when compared with
+  /// the positions of other nodes. Positions are initially spaced by the
+  /// stride, such that a new node can take a position between two nodes.
+  static constexpr uint64_t positionStride = 1 << 16;
+
+  struct ScheduleGraph {
+    DenseMap<Operation *, uint64_t> positions;
+    DenseMap<Operation *, SmallVector<std::pair<Value, bool>, 4>> edges;
+    DenseMap<Value, SmallVector<NodeOp, 2>> consumers;
+    DenseMap<Value, SmallVector<NodeOp, 2>> producers;
+  };
+
+  ScheduleGraph *getGraph(ScheduleOp schedule);
+  ScheduleGraph *getGraph(Value buffer);
+  ScheduleGraph *lookupGraph(NodeOp node);
+  void placeNode(ScheduleGraph &graph, NodeOp node);
+  void insertEdges(ScheduleGraph &graph, NodeOp node);
+  void eraseEdges(ScheduleGraph &graph, NodeOp node);
+
+  DenseMap<Operation *, std::unique_ptr<ScheduleGraph>> graphs;
+};
+
+/// Erase the dead nodes nested in the given operation and remove them from the
+/// graph. The greedy pattern driver erases dead nodes without updating the
+/// graph, thus this must be called before driving patterns that hold the graph.
+/// As the driver may still fold other ops, the graph should not be marked as
+/// preserved after the driver.
+void eraseDeadNodes(Operation *op, DataflowGraphAnalysis &graph);
+
 } // namespace scalehls
 } // namespace mlir
 
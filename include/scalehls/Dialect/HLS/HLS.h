@@ -55,6 +55,13 @@ void setTileLayout(Value memref, ArrayRef<int64_t> tileShape,
                    ArrayRef<int64_t> vectorShape);
 void setTileLayout(Value memref, ArrayRef<int64_t> tileShape);
 
+//===----------------------------------------------------------------------===//
+// AXI port width attribute utils.
+//===----------------------------------------------------------------------===//
+
+IntegerAttr getMaxWidenBitwidth(Value memref);
+void setMaxWidenBitwidth(Value memref, int64_t bitwidth);
+
 //===----------------------------------------------------------------------===//
 // HLS resource and timing attributes
 //===----------------------------------------------------------------------===//
@@ -68,7 +75,8 @@ void setTiming(Operation *op, int64_t begin, int64_t end, int64_t latency,
 /// Resource attribute utils.
 ResourceAttr getResource(Operation *op);
 void setResource(Operation *op, ResourceAttr resource);
-void setResource(Operation *op, int64_t lut, int64_t dsp, int64_t bram);
+void setResource(Operation *op, int64_t lut, int64_t dsp, int64_t bram,
+                 int64_t uram = 0);
 
 /// Loop information attribute utils.
 LoopInfoAttr getLoopInfo(Operation *op);
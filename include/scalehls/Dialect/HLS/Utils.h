@@ -33,6 +33,8 @@ bool isRamS2P(MemRefType type);
 bool isRamT2P(MemRefType type);
 bool isDram(MemRefType type);
 bool isUnknown(MemRefType type);
+bool isLutram(MemRefType type);
+bool isUram(MemRefType type);
 
 //===----------------------------------------------------------------------===//
 // Dataflow utils
@@ -24,9 +24,9 @@ public:
     return TypeSwitch<Operation *, ResultType>(op)
         .template Case<
             // HLS dialect operations.
-            BufferOp, ConstBufferOp, StreamOp, StreamReadOp, StreamWriteOp,
-            AxiBundleOp, AxiPortOp, AxiPackOp, PrimMulOp, PrimCastOp,
-            hls::AffineSelectOp, hls::VectorInitOp,
+            ScheduleOp, NodeOp, BufferOp, ConstBufferOp, StreamOp, StreamReadOp,
+            StreamWriteOp, AxiBundleOp, AxiPortOp, AxiPackOp, PrimMulOp,
+            PrimCastOp, hls::AffineSelectOp, hls::VectorInitOp,
 
             // Function operations.
             func::CallOp, func::ReturnOp,
@@ -97,6 +97,8 @@ public:
   }
 
   // HLS dialect operations.
+  HANDLE(ScheduleOp);
+  HANDLE(NodeOp);
   HANDLE(BufferOp);
   HANDLE(ConstBufferOp);
   HANDLE(StreamOp);
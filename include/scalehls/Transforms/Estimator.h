@@ -11,16 +11,159 @@
 #include "mlir/IR/Dominance.h"
 #include "scalehls/Dialect/HLS/Visitor.h"
 #include "scalehls/Transforms/Utils.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/Support/JSON.h"
+#include <array>
 
 namespace mlir {
 namespace scalehls {
 
-// Get the operator name to latency/DSP usage mapping.
+// Get the operator name to latency/DSP/LUT usage mapping.
 void getLatencyMap(llvm::json::Object *config,
                    llvm::StringMap<int64_t> &latencyMap);
 void getDspUsageMap(llvm::json::Object *config,
                     llvm::StringMap<int64_t> &dspUsageMap);
+void getLutUsageMap(llvm::json::Object *config,
+                    llvm::StringMap<int64_t> &lutUsageMap);
+
+/// Remove the estimation results annotated by the estimator from the operation
+/// and all its nested operations.
+void removeEstimation(Operation *op);
+
+/// Return the number of tokens pushed into (or popped from) the stream channel
+/// in one execution of the region holding the channel. Accesses in nested nodes
+/// and schedules are counted through their block arguments. Return None if any
+/// access is enclosed by a loop with unknown trip count.
+Optional<int64_t> getStreamTokenNum(Value channel, bool isPush);
+
+/// The on-chip resource utilization of a memory, where LUTRAMs are counted as
+/// LUTs, BRAMs as 18Kb blocks, and URAMs as 288Kb blocks (4096 x 72 bits).
+struct MemoryResource {
+  int64_t lut = 0;
+  int64_t bram = 0;
+  int64_t uram = 0;
+};
+
+/// Return the resource utilization of the memory with the given type and
+/// depth, which is determined by its memory kind. Each partition and each stage
+/// of a multi-stage (e.g., ping-pong) buffer is an individual copy of the
+/// memory. Memories of unknown kind are implemented with BRAMs, while DRAMs and
+/// single-element memories occupy no memory resource.
+MemoryResource getMemoryResource(MemRefType type, int64_t depth = 1);
+
+//===----------------------------------------------------------------------===//
+// OperatorLibrary Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// The characterized latency and resource utilization of an operator instance.
+/// An operator with zero latency is combinational and is chained with other
+/// operations in the same schedule level.
+struct OperatorCost {
+  int64_t latency = 0;
+  int64_t dsp = 0;
+  int64_t lut = 0;
+};
+
+/// A table-driven library of operators characterized under the target clock
+/// frequency. Each operator is characterized at one or more bit widths, and the
+/// cost of an uncharacterized bit width is linearly interpolated between the
+/// two nearest characterized bit widths, or clamped to the narrowest/widest
+/// characterized bit width if out of range.
+class OperatorLibrary {
+public:
+  /// Characterize the operator at the given bit width. The existing cost of the
+  /// same bit width is overwritten.
+  void insert(StringRef name, unsigned bitWidth, OperatorCost cost);
+
+  bool contains(StringRef name) const { return operators.count(name); }
+
+  /// Return the cost of the operator at the given bit width, or None if the
+  /// operator is not characterized.
+  Optional<OperatorCost> lookup(StringRef name, unsigned bitWidth) const;
+
+  /// Return a string describing all characterized operators in a sorted order.
+  std::string getSignature() const;
+
+private:
+  using CostList = SmallVector<std::pair<unsigned, OperatorCost>, 4>;
+  llvm::StringMap<CostList> operators;
+};
+
+/// Get the operator library of the target frequency, where operators that are
+/// characterized in the target spec override the built-in ones. Return false
+/// if the operator library in the target spec is malformed.
+bool getOperatorLibrary(llvm::json::Object *config, OperatorLibrary &library);
+
+//===----------------------------------------------------------------------===//
+// EstimationCache Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// The estimated QoR of a function or loop band. For loop bands, "latency" is
+/// the iteration latency and "interval" is the minimum II of the innermost
+/// loop. A record with negative latency represents a failed estimation.
+struct EstimationRecord {
+  int64_t latency = -1;
+  int64_t interval = -1;
+  int64_t dsp = -1;
+  int64_t bram = -1;
+  int64_t uram = -1;
+  int64_t lut = -1;
+
+  bool isValid() const { return latency >= 0; }
+};
+
+/// A persistent and content-addressed cache of estimation results. The keys
+/// are hashed from the structure of the estimated IR, the applied tile list and
+/// target II, and the latency/DSP/LUT usage mapping and operator library of the
+/// target spec. Records are loaded from the cache file and new records are
+/// appended to the file, such that repeated or parallel processes can share the
+/// results. The file is always accessed under an advisory lock, and records are
+/// appended at record boundaries with a single write.
+class EstimationCache {
+public:
+  explicit EstimationCache(StringRef filePath,
+                           const llvm::StringMap<int64_t> &latencyMap,
+                           const llvm::StringMap<int64_t> &dspUsageMap,
+                           const llvm::StringMap<int64_t> &lutUsageMap,
+                           const OperatorLibrary &library);
+  ~EstimationCache();
+
+  EstimationCache(const EstimationCache &) = delete;
+  EstimationCache &operator=(const EstimationCache &) = delete;
+
+  /// Return whether the cache file is successfully opened for appending.
+  bool isOpen() const { return fd >= 0; }
+
+  /// Return the key of the given IR, tile list, and target II.
+  std::string getKey(StringRef ir, ArrayRef<unsigned> tileList,
+                     unsigned targetII) const;
+
+  Optional<EstimationRecord> lookup(StringRef key) const;
+  void insert(StringRef key, EstimationRecord record);
+
+  /// Flush all inserted records to the cache file.
+  void flush();
+
+private:
+  LogicalResult truncateFile(uint64_t size);
+  bool writeFile(StringRef data);
+  void closeFile();
+
+  std::string signature;
+  llvm::StringMap<EstimationRecord> records;
+
+  /// The file descriptor of the cache file, and the encoded records that have
+  /// not been written to the file.
+  int fd = -1;
+  std::string pendingRecords;
+};
+
+/// Read all records of the estimation cache file, and call "callback" with the
+/// key and record of each of them. Return failure if the file cannot be read,
+/// is written in an obsolete format, or ends with an incomplete record.
+LogicalResult
+readEstimationCache(StringRef filePath,
+                    function_ref<void(StringRef, EstimationRecord)> callback);
 
 //===----------------------------------------------------------------------===//
 // ScaleHLSEstimator Class Declaration
@@ -31,20 +174,66 @@ class ScaleHLSEstimator
 public:
   explicit ScaleHLSEstimator(llvm::StringMap<int64_t> &latencyMap,
                              llvm::StringMap<int64_t> &dspUsageMap,
-                             bool depAnalysis)
+                             llvm::StringMap<int64_t> &lutUsageMap,
+                             const OperatorLibrary &library, bool depAnalysis)
       : latencyMap(latencyMap), dspUsageMap(dspUsageMap),
-        depAnalysis(depAnalysis) {}
+        lutUsageMap(lutUsageMap), library(library), depAnalysis(depAnalysis) {}
+
+  /// Create a new estimator sharing the same latency/DSP/LUT usage mapping and
+  /// operator library. The new estimator holds its own scheduling states, thus
+  /// can be used in parallel with this estimator on a different function.
+  std::unique_ptr<ScaleHLSEstimator> clone() const {
+    return std::make_unique<ScaleHLSEstimator>(
+        latencyMap, dspUsageMap, lutUsageMap, library, depAnalysis);
+  }
 
   // Entry for estimating function and loop.
   void estimateFunc(func::FuncOp func);
   void estimateLoop(AffineForOp loop, func::FuncOp func);
 
-  using HLSVisitorBase::visitOp;
-  bool visitUnhandledOp(Operation *op, int64_t begin) {
-    // Default latency of any unhandled operation is 0.
-    return setTiming(op, begin, begin, 0, 0), true;
+  /// Estimate the dataflow schedule and all its nested nodes. Each node is
+  /// annotated with its latency and interval, and each stream channel defined
+  /// in the schedule is annotated with the "required_depth" for not stalling
+  /// its producer. The schedule is annotated with its latency and the interval
+  /// of the slowest node, which determines the throughput of the schedule.
+  void estimateSchedule(ScheduleOp schedule);
+
+  /// Return the BRAM utilization of all buffers contained by the operation.
+  int64_t estimateBram(Operation *op);
+
+  /// Return the URAM utilization of all buffers contained by the operation.
+  int64_t estimateUram(Operation *op);
+
+  /// Record the resource-bound II of each pipelined loop and function into the
+  /// map in the following estimations, including the estimations of called
+  /// sub-functions. Pass nullptr to stop recording.
+  void recordResMinII(DenseMap<Operation *, int64_t> *map) {
+    resMinIIMap = map;
   }
 
+  /// Re-estimate the function after the timing or resource of no_touch
+  /// operations is updated. Only the ancestors of the updated operations and
+  /// the operations scheduled after them are rescheduled with the schedule
+  /// dependencies tracked in the last estimation, thus the structure of the
+  /// function must not be changed in between. If the incremental estimation is
+  /// not applicable, a full estimation is conducted instead. Note that only the
+  /// timing and resource of the function itself are updated.
+  void estimateFuncIncrementally(func::FuncOp func);
+
+  using HLSVisitorBase::visitOp;
+  bool visitUnhandledOp(Operation *op, int64_t begin);
+
+  bool visitOp(ScheduleOp op, int64_t begin);
+  bool visitOp(NodeOp op, int64_t begin) {
+    // Nodes are only estimated as a part of their parent schedule.
+    return false;
+  }
+  bool visitOp(StreamReadOp op, int64_t begin) {
+    return setTiming(op, begin, begin + 1, 1, 1), true;
+  }
+  bool visitOp(StreamWriteOp op, int64_t begin) {
+    return setTiming(op, begin, begin + 1, 1, 1), true;
+  }
   bool visitOp(AffineForOp op, int64_t begin);
   bool visitOp(AffineIfOp op, int64_t begin);
   bool visitOp(scf::IfOp op, int64_t begin);
@@ -86,48 +275,179 @@ public:
 
 private:
   /// LoadOp and StoreOp related methods.
+  struct MemPortTable;
   void getPartitionIndices(Operation *op);
+  MemPortTable &getMemPortTable(Value memref);
+  int64_t occupyMemPorts(MemPortTable &table, int64_t begin,
+                         ArrayRef<unsigned> partitions,
+                         const MemRefAccess &access, bool isRead);
   void estimateLoadStoreTiming(Operation *op, int64_t begin);
 
+  /// Dependence analysis related methods.
+  DependenceResult checkDependence(
+      const MemRefAccess &srcAccess, const MemRefAccess &dstAccess,
+      unsigned depth, SmallVector<DependenceComponent, 2> *depComps);
+
   /// AffineForOp related methods.
   int64_t getResMinII(int64_t begin, int64_t end, MemAccessesMap &map);
   int64_t getDepMinII(int64_t II, func::FuncOp func, MemAccessesMap &map);
   int64_t getDepMinII(int64_t II, AffineForOp forOp, MemAccessesMap &map);
 
+  /// Dataflow schedule related methods.
+  void estimateNode(NodeOp node);
+
   /// Block scheduler and estimator.
   ResourceAttr calculateResource(Operation *funcOrLoop);
   TimingAttr estimateBlock(Block &block, int64_t begin = 0);
   void reverseTiming(Block &block);
   void initEstimator(Block &block);
 
-  // Hold the memory ports information.
-  struct MemPortInfo {
+  /// Incremental estimation related methods.
+  void trackScheduleDep(Operation *op, Operation *depOp);
+  void trackFuncSchedule(func::FuncOp func);
+  Optional<int64_t> rescheduleBlock(Block &block, int64_t begin);
+
+  // Hold the memory ports occupation of all partitions in a schedule level.
+  // The n-th bit of each bitset indicates whether the corresponding port of
+  // the n-th partition is occupied, where a partition has at most two
+  // read-write ports.
+  struct MemPortRow {
+    explicit MemPortRow(unsigned partitionNum)
+        : rdUsed(partitionNum), wrUsed(partitionNum),
+          rdwrUsed{llvm::BitVector(partitionNum),
+                   llvm::BitVector(partitionNum)} {}
+
+    unsigned getRdwrUsedNum(unsigned partition) const {
+      return rdwrUsed[0].test(partition) + rdwrUsed[1].test(partition);
+    }
+
+    llvm::BitVector rdUsed;
+    llvm::BitVector wrUsed;
+    std::array<llvm::BitVector, 2> rdwrUsed;
+  };
+
+  // Hold the memory ports occupation of a memref, which is a dense table of
+  // partitions x schedule levels. Only the schedule levels that have been
+  // tried by any memory access hold a row.
+  struct MemPortTable {
+    // The number of ports of each partition.
     unsigned rdPort = 0;
     unsigned wrPort = 0;
     unsigned rdwrPort = 0;
+    bool isUnlimited = false;
+
+    // The latency of reading a partition.
+    int64_t rdLatency = 2;
+
+    unsigned partitionNum = 1;
+    SmallVector<int64_t, 4> factors;
 
-    SmallVector<MemRefAccess, 2> rdAccesses;
+    DenseMap<int64_t, unsigned> rowIndices;
+    std::vector<MemPortRow> rows;
+
+    // For each partition, map each schedule level where no read (or write)
+    // port is free to a later level that may have a free port. The first free
+    // level of a partition is found by following and compressing the links,
+    // thus the occupied levels are never probed one by one.
+    std::vector<DenseMap<int64_t, int64_t>> rdNextLevels;
+    std::vector<DenseMap<int64_t, int64_t>> wrNextLevels;
+
+    // Hold each distinct read access and the sorted schedule levels where it
+    // occupies memory ports. An identical read access in the same block can
+    // share the ports at these levels.
+    SmallVector<std::pair<MemRefAccess, SmallVector<int64_t, 4>>, 4>
+        rdAccessLevels;
+
+    MemPortRow &getRow(int64_t level) {
+      auto result = rowIndices.insert({level, rows.size()});
+      if (result.second)
+        rows.emplace_back(partitionNum);
+      return rows[result.first->second];
+    }
   };
 
-  // For storing memory port information of all partitions indexed by the
-  // {schedule_level, memref}.
-  using MemPortInfos = std::vector<MemPortInfo>;
-  using MemPortInfosMap = DenseMap<int64_t, DenseMap<Value, MemPortInfos>>;
-  MemPortInfosMap memPortInfosMap;
+  // For storing memory port occupation tables indexed by the memref.
+  using MemPortTables = DenseMap<Value, MemPortTable>;
+  MemPortTables memPortTables;
 
   // For storing the number of each operator indexed by the schedule level.
   using NumOperatorMap = DenseMap<int64_t, llvm::StringMap<int64_t>>;
   NumOperatorMap numOperatorMap;
   llvm::StringMap<int64_t> totalNumOperatorMap;
 
-  // Store the operator name to latency/DSP usage mapping.
+  // Store the operator name to latency/DSP/LUT usage mapping.
   llvm::StringMap<int64_t> &latencyMap;
   llvm::StringMap<int64_t> &dspUsageMap;
+  llvm::StringMap<int64_t> &lutUsageMap;
+
+  // Store the operator library and the cost of each library operator occupied
+  // by the estimated operations, which is indexed by "<name>_<bit width>".
+  const OperatorLibrary &library;
+  llvm::StringMap<OperatorCost> libraryCostMap;
+
+  // For storing the same-level operations that constrain the schedule begin
+  // of each operation, and the absolute schedule level {begin, end} of each
+  // operation. They are only tracked for the incremental estimation.
+  bool trackSchedule = false;
+  func::FuncOp trackedFunc;
+  DenseMap<Operation *, SmallVector<Operation *, 4>> scheduleDepsMap;
+  DenseMap<Operation *, std::pair<int64_t, int64_t>> scheduleLevelsMap;
+
+  // For storing the {latency, DSP usage, LUT usage} of each no_touch operation
+  // in the last estimation, and the updated no_touch operations and their
+  // ancestors.
+  using NoTouchState = std::tuple<int64_t, int64_t, int64_t>;
+  DenseMap<Operation *, NoTouchState> noTouchStateMap;
+  SmallPtrSet<Operation *, 8> updatedOps;
+  SmallPtrSet<Operation *, 16> updatedAncestors;
+
+  // For caching the dependence analysis results indexed by the structural
+  // description of the {source access, destination access, loop depth}.
+  struct DependenceCacheEntry {
+    DependenceResult::ResultEnum result;
+    bool hasComponents = false;
+    SmallVector<std::pair<Optional<int64_t>, Optional<int64_t>>, 4>
+        componentBounds;
+  };
+  llvm::StringMap<DependenceCacheEntry> depCache;
+  MLIRContext *depCacheContext = nullptr;
+
+  // For recording the resource-bound II of pipelined loops and functions.
+  DenseMap<Operation *, int64_t> *resMinIIMap = nullptr;
 
   DominanceInfo DT;
   bool depAnalysis = true;
 };
 
+//===----------------------------------------------------------------------===//
+// TargetSpec Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// The profiling data parsed from a target spec JSON file. Estimators created
+/// from the target spec hold references to its data, thus the target spec must
+/// outlive all of them.
+class TargetSpec {
+public:
+  /// Load and parse the target spec JSON file. Return false and print the error
+  /// message if failed.
+  bool load(StringRef filePath);
+
+  /// Return the JSON object of the target spec for querying other settings.
+  llvm::json::Object *getConfig() { return config.getAsObject(); }
+
+  std::unique_ptr<ScaleHLSEstimator> createEstimator(bool depAnalysis = true) {
+    return std::make_unique<ScaleHLSEstimator>(
+        latencyMap, dspUsageMap, lutUsageMap, library, depAnalysis);
+  }
+
+private:
+  llvm::json::Value config = nullptr;
+  llvm::StringMap<int64_t> latencyMap;
+  llvm::StringMap<int64_t> dspUsageMap;
+  llvm::StringMap<int64_t> lutUsageMap;
+  OperatorLibrary library;
+};
+
 } // namespace scalehls
 } // namespace mlir
 
@@ -7,25 +7,261 @@
 #ifndef SCALEHLS_TRANSFORMS_EXPLORER_H
 #define SCALEHLS_TRANSFORMS_EXPLORER_H
 
+#include "mlir/IR/OwningOpRef.h"
 #include "scalehls/Transforms/Estimator.h"
+#include <array>
+#include <deque>
+#include <random>
+#include <tuple>
 
 namespace mlir {
 namespace scalehls {
 
-using TileConfig = unsigned;
+/// A tile config of a loop band, which is encoded as a mixed-radix number. The
+/// n-th digit is the index of the tile size of the n-th loop in its valid tile
+/// sizes, where the first loop is the least significant digit. Therefore, the
+/// encoding scales with the depth of the loop band rather than the size of the
+/// design space, which can easily exceed 2^64 for deep loop bands.
+class TileConfig {
+public:
+  /// The maximum radix that can be encoded. The larger values are reserved as
+  /// the empty and tombstone keys of DenseMap.
+  static constexpr unsigned maxRadix = UINT16_MAX - 1;
+
+  TileConfig() = default;
+  explicit TileConfig(ArrayRef<unsigned> digits)
+      : digits(digits.begin(), digits.end()) {}
+
+  unsigned size() const { return digits.size(); }
+  unsigned operator[](unsigned idx) const { return digits[idx]; }
+  void setDigit(unsigned idx, unsigned digit) { digits[idx] = digit; }
+  ArrayRef<uint16_t> getDigits() const { return digits; }
+
+  bool operator==(const TileConfig &other) const {
+    return digits == other.digits;
+  }
+  bool operator!=(const TileConfig &other) const { return !(*this == other); }
+
+  /// Compare the numeric values of the two tile configs.
+  bool operator<(const TileConfig &other) const {
+    return std::lexicographical_compare(digits.rbegin(), digits.rend(),
+                                        other.digits.rbegin(),
+                                        other.digits.rend());
+  }
+
+  unsigned getHashValue() const {
+    return llvm::hash_combine_range(digits.begin(), digits.end());
+  }
+
+private:
+  SmallVector<uint16_t, 8> digits;
+};
+
+} // namespace scalehls
+} // namespace mlir
+
+//===----------------------------------------------------------------------===//
+// Make TileConfig eligible as key of DenseMap
+//===----------------------------------------------------------------------===//
+
+namespace llvm {
+
+template <> struct DenseMapInfo<mlir::scalehls::TileConfig> {
+  static mlir::scalehls::TileConfig getEmptyKey() {
+    return mlir::scalehls::TileConfig({UINT16_MAX});
+  }
+  static mlir::scalehls::TileConfig getTombstoneKey() {
+    return mlir::scalehls::TileConfig({UINT16_MAX - 1});
+  }
+  static unsigned getHashValue(const mlir::scalehls::TileConfig &config) {
+    return config.getHashValue();
+  }
+  static bool isEqual(const mlir::scalehls::TileConfig &lhs,
+                      const mlir::scalehls::TileConfig &rhs) {
+    return lhs == rhs;
+  }
+};
+
+} // namespace llvm
+
+namespace mlir {
+namespace scalehls {
+
+/// The random engine used in the DSE. The engine is fully specified by the C++
+/// standard, thus the DSE is reproducible across platforms given a seed.
+using DSERandomEngine = std::mt19937_64;
+
+class DSEStrategy;
+struct LoopSnapshot;
+struct LoopEvaluationState;
+
+//===----------------------------------------------------------------------===//
+// DSECheckpoint Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// The checkpoint of the exploration, which records the estimation result of
+/// all estimated tile configs of each loop band. As the exploration is fully
+/// determined by the explored module, the target spec (including the seed of
+/// search strategies), and the estimation results, the evaluated configs, the
+/// pareto points, and the random engine states are exactly reconstructed by
+/// replaying the exploration with the recorded results. This holds because
+/// each tile config is estimated on a fresh snapshot of the module, thus
+/// skipping the estimation of a restored config never changes the estimation
+/// of other configs. The checkpoint is keyed by the hash of the module and the
+/// target spec, and is only restored when the key is matched.
+class DSECheckpoint {
+public:
+  explicit DSECheckpoint(StringRef filePath, StringRef key,
+                         unsigned saveInterval = 32)
+      : filePath(filePath), key(key), saveInterval(saveInterval) {}
+
+  /// Restore the checkpoint from the file. Return false and set the error
+  /// message if the file cannot be read, the key is mismatched, or the file is
+  /// malformed.
+  bool restore(std::string &errorMessage);
+
+  /// Verify the restored records of the loop band against the number of valid
+  /// tile sizes of each loop. Return false and drop the records of the loop
+  /// band if any record is mismatched.
+  bool verifyBand(StringRef bandName, ArrayRef<unsigned> radices);
+
+  /// Append all unsaved records to the checkpoint file.
+  bool save();
+
+  /// Look up and insert the estimation record of a tile config of the given
+  /// loop band. The checkpoint is saved once the number of unsaved records
+  /// reaches the save interval.
+  Optional<EstimationRecord> lookup(StringRef bandName,
+                                    const TileConfig &config) const;
+  void insert(StringRef bandName, const TileConfig &config,
+              EstimationRecord record);
+
+private:
+  std::string filePath;
+  std::string key;
+  unsigned saveInterval;
+
+  /// Whether the file holds a valid header written or restored by this
+  /// exploration, such that new records can be appended.
+  bool isFileReady = false;
+
+  llvm::StringMap<llvm::DenseMap<TileConfig, EstimationRecord>> bandRecords;
+  SmallVector<std::tuple<std::string, TileConfig, EstimationRecord>, 32>
+      unsavedRecords;
+};
+
+//===----------------------------------------------------------------------===//
+// NeighborIndex Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// A neighbor index over the lattice of tile config digits. All non-zero
+/// integer offsets whose length is not larger than the maximum distance are
+/// precomputed and grouped into shells with the same length, such that the
+/// neighbors of a tile config can be enumerated from the closest shell without
+/// scanning the design space.
+class NeighborIndex {
+public:
+  NeighborIndex() = default;
+  explicit NeighborIndex(unsigned dimNum, float maxDistance);
+
+  unsigned getDimNum() const { return dimNum; }
+  float getMaxDistance() const { return maxDistance; }
+
+  unsigned getNumShells() const { return shellDistances.size(); }
+  float getShellDistance(unsigned shell) const {
+    return shellDistances[shell];
+  }
+
+  /// Return the number of offsets in the shell and the "idx"-th offset.
+  unsigned getShellSize(unsigned shell) const {
+    return shellBegins[shell + 1] - shellBegins[shell];
+  }
+  ArrayRef<int32_t> getOffset(unsigned shell, unsigned idx) const {
+    return ArrayRef<int32_t>(offsets).slice(
+        (shellBegins[shell] + idx) * dimNum, dimNum);
+  }
+
+private:
+  unsigned dimNum = 0;
+  float maxDistance = -1;
+
+  /// The flattened offsets of all shells, where the offsets of the n-th shell
+  /// are located in [shellBegins[n], shellBegins[n + 1]).
+  SmallVector<int32_t, 64> offsets;
+  SmallVector<unsigned, 16> shellBegins;
+  SmallVector<float, 16> shellDistances;
+};
+
+//===----------------------------------------------------------------------===//
+// DesignPointWriter Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// An append-only and columnar writer of design points, where each design point
+/// is a row of 64-bits integers. Rows are buffered and flushed in chunks, and
+/// the values of each column are stored contiguously in a chunk. As flushed
+/// chunks are never rewritten, a killed exploration still keeps all design
+/// points flushed before, while the memory footprint is bounded by the chunk
+/// size no matter how many points are written.
+class DesignPointWriter {
+public:
+  explicit DesignPointWriter(StringRef filePath,
+                             ArrayRef<std::string> columnNames,
+                             unsigned chunkSize = 1024);
+  ~DesignPointWriter() { flush(); }
+
+  /// Return whether the file is successfully opened for writing.
+  bool isOpen() const { return os != nullptr; }
+  StringRef getFilePath() const { return filePath; }
+
+  void append(ArrayRef<int64_t> row);
+
+  /// Flush all buffered rows to the file as a new chunk.
+  void flush();
+
+private:
+  std::string filePath;
+  unsigned numColumns;
+  unsigned chunkSize;
+
+  SmallVector<int64_t, 64> rows;
+  std::unique_ptr<llvm::raw_fd_ostream> os;
+};
+
+/// Read all complete chunks of the design point file written by
+/// DesignPointWriter, and call "callback" with each row. An incomplete chunk at
+/// the end of the file is ignored.
+LogicalResult readDesignPoints(StringRef filePath,
+                               SmallVectorImpl<std::string> &columnNames,
+                               function_ref<void(ArrayRef<int64_t>)> callback);
+
+/// Convert the design point file written by DesignPointWriter to a CSV file
+/// with a header row.
+LogicalResult convertDesignPointsToCsv(StringRef filePath, raw_ostream &os);
 
 //===----------------------------------------------------------------------===//
 // LoopDesignSpace Class Declaration
 //===----------------------------------------------------------------------===//
 
+/// The objectives of a design point, which are {latency, DSP, BRAM, LUT} and
+/// are all minimized in the exploration.
+using DesignObjectives = std::array<int64_t, 4>;
+
 struct LoopDesignPoint {
-  explicit LoopDesignPoint(int64_t latency, int64_t dspNum,
-                           TileConfig tileConfig, unsigned targetII)
-      : latency(latency), dspNum(dspNum), tileConfig(tileConfig),
-        targetII(targetII) {}
+  explicit LoopDesignPoint(int64_t latency, int64_t dspNum, int64_t bramNum,
+                           int64_t uramNum, int64_t lutNum,
+                           const TileConfig &tileConfig, unsigned targetII)
+      : latency(latency), dspNum(dspNum), bramNum(bramNum), uramNum(uramNum),
+        lutNum(lutNum), tileConfig(tileConfig), targetII(targetII) {}
+
+  DesignObjectives getObjectives() const {
+    return {latency, dspNum, bramNum, lutNum};
+  }
 
   int64_t latency;
   int64_t dspNum;
+  int64_t bramNum;
+  int64_t uramNum;
+  int64_t lutNum;
 
   TileConfig tileConfig;
   unsigned targetII;
@@ -37,45 +273,139 @@ class LoopDesignSpace {
 public:
   explicit LoopDesignSpace(func::FuncOp func, AffineLoopBand &band,
                            ScaleHLSEstimator &estimator, unsigned maxDspNum,
-                           unsigned maxExplParallel, unsigned maxLoopParallel,
-                           bool directiveOnly);
+                           unsigned maxBramNum, unsigned maxUramNum,
+                           unsigned maxLutNum, unsigned maxExplParallel,
+                           unsigned maxLoopParallel, bool directiveOnly,
+                           unsigned numThreads = 1,
+                           EstimationCache *cache = nullptr);
 
   /// Return the actual tile vector given a tile config.
-  FactorList getTileList(TileConfig config);
+  FactorList getTileList(const TileConfig &config);
 
   /// Return the corresponding tile config given a tile list.
   TileConfig getTileConfig(FactorList tileList);
 
   /// Calculate the Euclid distance of config a and config b.
-  float getTileConfigDistance(TileConfig configA, TileConfig configB);
+  float getTileConfigDistance(const TileConfig &configA,
+                              const TileConfig &configB);
+
+  /// Return whether the tile config is in the design space, i.e., its overall
+  /// parallelism is in bound and it is not the fully unrolled config.
+  bool isValidTileConfig(const TileConfig &config);
+
+  /// Return whether the tile config is in the design space and has not been
+  /// estimated.
+  bool isUnestimatedTileConfig(const TileConfig &config) {
+    return !estimatedRecords.count(config) && isValidTileConfig(config);
+  }
+
+  /// Lazily enumerate all valid tile configs whose overall parallelism is not
+  /// larger than "maxParallel" in an ascending order. The enumeration is pruned
+  /// with the parallelism, thus only visits the tile configs in bound.
+  void enumerateTileConfigs(unsigned maxParallel,
+                            function_ref<void(const TileConfig &)> callback);
+
+  /// Return the total iteration number of the loop band under the given tile
+  /// list.
+  int64_t getIterNum(FactorList tileList);
+
+  /// Return whether the design point fits in the resource budgets.
+  bool isWithinBudget(const LoopDesignPoint &point) const {
+    return point.dspNum <= maxDspNum && point.bramNum <= maxBramNum &&
+           point.uramNum <= maxUramNum && point.lutNum <= maxLutNum;
+  }
+
+  /// Estimate the given tile config on "targetBand" located in "targetFunc"
+  /// with "targetEstimator", and return the estimation record of the loop band.
+  /// The design space is not modified, thus this method can be called in
+  /// parallel as long as each caller holds its own function and estimator.
+  EstimationRecord estimateTileConfig(const TileConfig &config,
+                                      func::FuncOp targetFunc,
+                                      AffineLoopBand &targetBand,
+                                      ScaleHLSEstimator &targetEstimator);
+
+  /// Estimate the given tile config on a fresh copy of the function held by
+  /// "snapshot", and return the estimation record of the loop band. This
+  /// method can be called in parallel on different snapshots.
+  EstimationRecord
+  estimateTileConfigOnSnapshot(const TileConfig &config,
+                               LoopSnapshot &snapshot,
+                               ScaleHLSEstimator &targetEstimator);
+
+  /// Return a copy of the module holding the function, where the function is
+  /// replaced with its current state.
+  OwningOpRef<ModuleOp> takeSnapshot();
 
   /// Evaluate all design points under the given tile config.
-  bool evaluateTileConfig(TileConfig config);
+  bool evaluateTileConfig(const TileConfig &config);
+
+  /// Evaluate all design points under the given tile configs. If more than one
+  /// thread is available, the tile configs are evaluated in parallel and the
+  /// design points are merged in the order of "configs".
+  void evaluateTileConfigs(ArrayRef<TileConfig> configs);
+
+  /// Release the snapshot and workers of the tile config evaluation, which are
+  /// kept across evaluations until the exploration of the loop band is done.
+  void releaseEvaluationState() { evaluationState.reset(); }
 
   /// Initialize the design space.
   void initializeLoopDesignSpace(unsigned maxInitParallel);
 
+  /// Stream all design points evaluated afterwards to the given file. Return
+  /// false if the file cannot be opened.
+  bool openPointWriter(StringRef filePath);
+
   /// Dump pareto and non-pareto points which have been evaluated in the design
-  /// space to a csv output file.
+  /// space to a csv output file. Non-pareto points are read back from the file
+  /// of the point writer.
   void dumpLoopDesignSpace(StringRef csvFilePath);
 
   /// Get a random tile config which is one of the closest neighbors of "point".
   Optional<TileConfig> getRandomClosestNeighbor(LoopDesignPoint point,
-                                                float maxDistance);
-
-  void exploreLoopDesignSpace(unsigned maxIterNum, float maxDistance);
-
-  /// Stores current pareto frontiers and all evaluated design points. The
-  /// "allPoints" is mainly used for design space dumping, which is actually not
-  /// used in the DSE procedure.
+                                                float maxDistance,
+                                                DSERandomEngine &rng);
+
+  /// Get a random unestimated tile config whose distance to "config" is not
+  /// larger than "maxDistance".
+  Optional<TileConfig> getRandomNeighbor(const TileConfig &config,
+                                         float maxDistance,
+                                         DSERandomEngine &rng);
+
+  /// Lazily enumerate all unestimated tile configs whose distance to "config"
+  /// is not larger than "maxDistance" in an ascending order of distance. The
+  /// enumeration is stopped once "callback" returns false.
+  void enumerateNeighbors(
+      const TileConfig &config, float maxDistance,
+      function_ref<bool(const TileConfig &, float)> callback);
+
+  /// Explore the design space with the given search strategy.
+  void exploreLoopDesignSpace(DSEStrategy &strategy, unsigned maxIterNum,
+                              float maxDistance);
+
+  /// Stores current pareto frontiers. All evaluated design points are not kept
+  /// in memory, but are streamed to the point writer if available.
   SmallVector<LoopDesignPoint, 16> paretoPoints;
-  SmallVector<LoopDesignPoint, 16> allPoints;
+  uint64_t evaluatedPointNum = 0;
+  std::shared_ptr<DesignPointWriter> pointWriter;
 
-  /// Associated function, loop band, and estimator.
+  /// The checkpoint of the exploration, which is optional. The records of this
+  /// loop band are stored in the checkpoint with the name "checkpointName".
+  DSECheckpoint *checkpoint = nullptr;
+  std::string checkpointName;
+
+  /// Associated function, loop band, and estimator. As "func" may be a
+  /// detached copy, the module holding the original function is recorded in
+  /// "module" to provide the callees and globals of the function.
   func::FuncOp func;
   AffineLoopBand &band;
   ScaleHLSEstimator &estimator;
+  ModuleOp module;
+
+  /// The resource budgets of the design points.
   unsigned maxDspNum;
+  unsigned maxBramNum;
+  unsigned maxUramNum;
+  unsigned maxLutNum;
 
   /// Records the trip count of each loop level.
   SmallVector<unsigned, 8> tripCountList;
@@ -85,39 +415,188 @@ public:
   /// n-th loop in the loop band.
   std::vector<SmallVector<unsigned, 8>> validTileSizesList;
 
-  /// Holds the total number of valid tile size combinations.
-  unsigned validTileConfigNum;
+  /// Holds the estimation records of estimated tile configs. Tile configs that
+  /// are not in this map and valid have not been estimated or been evicted.
+  llvm::DenseMap<TileConfig, EstimationRecord> estimatedRecords;
 
-  /// Holds all tile configs that have not been estimated.
-  llvm::SmallDenseSet<TileConfig, 32> unestimatedTileConfigs;
+  /// The maximum number of records held in "estimatedRecords", which bounds
+  /// the memory footprint of the design space.
+  unsigned maxRecordNum = 65536;
+
+  // The maximum overall parallelism of the tile configs in the design space.
+  unsigned maxExplParallel;
+
+  // The neighbor index used in neighbor queries, which is rebuilt once the
+  // maximum distance of the query is changed.
+  NeighborIndex neighborIndex;
 
   // Whether to include loop transformation into the loop design space.
   bool directiveOnly;
+
+  // The maximum number of threads used in the tile config evaluation.
+  unsigned numThreads;
+
+  // The persistent estimation cache, which is optional.
+  EstimationCache *cache;
+
+private:
+  /// Generate and add design points of the given tile config to the design
+  /// space.
+  void addDesignPoints(const TileConfig &config, EstimationRecord record);
+
+  /// Insert the estimation record of the tile config, where the oldest records
+  /// of non-pareto tile configs are evicted once "maxRecordNum" is exceeded.
+  void insertRecord(const TileConfig &config, EstimationRecord record);
+
+  /// Return the evaluation state, which is created at the first evaluation.
+  LoopEvaluationState &getEvaluationState();
+
+  /// The tile configs held in "estimatedRecords" in the order of insertion.
+  std::deque<TileConfig> recordQueue;
+
+  /// The snapshot and workers of the tile config evaluation. As the loop band
+  /// is not changed during the exploration, they are shared by all
+  /// evaluations rather than recreated for each batch of tile configs.
+  std::shared_ptr<LoopEvaluationState> evaluationState;
 };
 
+//===----------------------------------------------------------------------===//
+// DSEStrategy Class Declaration
+//===----------------------------------------------------------------------===//
+
+/// The options of the search strategy used in the loop design space
+/// exploration.
+struct DSEStrategyOptions {
+  /// The name of the strategy, which can be "neighbor", "annealing", or
+  /// "nsga2".
+  std::string name = "neighbor";
+
+  /// The seed of the random engine.
+  uint64_t seed = 0;
+
+  /// The number of tile configs evaluated in each iteration of the neighbor
+  /// search and simulated annealing. This is independent from the number of
+  /// threads, such that the explored design points only depend on the options.
+  unsigned batchSize = 1;
+
+  /// The population size of each generation of NSGA-II.
+  unsigned populationSize = 16;
+
+  /// The initial temperature and the cooling rate of simulated annealing.
+  float initialTemperature = 1.0;
+  float coolingRate = 0.9;
+};
+
+/// The base class of all search strategies of the loop design space. A strategy
+/// iteratively selects tile configs to be evaluated until the iteration number
+/// reaches the limit or no more tile config can be found. All random decisions
+/// must be made with "rng", such that the same seed always leads to the same
+/// pareto frontiers.
+class DSEStrategy {
+public:
+  explicit DSEStrategy(uint64_t seed) : rng(seed) {}
+  virtual ~DSEStrategy() = default;
+
+  virtual void explore(LoopDesignSpace &space, unsigned maxIterNum,
+                       float maxDistance) = 0;
+
+protected:
+  DSERandomEngine rng;
+};
+
+/// Evaluate a random closest neighbor of "batchSize" pareto points in each
+/// iteration, which is a hill climbing around the current pareto frontiers.
+class NeighborSearchStrategy : public DSEStrategy {
+public:
+  explicit NeighborSearchStrategy(uint64_t seed, unsigned batchSize = 1)
+      : DSEStrategy(seed), batchSize(std::max(batchSize, 1u)) {}
+
+  void explore(LoopDesignSpace &space, unsigned maxIterNum,
+               float maxDistance) override;
+
+private:
+  unsigned batchSize;
+};
+
+/// Move from a pareto point through random neighbors, where "batchSize"
+/// neighbors are evaluated in each iteration and a worse neighbor is accepted
+/// with a probability decreasing with the temperature. The objectives are
+/// scalarized with a random weight in each iteration to cover different
+/// latency/DSP trade-offs.
+class SimulatedAnnealingStrategy : public DSEStrategy {
+public:
+  explicit SimulatedAnnealingStrategy(uint64_t seed, unsigned batchSize,
+                                      float initialTemperature,
+                                      float coolingRate)
+      : DSEStrategy(seed), batchSize(std::max(batchSize, 1u)),
+        initialTemperature(initialTemperature), coolingRate(coolingRate) {}
+
+  void explore(LoopDesignSpace &space, unsigned maxIterNum,
+               float maxDistance) override;
+
+private:
+  unsigned batchSize;
+  float initialTemperature;
+  float coolingRate;
+};
+
+/// Evolve a population of tile configs with the NSGA-II algorithm, where the
+/// offsprings are generated with uniform crossover and single-step mutation of
+/// tile sizes, and selected with non-dominated sorting and crowding distance.
+/// The maximum distance is not used as offsprings are not limited to neighbors.
+class NSGA2Strategy : public DSEStrategy {
+public:
+  explicit NSGA2Strategy(uint64_t seed, unsigned populationSize)
+      : DSEStrategy(seed), populationSize(std::max(populationSize, 2u)) {}
+
+  void explore(LoopDesignSpace &space, unsigned maxIterNum,
+               float maxDistance) override;
+
+private:
+  unsigned populationSize;
+};
+
+/// Create a search strategy with the given options and seed. Return nullptr if
+/// the name of the strategy is unknown.
+std::unique_ptr<DSEStrategy> createDSEStrategy(const DSEStrategyOptions &opts,
+                                               uint64_t seed);
+
 //===----------------------------------------------------------------------===//
 // FuncDesignSpace Class Declaration
 //===----------------------------------------------------------------------===//
 
 /// Each function design point contains multiple loop design point.
 struct FuncDesignPoint {
-  explicit FuncDesignPoint(int64_t latency, int64_t dspNum)
-      : latency(latency), dspNum(dspNum) {}
+  explicit FuncDesignPoint(int64_t latency, int64_t dspNum, int64_t bramNum,
+                           int64_t uramNum, int64_t lutNum)
+      : latency(latency), dspNum(dspNum), bramNum(bramNum), uramNum(uramNum),
+        lutNum(lutNum) {}
 
-  explicit FuncDesignPoint(int64_t latency, int64_t dspNum,
+  explicit FuncDesignPoint(int64_t latency, int64_t dspNum, int64_t bramNum,
+                           int64_t uramNum, int64_t lutNum,
                            LoopDesignPoint point)
-      : latency(latency), dspNum(dspNum) {
+      : latency(latency), dspNum(dspNum), bramNum(bramNum), uramNum(uramNum),
+        lutNum(lutNum) {
     loopDesignPoints.push_back(point);
   }
 
-  explicit FuncDesignPoint(int64_t latency, int64_t dspNum,
+  explicit FuncDesignPoint(int64_t latency, int64_t dspNum, int64_t bramNum,
+                           int64_t uramNum, int64_t lutNum,
                            SmallVector<LoopDesignPoint, 4> &points)
-      : latency(latency), dspNum(dspNum) {
+      : latency(latency), dspNum(dspNum), bramNum(bramNum), uramNum(uramNum),
+        lutNum(lutNum) {
     loopDesignPoints = points;
   }
 
+  DesignObjectives getObjectives() const {
+    return {latency, dspNum, bramNum, lutNum};
+  }
+
   int64_t latency;
   int64_t dspNum;
+  int64_t bramNum;
+  int64_t uramNum;
+  int64_t lutNum;
 
   SmallVector<LoopDesignPoint, 4> loopDesignPoints;
 };
@@ -126,9 +605,13 @@ class FuncDesignSpace {
 public:
   explicit FuncDesignSpace(func::FuncOp func,
                            SmallVector<LoopDesignSpace, 4> &loopDesignSpaces,
-                           ScaleHLSEstimator &estimator, unsigned maxDspNum)
+                           ScaleHLSEstimator &estimator, unsigned maxDspNum,
+                           unsigned maxBramNum, unsigned maxUramNum,
+                           unsigned maxLutNum, bool incremental = false,
+                           unsigned numThreads = 1)
       : func(func), loopDesignSpaces(loopDesignSpaces), estimator(estimator),
-        maxDspNum(maxDspNum) {
+        maxDspNum(maxDspNum), maxBramNum(maxBramNum), maxUramNum(maxUramNum),
+        maxLutNum(maxLutNum), incremental(incremental), numThreads(numThreads) {
     AffineLoopBands targetBands;
     getLoopBands(func.front(), targetBands);
 
@@ -138,20 +621,47 @@ public:
     }
   }
 
+  /// Combine the loop design spaces into the function design space. Function
+  /// design points exceeding the resource budgets are dropped.
   void combLoopDesignSpaces();
 
   void dumpFuncDesignSpace(StringRef csvFilePath);
-  bool exportParetoDesigns(unsigned outputNum, StringRef outputRootPath);
+
+  /// Export sampled pareto designs to MLIR files and, if "emitCpp" is set, HLS
+  /// C++ files. Each design is exported as a copy of "module" holding the
+  /// optimized function. The designs are exported in parallel with
+  /// "numThreads" threads. Return false if any design fails to be exported.
+  bool exportParetoDesigns(unsigned outputNum, StringRef outputRootPath,
+                           bool emitCpp = false);
 
   SmallVector<FuncDesignPoint, 16> paretoPoints;
 
-  /// Associated function, loop design spaces, and estimator.
+  /// Associated function, loop design spaces, and estimator. As "func" may be
+  /// a detached copy, the module holding the original function is recorded in
+  /// "module" to provide the callees and globals of the exported designs.
   func::FuncOp func;
   SmallVector<LoopDesignSpace, 4> &loopDesignSpaces;
   ScaleHLSEstimator &estimator;
+  ModuleOp module;
+
+  /// The resource budgets of the design points.
   unsigned maxDspNum;
+  unsigned maxBramNum;
+  unsigned maxUramNum;
+  unsigned maxLutNum;
+
+  // Whether to incrementally re-estimate the function when combining loops.
+  bool incremental;
+
+  // The maximum number of threads used in the export of pareto designs.
+  unsigned numThreads;
 
   SmallVector<AffineForOp, 4> targetLoops;
+
+private:
+  void estimateFunc();
+  Optional<FuncDesignPoint>
+  getFuncDesignPoint(SmallVector<LoopDesignPoint, 4> &points);
 };
 
 //===----------------------------------------------------------------------===//
@@ -161,31 +671,53 @@ public:
 class ScaleHLSExplorer {
 public:
   explicit ScaleHLSExplorer(ScaleHLSEstimator &estimator, unsigned outputNum,
-                            unsigned maxDspNum, unsigned maxInitParallel,
-                            unsigned maxExplParallel, unsigned maxLoopParallel,
-                            unsigned maxIterNum, float maxDistance)
+                            unsigned maxDspNum, unsigned maxBramNum,
+                            unsigned maxUramNum, unsigned maxLutNum,
+                            unsigned maxInitParallel, unsigned maxExplParallel,
+                            unsigned maxLoopParallel, unsigned maxIterNum,
+                            float maxDistance, unsigned numThreads = 1,
+                            EstimationCache *cache = nullptr,
+                            bool incremental = false,
+                            DSEStrategyOptions strategyOpts = {},
+                            DSECheckpoint *checkpoint = nullptr,
+                            bool emitCpp = false)
       : estimator(estimator), outputNum(outputNum), maxDspNum(maxDspNum),
+        maxBramNum(maxBramNum), maxUramNum(maxUramNum), maxLutNum(maxLutNum),
         maxInitParallel(maxInitParallel), maxExplParallel(maxExplParallel),
         maxLoopParallel(maxLoopParallel), maxIterNum(maxIterNum),
-        maxDistance(maxDistance) {}
+        maxDistance(maxDistance), numThreads(numThreads), cache(cache),
+        incremental(incremental), strategyOpts(strategyOpts),
+        checkpoint(checkpoint), emitCpp(emitCpp) {}
+
+  /// Return whether the resource utilization fits in the resource budgets.
+  bool isWithinBudget(ResourceAttr resource) const {
+    return resource.getDsp() <= maxDspNum && resource.getBram() <= maxBramNum &&
+           resource.getUram() <= maxUramNum && resource.getLut() <= maxLutNum;
+  }
 
   bool emitQoRDebugInfo(func::FuncOp func, std::string message);
 
   bool evaluateFuncPipeline(func::FuncOp func);
   bool simplifyLoopNests(func::FuncOp func);
   bool optimizeLoopBands(func::FuncOp func, bool directiveOnly);
-  bool exploreDesignSpace(func::FuncOp func, bool directiveOnly,
-                          StringRef outputRootPath, StringRef csvRootPath);
+  LogicalResult exploreDesignSpace(func::FuncOp func, bool directiveOnly,
+                                   StringRef outputRootPath,
+                                   StringRef csvRootPath);
 
-  void applyDesignSpaceExplore(func::FuncOp func, bool directiveOnly,
-                               StringRef outputRootPath, StringRef csvRootPath);
+  LogicalResult applyDesignSpaceExplore(func::FuncOp func, bool directiveOnly,
+                                        StringRef outputRootPath,
+                                        StringRef csvRootPath);
 
   ScaleHLSEstimator &estimator;
 
   // The number of pareto designs that will be generated.
   unsigned outputNum;
 
+  // The resource budgets of the target device.
   unsigned maxDspNum;
+  unsigned maxBramNum;
+  unsigned maxUramNum;
+  unsigned maxLutNum;
 
   // The maximum parallelism of the initiation and exploration of phase of DSE.
   unsigned maxInitParallel;
@@ -199,6 +731,29 @@ public:
 
   // The maximum distance in the neighbor search of DSE.
   float maxDistance;
+
+  // The maximum number of threads used in the loop design space exploration.
+  unsigned numThreads;
+
+  // The persistent estimation cache, which is optional.
+  EstimationCache *cache;
+
+  // Whether to incrementally estimate the function when combining the loop
+  // design spaces.
+  bool incremental;
+
+  // The search strategy of the loop design space exploration. The n-th loop
+  // band is explored with a seed of "strategyOpts.seed + n".
+  DSEStrategyOptions strategyOpts;
+
+  // The checkpoint of the exploration, which is optional.
+  DSECheckpoint *checkpoint;
+
+  // Whether to emit HLS C++ code of the exported pareto designs.
+  bool emitCpp;
+
+  // The maximum number of estimation records held by each loop design space.
+  unsigned maxRecordNum = 65536;
 };
 
 } // namespace scalehls
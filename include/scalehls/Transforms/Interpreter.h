@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SCALEHLS_TRANSFORMS_INTERPRETER_H
+#define SCALEHLS_TRANSFORMS_INTERPRETER_H
+
+#include "scalehls/Transforms/Utils.h"
+
+namespace mlir {
+namespace scalehls {
+
+/// The data held by an argument or result of the interpreted function. Each
+/// element is flattened into lanes in row-major order, where integers are held
+/// sign-extended and floats are held as the bit pattern of doubles.
+struct InterpretData {
+  Type elementType;
+  std::vector<int64_t> lanes;
+};
+
+/// The number of accesses to a memory object or stream channel. Objects created
+/// by the same operation are profiled together. The peak occupancy is only
+/// tracked for stream channels.
+struct MemoryProfile {
+  std::string name;
+  int64_t loadNum = 0;
+  int64_t storeNum = 0;
+  int64_t peakOccupancy = 0;
+};
+
+/// The results of interpreting a function.
+struct InterpretResult {
+  SmallVector<InterpretData, 8> arguments;
+  SmallVector<InterpretData, 4> results;
+  SmallVector<MemoryProfile, 16> profiles;
+};
+
+/// Interpret the function with arguments randomly generated from the seed,
+/// thus functions with the same signature are fed with the same arguments. The
+/// data held by each argument after the execution is returned as well as the
+/// function results. The affine, arith, math, memref, scf, vector, and HLS
+/// dialects are supported, where dataflow nodes are executed sequentially.
+FailureOr<InterpretResult> interpretFunc(func::FuncOp func, unsigned seed);
+
+/// Compare the results with the golden results, where floats are compared with
+/// the given relative tolerance. Mismatches are printed to the output stream
+/// and the number of mismatched lanes is returned.
+int64_t compareInterpretResults(const InterpretResult &result,
+                                const InterpretResult &golden,
+                                double tolerance, raw_ostream &os);
+
+/// Print the access profile of each memory object and stream channel.
+void printMemoryProfiles(const InterpretResult &result, raw_ostream &os);
+
+} // namespace scalehls
+} // namespace mlir
+
+#endif // SCALEHLS_TRANSFORMS_INTERPRETER_H
@@ -26,6 +26,11 @@ namespace scalehls {
 enum AffineFusionMode { Greedy, ProducerConsumer, Sibling };
 enum CreateSubviewMode { Point, Reduction };
 
+/// Strategy of scheduling dataflow nodes to levels. `ALAP` schedules each node
+/// right above its consumers, `ASAP` schedules each node right below its
+/// producers, and `Latency` balances the maximum node latency of all levels.
+enum class ScheduleStrategy { ALAP, ASAP, Latency };
+
 void registerScaleHLSDSEPipeline();
 void registerHIDAPyTorchPipeline();
 void registerHIDAPyTorchPipelinePost();
@@ -59,11 +64,15 @@ std::unique_ptr<Pass> createLowerDataflowPass(bool splitExternalAccess = true);
 std::unique_ptr<Pass> createParallelizeDataflowNodePass(
     unsigned loopUnrollFactor = 1, bool unrollPointLoopOnly = false,
     bool complexityAware = true, bool correlationAware = true);
+std::unique_ptr<Pass> createPlaceDataflowBufferPass(
+    unsigned threshold = 1024, bool placeExternalBuffer = true,
+    bool capacityAware = false, std::string placeTargetSpec = "./config.json");
+std::unique_ptr<Pass> createScheduleDataflowNodePass(
+    bool ignoreViolations = false,
+    ScheduleStrategy strategy = ScheduleStrategy::ALAP, bool report = false,
+    std::string scheduleTargetSpec = "./config.json");
 std::unique_ptr<Pass>
-createPlaceDataflowBufferPass(unsigned threshold = 1024,
-                              bool placeExternalBuffer = true);
-std::unique_ptr<Pass>
-createScheduleDataflowNodePass(bool ignoreViolations = false);
+createSizeDataflowDepthPass(std::string sizeTargetSpec = "./config.json");
 std::unique_ptr<Pass> createStreamDataflowTaskPass();
 
 /// Tensor-related passes.
@@ -77,7 +86,8 @@ std::unique_ptr<Pass> createTosaSimplifyGraphPass();
 std::unique_ptr<Pass> createAffineLoopFusionPass(
     double computeToleranceThreshold = 0.3, unsigned fastMemorySpace = 0,
     uint64_t localBufSizeThreshold = 0, bool maximalFusion = false,
-    enum AffineFusionMode fusionMode = AffineFusionMode::Greedy);
+    enum AffineFusionMode fusionMode = AffineFusionMode::Greedy,
+    bool qorAware = false, std::string fusionTargetSpec = "./config.json");
 std::unique_ptr<Pass> createAffineLoopOrderOptPass();
 std::unique_ptr<Pass> createAffineLoopPerfectionPass();
 std::unique_ptr<Pass> createAffineLoopTilePass(unsigned loopTileSize = 1);
@@ -99,13 +109,16 @@ std::unique_ptr<Pass> createCreateMemrefSubviewPass(
     CreateSubviewMode createSubviewMode = CreateSubviewMode::Point);
 std::unique_ptr<Pass>
 createLowerCopyToAffinePass(bool internalCopyOnly = false);
+std::unique_ptr<Pass> createPackExternalBufferPass(unsigned busWidth = 512);
 std::unique_ptr<Pass> createRaiseAffineToCopyPass();
 std::unique_ptr<Pass> createReduceInitialIntervalPass();
 std::unique_ptr<Pass> createSimplifyAffineIfPass();
 std::unique_ptr<Pass> createSimplifyCopyPass();
 
 /// Directive-related passes.
-std::unique_ptr<Pass> createArrayPartitionPass(unsigned threshold = 1024);
+std::unique_ptr<Pass>
+createArrayPartitionPass(unsigned threshold = 1024, bool qorAware = false,
+                         std::string partitionTargetSpec = "./config.json");
 std::unique_ptr<Pass>
 createCreateAxiInterfacePass(std::string hlsTopFunc = "forward");
 std::unique_ptr<Pass> createCreateHLSPrimitivePass();
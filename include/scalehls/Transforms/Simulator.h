@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SCALEHLS_TRANSFORMS_SIMULATOR_H
+#define SCALEHLS_TRANSFORMS_SIMULATOR_H
+
+#include "scalehls/Transforms/Estimator.h"
+
+namespace mlir {
+namespace scalehls {
+
+/// The simulated activities of a dataflow node. A node is busy when executing,
+/// starved when waiting for input buffers or tokens, and blocked when waiting
+/// for output buffers or stream channels to be drained by its consumers. The
+/// starved and blocked cycles in the middle of a frame, which stretch the frame
+/// of the node, are also counted as stalled cycles.
+struct NodeSimResult {
+  NodeOp node;
+  int64_t latency = 0;
+  int64_t interval = 0;
+  int64_t busyCycles = 0;
+  int64_t stalledCycles = 0;
+  int64_t starvedCycles = 0;
+  int64_t blockedCycles = 0;
+};
+
+/// The simulated results of a dataflow schedule executed for a number of
+/// frames. The latency is the cycle when the last frame is finished, and the
+/// interval is the average number of cycles between two consecutive frames.
+struct ScheduleSimResult {
+  ScheduleOp schedule;
+  unsigned frameNum = 1;
+  int64_t latency = 0;
+  int64_t interval = 0;
+  bool deadlock = false;
+  SmallVector<NodeSimResult, 16> nodes;
+
+  /// Return the node occupied by its frames for the most cycles, which is the
+  /// sum of the busy and stalled cycles, as the bottleneck of the throughput of
+  /// the schedule. Among equally occupied nodes, the node stalled for fewer
+  /// cycles is the bottleneck. Return nullptr if there is no node.
+  const NodeSimResult *getBottleneck() const;
+};
+
+/// Simulate the dataflow schedule for the given number of frames. The latency
+/// and interval of each node are estimated by the estimator, while the depth of
+/// each stream channel and buffer is read from the IR. The simulation is event
+/// driven and cycle-approximate: each node executes its frames sequentially,
+/// and pushes or pops stream tokens evenly within its interval.
+FailureOr<ScheduleSimResult> simulateSchedule(ScheduleOp schedule,
+                                              ScaleHLSEstimator &estimator,
+                                              unsigned frameNum);
+
+/// Print the simulation results as a human-readable report.
+void printSimulationReport(const ScheduleSimResult &result, raw_ostream &os);
+
+} // namespace scalehls
+} // namespace mlir
+
+#endif // SCALEHLS_TRANSFORMS_SIMULATOR_H
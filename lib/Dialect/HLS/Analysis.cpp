@@ -265,3 +265,219 @@ CorrelationAnalysis::CorrelationAnalysis(func::FuncOp func) {
     return WalkResult::advance();
   });
 }
+
+//===----------------------------------------------------------------------===//
+// DataflowGraphAnalysis
+//===----------------------------------------------------------------------===//
+
+/// Get the graph of the schedule, which is built if not cached.
+DataflowGraphAnalysis::ScheduleGraph *
+DataflowGraphAnalysis::getGraph(ScheduleOp schedule) {
+  auto &graph = graphs[schedule];
+  if (graph)
+    return graph.get();
+
+  graph = std::make_unique<ScheduleGraph>();
+  uint64_t position = 0;
+  for (auto node : schedule.getOps<NodeOp>()) {
+    graph->positions[node] = position += positionStride;
+    insertEdges(*graph, node);
+  }
+  return graph.get();
+}
+
+/// Get the graph of the schedule holding the buffer. Return nullptr if the
+/// buffer is not held by a schedule, which means it has no node user.
+DataflowGraphAnalysis::ScheduleGraph *
+DataflowGraphAnalysis::getGraph(Value buffer) {
+  auto schedule = dyn_cast<ScheduleOp>(buffer.getParentBlock()->getParentOp());
+  if (!schedule)
+    return nullptr;
+  return getGraph(schedule);
+}
+
+/// Get the graph of the schedule holding the node. Return nullptr if the graph
+/// is not built yet, in which case the node is picked up when it is built.
+DataflowGraphAnalysis::ScheduleGraph *
+DataflowGraphAnalysis::lookupGraph(NodeOp node) {
+  auto it = graphs.find(node.getScheduleOp());
+  if (it == graphs.end())
+    return nullptr;
+  return it->second.get();
+}
+
+/// Record the position of the node between its neighbor nodes in the schedule.
+/// All nodes are re-spaced if there is no free position between the neighbors.
+void DataflowGraphAnalysis::placeNode(ScheduleGraph &graph, NodeOp node) {
+  auto getPosition = [&](Operation *op) -> Optional<uint64_t> {
+    auto it = graph.positions.find(op);
+    if (it != graph.positions.end())
+      return it->second;
+    return llvm::None;
+  };
+
+  Optional<uint64_t> prevPosition, nextPosition;
+  for (auto op = node->getPrevNode(); op && !prevPosition;
+       op = op->getPrevNode())
+    prevPosition = getPosition(op);
+  for (auto op = node->getNextNode(); op && !nextPosition;
+       op = op->getNextNode())
+    nextPosition = getPosition(op);
+
+  auto low = prevPosition.value_or(0);
+  if (!nextPosition) {
+    graph.positions[node] = low + positionStride;
+    return;
+  }
+  if (*nextPosition - low > 1) {
+    graph.positions[node] = low + (*nextPosition - low) / 2;
+    return;
+  }
+
+  uint64_t position = 0;
+  for (auto &op : *node->getBlock())
+    if (&op == node.getOperation() || graph.positions.count(&op))
+      graph.positions[&op] = position += positionStride;
+}
+
+/// Insert the node into the consumer/producer list of each of its operands,
+/// where the position of the node must have been recorded.
+void DataflowGraphAnalysis::insertEdges(ScheduleGraph &graph, NodeOp node) {
+  auto position = graph.positions.lookup(node);
+  auto &edges = graph.edges[node];
+  for (auto &use : node->getOpOperands()) {
+    auto kind = node.getOperandKind(use);
+    if (kind == OperandKind::PARAM)
+      continue;
+
+    auto isInput = kind == OperandKind::INPUT;
+    auto &nodes =
+        isInput ? graph.consumers[use.get()] : graph.producers[use.get()];
+    if (llvm::is_contained(nodes, node))
+      continue;
+    auto it = llvm::upper_bound(nodes, position, [&](uint64_t pos, NodeOp n) {
+      return pos < graph.positions.lookup(n);
+    });
+    nodes.insert(it, node);
+    edges.push_back({use.get(), isInput});
+  }
+}
+
+/// Erase the node from the consumer/producer lists it has been inserted into,
+/// which doesn't rely on the current operands of the node.
+void DataflowGraphAnalysis::eraseEdges(ScheduleGraph &graph, NodeOp node) {
+  for (auto [buffer, isInput] : graph.edges.lookup(node)) {
+    auto &nodes = isInput ? graph.consumers[buffer] : graph.producers[buffer];
+    llvm::erase_value(nodes, node);
+  }
+  graph.edges.erase(node);
+}
+
+ArrayRef<NodeOp> DataflowGraphAnalysis::getConsumers(Value buffer) {
+  if (auto graph = getGraph(buffer)) {
+    auto it = graph->consumers.find(buffer);
+    if (it != graph->consumers.end())
+      return it->second;
+  }
+  return {};
+}
+
+ArrayRef<NodeOp> DataflowGraphAnalysis::getProducers(Value buffer) {
+  if (auto graph = getGraph(buffer)) {
+    auto it = graph->producers.find(buffer);
+    if (it != graph->producers.end())
+      return it->second;
+  }
+  return {};
+}
+
+SmallVector<NodeOp> DataflowGraphAnalysis::getConsumersExcept(Value buffer,
+                                                              NodeOp except) {
+  SmallVector<NodeOp> nodes;
+  for (auto node : getConsumers(buffer))
+    if (node != except)
+      nodes.push_back(node);
+  return nodes;
+}
+
+SmallVector<NodeOp> DataflowGraphAnalysis::getProducersExcept(Value buffer,
+                                                              NodeOp except) {
+  SmallVector<NodeOp> nodes;
+  for (auto node : getProducers(buffer))
+    if (node != except)
+      nodes.push_back(node);
+  return nodes;
+}
+
+SmallVector<NodeOp> DataflowGraphAnalysis::getDependentConsumers(Value buffer,
+                                                                 NodeOp node) {
+  // If the buffer is defined outside of a dependence free schedule op, we can
+  // ignore back dependences.
+  bool ignoreBackDependence =
+      buffer.isa<BlockArgument>() && node.getScheduleOp().isDependenceFree();
+
+  SmallVector<NodeOp> nodes;
+  for (auto consumer : getConsumersExcept(buffer, node))
+    if (!ignoreBackDependence || properlyDominates(node, consumer))
+      nodes.push_back(consumer);
+  return nodes;
+}
+
+bool DataflowGraphAnalysis::properlyDominates(NodeOp a, NodeOp b) {
+  assert(a->getBlock() == b->getBlock() && "nodes are in different schedules");
+  auto graph = getGraph(a.getScheduleOp());
+  auto aIt = graph->positions.find(a);
+  auto bIt = graph->positions.find(b);
+  if (aIt != graph->positions.end() && bIt != graph->positions.end())
+    return aIt->second < bIt->second;
+
+  // Nodes that are not added into the graph are compared with their order in
+  // the schedule block.
+  return a != b && a->isBeforeInBlock(b);
+}
+
+void DataflowGraphAnalysis::addNode(NodeOp node) {
+  if (auto graph = lookupGraph(node)) {
+    placeNode(*graph, node);
+    insertEdges(*graph, node);
+  }
+}
+
+void DataflowGraphAnalysis::updateNode(NodeOp node) {
+  if (auto graph = lookupGraph(node)) {
+    eraseEdges(*graph, node);
+    insertEdges(*graph, node);
+  }
+}
+
+void DataflowGraphAnalysis::removeNode(NodeOp node) {
+  if (auto graph = lookupGraph(node)) {
+    eraseEdges(*graph, node);
+    graph->positions.erase(node);
+  }
+}
+
+void DataflowGraphAnalysis::replaceNode(NodeOp node, NodeOp newNode) {
+  if (auto graph = lookupGraph(node)) {
+    eraseEdges(*graph, node);
+    graph->positions[newNode] = graph->positions.lookup(node);
+    graph->positions.erase(node);
+    insertEdges(*graph, newNode);
+  }
+}
+
+void DataflowGraphAnalysis::invalidate(ScheduleOp schedule) {
+  if (schedule)
+    graphs.erase(schedule);
+  else
+    graphs.clear();
+}
+
+void scalehls::eraseDeadNodes(Operation *op, DataflowGraphAnalysis &graph) {
+  op->walk([&](NodeOp node) {
+    if (isOpTriviallyDead(node)) {
+      graph.removeNode(node);
+      node.erase();
+    }
+  });
+}
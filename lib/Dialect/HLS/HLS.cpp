@@ -1337,6 +1337,36 @@ void hls::setTileLayout(Value memref, ArrayRef<int64_t> tileShape) {
   setTileLayout(memref, tileLayout);
 }
 
+//===----------------------------------------------------------------------===//
+// AXI port width attribute utils.
+//===----------------------------------------------------------------------===//
+
+IntegerAttr hls::getMaxWidenBitwidth(Value memref) {
+  if (auto buffer = findBuffer(memref)) {
+    if (auto bufferArg = buffer.dyn_cast<BlockArgument>()) {
+      if (auto func =
+              dyn_cast<func::FuncOp>(bufferArg.getOwner()->getParentOp()))
+        return func.getArgAttrOfType<IntegerAttr>(bufferArg.getArgNumber(),
+                                                  "hls.max_widen_bitwidth");
+    } else if (auto bufferOp = buffer.getDefiningOp())
+      return bufferOp->getAttrOfType<IntegerAttr>("max_widen_bitwidth");
+  }
+  return IntegerAttr();
+}
+void hls::setMaxWidenBitwidth(Value memref, int64_t bitwidth) {
+  auto attr =
+      IntegerAttr::get(IntegerType::get(memref.getContext(), 64), bitwidth);
+  if (auto buffer = findBuffer(memref)) {
+    if (auto bufferArg = buffer.dyn_cast<BlockArgument>()) {
+      if (auto func =
+              dyn_cast<func::FuncOp>(bufferArg.getOwner()->getParentOp()))
+        func.setArgAttr(bufferArg.getArgNumber(), "hls.max_widen_bitwidth",
+                        attr);
+    } else if (auto bufferOp = buffer.getDefiningOp())
+      bufferOp->setAttr("max_widen_bitwidth", attr);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // HLS resource and timing attributes
 //===----------------------------------------------------------------------===//
@@ -1362,8 +1392,9 @@ ResourceAttr hls::getResource(Operation *op) {
 void hls::setResource(Operation *op, ResourceAttr resource) {
   op->setAttr("resource", resource);
 }
-void hls::setResource(Operation *op, int64_t lut, int64_t dsp, int64_t bram) {
-  auto resource = ResourceAttr::get(op->getContext(), lut, dsp, bram);
+void hls::setResource(Operation *op, int64_t lut, int64_t dsp, int64_t bram,
+                      int64_t uram) {
+  auto resource = ResourceAttr::get(op->getContext(), lut, dsp, bram, uram);
   setResource(op, resource);
 }
 
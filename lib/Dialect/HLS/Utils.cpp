@@ -57,6 +57,16 @@ bool scalehls::isUnknown(MemRefType type) {
   auto kind = getMemoryKind(type);
   return kind == MemoryKind::UNKNOWN;
 }
+bool scalehls::isLutram(MemRefType type) {
+  auto kind = getMemoryKind(type);
+  return kind == MemoryKind::LUTRAM_1P || kind == MemoryKind::LUTRAM_2P ||
+         kind == MemoryKind::LUTRAM_S2P;
+}
+bool scalehls::isUram(MemRefType type) {
+  auto kind = getMemoryKind(type);
+  return kind == MemoryKind::URAM_1P || kind == MemoryKind::URAM_2P ||
+         kind == MemoryKind::URAM_S2P || kind == MemoryKind::URAM_T2P;
+}
 
 //===----------------------------------------------------------------------===//
 // Dataflow utils
@@ -241,10 +251,12 @@ SmallVector<NodeOp> scalehls::getDependentConsumers(Value buffer, NodeOp node) {
   bool ignoreBackDependence =
       buffer.isa<BlockArgument>() && node.getScheduleOp().isDependenceFree();
 
-  DominanceInfo domInfo;
+  // Nodes sharing the same buffer are located in the same schedule block,
+  // where the dominance is simply the order of nodes in the block.
   SmallVector<NodeOp> nodes;
   for (auto consumer : getConsumersExcept(buffer, node))
-    if (!ignoreBackDependence || domInfo.properlyDominates(node, consumer))
+    if (!ignoreBackDependence || (node->getBlock() == consumer->getBlock() &&
+                                  node->isBeforeInBlock(consumer)))
       nodes.push_back(consumer);
   return nodes;
 }
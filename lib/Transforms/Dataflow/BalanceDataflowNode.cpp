@@ -5,6 +5,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Dialect/HLS/Analysis.h"
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -12,23 +14,61 @@ using namespace mlir;
 using namespace scalehls;
 using namespace hls;
 
+namespace {
+/// The estimated schedule begin and end of a dataflow node, and the interval of
+/// the dataflow schedule containing the node.
+struct NodeTiming {
+  int64_t begin;
+  int64_t end;
+  int64_t interval;
+};
+using NodeTimingMap = llvm::SmallDenseMap<NodeOp, NodeTiming>;
+} // namespace
+
 namespace {
 struct InsertCopyNode : public OpRewritePattern<NodeOp> {
-  using OpRewritePattern<NodeOp>::OpRewritePattern;
+  InsertCopyNode(MLIRContext *context, DataflowGraphAnalysis &graph,
+                 const NodeTimingMap &timingMap)
+      : OpRewritePattern<NodeOp>(context), graph(graph), timingMap(timingMap) {}
+
+  /// Return the number of dataflow levels that the output of the node must be
+  /// held for the consumer, which is their level difference. If the nodes are
+  /// estimated, the output is only held until the consumer finishes, during
+  /// which the schedule is executed again every interval. As a ping-pong buffer
+  /// holds the outputs of two executions and each copy holds one more, the
+  /// levels to hold is one less than the number of executions in flight.
+  unsigned getLevelDiff(NodeOp node, NodeOp consumer) const {
+    auto diff = node.getLevel().value() - consumer.getLevel().value();
+    auto nodeIt = timingMap.find(node);
+    auto consumerIt = timingMap.find(consumer);
+    if (diff <= 1 || nodeIt == timingMap.end() ||
+        consumerIt == timingMap.end())
+      return diff;
+
+    auto span = consumerIt->second.end - nodeIt->second.begin;
+    auto interval = nodeIt->second.interval;
+    auto executionNum = (span + interval - 1) / interval;
+    return std::min(diff, (unsigned)std::max(executionNum - 1, (int64_t)1));
+  }
 
   LogicalResult matchAndRewrite(NodeOp node,
                                 PatternRewriter &rewriter) const override {
     if (!node.getLevel())
       return failure();
 
+    // Copy nodes are not estimated. As the levels to hold their outputs have
+    // been decided by the estimated nodes, they are not balanced again.
+    if (!timingMap.empty() && !timingMap.count(node))
+      return failure();
+
     for (auto output : node.getOutputs()) {
       if (output.isa<BlockArgument>() &&
           node.getScheduleOp().isDependenceFree())
         continue;
 
       SmallVector<std::pair<unsigned, NodeOp>, 4> worklist;
-      for (auto consumer : getDependentConsumers(output, node)) {
-        auto diff = node.getLevel().value() - consumer.getLevel().value();
+      for (auto consumer : graph.getDependentConsumers(output, node)) {
+        auto diff = getLevelDiff(node, consumer);
         if (diff > 1)
           worklist.push_back({diff, consumer});
       }
@@ -83,6 +123,7 @@ struct InsertCopyNode : public OpRewritePattern<NodeOp> {
         rewriter.setInsertionPointToStart(block);
         rewriter.create<memref::CopyOp>(loc, block->getArgument(0),
                                         block->getArgument(1));
+        graph.addNode(newNode);
 
         // Replace all uses at the current level.
         llvm::SmallDenseSet<Operation *, 4> consumers;
@@ -91,6 +132,8 @@ struct InsertCopyNode : public OpRewritePattern<NodeOp> {
         output.replaceUsesWithIf(newBuf, [&](OpOperand &use) {
           return consumers.count(use.getOwner());
         });
+        for (auto consumer : consumers)
+          graph.updateNode(cast<NodeOp>(consumer));
 
         // Finally, we can update current buffer and current node.
         currentBuf = newBuf;
@@ -99,20 +142,68 @@ struct InsertCopyNode : public OpRewritePattern<NodeOp> {
     }
     return success();
   }
+
+private:
+  DataflowGraphAnalysis &graph;
+  const NodeTimingMap &timingMap;
 };
 } // namespace
 
 namespace {
 struct BalanceDataflowNode
     : public BalanceDataflowNodeBase<BalanceDataflowNode> {
+  /// Estimate all dataflow nodes with the target spec, and record the timing
+  /// of each node. The estimation results are removed from the IR afterwards.
+  /// Return false if the target spec cannot be loaded.
+  bool getNodeTimingMap(func::FuncOp func) {
+    TargetSpec spec;
+    if (!spec.load(targetSpec))
+      return false;
+
+    auto estimator = spec.createEstimator();
+    func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+      estimator->estimateSchedule(schedule);
+      return WalkResult::skip();
+    });
+
+    // If any node failed to be estimated, fall back to the level differences.
+    nodeTimingMap.clear();
+    bool estimated = true;
+    func.walk([&](NodeOp node) {
+      auto timing = getTiming(node);
+      auto scheduleTiming = getTiming(node.getScheduleOp());
+      if (timing && scheduleTiming)
+        nodeTimingMap[node] = {
+            timing.getBegin(), timing.getEnd(),
+            std::max(scheduleTiming.getInterval(), (int64_t)1)};
+      else
+        estimated = false;
+    });
+    removeEstimation(func);
+    if (!estimated) {
+      func.emitWarning("failed to estimate dataflow nodes, fall back to "
+                       "level differences");
+      nodeTimingMap.clear();
+    }
+    return true;
+  }
+
   void runOnOperation() override {
     auto func = getOperation();
     auto context = func.getContext();
+    nodeTimingMap.clear();
+    if (!targetSpec.empty() && !getNodeTimingMap(func))
+      return signalPassFailure();
 
+    auto &graph = getAnalysis<DataflowGraphAnalysis>();
+    eraseDeadNodes(func, graph);
     mlir::RewritePatternSet patterns(context);
-    patterns.add<InsertCopyNode>(context);
+    patterns.add<InsertCopyNode>(context, graph, nodeTimingMap);
     (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
   }
+
+private:
+  NodeTimingMap nodeTimingMap;
 };
 } // namespace
 
@@ -5,6 +5,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Dialect/HLS/Analysis.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -19,6 +20,7 @@ struct CreateTokenStream : public CreateTokenStreamBase<CreateTokenStream> {
     auto context = func.getContext();
     OpBuilder b(context);
     auto loc = b.getUnknownLoc();
+    auto &graph = getAnalysis<DataflowGraphAnalysis>();
 
     func.walk([&](ScheduleOp schedule) {
       if (!schedule.getIsLegal())
@@ -33,7 +35,7 @@ struct CreateTokenStream : public CreateTokenStreamBase<CreateTokenStream> {
           buffers.push_back(bufferOp);
 
       for (auto buffer : buffers) {
-        auto producers = getProducers(buffer);
+        auto producers = graph.getProducers(buffer);
         if (!llvm::hasSingleElement(producers))
           continue;
 
@@ -43,7 +45,7 @@ struct CreateTokenStream : public CreateTokenStreamBase<CreateTokenStream> {
         SmallVector<Value, 8> outputs(producer.getOutputs());
         SmallVector<StreamOp, 4> tokens;
 
-        auto consumers = getDependentConsumers(buffer, producer);
+        auto consumers = graph.getDependentConsumers(buffer, producer);
         if (consumers.empty())
           continue;
 
@@ -80,6 +82,7 @@ struct CreateTokenStream : public CreateTokenStreamBase<CreateTokenStream> {
                              producer.getLevelAttr());
         newProducer.getBody().getBlocks().splice(
             newProducer.getBody().end(), producer.getBody().getBlocks());
+        graph.replaceNode(producer, newProducer);
         producer.erase();
 
         for (auto t : llvm::zip(tokens, consumers)) {
@@ -110,11 +113,13 @@ struct CreateTokenStream : public CreateTokenStreamBase<CreateTokenStream> {
               consumer.getParams(), inputTaps, consumer.getLevelAttr());
           newConsumer.getBody().getBlocks().splice(
               newConsumer.getBody().end(), consumer.getBody().getBlocks());
+          graph.replaceNode(consumer, newConsumer);
           consumer.erase();
         }
       }
       return WalkResult::advance();
     });
+    markAnalysesPreserved<DataflowGraphAnalysis>();
   }
 };
 } // namespace
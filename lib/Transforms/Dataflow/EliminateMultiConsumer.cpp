@@ -5,6 +5,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Dialect/HLS/Analysis.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -14,7 +15,8 @@ using namespace hls;
 
 namespace {
 struct InsertForkNode : public OpRewritePattern<NodeOp> {
-  using OpRewritePattern<NodeOp>::OpRewritePattern;
+  InsertForkNode(MLIRContext *context, DataflowGraphAnalysis &graph)
+      : OpRewritePattern<NodeOp>(context), graph(graph) {}
 
   LogicalResult matchAndRewrite(NodeOp node,
                                 PatternRewriter &rewriter) const override {
@@ -27,7 +29,7 @@ struct InsertForkNode : public OpRewritePattern<NodeOp> {
       if (isExtBuffer(output))
         continue;
 
-      auto consumers = getDependentConsumers(output, node);
+      auto consumers = graph.getDependentConsumers(output, node);
       if (consumers.size() < 2)
         continue;
 
@@ -41,6 +43,7 @@ struct InsertForkNode : public OpRewritePattern<NodeOp> {
         auto buffer = rewriter.create<BufferOp>(loc, output.getType());
         output.replaceUsesWithIf(
             buffer, [&](OpOperand &use) { return use.getOwner() == consumer; });
+        graph.updateNode(consumer);
         buffers.push_back(buffer);
         bufferLocs.push_back(loc);
       }
@@ -55,9 +58,13 @@ struct InsertForkNode : public OpRewritePattern<NodeOp> {
       rewriter.setInsertionPointToStart(block);
       for (auto bufferArg : bufferArgs)
         rewriter.create<memref::CopyOp>(loc, outputArg, bufferArg);
+      graph.addNode(fork);
     }
     return success(hasChanged);
   }
+
+private:
+  DataflowGraphAnalysis &graph;
 };
 } // namespace
 
@@ -68,8 +75,10 @@ struct EliminateMultiConsumer
     auto func = getOperation();
     auto context = func.getContext();
 
+    auto &graph = getAnalysis<DataflowGraphAnalysis>();
+    eraseDeadNodes(func, graph);
     mlir::RewritePatternSet patterns(context);
-    patterns.add<InsertForkNode>(context);
+    patterns.add<InsertForkNode>(context, graph);
     (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
   }
 };
@@ -4,8 +4,8 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include "mlir/IR/Dominance.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Dialect/HLS/Analysis.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -13,21 +13,23 @@ using namespace mlir;
 using namespace scalehls;
 using namespace hls;
 
-static void collectNodes(llvm::SmallDenseSet<NodeOp> const &allNodes,
+static void collectNodes(DataflowGraphAnalysis &graph,
+                         llvm::SmallDenseSet<NodeOp> const &allNodes,
                          llvm::SmallDenseSet<NodeOp> &visitedNodes,
                          SmallVector<NodeOp> &nodesToMerge, NodeOp node) {
   if (!visitedNodes.insert(node).second)
     return;
   nodesToMerge.push_back(node);
   for (auto input : node.getInputs())
-    for (auto consumer : getConsumersExcept(input, node))
+    for (auto consumer : graph.getConsumersExcept(input, node))
       if (allNodes.count(consumer))
-        collectNodes(allNodes, visitedNodes, nodesToMerge, consumer);
+        collectNodes(graph, allNodes, visitedNodes, nodesToMerge, consumer);
 }
 
 namespace {
 struct FuseMultiConsumer : public OpRewritePattern<ScheduleOp> {
-  using OpRewritePattern<ScheduleOp>::OpRewritePattern;
+  FuseMultiConsumer(MLIRContext *context, DataflowGraphAnalysis &graph)
+      : OpRewritePattern<ScheduleOp>(context), graph(graph) {}
 
   LogicalResult matchAndRewrite(ScheduleOp schedule,
                                 PatternRewriter &rewriter) const override {
@@ -41,39 +43,49 @@ struct FuseMultiConsumer : public OpRewritePattern<ScheduleOp> {
     }
 
     // Merge nodes at the same level if they share the same input (to remove
-    // multi-consumer violation).
-    DominanceInfo domInfo;
-    bool hasChanged = false;
+    // multi-consumer violation). Nodes at different levels are never merged
+    // together, thus all nodes to merge are collected before any merge while
+    // the dataflow graph is still valid.
+    SmallVector<std::pair<unsigned, SmallVector<NodeOp>>> worklist;
     for (const auto &p : levelToNodesMap) {
       // llvm::outs() << p.first << "\n";
       llvm::SmallDenseSet<NodeOp> visitedNodes;
-      SmallVector<SmallVector<NodeOp>> worklist;
 
       for (auto node : p.second) {
         if (visitedNodes.count(node))
           continue;
         SmallVector<NodeOp> nodesToMerge;
-        collectNodes(p.second, visitedNodes, nodesToMerge, node);
-        if (nodesToMerge.size() > 1)
-          worklist.push_back(nodesToMerge);
+        collectNodes(graph, p.second, visitedNodes, nodesToMerge, node);
+        if (nodesToMerge.size() > 1) {
+          llvm::sort(nodesToMerge, [&](NodeOp a, NodeOp b) {
+            return graph.properlyDominates(a, b);
+          });
+          worklist.push_back({p.first, nodesToMerge});
+        }
       }
+    }
 
-      for (auto nodesToMerge : worklist) {
-        // llvm::outs() << "merged " << nodesToMerge.size() << "\n";
-        llvm::sort(nodesToMerge,
-                   [&](NodeOp a, NodeOp b) { return domInfo.dominates(a, b); });
-        auto newNode = fuseNodeOps(nodesToMerge, rewriter);
-        newNode.setLevelAttr(rewriter.getI32IntegerAttr(p.first));
-        hasChanged = true;
-      }
+    for (auto &[level, nodesToMerge] : worklist) {
+      // llvm::outs() << "merged " << nodesToMerge.size() << "\n";
+      for (auto node : nodesToMerge)
+        graph.removeNode(node);
+      auto newNode = fuseNodeOps(nodesToMerge, rewriter);
+      newNode.setLevelAttr(rewriter.getI32IntegerAttr(level));
+      graph.addNode(newNode);
     }
+    if (worklist.empty())
+      return failure();
     // schedule.setIsLegalAttr(rewriter.getUnitAttr());
-    return success(hasChanged);
+    return success();
   }
+
+private:
+  DataflowGraphAnalysis &graph;
 };
 } // namespace
 
 static void collectBypassNodes(
+    DataflowGraphAnalysis &graph,
     llvm::SmallDenseMap<unsigned, llvm::SmallDenseSet<NodeOp>> const &map,
     llvm::SmallDenseSet<unsigned> &mergedLevels,
     SmallVector<NodeOp> &nodesToMerge, unsigned targetLevel) {
@@ -92,7 +104,7 @@ static void collectBypassNodes(
         continue;
 
       SmallVector<std::pair<unsigned, NodeOp>, 4> bypassNodes;
-      for (auto consumer : getDependentConsumers(output, node)) {
+      for (auto consumer : graph.getDependentConsumers(output, node)) {
         auto diff = node.getLevel().value() - consumer.getLevel().value();
         if (diff > 1)
           bypassNodes.push_back({diff, consumer});
@@ -114,13 +126,14 @@ static void collectBypassNodes(
     // llvm::outs() << "---------- " << level << "\n";
     for (auto node : map.lookup(level))
       nodesToMerge.push_back(node);
-    collectBypassNodes(map, mergedLevels, nodesToMerge, level);
+    collectBypassNodes(graph, map, mergedLevels, nodesToMerge, level);
   }
 }
 
 namespace {
 struct FuseBypassPath : public OpRewritePattern<ScheduleOp> {
-  using OpRewritePattern<ScheduleOp>::OpRewritePattern;
+  FuseBypassPath(MLIRContext *context, DataflowGraphAnalysis &graph)
+      : OpRewritePattern<ScheduleOp>(context), graph(graph) {}
 
   LogicalResult matchAndRewrite(ScheduleOp schedule,
                                 PatternRewriter &rewriter) const override {
@@ -144,24 +157,35 @@ struct FuseBypassPath : public OpRewritePattern<ScheduleOp> {
         continue;
       // llvm::outs() << "\n========== " << level << "\n";
       SmallVector<NodeOp> nodesToMerge;
-      collectBypassNodes(levelToNodesMap, mergedLevels, nodesToMerge, level);
+      collectBypassNodes(graph, levelToNodesMap, mergedLevels, nodesToMerge,
+                         level);
       if (nodesToMerge.size() > 1)
         worklist.push_back(nodesToMerge);
     }
 
-    bool hasChanged = false;
-    DominanceInfo domInfo;
+    // Sort all nodes to merge before any merge while the dataflow graph is
+    // still valid.
+    for (auto &nodesToMerge : worklist)
+      llvm::sort(nodesToMerge, [&](NodeOp a, NodeOp b) {
+        return graph.properlyDominates(a, b);
+      });
+
     for (auto nodesToMerge : worklist) {
       // llvm::outs() << "merged " << nodesToMerge.size() << "\n";
-      llvm::sort(nodesToMerge,
-                 [&](NodeOp a, NodeOp b) { return domInfo.dominates(a, b); });
+      auto level = nodesToMerge.front().getLevel().value();
+      for (auto node : nodesToMerge)
+        graph.removeNode(node);
       auto newNode = fuseNodeOps(nodesToMerge, rewriter);
-      newNode.setLevelAttr(
-          rewriter.getI32IntegerAttr(nodesToMerge.front().getLevel().value()));
-      hasChanged = true;
+      newNode.setLevelAttr(rewriter.getI32IntegerAttr(level));
+      graph.addNode(newNode);
     }
-    return success(hasChanged);
+    if (worklist.empty())
+      return failure();
+    return success();
   }
+
+private:
+  DataflowGraphAnalysis &graph;
 };
 } // namespace
 
@@ -193,19 +217,30 @@ struct LegalizeDataflow : public LegalizeDataflowBase<LegalizeDataflow> {
     auto context = func.getContext();
 
     // Fuse multi consumer and bypass path dataflow nodes.
+    auto &graph = getAnalysis<DataflowGraphAnalysis>();
     mlir::RewritePatternSet patterns(context);
-    patterns.add<FuseMultiConsumer>(context);
-    patterns.add<FuseBypassPath>(context);
+    patterns.add<FuseMultiConsumer>(context, graph);
+    patterns.add<FuseBypassPath>(context, graph);
     auto frozenPatterns = FrozenRewritePatternSet(std::move(patterns));
 
+    // The patterns update the graph incrementally, and the driver only folds
+    // or erases the schedule itself, whose graph is dropped once it is erased.
+    // Thus the graph is still valid after the pass.
     func.walk([&](ScheduleOp schedule) {
-      (void)applyOpPatternsAndFold(schedule, frozenPatterns);
+      bool erased = false;
+      (void)applyOpPatternsAndFold(schedule, frozenPatterns, &erased);
+      if (erased) {
+        graph.invalidate(schedule);
+        return;
+      }
 
       if (llvm::all_of(schedule.getOps<NodeOp>(),
                        [](NodeOp node) { return node.getLevel(); }))
         schedule.setIsLegalAttr(UnitAttr::get(context));
     });
 
+    markAnalysesPreserved<DataflowGraphAnalysis>();
+
     // // Reallocate internal buffers.
     // patterns.clear();
     // patterns.add<AllocateInternalBuffer>(context);
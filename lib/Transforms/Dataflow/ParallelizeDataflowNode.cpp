@@ -9,9 +9,11 @@
 #include "mlir/Dialect/Affine/Utils.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "scalehls/Dialect/HLS/Analysis.h"
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 #include "llvm/Support/Debug.h"
+#include <cmath>
 
 #define DEBUG_TYPE "parallelize-dataflow-node"
 
@@ -79,6 +81,20 @@ struct GenerateBufferLayout
 };
 } // namespace
 
+/// Return the BRAM utilization of the on-chip buffer if it is partitioned into
+/// at least the given number of banks.
+static int64_t getBufferBramNum(BufferOp buffer, unsigned long bankNum) {
+  auto memrefType = buffer.getType().cast<MemRefType>();
+  if (isDram(memrefType) || memrefType.getNumElements() <= 1 ||
+      !memrefType.getElementType().isIntOrFloat())
+    return 0;
+
+  bankNum = std::max(bankNum, (unsigned long)getPartitionFactors(memrefType));
+  int64_t bankSize = memrefType.getElementTypeBitWidth() *
+                     memrefType.getNumElements() / bankNum;
+  return ((bankSize + 18000 - 1) / 18000) * bankNum;
+}
+
 namespace {
 struct ParallelizeDataflowNode
     : public ParallelizeDataflowNodeBase<ParallelizeDataflowNode> {
@@ -91,15 +107,201 @@ struct ParallelizeDataflowNode
     correlationAware = argCorrelationAware;
   }
 
+  /// Estimate the latency, interval, and DSP utilization of all dataflow nodes
+  /// with the target spec. The estimation results are removed from the IR
+  /// afterwards. Return false if the target spec cannot be loaded.
+  bool getNodeLatencyMap(func::FuncOp func) {
+    TargetSpec spec;
+    if (!spec.load(targetSpec))
+      return false;
+    // Each budget is relaxed by 10% as in the design space exploration.
+    maxDspNum = ceil(spec.getConfig()->getInteger("dsp").value_or(220) * 1.1);
+    maxBramNum =
+        ceil(spec.getConfig()->getInteger("bram").value_or(280) * 1.1);
+
+    auto estimator = spec.createEstimator();
+    func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+      estimator->estimateSchedule(schedule);
+      return WalkResult::skip();
+    });
+
+    // If any node failed to be estimated, fall back to the operation counts
+    // of the complexity analysis.
+    nodeLatencyMap.clear();
+    bool estimated = true;
+    func.walk([&](NodeOp node) {
+      auto timing = getTiming(node);
+      auto resource = getResource(node);
+      if (timing && resource) {
+        nodeLatencyMap[node] = std::max(timing.getLatency(), (int64_t)1);
+        nodeIntervalMap[node] = std::max(timing.getInterval(), (int64_t)1);
+        nodeDspMap[node] = resource.getDsp();
+      } else
+        estimated = false;
+    });
+    removeEstimation(func);
+    if (!estimated) {
+      func.emitWarning("failed to estimate dataflow nodes, fall back to "
+                       "operation counts");
+      nodeLatencyMap.clear();
+      nodeIntervalMap.clear();
+      nodeDspMap.clear();
+    }
+    return true;
+  }
+
+  /// Allocate the unroll factors of the nodes in the outermost schedules, such
+  /// that the maximum interval of the nodes, which determines the throughput of
+  /// the schedules, is minimized under the DSP and BRAM budget of the target
+  /// spec. The interval and DSP utilization of each node are assumed to scale
+  /// linearly with its unroll factor, while each buffer is partitioned into as
+  /// many banks as the largest unroll factor of the nodes accessing it. The
+  /// unroll factors are restricted to powers of two, thus the minimized
+  /// maximum interval is optimal among power-of-two factors.
+  void allocateThroughputFactors(func::FuncOp func) {
+    SmallVector<NodeOp, 16> nodes;
+    func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+      llvm::append_range(nodes, schedule.getOps<NodeOp>());
+      return WalkResult::skip();
+    });
+
+    // Collect the buffers accessed by each node. Meanwhile, calculate the
+    // maximum useful unroll factor of each node, which is the total trip count
+    // of its loop band and is bounded by the maximum unroll factor.
+    llvm::MapVector<BufferOp, SmallVector<NodeOp, 4>> bufferNodesMap;
+    llvm::SmallDenseMap<NodeOp, unsigned long> maxFactorMap;
+    for (auto node : nodes) {
+      for (auto operand : node->getOperands())
+        if (auto buffer = operand.getDefiningOp<BufferOp>())
+          bufferNodesMap[buffer].push_back(node);
+      node.walk(
+          [&](BufferOp buffer) { bufferNodesMap[buffer].push_back(node); });
+
+      unsigned long maxFactor = maxUnrollFactor.getValue();
+      if (llvm::hasSingleElement(node.getOps<AffineForOp>())) {
+        unsigned long tripCount = 1;
+        for (auto loop : getNodeLoopBand(node))
+          tripCount *= getAverageTripCount(loop).value_or(1);
+        maxFactor = std::min(maxFactor, tripCount);
+      }
+      maxFactorMap[node] = std::max(maxFactor, 1UL);
+      nodeParallelFactorMap[node] = 1;
+    }
+
+    auto getDspNum = [&]() {
+      int64_t dspNum = 0;
+      for (auto node : nodes)
+        dspNum += nodeDspMap.lookup(node) *
+                  (int64_t)nodeParallelFactorMap.lookup(node);
+      return dspNum;
+    };
+    auto getBramNum = [&]() {
+      int64_t bramNum = 0;
+      for (auto &bufferAndNodes : bufferNodesMap) {
+        unsigned long bankNum = 1;
+        for (auto node : bufferAndNodes.second)
+          bankNum = std::max(bankNum, nodeParallelFactorMap.lookup(node));
+        bramNum += getBufferBramNum(bufferAndNodes.first, bankNum);
+      }
+      return bramNum;
+    };
+
+    // Set the unroll factor of each node to the smallest power of two that
+    // reaches the target interval, bounded by the maximum unroll factor of the
+    // node. Return whether the factors fit in the budget.
+    auto setFactors = [&](int64_t targetInterval) {
+      for (auto node : nodes) {
+        unsigned long factor = llvm::PowerOf2Ceil(
+            llvm::divideCeil(nodeIntervalMap.lookup(node), targetInterval));
+        nodeParallelFactorMap[node] =
+            std::clamp(factor, 1UL, maxFactorMap.lookup(node));
+      }
+      return getDspNum() <= maxDspNum && getBramNum() <= maxBramNum;
+    };
+
+    // The maximum interval of the nodes cannot be lower than the interval of
+    // any node with its maximum unroll factor, and is not higher than the
+    // interval of the slowest node without unrolling.
+    int64_t minInterval = 1;
+    int64_t maxInterval = 1;
+    for (auto node : nodes) {
+      int64_t interval = nodeIntervalMap.lookup(node);
+      minInterval = std::max(
+          minInterval,
+          (int64_t)llvm::divideCeil(interval, maxFactorMap.lookup(node)));
+      maxInterval = std::max(maxInterval, interval);
+    }
+
+    // As the resource utilization never increases with the target interval,
+    // binary search the lowest target interval whose factors fit in the
+    // budget. If even the highest target interval, where no node is unrolled,
+    // exceeds the budget, the nodes are left not unrolled.
+    if (setFactors(maxInterval)) {
+      while (minInterval < maxInterval) {
+        auto targetInterval = minInterval + (maxInterval - minInterval) / 2;
+        if (setFactors(targetInterval))
+          maxInterval = targetInterval;
+        else
+          minInterval = targetInterval + 1;
+      }
+      setFactors(maxInterval);
+    }
+
+    LLVM_DEBUG(
+        // clang-format off
+        for (auto node : nodes) {
+          llvm::dbgs() << "\nNode Interval: " << nodeIntervalMap.lookup(node) << "\n";
+          llvm::dbgs() << "Node Factor: " << nodeParallelFactorMap.lookup(node) << "\n";
+          llvm::dbgs() << "Node at " << node.getLoc() << "\n";
+        }
+        llvm::dbgs() << "DSP: " << getDspNum() << ", BRAM: " << getBramNum() << "\n";
+        // clang-format on
+    );
+  }
+
   /// Try to calculate the unroll factors of the nodes contained in each
   /// dataflow schedule.
   void getNodeParallelFactorMap(func::FuncOp func) {
     auto compAnal = ComplexityAnalysis(func);
     nodeParallelFactorMap.clear();
 
+    // If throughput aware, the nodes of the outermost schedules are allocated
+    // with unroll factors directly, which replaces the manual tuning of their
+    // sub-schedules as well.
+    bool allocated = throughputAware && !nodeIntervalMap.empty();
+    if (allocated)
+      allocateThroughputFactors(func);
+
+    // The estimated node latency is preferred over the operation counts if
+    // available. As nodes are executed in a pipelined manner, the complexity
+    // of a schedule is determined by its slowest node.
+    auto getNodeComplexity = [&](NodeOp node) -> Optional<unsigned long> {
+      if (nodeLatencyMap.empty())
+        return compAnal.getNodeComplexity(node);
+      if (!nodeLatencyMap.count(node))
+        return Optional<unsigned long>();
+      return nodeLatencyMap.lookup(node);
+    };
+    auto getScheduleComplexity =
+        [&](ScheduleOp schedule) -> Optional<unsigned long> {
+      if (nodeLatencyMap.empty())
+        return compAnal.getScheduleComplexity(schedule);
+      unsigned long complexity = 1;
+      for (auto node : schedule.getOps<NodeOp>()) {
+        auto nodeComplexity = getNodeComplexity(node);
+        if (!nodeComplexity)
+          return Optional<unsigned long>();
+        complexity = std::max(complexity, nodeComplexity.value());
+      }
+      return complexity;
+    };
+
     func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
       unsigned long scheduleUnrollFactor = maxUnrollFactor.getValue();
-      if (auto parentNode = schedule->getParentOfType<NodeOp>()) {
+      auto parentNode = schedule->getParentOfType<NodeOp>();
+      if (!parentNode && allocated)
+        return WalkResult::advance();
+      if (parentNode) {
         if (!nodeParallelFactorMap.count(parentNode)) {
           parentNode.emitOpError("failed to get parent node's unroll factor");
           return WalkResult::interrupt();
@@ -107,22 +309,24 @@ struct ParallelizeDataflowNode
         scheduleUnrollFactor = nodeParallelFactorMap.lookup(parentNode);
         // FIXME: A hacky method to hand tune the factors and resolve
         // outstanding dataflow nodes.
-        if (auto attr = schedule->getAttr("increase"))
-          if (auto annoFactor = attr.dyn_cast<IntegerAttr>())
-            scheduleUnrollFactor *= annoFactor.getInt();
-        if (auto attr = schedule->getAttr("decrease"))
-          if (auto annoFactor = attr.dyn_cast<IntegerAttr>())
-            scheduleUnrollFactor /= annoFactor.getInt();
+        if (!allocated) {
+          if (auto attr = schedule->getAttr("increase"))
+            if (auto annoFactor = attr.dyn_cast<IntegerAttr>())
+              scheduleUnrollFactor *= annoFactor.getInt();
+          if (auto attr = schedule->getAttr("decrease"))
+            if (auto annoFactor = attr.dyn_cast<IntegerAttr>())
+              scheduleUnrollFactor /= annoFactor.getInt();
+        }
       }
 
-      auto scheduleComplexity = compAnal.getScheduleComplexity(schedule);
+      auto scheduleComplexity = getScheduleComplexity(schedule);
       if (!scheduleComplexity.has_value()) {
         schedule.emitOpError("failed to get schedule complexity");
         return WalkResult::interrupt();
       }
 
       for (auto node : schedule.getOps<NodeOp>()) {
-        auto nodeComplexity = compAnal.getNodeComplexity(node);
+        auto nodeComplexity = getNodeComplexity(node);
         if (!nodeComplexity.has_value()) {
           node.emitOpError("failed to get node complexity");
           return WalkResult::interrupt();
@@ -320,6 +524,15 @@ struct ParallelizeDataflowNode
   void runOnOperation() override {
     auto func = getOperation();
     auto context = func.getContext();
+    if (throughputAware && targetSpec.empty()) {
+      llvm::errs() << "throughput-aware allocation requires a target spec\n";
+      return signalPassFailure();
+    }
+    nodeLatencyMap.clear();
+    nodeIntervalMap.clear();
+    nodeDspMap.clear();
+    if (!targetSpec.empty() && !getNodeLatencyMap(func))
+      return signalPassFailure();
     getNodeParallelFactorMap(func);
     if (correlationAware)
       applyCorrelationAwareUnroll(func);
@@ -334,6 +547,11 @@ struct ParallelizeDataflowNode
   }
 
 private:
+  llvm::SmallDenseMap<NodeOp, unsigned long> nodeLatencyMap;
+  llvm::SmallDenseMap<NodeOp, unsigned long> nodeIntervalMap;
+  llvm::SmallDenseMap<NodeOp, int64_t> nodeDspMap;
+  int64_t maxDspNum = 220;
+  int64_t maxBramNum = 280;
   llvm::SmallDenseMap<NodeOp, unsigned long> nodeParallelFactorMap;
 };
 } // namespace
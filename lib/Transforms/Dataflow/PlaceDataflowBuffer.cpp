@@ -6,6 +6,7 @@
 
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -13,23 +14,163 @@ using namespace mlir;
 using namespace scalehls;
 using namespace hls;
 
+/// Return the number of accesses to the memory, where each access is weighted
+/// by the trip count of its surrounding loops. Accesses through views, yields,
+/// and dataflow nodes are traced, while other users (e.g., copies and calls)
+/// are assumed to access each element once.
+static int64_t getAccessNum(Value memref) {
+  int64_t accessNum = 0;
+  for (auto &use : memref.getUses()) {
+    auto user = use.getOwner();
+    if (isa<AffineReadOpInterface, AffineWriteOpInterface, memref::LoadOp,
+            memref::StoreOp>(user)) {
+      int64_t tripCount = 1;
+      for (auto loop = user->getParentOfType<AffineForOp>(); loop;
+           loop = loop->getParentOfType<AffineForOp>())
+        tripCount *= getAverageTripCount(loop).value_or(1);
+      accessNum += tripCount;
+    } else if (auto viewLike = dyn_cast<ViewLikeOpInterface>(user)) {
+      if (viewLike.getViewSource() == memref)
+        accessNum += getAccessNum(viewLike->getResult(0));
+    } else if (isa<YieldOp>(user)) {
+      accessNum += getAccessNum(
+          user->getParentOp()->getResult(use.getOperandNumber()));
+    } else if (isa<NodeOp, ScheduleOp>(user)) {
+      accessNum += getAccessNum(
+          user->getRegion(0).getArgument(use.getOperandNumber()));
+    } else if (auto type = memref.getType().dyn_cast<MemRefType>())
+      accessNum += type.getNumElements();
+  }
+  return accessNum;
+}
+
+/// Return the memref type placed in the given kind of memory.
+static MemRefType getPlacedType(MemRefType type, MemoryKind kind) {
+  return MemRefType::get(type.getShape(), type.getElementType(),
+                         type.getLayout().getAffineMap(),
+                         MemoryKindAttr::get(type.getContext(), kind));
+}
+
+/// Solve the 0-1 knapsack problem with dynamic programming over the capacity.
+/// Return whether each item is selected. Items with zero weight are always
+/// selected.
+static SmallVector<bool, 16> solveKnapsack(ArrayRef<int64_t> weights,
+                                           ArrayRef<int64_t> values,
+                                           int64_t capacity) {
+  capacity = std::max(capacity, (int64_t)0);
+  SmallVector<int64_t, 64> totalValues(capacity + 1, 0);
+  SmallVector<SmallVector<bool, 64>, 16> takens;
+  for (unsigned i = 0, e = weights.size(); i < e; ++i) {
+    takens.emplace_back(capacity + 1, false);
+    for (auto c = capacity; c >= weights[i]; --c)
+      if (totalValues[c - weights[i]] + values[i] > totalValues[c]) {
+        totalValues[c] = totalValues[c - weights[i]] + values[i];
+        takens[i][c] = true;
+      }
+  }
+
+  SmallVector<bool, 16> selects(weights.size(), false);
+  for (auto i = (int64_t)weights.size() - 1, c = capacity; i >= 0; --i) {
+    selects[i] = !weights[i] || takens[i][c];
+    if (selects[i])
+      c -= weights[i];
+  }
+  return selects;
+}
+
+/// Select the memory kind of each buffer with 0-1 knapsacks, which keep the
+/// buffers with the maximum accessed bits on chip under the URAM and BRAM
+/// budgets. Large buffers that fill the depth of URAMs are first placed in
+/// URAMs, then the remaining buffers are placed in BRAMs or DRAM. The placement
+/// is reported as a remark attached to the function.
+static void selectBufferKinds(func::FuncOp func, int64_t maxBramNum,
+                              int64_t maxUramNum,
+                              DenseMap<Operation *, MemoryKind> &kinds) {
+  SmallVector<hls::BufferLikeInterface, 16> buffers;
+  SmallVector<int64_t, 16> accessBits;
+  func.walk([&](hls::BufferLikeInterface buffer) {
+    buffers.push_back(buffer);
+    accessBits.push_back(getAccessNum(buffer.getMemref()) *
+                         buffer.getMemrefType().getElementTypeBitWidth());
+  });
+
+  // Collect the URAM candidates and solve the URAM knapsack.
+  SmallVector<unsigned, 16> candidates;
+  SmallVector<int64_t, 16> weights;
+  SmallVector<int64_t, 16> values;
+  for (unsigned i = 0, e = buffers.size(); i < e; ++i) {
+    auto type = buffers[i].getMemrefType();
+    auto depthPerPartition = type.getNumElements() / getPartitionFactors(type);
+    if (maxUramNum <= 0 || depthPerPartition < 4096)
+      continue;
+    auto uramType = getPlacedType(type, MemoryKind::URAM_T2P);
+    candidates.push_back(i);
+    weights.push_back(
+        getMemoryResource(uramType, buffers[i].getBufferDepth()).uram);
+    values.push_back(accessBits[i]);
+  }
+  auto selects = solveKnapsack(weights, values, maxUramNum);
+  int64_t uramNum = 0;
+  for (unsigned i = 0, e = candidates.size(); i < e; ++i)
+    if (selects[i]) {
+      kinds[buffers[candidates[i]]] = MemoryKind::URAM_T2P;
+      uramNum += weights[i];
+    }
+
+  // Solve the BRAM knapsack with the remaining buffers. All of them are placed
+  // on chip if the budget is sufficient.
+  candidates.clear(), weights.clear(), values.clear();
+  int64_t totalBramNum = 0;
+  for (unsigned i = 0, e = buffers.size(); i < e; ++i) {
+    if (kinds.count(buffers[i]))
+      continue;
+    auto type = getPlacedType(buffers[i].getMemrefType(), MemoryKind::BRAM_T2P);
+    candidates.push_back(i);
+    weights.push_back(
+        getMemoryResource(type, buffers[i].getBufferDepth()).bram);
+    values.push_back(accessBits[i]);
+    totalBramNum += weights.back();
+  }
+  selects = totalBramNum > maxBramNum
+                ? solveKnapsack(weights, values, maxBramNum)
+                : SmallVector<bool, 16>(candidates.size(), true);
+  int64_t bramNum = 0;
+  for (unsigned i = 0, e = candidates.size(); i < e; ++i) {
+    kinds[buffers[candidates[i]]] =
+        selects[i] ? MemoryKind::BRAM_T2P : MemoryKind::DRAM;
+    if (selects[i])
+      bramNum += weights[i];
+  }
+
+  auto onChipNum = llvm::count_if(
+      kinds, [](auto &pair) { return pair.second != MemoryKind::DRAM; });
+  func.emitRemark() << "buffer placement: " << onChipNum << "/"
+                    << buffers.size() << " buffers on-chip, bram " << bramNum
+                    << "/" << maxBramNum << ", uram " << uramNum << "/"
+                    << maxUramNum;
+}
+
 namespace {
 struct PlaceBuffer : public OpRewritePattern<func::FuncOp> {
   PlaceBuffer(MLIRContext *context, unsigned threshold,
-              bool placeExternalBuffer)
+              bool placeExternalBuffer,
+              const DenseMap<Operation *, MemoryKind> *kinds = nullptr)
       : OpRewritePattern<func::FuncOp>(context), threshold(threshold),
-        placeExternalBuffer(placeExternalBuffer) {}
-
-  // TODO: For now, we use a heuristic to determine the buffer location.
-  MemRefType getPlacedType(MemRefType type, bool isConstBuffer) const {
-    auto kind = MemoryKind::BRAM_T2P;
-    if (placeExternalBuffer)
-      kind = type.getNumElements() >= threshold ? MemoryKind::DRAM
-                                                : MemoryKind::BRAM_T2P;
-    auto newType = MemRefType::get(
-        type.getShape(), type.getElementType(), type.getLayout().getAffineMap(),
-        MemoryKindAttr::get(type.getContext(), kind));
-    return newType;
+        placeExternalBuffer(placeExternalBuffer), kinds(kinds) {}
+
+  // TODO: For now, we use a heuristic to determine the buffer location if the
+  // memory kinds of buffers are not given.
+  MemoryKind getPlacedKind(MemRefType type, Operation *buffer) const {
+    if (!placeExternalBuffer)
+      return MemoryKind::BRAM_T2P;
+    if (buffer && kinds)
+      return kinds->lookup(buffer);
+    return type.getNumElements() >= threshold ? MemoryKind::DRAM
+                                              : MemoryKind::BRAM_T2P;
+  }
+
+  MemRefType getPlacedType(MemRefType type, Operation *buffer) const {
+    return ::getPlacedType(type, getPlacedKind(type, buffer));
   }
 
   MemRefType getPlacedOnDramType(MemRefType type) const {
@@ -43,11 +184,11 @@ struct PlaceBuffer : public OpRewritePattern<func::FuncOp> {
                                 PatternRewriter &rewriter) const override {
     for (auto arg : func.getArguments())
       if (auto type = arg.getType().dyn_cast<MemRefType>())
-        arg.setType(getPlacedType(type, false));
+        arg.setType(getPlacedType(type, nullptr));
 
     func.walk([&](hls::BufferLikeInterface buffer) {
-      buffer.getMemref().setType(getPlacedType(
-          buffer.getMemrefType(), isa<ConstBufferOp>(buffer.getOperation())));
+      buffer.getMemref().setType(
+          getPlacedType(buffer.getMemrefType(), buffer));
     });
 
     func.walk([](YieldOp yield) {
@@ -65,6 +206,7 @@ struct PlaceBuffer : public OpRewritePattern<func::FuncOp> {
 private:
   unsigned threshold;
   bool placeExternalBuffer;
+  const DenseMap<Operation *, MemoryKind> *kinds;
 };
 } // namespace
 
@@ -95,17 +237,34 @@ struct PlaceDataflowBuffer
     : public PlaceDataflowBufferBase<PlaceDataflowBuffer> {
   PlaceDataflowBuffer() = default;
   explicit PlaceDataflowBuffer(unsigned argThreshold,
-                               bool argPlaceExternalBuffer) {
+                               bool argPlaceExternalBuffer,
+                               bool argCapacityAware,
+                               std::string argTargetSpec) {
     threshold = argThreshold;
     placeExternalBuffer = argPlaceExternalBuffer;
+    capacityAware = argCapacityAware;
+    targetSpec = argTargetSpec;
   }
 
   void runOnOperation() override {
     auto func = getOperation();
     auto context = func.getContext();
 
+    // Select the memory kind of buffers under the BRAM and URAM budgets of the
+    // target device if capacity-aware placement is enabled.
+    DenseMap<Operation *, MemoryKind> kinds;
+    if (placeExternalBuffer && capacityAware) {
+      TargetSpec spec;
+      if (!spec.load(targetSpec))
+        return signalPassFailure();
+      auto config = spec.getConfig();
+      selectBufferKinds(func, config->getInteger("bram").value_or(280),
+                        config->getInteger("uram").value_or(0), kinds);
+    }
+
     mlir::RewritePatternSet patterns(context);
-    patterns.add<PlaceBuffer>(context, threshold, placeExternalBuffer);
+    patterns.add<PlaceBuffer>(context, threshold, placeExternalBuffer,
+                              capacityAware ? &kinds : nullptr);
     (void)applyOpPatternsAndFold(func, std::move(patterns));
 
     patterns.clear();
@@ -115,8 +274,9 @@ struct PlaceDataflowBuffer
 };
 } // namespace
 
-std::unique_ptr<Pass>
-scalehls::createPlaceDataflowBufferPass(unsigned threshold,
-                                        bool placeExternalBuffer) {
-  return std::make_unique<PlaceDataflowBuffer>(threshold, placeExternalBuffer);
+std::unique_ptr<Pass> scalehls::createPlaceDataflowBufferPass(
+    unsigned threshold, bool placeExternalBuffer, bool capacityAware,
+    std::string placeTargetSpec) {
+  return std::make_unique<PlaceDataflowBuffer>(
+      threshold, placeExternalBuffer, capacityAware, placeTargetSpec);
 }
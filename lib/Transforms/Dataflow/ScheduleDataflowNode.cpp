@@ -4,8 +4,8 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include "mlir/IR/Dominance.h"
-#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "scalehls/Dialect/HLS/Analysis.h"
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 
@@ -14,61 +14,260 @@ using namespace scalehls;
 using namespace hls;
 
 namespace {
-struct ALAPScheduleNode : public OpRewritePattern<NodeOp> {
-  ALAPScheduleNode(MLIRContext *context, bool ignoreViolations)
-      : OpRewritePattern<NodeOp>(context), ignoreViolations(ignoreViolations) {}
+/// Schedule the nodes of a dataflow schedule to levels, where each node is
+/// scheduled to a higher level than all its dependent consumers and the sink
+/// nodes are at level 0. Nodes that already have a level are kept untouched.
+/// Nodes with multi-consumer or multi-producer violations, nodes in dependence
+/// cycles, and all nodes depending on them are left unscheduled.
+class LevelScheduler {
+public:
+  explicit LevelScheduler(ScheduleOp schedule, DataflowGraphAnalysis &graph,
+                          bool ignoreViolations);
 
-  LogicalResult matchAndRewrite(NodeOp node,
-                                PatternRewriter &rewriter) const override {
-    if (node.getLevel())
-      return failure();
+  /// Schedule the nodes with the given strategy. The latency of each node is
+  /// only required by the latency-weighted strategy.
+  void schedule(ScheduleStrategy strategy,
+                const DenseMap<Operation *, int64_t> &latencies);
+
+private:
+  void scheduleALAP();
+  void scheduleForward(ScheduleStrategy strategy,
+                       const DenseMap<Operation *, int64_t> &latencies);
 
-    DominanceInfo domInfo;
-    unsigned level = 0;
-    for (auto output : node.getOutputs()) {
-      // Stop to schedule the node if an internal buffer has multi-producer or
+  SmallVector<NodeOp, 16> nodes;
+  SmallVector<SmallVector<unsigned, 4>, 16> succs;
+  SmallVector<SmallVector<unsigned, 4>, 16> preds;
+  SmallVector<bool, 16> violated;
+
+  // The ALAP level of each node, which is the lower bound of its level, and
+  // the scheduled level. A negative level means the node is unschedulable.
+  SmallVector<int64_t, 16> alapLevels;
+  SmallVector<int64_t, 16> levels;
+};
+} // namespace
+
+LevelScheduler::LevelScheduler(ScheduleOp schedule,
+                               DataflowGraphAnalysis &graph,
+                               bool ignoreViolations) {
+  DenseMap<Operation *, unsigned> indexMap;
+  for (auto node : schedule.getOps<NodeOp>()) {
+    indexMap[node] = nodes.size();
+    nodes.push_back(node);
+  }
+  succs.resize(nodes.size());
+  preds.resize(nodes.size());
+  violated.assign(nodes.size(), false);
+
+  for (unsigned index = 0, e = nodes.size(); index < e; ++index)
+    for (auto output : nodes[index].getOutputs()) {
+      // A node cannot be scheduled if an internal buffer has multi-producer or
       // multi-consumer violation. DRAM buffer is not considered - the
       // dependencies associated with them are handled later by tokens.
+      auto consumers = graph.getDependentConsumers(output, nodes[index]);
       if (!isExtBuffer(output) && !ignoreViolations)
-        if (getDependentConsumers(output, node).size() > 1 ||
-            getProducers(output).size() > 1)
-          return failure();
-
-      for (auto consumer : getDependentConsumers(output, node)) {
-        if (!consumer.getLevel())
-          return failure();
-        level = std::max(level, consumer.getLevel().value() + 1);
+        if (consumers.size() > 1 || graph.getProducers(output).size() > 1)
+          violated[index] = true;
+
+      for (auto consumer : consumers) {
+        auto consumerIndex = indexMap.lookup(consumer);
+        succs[index].push_back(consumerIndex);
+        preds[consumerIndex].push_back(index);
       }
     }
-    node.setLevelAttr(rewriter.getI32IntegerAttr(level));
-    return success();
+}
+
+/// Schedule each node right above its highest consumer in a reversed
+/// topological order, which is the same as the original ALAP scheduling.
+void LevelScheduler::scheduleALAP() {
+  alapLevels.assign(nodes.size(), -1);
+  SmallVector<unsigned, 16> pendingNums;
+  SmallVector<unsigned, 16> worklist;
+  for (unsigned i = 0, e = nodes.size(); i < e; ++i) {
+    pendingNums.push_back(succs[i].size());
+    if (succs[i].empty())
+      worklist.push_back(i);
   }
 
-private:
-  bool ignoreViolations;
-};
-} // namespace
+  while (!worklist.empty()) {
+    auto index = worklist.pop_back_val();
+    auto node = nodes[index];
+
+    // A node that has been scheduled is kept untouched. Otherwise, the node is
+    // unschedulable if it has violations or any of its consumers is
+    // unschedulable.
+    int64_t level = violated[index] ? -1 : 0;
+    for (auto succ : succs[index])
+      level = alapLevels[succ] < 0 || level < 0
+                  ? -1
+                  : std::max(level, alapLevels[succ] + 1);
+    if (node.getLevel())
+      level = node.getLevel().value();
+    alapLevels[index] = level;
+
+    for (auto pred : preds[index])
+      if (--pendingNums[pred] == 0)
+        worklist.push_back(pred);
+  }
+}
+
+/// Schedule each node in a topological order, where the level of each node is
+/// selected between its ALAP level and the level right below its lowest
+/// producer. ASAP strategy always selects the highest level, while the
+/// latency-weighted strategy selects the level whose maximum node latency is
+/// least increased, such that the critical path of the schedule, which is the
+/// sum of the maximum node latency of all levels, is minimized.
+void LevelScheduler::scheduleForward(
+    ScheduleStrategy strategy,
+    const DenseMap<Operation *, int64_t> &latencies) {
+  levels.assign(nodes.size(), -1);
+  int64_t maxLevel = 0;
+  for (auto level : alapLevels)
+    maxLevel = std::max(maxLevel, level);
+  SmallVector<int64_t, 16> levelLatencies(maxLevel + 1, 0);
+
+  // Only schedulable nodes are traversed. All consumers of a schedulable node
+  // are schedulable, while its producers may not be.
+  SmallVector<unsigned, 16> pendingNums;
+  SmallVector<unsigned, 16> worklist;
+  for (unsigned i = 0, e = nodes.size(); i < e; ++i) {
+    pendingNums.push_back(llvm::count_if(
+        preds[i], [&](unsigned pred) { return alapLevels[pred] >= 0; }));
+    if (alapLevels[i] >= 0 && pendingNums.back() == 0)
+      worklist.push_back(i);
+  }
+
+  while (!worklist.empty()) {
+    auto index = worklist.pop_back_val();
+    auto node = nodes[index];
+    auto alapLevel = alapLevels[index];
+    auto latency = latencies.lookup(node);
+
+    auto maxAvailLevel = maxLevel;
+    for (auto pred : preds[index])
+      if (levels[pred] >= 0)
+        maxAvailLevel = std::min(maxAvailLevel, levels[pred] - 1);
+
+    auto level = alapLevel;
+    if (node.getLevel())
+      level = node.getLevel().value();
+    else if (strategy == ScheduleStrategy::ASAP)
+      level = std::max(alapLevel, maxAvailLevel);
+    else {
+      // Select the level with the least latency increase. The higher level is
+      // preferred to leave more available levels for the consumers.
+      auto minIncrease = std::numeric_limits<int64_t>::max();
+      for (auto l = maxAvailLevel; l >= alapLevel; --l) {
+        auto increase = std::max(latency - levelLatencies[l], (int64_t)0);
+        if (increase < minIncrease) {
+          minIncrease = increase;
+          level = l;
+        }
+      }
+    }
+    levels[index] = level;
+    if (level <= maxLevel)
+      levelLatencies[level] = std::max(levelLatencies[level], latency);
+
+    for (auto succ : succs[index])
+      if (--pendingNums[succ] == 0)
+        worklist.push_back(succ);
+  }
+}
+
+void LevelScheduler::schedule(ScheduleStrategy strategy,
+                              const DenseMap<Operation *, int64_t> &latencies) {
+  scheduleALAP();
+  if (strategy == ScheduleStrategy::ALAP)
+    levels = alapLevels;
+  else
+    scheduleForward(strategy, latencies);
+
+  if (nodes.empty())
+    return;
+  auto builder = Builder(nodes.front().getContext());
+  for (auto [node, level] : llvm::zip(nodes, levels))
+    if (level >= 0 && !node.getLevel())
+      node.setLevelAttr(builder.getI32IntegerAttr(level));
+}
+
+/// Report the number of nodes and the maximum node latency of each level as
+/// remarks attached to the schedule.
+static void reportLevels(ScheduleOp schedule,
+                         const DenseMap<Operation *, int64_t> &latencies) {
+  std::map<unsigned, std::pair<unsigned, int64_t>> levelMap;
+  unsigned unscheduledNum = 0;
+  for (auto node : schedule.getOps<NodeOp>()) {
+    if (!node.getLevel()) {
+      ++unscheduledNum;
+      continue;
+    }
+    auto &entry = levelMap[node.getLevel().value()];
+    ++entry.first;
+    entry.second = std::max(entry.second, latencies.lookup(node));
+  }
+
+  int64_t criticalPath = 0;
+  for (auto [level, entry] : llvm::reverse(levelMap)) {
+    schedule.emitRemark() << "level " << level << ": " << entry.first
+                          << " nodes, max latency " << entry.second;
+    criticalPath += entry.second;
+  }
+  schedule.emitRemark() << "critical path latency " << criticalPath << ", "
+                        << unscheduledNum << " unscheduled nodes";
+}
 
 namespace {
 struct ScheduleDataflowNode
     : public ScheduleDataflowNodeBase<ScheduleDataflowNode> {
   ScheduleDataflowNode() = default;
-  explicit ScheduleDataflowNode(bool argIgnoreViolations) {
+  explicit ScheduleDataflowNode(bool argIgnoreViolations,
+                                ScheduleStrategy argStrategy, bool argReport,
+                                std::string argTargetSpec) {
     ignoreViolations = argIgnoreViolations;
+    strategy = argStrategy;
+    report = argReport;
+    targetSpec = argTargetSpec;
   }
 
   void runOnOperation() override {
     auto func = getOperation();
-    auto context = func.getContext();
 
-    mlir::RewritePatternSet patterns(context);
-    patterns.add<ALAPScheduleNode>(context, ignoreViolations.getValue());
-    (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
+    // Estimate the latency of each node with the outermost schedules if it is
+    // required by the strategy or the report.
+    DenseMap<Operation *, int64_t> latencies;
+    if (strategy == ScheduleStrategy::Latency || report) {
+      TargetSpec spec;
+      if (!spec.load(targetSpec))
+        return signalPassFailure();
+      auto estimator = spec.createEstimator();
+      func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+        estimator->estimateSchedule(schedule);
+        return WalkResult::skip();
+      });
+      func.walk([&](NodeOp node) {
+        if (auto timing = getTiming(node))
+          latencies[node] = timing.getLatency();
+      });
+      removeEstimation(func);
+    }
+
+    // Scheduling only updates the level of nodes, thus the dataflow graph is
+    // still valid after the pass.
+    auto &graph = getAnalysis<DataflowGraphAnalysis>();
+    func.walk([&](ScheduleOp schedule) {
+      LevelScheduler(schedule, graph, ignoreViolations)
+          .schedule(strategy, latencies);
+      if (report)
+        reportLevels(schedule, latencies);
+    });
+    markAnalysesPreserved<DataflowGraphAnalysis>();
   }
 };
 } // namespace
 
-std::unique_ptr<Pass>
-scalehls::createScheduleDataflowNodePass(bool ignoreViolations) {
-  return std::make_unique<ScheduleDataflowNode>(ignoreViolations);
+std::unique_ptr<Pass> scalehls::createScheduleDataflowNodePass(
+    bool ignoreViolations, ScheduleStrategy strategy, bool report,
+    std::string scheduleTargetSpec) {
+  return std::make_unique<ScheduleDataflowNode>(ignoreViolations, strategy,
+                                                report, scheduleTargetSpec);
 }
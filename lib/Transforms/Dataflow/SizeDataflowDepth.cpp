@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "scalehls/Transforms/Estimator.h"
+#include "scalehls/Transforms/Passes.h"
+#include "scalehls/Transforms/Utils.h"
+
+using namespace mlir;
+using namespace scalehls;
+using namespace hls;
+
+/// Return the minimal depth of the buffer or stream channel, such that the
+/// deepest tap accessed by its consumers is still held.
+static unsigned getMinimalDepth(Value value) {
+  unsigned depth = 1;
+  for (auto &use : value.getUses())
+    if (auto node = dyn_cast<NodeOp>(use.getOwner()))
+      if (use.getOperandNumber() < node.getNumInputs())
+        depth = std::max(depth, node.getInputTap(use.getOperandNumber()) + 1);
+  return depth;
+}
+
+/// Update the type of the stream channel, and the types of all node and
+/// schedule arguments the channel is passed to.
+static void setChannelType(Value channel, Type type) {
+  channel.setType(type);
+  for (auto &use : channel.getUses())
+    if (isa<NodeOp, ScheduleOp>(use.getOwner()))
+      setChannelType(
+          use.getOwner()->getRegion(0).getArgument(use.getOperandNumber()),
+          type);
+}
+
+namespace {
+struct SizeDataflowDepth : public SizeDataflowDepthBase<SizeDataflowDepth> {
+  SizeDataflowDepth() = default;
+  SizeDataflowDepth(std::string sizeTargetSpec) { targetSpec = sizeTargetSpec; }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    TargetSpec spec;
+    if (!spec.load(targetSpec))
+      return signalPassFailure();
+
+    // Estimate the outermost schedules, where each stream channel is annotated
+    // with the depth required by the token rates of its producer and consumer.
+    auto estimator = spec.createEstimator();
+    func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+      estimator->estimateSchedule(schedule);
+      return WalkResult::skip();
+    });
+    auto originalBramNum = estimator->estimateBram(func);
+
+    llvm::SmallDenseMap<StreamOp, unsigned> requiredDepthMap;
+    func.walk([&](StreamOp stream) {
+      if (auto attr = stream->getAttrOfType<IntegerAttr>("required_depth"))
+        requiredDepthMap[stream] = attr.getInt();
+    });
+    removeEstimation(func);
+
+    // Size each stream channel with the depth required by the token rates.
+    // Streams that are not estimated, e.g., streams crossing schedules, are
+    // only deepened if their taps are not held.
+    OpBuilder builder(func);
+    func.walk([&](StreamOp stream) {
+      auto depth = getMinimalDepth(stream.getChannel());
+      if (requiredDepthMap.count(stream))
+        depth = std::max(depth, requiredDepthMap.lookup(stream));
+      else
+        depth = std::max(depth, stream.getDepth());
+      if (depth == stream.getDepth())
+        return;
+
+      auto type = stream.getChannel().getType().cast<StreamType>();
+      setChannelType(stream.getChannel(),
+                     StreamType::get(type.getContext(), type.getElementType(),
+                                     depth));
+      stream.setDepthAttr(builder.getI32IntegerAttr(depth));
+    });
+
+    // A multi-stage buffer only needs to hold the deepest tap accessed by its
+    // consumers. Any additional stage is never accessed.
+    func.walk([&](BufferOp buffer) {
+      auto depth = getMinimalDepth(buffer.getMemref());
+      if (depth < buffer.getDepth())
+        buffer.setDepthAttr(builder.getI32IntegerAttr(depth));
+    });
+
+    // Deepening streams may take more BRAMs than shrinking buffers saves, thus
+    // the BRAM utilization before and after the sizing is reported.
+    func.emitRemark() << "dataflow depth sizing changed BRAM utilization from "
+                      << originalBramNum << " to "
+                      << estimator->estimateBram(func);
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass>
+scalehls::createSizeDataflowDepthPass(std::string sizeTargetSpec) {
+  return std::make_unique<SizeDataflowDepth>(sizeTargetSpec);
+}
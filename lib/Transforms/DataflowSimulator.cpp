@@ -0,0 +1,369 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "scalehls/Transforms/Simulator.h"
+#include "llvm/Support/Format.h"
+#include <queue>
+
+using namespace mlir;
+using namespace scalehls;
+using namespace hls;
+
+const NodeSimResult *ScheduleSimResult::getBottleneck() const {
+  auto getRank = [](const NodeSimResult &node) {
+    return std::make_pair(node.busyCycles + node.stalledCycles,
+                          -node.stalledCycles);
+  };
+  const NodeSimResult *bottleneck = nullptr;
+  for (auto &node : nodes)
+    if (!bottleneck || getRank(node) > getRank(*bottleneck))
+      bottleneck = &node;
+  return bottleneck;
+}
+
+//===----------------------------------------------------------------------===//
+// DataflowSimulation Class Definition
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A buffer or stream channel connecting dataflow nodes in the simulation.
+struct SimChannel {
+  bool isStream = false;
+  int64_t depth = 1;
+  SmallVector<unsigned, 2> producers;
+  SmallVector<unsigned, 2> consumers;
+
+  /// The number of tokens held by a stream channel.
+  int64_t tokenNum = 0;
+
+  /// The number of frames committed by all producers of a buffer, and the
+  /// number of frames released by each consumer of the buffer.
+  int64_t committedNum = 0;
+  SmallVector<int64_t, 2> releasedNums;
+
+  /// The nodes waiting for the state of the channel to be changed.
+  SmallVector<unsigned, 4> waiters;
+};
+
+/// A stream access of a dataflow node, where the offset is the cycle relative
+/// to the beginning of each frame.
+struct SimAccess {
+  int64_t offset;
+  unsigned channel;
+  bool isPush;
+};
+
+/// A dataflow node in the simulation and its execution states.
+struct SimNode {
+  NodeSimResult result;
+  SmallVector<std::pair<unsigned, unsigned>, 4> inputBuffers;
+  SmallVector<unsigned, 4> outputBuffers;
+  SmallVector<SimAccess, 16> accesses;
+
+  int64_t frame = 0;
+  int64_t committedFrame = 0;
+  bool running = false;
+  unsigned accessIdx = 0;
+  int64_t frameBegin = 0;
+  int64_t stallCycles = 0;
+  int64_t waitBegin = 0;
+  bool waitBlocked = false;
+};
+
+class DataflowSimulation {
+public:
+  explicit DataflowSimulation(unsigned frameNum)
+      : frameNum(frameNum), frameEnds(frameNum, 0) {}
+
+  LogicalResult build(ScheduleOp schedule);
+  void run();
+  void getResult(ScheduleSimResult &result);
+
+private:
+  /// Events happening at the same cycle are handled in the order of their
+  /// kinds, where committed buffers are visible to the stepped nodes.
+  enum class EventKind { COMMIT, STEP };
+  using Event = std::tuple<int64_t, EventKind, unsigned>;
+
+  void push(int64_t time, EventKind kind, unsigned nodeIdx) {
+    events.push({time, kind, nodeIdx});
+  }
+  void wait(unsigned nodeIdx, unsigned channelIdx, int64_t time,
+            bool blocked);
+  void wake(unsigned channelIdx, int64_t time);
+  void commit(unsigned nodeIdx, int64_t time);
+  void step(unsigned nodeIdx, int64_t time);
+
+  unsigned frameNum;
+  SmallVector<int64_t, 8> frameEnds;
+  int64_t currentTime = 0;
+
+  SmallVector<SimNode, 16> nodes;
+  SmallVector<SimChannel, 32> channels;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+};
+} // namespace
+
+LogicalResult DataflowSimulation::build(ScheduleOp schedule) {
+  for (auto node : schedule.getOps<NodeOp>()) {
+    auto timing = getTiming(node);
+    if (!timing)
+      return node.emitOpError("failed to estimate the node");
+
+    SimNode simNode;
+    simNode.result.node = node;
+    simNode.result.latency = std::max(timing.getLatency(), (int64_t)1);
+    simNode.result.interval =
+        std::clamp(timing.getInterval(), (int64_t)1, simNode.result.latency);
+    nodes.push_back(simNode);
+  }
+
+  // Collect the buffers and stream channels accessed by the nodes. Each stream
+  // access is assigned with a cycle offset, such that tokens are popped from
+  // the beginning and pushed until the end of the node interval.
+  llvm::SmallDenseMap<Value, unsigned, 32> channelMap;
+  for (unsigned nodeIdx = 0, e = nodes.size(); nodeIdx < e; ++nodeIdx) {
+    auto &simNode = nodes[nodeIdx];
+    auto node = simNode.result.node;
+    auto interval = simNode.result.interval;
+
+    for (auto &operand : node->getOpOperands()) {
+      auto kind = node.getOperandKind(operand);
+      auto value = operand.get();
+      auto isStream = value.getType().isa<StreamType>();
+      if (kind == OperandKind::PARAM ||
+          !(isStream || value.getType().isa<MemRefType>()))
+        continue;
+
+      if (!channelMap.count(value)) {
+        SimChannel channel;
+        channel.isStream = isStream;
+        if (isStream)
+          channel.depth = value.getType().cast<StreamType>().getDepth();
+        else if (auto buffer = value.getDefiningOp<BufferOp>())
+          channel.depth = buffer.getDepth();
+        channel.depth = std::max(channel.depth, (int64_t)1);
+        channelMap[value] = channels.size();
+        channels.push_back(channel);
+      }
+      auto channelIdx = channelMap.lookup(value);
+      auto &channel = channels[channelIdx];
+      auto isOutput = kind == OperandKind::OUTPUT;
+
+      if (isOutput)
+        channel.producers.push_back(nodeIdx);
+      else
+        channel.consumers.push_back(nodeIdx);
+
+      if (isStream) {
+        auto arg = node.getBody().getArgument(operand.getOperandNumber());
+        auto tokenNum = getStreamTokenNum(arg, isOutput);
+        if (!tokenNum)
+          return node.emitOpError("failed to count the tokens of stream ")
+                 << value;
+
+        for (int64_t i = 0, num = tokenNum.value(); i < num; ++i) {
+          auto offset =
+              isOutput ? (i + 1) * interval / num : i * interval / num;
+          simNode.accesses.push_back({offset, channelIdx, isOutput});
+        }
+      } else if (isOutput)
+        simNode.outputBuffers.push_back(channelIdx);
+      else {
+        simNode.inputBuffers.push_back(
+            {channelIdx, channel.releasedNums.size()});
+        channel.releasedNums.push_back(0);
+      }
+    }
+    llvm::stable_sort(simNode.accesses, [](const auto &a, const auto &b) {
+      return a.offset < b.offset;
+    });
+  }
+  return success();
+}
+
+void DataflowSimulation::wait(unsigned nodeIdx, unsigned channelIdx,
+                              int64_t time, bool blocked) {
+  auto &node = nodes[nodeIdx];
+  node.waitBegin = time;
+  node.waitBlocked = blocked;
+  channels[channelIdx].waiters.push_back(nodeIdx);
+}
+
+void DataflowSimulation::wake(unsigned channelIdx, int64_t time) {
+  auto waiters = std::move(channels[channelIdx].waiters);
+  channels[channelIdx].waiters.clear();
+  for (auto nodeIdx : waiters) {
+    auto &node = nodes[nodeIdx];
+    auto cycles = time - node.waitBegin;
+    if (node.waitBlocked)
+      node.result.blockedCycles += cycles;
+    else
+      node.result.starvedCycles += cycles;
+    if (node.running) {
+      node.stallCycles += cycles;
+      node.result.stalledCycles += cycles;
+    }
+    push(time, EventKind::STEP, nodeIdx);
+  }
+}
+
+void DataflowSimulation::commit(unsigned nodeIdx, int64_t time) {
+  auto &node = nodes[nodeIdx];
+  for (auto channelIdx : node.outputBuffers) {
+    channels[channelIdx].committedNum++;
+    wake(channelIdx, time);
+  }
+  auto &frameEnd = frameEnds[node.committedFrame++];
+  frameEnd = std::max(frameEnd, time);
+}
+
+void DataflowSimulation::step(unsigned nodeIdx, int64_t time) {
+  auto &node = nodes[nodeIdx];
+  if (!node.running) {
+    if (node.frame == (int64_t)frameNum)
+      return;
+
+    // Wait until all producers of the input buffers have committed the current
+    // frame, and the output buffers have free stages to be written.
+    for (auto [channelIdx, consumerIdx] : node.inputBuffers) {
+      auto &channel = channels[channelIdx];
+      if (channel.producers.empty() ||
+          llvm::is_contained(channel.producers, nodeIdx))
+        continue;
+      if (channel.committedNum <
+          (node.frame + 1) * (int64_t)channel.producers.size())
+        return wait(nodeIdx, channelIdx, time, /*blocked=*/false);
+    }
+    for (auto channelIdx : node.outputBuffers) {
+      auto &channel = channels[channelIdx];
+      if (channel.releasedNums.empty())
+        continue;
+      auto releasedNum = *std::min_element(channel.releasedNums.begin(),
+                                           channel.releasedNums.end());
+      if (node.frame - releasedNum >= channel.depth)
+        return wait(nodeIdx, channelIdx, time, /*blocked=*/true);
+    }
+
+    node.running = true;
+    node.accessIdx = 0;
+    node.frameBegin = time;
+    node.stallCycles = 0;
+  }
+
+  // Access the stream channels in the order of their offsets. The node stalls
+  // if the channel is empty when popping or full when pushing.
+  while (node.accessIdx < node.accesses.size()) {
+    auto &access = node.accesses[node.accessIdx];
+    auto accessTime = node.frameBegin + node.stallCycles + access.offset;
+    if (accessTime > time)
+      return push(accessTime, EventKind::STEP, nodeIdx);
+
+    auto &channel = channels[access.channel];
+    if (access.isPush ? channel.tokenNum >= channel.depth
+                      : channel.tokenNum <= 0)
+      return wait(nodeIdx, access.channel, time, /*blocked=*/access.isPush);
+    channel.tokenNum += access.isPush ? 1 : -1;
+    node.accessIdx++;
+    wake(access.channel, time);
+  }
+
+  auto frameBegin = node.frameBegin + node.stallCycles;
+  auto frameEnd = frameBegin + node.result.interval;
+  if (frameEnd > time)
+    return push(frameEnd, EventKind::STEP, nodeIdx);
+
+  // Release the input buffers once the frame is finished. The output buffers
+  // are committed after the latency of the node.
+  for (auto [channelIdx, consumerIdx] : node.inputBuffers) {
+    channels[channelIdx].releasedNums[consumerIdx]++;
+    wake(channelIdx, time);
+  }
+  push(std::max(time, frameBegin + node.result.latency), EventKind::COMMIT,
+       nodeIdx);
+
+  node.result.busyCycles += node.result.interval;
+  node.running = false;
+  node.frame++;
+  push(time, EventKind::STEP, nodeIdx);
+}
+
+void DataflowSimulation::run() {
+  for (unsigned nodeIdx = 0, e = nodes.size(); nodeIdx < e; ++nodeIdx)
+    push(0, EventKind::STEP, nodeIdx);
+
+  while (!events.empty()) {
+    auto [time, kind, nodeIdx] = events.top();
+    events.pop();
+    currentTime = time;
+    if (kind == EventKind::COMMIT)
+      commit(nodeIdx, time);
+    else
+      step(nodeIdx, time);
+  }
+}
+
+void DataflowSimulation::getResult(ScheduleSimResult &result) {
+  result.frameNum = frameNum;
+  result.deadlock = llvm::any_of(
+      nodes, [&](const SimNode &n) { return n.frame < (int64_t)frameNum; });
+  result.latency = result.deadlock ? currentTime : frameEnds.back();
+  result.interval = result.latency;
+  if (frameNum > 1 && !result.deadlock)
+    result.interval = (frameEnds.back() - frameEnds.front()) / (frameNum - 1);
+  for (auto &node : nodes)
+    result.nodes.push_back(node.result);
+}
+
+//===----------------------------------------------------------------------===//
+// Entry of scalehls-sim
+//===----------------------------------------------------------------------===//
+
+FailureOr<ScheduleSimResult>
+scalehls::simulateSchedule(ScheduleOp schedule, ScaleHLSEstimator &estimator,
+                           unsigned frameNum) {
+  frameNum = std::max(frameNum, 1u);
+  estimator.estimateSchedule(schedule);
+
+  DataflowSimulation simulation(frameNum);
+  if (failed(simulation.build(schedule)))
+    return failure();
+  simulation.run();
+
+  ScheduleSimResult result;
+  result.schedule = schedule;
+  simulation.getResult(result);
+  return result;
+}
+
+void scalehls::printSimulationReport(const ScheduleSimResult &result,
+                                     raw_ostream &os) {
+  os << "Schedule at " << result.schedule.getLoc() << "\n";
+  os << "  Frames: " << result.frameNum << ", latency: " << result.latency
+     << " cycles, interval: " << result.interval << " cycles\n";
+  if (result.deadlock)
+    os << "  Deadlock: not all frames are finished\n";
+
+  auto latency = std::max(result.latency, (int64_t)1);
+  os << llvm::format("  %-6s %-6s %10s %10s %12s %12s %12s %12s %7s\n",
+                     "Node", "Level", "Latency", "Interval", "Busy", "Stalled",
+                     "Starved", "Blocked", "Util");
+  for (unsigned idx = 0, e = result.nodes.size(); idx < e; ++idx) {
+    auto &node = result.nodes[idx];
+    auto level = node.node.getLevel();
+    os << llvm::format(
+        "  #%-5u %-6s %10lld %10lld %12lld %12lld %12lld %12lld %6.1f%%\n",
+        idx, level ? std::to_string(level.value()).c_str() : "-",
+        (long long)node.latency, (long long)node.interval,
+        (long long)node.busyCycles, (long long)node.stalledCycles,
+        (long long)node.starvedCycles, (long long)node.blockedCycles,
+        node.busyCycles * 100.0 / latency);
+  }
+
+  if (auto bottleneck = result.getBottleneck())
+    os << "  Bottleneck: node #" << bottleneck - result.nodes.begin() << " at "
+       << bottleneck->node.getLoc() << "\n";
+}
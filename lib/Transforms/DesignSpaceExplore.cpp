@@ -6,61 +6,467 @@
 
 #include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
 #include "mlir/Dialect/Affine/Analysis/Utils.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Support/FileUtilities.h"
 #include "scalehls/Transforms/Explorer.h"
 #include "scalehls/Transforms/Passes.h"
+#include "scalehls/Translation/EmitHLSCpp.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
-#include <numeric>
-// #include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
 #define DEBUG_TYPE "scalehls"
 
 using namespace mlir;
 using namespace scalehls;
 
+/// Return whether the objectives "a" dominate the objectives "b", i.e., "a" is
+/// not worse than "b" in all objectives and is better in at least one of them.
+static bool dominates(const DesignObjectives &a, const DesignObjectives &b) {
+  for (unsigned i = 0, e = a.size(); i < e; ++i)
+    if (a[i] > b[i])
+      return false;
+  return a != b;
+}
+
 /// Update paretoPoints to remove design points that are not pareto frontiers.
 template <typename DesignPointType>
 static void updateParetoPoints(SmallVector<DesignPointType, 16> &paretoPoints) {
-  // Sort the pareto points with in an ascending order of latency and the an
-  // ascending order of dsp number.
-  auto latencyThenDspNum = [&](const DesignPointType &a,
-                               const DesignPointType &b) {
-    return (a.latency < b.latency ||
-            (a.latency == b.latency && a.dspNum < b.dspNum));
+  // Sort the pareto points in a lexicographical order of the objectives. After
+  // the sorting, a design point can only be dominated by the points before it.
+  llvm::stable_sort(paretoPoints, [&](const DesignPointType &a,
+                                      const DesignPointType &b) {
+    return a.getObjectives() < b.getObjectives();
+  });
+
+  // Find pareto frontiers. If a design point is dominated by any point before
+  // it, it must also be dominated by one of the frontiers found so far.
+  SmallVector<DesignPointType, 16> frontiers;
+  for (auto &point : paretoPoints) {
+    auto objectives = point.getObjectives();
+    if (llvm::none_of(frontiers, [&](const DesignPointType &frontier) {
+          return dominates(frontier.getObjectives(), objectives);
+        }))
+      frontiers.push_back(point);
+  }
+
+  paretoPoints = frontiers;
+}
+
+//===----------------------------------------------------------------------===//
+// NeighborIndex Class Definition
+//===----------------------------------------------------------------------===//
+
+NeighborIndex::NeighborIndex(unsigned dimNum, float maxDistance)
+    : dimNum(dimNum), maxDistance(maxDistance) {
+  int32_t radius = std::max(maxDistance, 0.0f);
+
+  // Collect all offsets in the ball with their squared length.
+  SmallVector<std::pair<int64_t, unsigned>, 64> offsetLengths;
+  SmallVector<int32_t, 64> unsortedOffsets;
+  SmallVector<int32_t, 8> offset(dimNum, 0);
+
+  std::function<void(unsigned, int64_t)> walk = [&](unsigned dim,
+                                                    int64_t lengthSquare) {
+    if (dim == dimNum) {
+      if (lengthSquare == 0)
+        return;
+      offsetLengths.push_back({lengthSquare, (unsigned)offsetLengths.size()});
+      unsortedOffsets.append(offset.begin(), offset.end());
+      return;
+    }
+    for (int32_t delta = -radius; delta <= radius; ++delta) {
+      auto newLengthSquare = lengthSquare + (int64_t)delta * delta;
+      if (sqrtf(newLengthSquare) > maxDistance)
+        continue;
+      offset[dim] = delta;
+      walk(dim + 1, newLengthSquare);
+    }
+    offset[dim] = 0;
   };
-  llvm::sort(paretoPoints, latencyThenDspNum);
+  walk(0, 0);
+
+  // Group the offsets into shells in an ascending order of length, where the
+  // order of offsets in each shell is kept for determinism.
+  llvm::stable_sort(offsetLengths, [](auto &a, auto &b) {
+    return a.first < b.first;
+  });
+  for (auto [lengthSquare, idx] : offsetLengths) {
+    if (shellDistances.empty() ||
+        sqrtf(lengthSquare) != shellDistances.back()) {
+      shellBegins.push_back(offsets.size() / std::max(dimNum, 1u));
+      shellDistances.push_back(sqrtf(lengthSquare));
+    }
+    auto begin = unsortedOffsets.begin() + idx * dimNum;
+    offsets.append(begin, begin + dimNum);
+  }
+  shellBegins.push_back(offsets.size() / std::max(dimNum, 1u));
+}
 
-  // Find pareto frontiers. After the sorting, the first design point must be a
-  // pareto point.
-  auto paretoPoint = paretoPoints[0];
-  auto paretoLatency = paretoPoint.latency;
-  auto paretoDspNum = paretoPoint.dspNum;
-  SmallVector<DesignPointType, 16> frontiers;
+//===----------------------------------------------------------------------===//
+// DSECheckpoint Class Definition
+//===----------------------------------------------------------------------===//
 
-  for (auto point : paretoPoints) {
-    auto tmpLatency = point.latency;
-    auto tmpDspNum = point.dspNum;
+/// The number of values of an estimation record in each checkpoint row, which
+/// are latency, interval, DSP, BRAM, URAM, and LUT.
+static constexpr unsigned checkpointRecordSize = 6;
+static constexpr int64_t checkpointVersion = 4;
+
+/// Restore the checkpoint from the file. The checkpoint file is composed of
+/// lines of JSON objects, where the first line holds the version and key, and
+/// each following line holds the name of a loop band and a row composed of the
+/// digits of a tile config and the values of its estimation record. An
+/// incomplete line at the end of the file, e.g., left by a killed exploration,
+/// is ignored and truncated from the file.
+bool DSECheckpoint::restore(std::string &errorMessage) {
+  bandRecords.clear();
+  unsavedRecords.clear();
+  isFileReady = false;
+
+  auto buffer = llvm::MemoryBuffer::getFile(filePath);
+  if (!buffer) {
+    errorMessage = "failed to read the checkpoint file";
+    return false;
+  }
+  auto data = buffer.get()->getBuffer();
 
-    if (tmpDspNum < paretoDspNum) {
-      frontiers.push_back(point);
+  unsigned lineNum = 0;
+  size_t validSize = 0;
+  auto setError = [&](const Twine &message) {
+    errorMessage = ("line " + Twine(lineNum) + ": " + message).str();
+    bandRecords.clear();
+    return false;
+  };
+
+  while (validSize < data.size()) {
+    auto lineEnd = data.find('\n', validSize);
+    if (lineEnd == StringRef::npos)
+      break;
+    auto line = data.slice(validSize, lineEnd);
+    validSize = lineEnd + 1;
+    ++lineNum;
+
+    auto json = llvm::json::parse(line);
+    if (!json) {
+      llvm::consumeError(json.takeError());
+      return setError("malformed JSON");
+    }
+    auto lineObj = json->getAsObject();
+    if (!lineObj)
+      return setError("expected a JSON object");
+
+    // The first line is the header of the checkpoint.
+    if (lineNum == 1) {
+      auto version = lineObj->getInteger("version");
+      auto fileKey = lineObj->getString("key");
+      if (version != checkpointVersion || !fileKey || fileKey.value() != key) {
+        errorMessage = "the checkpoint is saved by a different exploration";
+        return false;
+      }
+      continue;
+    }
 
-      paretoPoint = point;
-      paretoLatency = tmpLatency;
-      paretoDspNum = tmpDspNum;
+    auto band = lineObj->getString("band");
+    auto values = lineObj->getArray("row");
+    if (!band || !values)
+      return setError("expected a band name and a row");
+    if (values->size() <= checkpointRecordSize)
+      return setError("expected at least one digit in the row");
+
+    SmallVector<int64_t, 16> ints;
+    for (auto &value : *values) {
+      auto integer = value.getAsInteger();
+      if (!integer)
+        return setError("expected integers in the row");
+      ints.push_back(integer.value());
+    }
 
-    } else if (tmpDspNum == paretoDspNum && tmpLatency == paretoLatency)
-      frontiers.push_back(point);
+    auto digitNum = values->size() - checkpointRecordSize;
+    SmallVector<unsigned, 8> digits;
+    for (auto digit : llvm::make_range(ints.begin(), ints.begin() + digitNum)) {
+      if (digit < 0 || digit >= TileConfig::maxRadix)
+        return setError("digit " + Twine(digit) + " is out of range");
+      digits.push_back(digit);
+    }
+
+    auto &records = bandRecords[band.value()];
+    if (!records.empty() && records.begin()->first.size() != digitNum)
+      return setError("expected " + Twine(records.begin()->first.size()) +
+                      " digits in the row of band \"" + band.value() + "\"");
+
+    EstimationRecord record;
+    record.latency = ints[digitNum];
+    record.interval = ints[digitNum + 1];
+    record.dsp = ints[digitNum + 2];
+    record.bram = ints[digitNum + 3];
+    record.uram = ints[digitNum + 4];
+    record.lut = ints[digitNum + 5];
+    records[TileConfig(digits)] = record;
   }
 
-  paretoPoints = frontiers;
+  if (lineNum == 0) {
+    errorMessage = "the checkpoint is empty";
+    return false;
+  }
+
+  // Drop the incomplete line at the end of the file, such that new rows are
+  // appended at a line boundary.
+  if (validSize < data.size()) {
+    int fd;
+    if (llvm::sys::fs::openFileForReadWrite(filePath, fd,
+                                            llvm::sys::fs::CD_OpenExisting,
+                                            llvm::sys::fs::OF_None))
+      return setError("failed to open the checkpoint file");
+    auto ec = llvm::sys::fs::resize_file(fd, validSize);
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    if (ec)
+      return setError("failed to truncate the checkpoint file");
+  }
+
+  isFileReady = true;
+  return true;
+}
+
+/// Verify the records of the loop band against the number of valid tile sizes
+/// of each loop. Mismatched records are dropped.
+bool DSECheckpoint::verifyBand(StringRef bandName, ArrayRef<unsigned> radices) {
+  auto band = bandRecords.find(bandName);
+  if (band == bandRecords.end())
+    return true;
+
+  for (auto &entry : band->second) {
+    auto &config = entry.first;
+    bool isValid = config.size() == radices.size();
+    for (unsigned i = 0, e = config.size(); isValid && i < e; ++i)
+      isValid = config[i] < radices[i];
+    if (!isValid) {
+      bandRecords.erase(band);
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Append all unsaved rows to the checkpoint file. If the file has not been
+/// written by this exploration and is not restored, it is overwritten with a
+/// new header. As rows are only appended, the cost of each save is
+/// proportional to the number of unsaved rows.
+bool DSECheckpoint::save() {
+  if (isFileReady && unsavedRecords.empty())
+    return true;
+
+  std::error_code ec;
+  llvm::raw_fd_ostream os(filePath, ec,
+                          isFileReady ? llvm::sys::fs::OF_Append
+                                      : llvm::sys::fs::OF_None);
+  if (ec)
+    return false;
+
+  if (!isFileReady)
+    os << llvm::json::Value(llvm::json::Object{{"version", checkpointVersion},
+                                               {"key", key}})
+       << "\n";
+
+  for (auto &[bandName, config, record] : unsavedRecords) {
+    llvm::json::Array row;
+    for (auto digit : config.getDigits())
+      row.push_back((int64_t)digit);
+    row.push_back(record.latency);
+    row.push_back(record.interval);
+    row.push_back(record.dsp);
+    row.push_back(record.bram);
+    row.push_back(record.uram);
+    row.push_back(record.lut);
+    os << llvm::json::Value(
+              llvm::json::Object{{"band", bandName}, {"row", std::move(row)}})
+       << "\n";
+  }
+
+  os.flush();
+  if (os.has_error()) {
+    os.clear_error();
+    return false;
+  }
+
+  isFileReady = true;
+  unsavedRecords.clear();
+  return true;
+}
+
+/// Look up the estimation record of a tile config of the given loop band.
+Optional<EstimationRecord>
+DSECheckpoint::lookup(StringRef bandName, const TileConfig &config) const {
+  auto band = bandRecords.find(bandName);
+  if (band == bandRecords.end())
+    return Optional<EstimationRecord>();
+  auto record = band->second.find(config);
+  if (record == band->second.end())
+    return Optional<EstimationRecord>();
+  return record->second;
+}
+
+/// Insert the estimation record of a tile config of the given loop band.
+void DSECheckpoint::insert(StringRef bandName, const TileConfig &config,
+                           EstimationRecord record) {
+  if (!bandRecords[bandName].insert({config, record}).second)
+    return;
+  unsavedRecords.push_back({bandName.str(), config, record});
+  if (unsavedRecords.size() >= saveInterval)
+    save();
+}
+
+//===----------------------------------------------------------------------===//
+// DesignPointWriter Class Definition
+//===----------------------------------------------------------------------===//
+
+/// The design point file starts with a magic number and the column names, and
+/// is followed by chunks. Each chunk is composed of the number of rows and the
+/// values of each column. All integers are in little-endian.
+static constexpr StringLiteral designPointMagic = "SHLSDSP2";
+
+DesignPointWriter::DesignPointWriter(StringRef filePath,
+                                     ArrayRef<std::string> columnNames,
+                                     unsigned chunkSize)
+    : filePath(filePath), numColumns(columnNames.size()),
+      chunkSize(std::max(chunkSize, 1u)) {
+  std::error_code ec;
+  os = std::make_unique<llvm::raw_fd_ostream>(filePath, ec);
+  if (ec) {
+    os.reset();
+    return;
+  }
+
+  // Write the header of the file.
+  llvm::support::endian::Writer writer(*os, llvm::support::little);
+  *os << designPointMagic;
+  writer.write<uint32_t>(numColumns);
+  for (auto &name : columnNames) {
+    writer.write<uint32_t>(name.size());
+    *os << name;
+  }
+  os->flush();
+}
+
+void DesignPointWriter::append(ArrayRef<int64_t> row) {
+  assert(row.size() == numColumns && "invalid design point row");
+  if (!os)
+    return;
+  rows.append(row.begin(), row.end());
+  if (rows.size() >= chunkSize * numColumns)
+    flush();
+}
+
+/// Flush all buffered rows to the file as a new chunk.
+void DesignPointWriter::flush() {
+  if (!os || rows.empty())
+    return;
+
+  // Transpose the buffered rows into columns.
+  unsigned numRows = rows.size() / numColumns;
+  llvm::support::endian::Writer writer(*os, llvm::support::little);
+  writer.write<uint32_t>(numRows);
+  for (unsigned col = 0; col < numColumns; ++col)
+    for (unsigned row = 0; row < numRows; ++row)
+      writer.write<int64_t>(rows[row * numColumns + col]);
+
+  os->flush();
+  rows.clear();
+}
+
+/// Read all complete chunks of the design point file written by
+/// DesignPointWriter, and call "callback" with each row.
+LogicalResult
+scalehls::readDesignPoints(StringRef filePath,
+                           SmallVectorImpl<std::string> &columnNames,
+                           function_ref<void(ArrayRef<int64_t>)> callback) {
+  auto buffer = llvm::MemoryBuffer::getFile(
+      filePath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return failure();
+  auto data = buffer.get()->getBuffer();
+
+  // Read the header of the file.
+  if (!data.consume_front(designPointMagic) || data.size() < 4)
+    return failure();
+  auto numColumns = llvm::support::endian::read32le(data.data());
+  data = data.drop_front(4);
+
+  columnNames.clear();
+  for (unsigned col = 0; col < numColumns; ++col) {
+    if (data.size() < 4)
+      return failure();
+    auto length = llvm::support::endian::read32le(data.data());
+    data = data.drop_front(4);
+    if (data.size() < length)
+      return failure();
+    columnNames.push_back(data.take_front(length).str());
+    data = data.drop_front(length);
+  }
+
+  // Read chunks until the end of the file or an incomplete chunk.
+  SmallVector<int64_t, 16> row(numColumns);
+  while (data.size() >= 4) {
+    uint64_t numRows = llvm::support::endian::read32le(data.data());
+    uint64_t chunkBytes = numRows * numColumns * 8;
+    if (data.size() - 4 < chunkBytes)
+      break;
+
+    auto values = data.data() + 4;
+    for (uint64_t r = 0; r < numRows; ++r) {
+      for (uint64_t col = 0; col < numColumns; ++col)
+        row[col] = llvm::support::endian::read64le(values +
+                                                   (col * numRows + r) * 8);
+      callback(row);
+    }
+    data = data.drop_front(4 + chunkBytes);
+  }
+  return success();
+}
+
+/// Convert the design point file written by DesignPointWriter to a CSV file.
+LogicalResult scalehls::convertDesignPointsToCsv(StringRef filePath,
+                                                 raw_ostream &os) {
+  // The header row is printed once the column names are read.
+  SmallVector<std::string, 16> columnNames;
+  bool isHeaderPrinted = false;
+  auto printRow = [&](ArrayRef<int64_t> row) {
+    if (!isHeaderPrinted) {
+      os << llvm::join(columnNames, ",") << "\n";
+      isHeaderPrinted = true;
+    }
+    llvm::interleave(row, os, ",");
+    os << "\n";
+  };
+
+  if (failed(readDesignPoints(filePath, columnNames, printRow)))
+    return failure();
+  if (!isHeaderPrinted)
+    os << llvm::join(columnNames, ",") << "\n";
+  return success();
 }
 
 //===----------------------------------------------------------------------===//
 // LoopDesignSpace Class Definition
 //===----------------------------------------------------------------------===//
 
+/// Return a random index in the range of [0, size).
+static unsigned getRandomIndex(DSERandomEngine &rng, unsigned size) {
+  return rng() % size;
+}
+
+/// Return a random real number in the range of [0, 1).
+static double getRandomReal(DSERandomEngine &rng) {
+  return (rng() >> 11) * 0x1.0p-53;
+}
+
 static void emitTileListDebugInfo(FactorList tileList) {
   LLVM_DEBUG(llvm::dbgs() << "(";
              for (unsigned i = 0, e = tileList.size(); i < e; ++i) {
@@ -74,11 +480,17 @@ static void emitTileListDebugInfo(FactorList tileList) {
 
 LoopDesignSpace::LoopDesignSpace(func::FuncOp func, AffineLoopBand &band,
                                  ScaleHLSEstimator &estimator,
-                                 unsigned maxDspNum, unsigned maxExplParallel,
-                                 unsigned maxLoopParallel, bool directiveOnly)
-    : func(func), band(band), estimator(estimator), maxDspNum(maxDspNum) {
-  // Initialize tile vector related members.
-  validTileConfigNum = 1;
+                                 unsigned maxDspNum, unsigned maxBramNum,
+                                 unsigned maxUramNum, unsigned maxLutNum,
+                                 unsigned maxExplParallel,
+                                 unsigned maxLoopParallel, bool directiveOnly,
+                                 unsigned numThreads, EstimationCache *cache)
+    : func(func), band(band), estimator(estimator), maxDspNum(maxDspNum),
+      maxBramNum(maxBramNum), maxUramNum(maxUramNum), maxLutNum(maxLutNum),
+      maxExplParallel(maxExplParallel), directiveOnly(directiveOnly),
+      numThreads(std::max(numThreads, 1u)), cache(cache) {
+  // Initialize tile vector related members. Note that tile configs are never
+  // materialized, but are checked and enumerated on demand.
   for (auto loop : band) {
     auto optionalTripCount = getConstantTripCount(loop);
     if (!optionalTripCount)
@@ -99,57 +511,19 @@ LoopDesignSpace::LoopDesignSpace(func::FuncOp func, AffineLoopBand &band,
         ++size;
     }
 
+    assert(validSizes.size() <= TileConfig::maxRadix && "too many tile sizes");
     validTileSizesList.push_back(validSizes);
-    validTileConfigNum *= validSizes.size();
-  }
-
-  // The last design point (all loops are fully unrolled) is removed.
-  --validTileConfigNum;
-
-  for (TileConfig config = 0; config < validTileConfigNum; ++config) {
-    auto tileList = getTileList(config);
-
-    // If the overall parallelism is out of bound, continue to next config.
-    auto parallel = std::accumulate(tileList.begin(), tileList.end(),
-                                    (unsigned)1, std::multiplies<unsigned>());
-    if (parallel > maxExplParallel)
-      continue;
-
-    // In only directive opt should be applied, once one loop is unrolled, all
-    // innter loops should be fully unrolled.
-    if (directiveOnly) {
-      bool mustFullyUnroll = false;
-      bool isInvalid = false;
-      unsigned i = 0;
-
-      for (auto tile : tileList) {
-        if (mustFullyUnroll && tile != tripCountList[i])
-          isInvalid = true;
-        if (tile != 1)
-          mustFullyUnroll = true;
-        ++i;
-      }
-
-      if (isInvalid)
-        continue;
-    }
-
-    unestimatedTileConfigs.insert(config);
   }
 }
 
 /// Return the actual tile vector given a tile config.
-FactorList LoopDesignSpace::getTileList(TileConfig config) {
-  assert(config < validTileConfigNum && "invalid tile config");
+FactorList LoopDesignSpace::getTileList(const TileConfig &config) {
+  assert(config.size() == validTileSizesList.size() && "invalid tile config");
 
   FactorList tileList;
-  unsigned factor = 1;
-  for (auto validSizes : validTileSizesList) {
-    auto idx = config / factor % validSizes.size();
-    factor *= validSizes.size();
-
-    auto size = validSizes[idx];
-    tileList.push_back(size);
+  for (unsigned i = 0, e = config.size(); i < e; ++i) {
+    assert(config[i] < validTileSizesList[i].size() && "invalid tile config");
+    tileList.push_back(validTileSizesList[i][config[i]]);
   }
   return tileList;
 }
@@ -158,8 +532,7 @@ FactorList LoopDesignSpace::getTileList(TileConfig config) {
 TileConfig LoopDesignSpace::getTileConfig(FactorList tileList) {
   assert(tileList.size() == validTileSizesList.size() && "invalid tile list");
 
-  TileConfig config = 0;
-  unsigned factor = 1;
+  SmallVector<unsigned, 8> digits;
   for (unsigned i = 0, e = tileList.size(); i < e; ++i) {
     auto tile = tileList[i];
     auto validSizes = validTileSizesList[i];
@@ -167,120 +540,520 @@ TileConfig LoopDesignSpace::getTileConfig(FactorList tileList) {
     auto idx = llvm::find(validSizes, tile) - validSizes.begin();
 
     assert(idx >= 0 && idx < (long)validSizes.size() && "invalid tile list");
-
-    config += factor * idx;
-    factor *= validSizes.size();
+    digits.push_back(idx);
   }
 
-  return config;
+  return TileConfig(digits);
 }
 
 /// Calculate the Euclid distance of config a and config b.
-float LoopDesignSpace::getTileConfigDistance(TileConfig configA,
-                                             TileConfig configB) {
-  assert(configA < validTileConfigNum && configB < validTileConfigNum &&
-         "invalid tile config");
+float LoopDesignSpace::getTileConfigDistance(const TileConfig &configA,
+                                             const TileConfig &configB) {
+  assert(configA.size() == validTileSizesList.size() &&
+         configB.size() == validTileSizesList.size() && "invalid tile config");
 
   int64_t distanceSquare = 0;
-  unsigned factor = 1;
-  for (auto validSizes : validTileSizesList) {
-    int64_t idxA = configA / factor % validSizes.size();
-    int64_t idxB = configB / factor % validSizes.size();
-    factor *= validSizes.size();
-
-    auto idxDistance = idxA - idxB;
+  for (unsigned i = 0, e = configA.size(); i < e; ++i) {
+    auto idxDistance = (int64_t)configA[i] - (int64_t)configB[i];
     distanceSquare += idxDistance * idxDistance;
   }
 
   return sqrtf(distanceSquare);
 }
 
-/// Evaluate all design points under the given tile config.
-bool LoopDesignSpace::evaluateTileConfig(TileConfig config) {
-  // If the current tile config is already estimated, return false.
-  if (!unestimatedTileConfigs.count(config))
+/// Return whether the tile config is in the design space.
+bool LoopDesignSpace::isValidTileConfig(const TileConfig &config) {
+  if (config.size() != validTileSizesList.size())
+    return false;
+
+  // The last design point (all loops are fully unrolled) is removed.
+  bool isLastConfig = true;
+  for (unsigned i = 0, e = config.size(); i < e; ++i) {
+    if (config[i] >= validTileSizesList[i].size())
+      return false;
+    if (config[i] != validTileSizesList[i].size() - 1)
+      isLastConfig = false;
+  }
+  if (isLastConfig)
     return false;
 
-  // Annotate the current tile config as estimated.
-  unestimatedTileConfigs.erase(config);
+  // If the overall parallelism is out of bound, the config is invalid.
+  auto tileList = getTileList(config);
+  uint64_t parallel = 1;
+  for (auto tile : tileList)
+    if ((parallel *= tile) > maxExplParallel)
+      return false;
+
+  // In only directive opt should be applied, once one loop is unrolled, all
+  // innter loops should be fully unrolled.
+  if (directiveOnly) {
+    bool mustFullyUnroll = false;
+    unsigned i = 0;
+
+    for (auto tile : tileList) {
+      if (mustFullyUnroll && tile != tripCountList[i])
+        return false;
+      if (tile != 1)
+        mustFullyUnroll = true;
+      ++i;
+    }
+  }
+  return true;
+}
+
+/// Lazily enumerate all valid tile configs whose overall parallelism is not
+/// larger than "maxParallel" in an ascending order.
+void LoopDesignSpace::enumerateTileConfigs(
+    unsigned maxParallel, function_ref<void(const TileConfig &)> callback) {
+  auto loopNum = validTileSizesList.size();
+  auto config = TileConfig(SmallVector<unsigned, 8>(loopNum, 0));
+
+  // Walk from the most significant digit. As the valid tile sizes are in an
+  // ascending order, the walk of a digit can be stopped once the parallelism
+  // is out of bound.
+  std::function<void(unsigned, uint64_t)> walk = [&](unsigned level,
+                                                     uint64_t parallel) {
+    if (level == 0) {
+      if (isValidTileConfig(config))
+        callback(config);
+      return;
+    }
+    auto &validSizes = validTileSizesList[level - 1];
+    for (unsigned idx = 0, e = validSizes.size(); idx < e; ++idx) {
+      if (parallel * validSizes[idx] > maxParallel)
+        break;
+      config.setDigit(level - 1, idx);
+      walk(level - 1, parallel * validSizes[idx]);
+    }
+    config.setDigit(level - 1, 0);
+  };
+  walk(loopNum, 1);
+}
+
+/// Estimate the given tile config on "targetBand" located in "targetFunc" with
+/// "targetEstimator", and return the estimation record of the loop band.
+EstimationRecord
+LoopDesignSpace::estimateTileConfig(const TileConfig &config,
+                                    func::FuncOp targetFunc,
+                                    AffineLoopBand &targetBand,
+                                    ScaleHLSEstimator &targetEstimator) {
+  // We always don't fully unroll all loops in the loop band.
+  auto tileList = getTileList(config);
+  if (getIterNum(tileList) == 1)
+    return EstimationRecord();
 
   // Clone a temporary loop band by cloning the outermost loop.
-  auto outerLoop = band.front();
+  auto outerLoop = targetBand.front();
   auto tmpOuterLoop = outerLoop.clone();
   AffineLoopBand tmpBand;
   getLoopBandFromOutermost(tmpOuterLoop, tmpBand);
 
   // Insert the clone loop band to the front of the original band for the
   // convenience of the estimation.
-  auto builder = OpBuilder(func);
+  auto builder = OpBuilder(targetFunc);
   builder.setInsertionPoint(outerLoop);
   builder.insert(tmpOuterLoop);
 
-  // Apply the tile config and estimate the loop band.
-  auto tileList = getTileList(config);
-  emitTileListDebugInfo(tileList);
-
-  // Calculate the total iteration number.
-  unsigned iterNum = 1;
-  for (unsigned i = 0, e = tileList.size(); i < e; ++i)
-    iterNum *= tripCountList[i] / tileList[i];
-
-  // We always don't fully unroll all loops in the loop band.
-  if (iterNum == 1)
-    return false;
-
   // Apply the current tiling config and start the estimation. Note that after
   // optimization, tmpBand is optimized in place and becomes a new loop band.
-  if (!applyOptStrategy(tmpBand, func, tileList, (unsigned)1))
-    return false;
+  if (!applyOptStrategy(tmpBand, targetFunc, tileList, (unsigned)1))
+    return EstimationRecord();
   tmpOuterLoop = tmpBand.front();
-  estimator.estimateLoop(tmpOuterLoop, func);
+  targetEstimator.estimateLoop(tmpOuterLoop, targetFunc);
 
   // Fetch latency and resource utilization.
   auto tmpInnerLoop = tmpBand.back();
   auto info = getLoopInfo(tmpInnerLoop);
   auto resource = getResource(tmpOuterLoop);
   assert(info && resource && "loop info or resource is not estimated");
-  auto totalDsp = resource.getDsp() * info.getMinII();
+
+  // As the array partition is applied to the whole function, the BRAM and URAM
+  // utilization is estimated on the function rather than the loop band.
+  EstimationRecord record;
+  record.latency = info.getIterLatency();
+  record.interval = info.getMinII();
+  record.dsp = resource.getDsp();
+  record.bram = targetEstimator.estimateBram(targetFunc);
+  record.uram = targetEstimator.estimateUram(targetFunc);
+  record.lut = resource.getLut();
+
+  // Erase the temporary loop band.
+  tmpOuterLoop.erase();
+  return record;
+}
+
+/// Return a copy of "module", where the function with the same name as "func"
+/// is replaced with a copy of "func". If "module" is null, the copy only holds
+/// the function.
+static OwningOpRef<ModuleOp> cloneModuleWithFunc(ModuleOp module,
+                                                 func::FuncOp func) {
+  OwningOpRef<ModuleOp> snapshot =
+      module ? module.clone() : ModuleOp::create(func.getLoc());
+  auto snapshotFunc = func.clone();
+  auto &operations = snapshot->getBody()->getOperations();
+  if (auto oldFunc = snapshot->lookupSymbol<func::FuncOp>(func.getName())) {
+    operations.insert(oldFunc->getIterator(), snapshotFunc);
+    oldFunc.erase();
+  } else
+    operations.push_back(snapshotFunc);
+  return snapshot;
+}
+
+/// Return a copy of the module holding the function, where the function is
+/// replaced with its current state. If the function is not held by any module,
+/// the copy only holds the function.
+OwningOpRef<ModuleOp> LoopDesignSpace::takeSnapshot() {
+  return cloneModuleWithFunc(module, func);
+}
+
+/// A snapshot of the module holding the function, where the function is
+/// detached from the module and kept as a template. Each tile config is
+/// estimated on a clone of the template inserted into the module, thus only the
+/// function is cloned for each tile config. As the array partition also updates
+/// the callees of the function, the module is cloned as well if the function
+/// has any call.
+struct mlir::scalehls::LoopSnapshot {
+  explicit LoopSnapshot(OwningOpRef<ModuleOp> snapshotModule,
+                        StringRef funcName)
+      : module(std::move(snapshotModule)) {
+    auto snapshotFunc = module->lookupSymbol<func::FuncOp>(funcName);
+    snapshotFunc->remove();
+    funcTemplate = OwningOpRef<func::FuncOp>(snapshotFunc);
+    hasCalls = snapshotFunc
+                   .walk([](func::CallOp) { return WalkResult::interrupt(); })
+                   .wasInterrupted();
+  }
+
+  OwningOpRef<ModuleOp> module;
+  OwningOpRef<func::FuncOp> funcTemplate;
+  bool hasCalls;
+};
+
+namespace {
+/// A worker of the parallel evaluation, which owns an MLIRContext, a snapshot
+/// parsed into the context, and an estimator. Therefore, no IR or estimator
+/// state is shared between the workers.
+struct EvaluationWorker {
+  std::unique_ptr<MLIRContext> context;
+  std::unique_ptr<LoopSnapshot> snapshot;
+  std::unique_ptr<ScaleHLSEstimator> estimator;
+};
+} // namespace
+
+/// The states of the tile config evaluation of a loop band. The snapshot is
+/// taken and printed once, and the workers and their thread pool are created
+/// once required and kept across evaluations.
+struct mlir::scalehls::LoopEvaluationState {
+  std::unique_ptr<LoopSnapshot> snapshot;
+
+  /// The printed snapshot, which is parsed by the workers, and its digest,
+  /// which serves as the structural key of the estimation cache.
+  std::string snapshotString;
+  std::string snapshotDigest;
+
+  SmallVector<EvaluationWorker, 8> workers;
+  std::unique_ptr<llvm::ThreadPool> threadPool;
+};
+
+/// Return the evaluation state. At the first evaluation, a snapshot of the
+/// module holding the function is taken with the target loop band annotated
+/// with "dse_target".
+LoopEvaluationState &LoopDesignSpace::getEvaluationState() {
+  if (evaluationState)
+    return *evaluationState;
+  evaluationState = std::make_shared<LoopEvaluationState>();
+
+  band.front()->setAttr("dse_target", UnitAttr::get(func.getContext()));
+  auto snapshotModule = takeSnapshot();
+  band.front()->removeAttr("dse_target");
+
+  if (cache || numThreads > 1) {
+    auto &snapshotString = evaluationState->snapshotString;
+    llvm::raw_string_ostream snapshotStream(snapshotString);
+    snapshotModule->print(snapshotStream,
+                          OpPrintingFlags().printGenericOpForm());
+    snapshotStream.flush();
+
+    llvm::MD5 hasher;
+    hasher.update(snapshotString);
+    llvm::MD5::MD5Result hash;
+    hasher.final(hash);
+    evaluationState->snapshotDigest = hash.digest().str().str();
+  }
+
+  evaluationState->snapshot = std::make_unique<LoopSnapshot>(
+      std::move(snapshotModule), func.getName());
+  return *evaluationState;
+}
+
+/// Estimate the given tile config on a fresh copy of the function held by
+/// "snapshot", where the target loop band is annotated with "dse_target". The
+/// loop band is then cloned and optimized in the function copy as before,
+/// while the configs never observe the memory optimizations and array
+/// partitions applied by each other.
+EstimationRecord LoopDesignSpace::estimateTileConfigOnSnapshot(
+    const TileConfig &config, LoopSnapshot &snapshot,
+    ScaleHLSEstimator &targetEstimator) {
+  auto module = *snapshot.module;
+  OwningOpRef<ModuleOp> tmpModule;
+  if (snapshot.hasCalls) {
+    tmpModule = module.clone();
+    module = *tmpModule;
+  }
+
+  auto tmpFunc = snapshot.funcTemplate->clone();
+  module.push_back(tmpFunc);
+
+  AffineLoopBand tmpBand;
+  tmpFunc.walk([&](AffineForOp loop) {
+    if (loop->hasAttr("dse_target")) {
+      loop->removeAttr("dse_target");
+      getLoopBandFromOutermost(loop, tmpBand);
+    }
+  });
+
+  EstimationRecord record;
+  if (!tmpBand.empty())
+    record = estimateTileConfig(config, tmpFunc, tmpBand, targetEstimator);
+  if (!tmpModule)
+    tmpFunc.erase();
+  return record;
+}
+
+/// Return the total iteration number of the loop band under the given tile
+/// list.
+int64_t LoopDesignSpace::getIterNum(FactorList tileList) {
+  int64_t iterNum = 1;
+  for (unsigned i = 0, e = tileList.size(); i < e; ++i)
+    iterNum *= tripCountList[i] / tileList[i];
+  return iterNum;
+}
+
+/// Generate and add design points of the given tile config to the design space.
+void LoopDesignSpace::addDesignPoints(const TileConfig &config,
+                                      EstimationRecord record) {
+  if (!record.isValid())
+    return;
+  auto iterNum = getIterNum(getTileList(config));
+  auto totalDsp = record.dsp * record.interval;
+  auto totalLut = record.lut * record.interval;
 
   // Improve target II until II is equal to iteration latency. Note that when II
   // equal to iteration latency, the pipeline pragma is similar to a region
   // fully unroll pragma which unrolls all contained loops.
-  for (auto tmpII = info.getMinII(); tmpII <= info.getIterLatency(); ++tmpII) {
+  for (auto tmpII = record.interval; tmpII <= record.latency; ++tmpII) {
     auto tmpDspNum = totalDsp / tmpII + 1;
-    auto tmpLatency = info.getIterLatency() + tmpII * (iterNum - 1) + 2;
-    auto point = LoopDesignPoint(tmpLatency, tmpDspNum, config, tmpII);
+    auto tmpLutNum = totalLut / tmpII;
+    auto tmpLatency = record.latency + tmpII * (iterNum - 1) + 2;
+    auto point = LoopDesignPoint(tmpLatency, tmpDspNum, record.bram,
+                                 record.uram, tmpLutNum, config, tmpII);
 
-    allPoints.push_back(point);
-    if (tmpDspNum <= maxDspNum)
+    ++evaluatedPointNum;
+    if (isWithinBudget(point))
       paretoPoints.push_back(point);
+
+    if (pointWriter) {
+      SmallVector<int64_t, 16> row;
+      for (auto size : getTileList(config))
+        row.push_back(size);
+      row.append(
+          {tmpII, tmpLatency, tmpDspNum, record.bram, record.uram, tmpLutNum});
+      pointWriter->append(row);
+    }
   }
+}
 
-  // Erase the temporary loop band.
-  tmpOuterLoop.erase();
-  return true;
+/// Evaluate all design points under the given tile config.
+bool LoopDesignSpace::evaluateTileConfig(const TileConfig &config) {
+  // If the current tile config is already estimated, return false.
+  if (!isUnestimatedTileConfig(config))
+    return false;
+
+  auto pointNum = evaluatedPointNum;
+  evaluateTileConfigs(config);
+  return evaluatedPointNum != pointNum;
 }
 
-/// Initialize the design space.
-void LoopDesignSpace::initializeLoopDesignSpace(unsigned maxInitParallel) {
-  LLVM_DEBUG(llvm::dbgs() << "Initialize the loop design space...\n";);
+/// Evaluate all design points under the given tile configs in parallel.
+void LoopDesignSpace::evaluateTileConfigs(ArrayRef<TileConfig> configs) {
+  // Collect all tile configs that have not been estimated. They are annotated
+  // as estimated once their estimation records are merged.
+  SmallVector<TileConfig, 32> targetConfigs;
+  for (auto &config : configs)
+    if (isUnestimatedTileConfig(config) &&
+        !llvm::is_contained(targetConfigs, config))
+      targetConfigs.push_back(config);
+
+  if (targetConfigs.empty())
+    return;
 
-  for (TileConfig config = 0; config < validTileConfigNum; ++config) {
-    auto tileList = getTileList(config);
+  // Restore the records of tile configs that have been estimated before the
+  // checkpoint was saved.
+  SmallVector<EstimationRecord, 32> records(targetConfigs.size());
+  SmallVector<unsigned, 32> uncachedIndices;
+  for (unsigned idx = 0, e = targetConfigs.size(); idx < e; ++idx) {
+    if (checkpoint) {
+      auto record = checkpoint->lookup(checkpointName, targetConfigs[idx]);
+      if (record) {
+        records[idx] = record.value();
+        continue;
+      }
+    }
+    uncachedIndices.push_back(idx);
+  }
 
-    // We only evaluate the design points whose overall parallel is smaller
-    // than the maxInitParallel to improve the efficiency.
-    auto parallel = std::accumulate(tileList.begin(), tileList.end(),
-                                    (unsigned)1, std::multiplies<unsigned>());
+  // Look up the estimation cache, and collect tile configs that are still
+  // required to be estimated.
+  SmallVector<std::string, 32> keys(targetConfigs.size());
+  SmallVector<unsigned, 32> pendingIndices;
+  for (auto idx : uncachedIndices) {
+    if (cache) {
+      auto tileList = getTileList(targetConfigs[idx]);
+      keys[idx] = cache->getKey(getEvaluationState().snapshotDigest,
+                                tileList, /*targetII=*/1);
+      if (auto record = cache->lookup(keys[idx])) {
+        records[idx] = record.value();
+        continue;
+      }
+    }
+    pendingIndices.push_back(idx);
+  }
 
-    if (parallel <= maxInitParallel) // || config == parallelConfig)
-      evaluateTileConfig(config);
+  // Both the serial and parallel evaluation estimate each tile config on a
+  // fresh copy of the function in the same snapshot, such that the callees and
+  // globals of the function are visible to the estimation, and the results are
+  // independent from the number of threads and the order of estimation.
+  auto workerNum = std::min(numThreads, (unsigned)pendingIndices.size());
+  if (workerNum <= 1) {
+    for (auto idx : pendingIndices)
+      records[idx] = estimateTileConfigOnSnapshot(
+          targetConfigs[idx], *getEvaluationState().snapshot, estimator);
+  } else {
+    // Workers are created once and parse the snapshot at their first run. Each
+    // task holds a distinct worker, and tile configs are fetched from a shared
+    // index until all of them are consumed.
+    auto &state = getEvaluationState();
+    if (state.workers.size() < workerNum)
+      state.workers.resize(workerNum);
+    if (!state.threadPool)
+      state.threadPool = std::make_unique<llvm::ThreadPool>(
+          llvm::hardware_concurrency(numThreads));
+
+    auto &registry = func.getContext()->getDialectRegistry();
+    std::atomic<unsigned> nextIndex(0);
+
+    auto runWorker = [&](EvaluationWorker &worker) {
+      if (!worker.context) {
+        worker.context = std::make_unique<MLIRContext>(
+            registry, MLIRContext::Threading::DISABLED);
+        auto workerModule = parseSourceString<ModuleOp>(
+            state.snapshotString, ParserConfig(worker.context.get()));
+        if (!workerModule)
+          return;
+        worker.snapshot = std::make_unique<LoopSnapshot>(
+            std::move(workerModule), func.getName());
+        worker.estimator = estimator.clone();
+      }
+      if (!worker.snapshot)
+        return;
+
+      for (unsigned i = nextIndex++; i < pendingIndices.size();
+           i = nextIndex++) {
+        auto idx = pendingIndices[i];
+        records[idx] = estimateTileConfigOnSnapshot(
+            targetConfigs[idx], *worker.snapshot, *worker.estimator);
+      }
+    };
+
+    for (unsigned i = 0; i < workerNum; ++i)
+      state.threadPool->async([&, i]() { runWorker(state.workers[i]); });
+    state.threadPool->wait();
+  }
+
+  // Store the newly estimated records into the estimation cache.
+  if (cache) {
+    for (auto idx : pendingIndices)
+      cache->insert(keys[idx], records[idx]);
+    cache->flush();
   }
 
+  // Merge design points in the order of the tile configs, such that the design
+  // space is deterministic no matter how the workers are scheduled.
+  for (auto [config, record] : llvm::zip(targetConfigs, records)) {
+    emitTileListDebugInfo(getTileList(config));
+    insertRecord(config, record);
+    addDesignPoints(config, record);
+  }
+
+  // Record all newly estimated tile configs into the checkpoint.
+  if (checkpoint)
+    for (auto idx : uncachedIndices)
+      checkpoint->insert(checkpointName, targetConfigs[idx], records[idx]);
+
+  // Flush the design points of each evaluation, such that they are kept even
+  // if the exploration is killed afterwards.
+  if (pointWriter)
+    pointWriter->flush();
+}
+
+/// Insert the estimation record of the tile config. Once the number of records
+/// exceeds "maxRecordNum", the oldest records of tile configs that are not
+/// pareto points are evicted to bound the memory footprint. An evicted tile
+/// config is considered as unestimated and is re-evaluated if visited again,
+/// where the checkpoint and estimation cache avoid the re-estimation. As the
+/// design points of an evicted tile config are dominated, the pareto points are
+/// not changed by the re-evaluation.
+void LoopDesignSpace::insertRecord(const TileConfig &config,
+                                   EstimationRecord record) {
+  if (!estimatedRecords.insert({config, record}).second)
+    return;
+  recordQueue.push_back(config);
+  if (estimatedRecords.size() <= maxRecordNum)
+    return;
+
+  DenseSet<TileConfig> paretoConfigs;
+  for (auto &point : paretoPoints)
+    paretoConfigs.insert(point.tileConfig);
+  for (unsigned i = 0, e = recordQueue.size();
+       i < e && estimatedRecords.size() > maxRecordNum; ++i) {
+    auto oldConfig = recordQueue.front();
+    recordQueue.pop_front();
+    if (paretoConfigs.count(oldConfig))
+      recordQueue.push_back(oldConfig);
+    else
+      estimatedRecords.erase(oldConfig);
+  }
+}
+
+/// Initialize the design space.
+void LoopDesignSpace::initializeLoopDesignSpace(unsigned maxInitParallel) {
+  LLVM_DEBUG(llvm::dbgs() << "Initialize the loop design space...\n";);
+
+  // We only evaluate the design points whose overall parallel is smaller than
+  // the maxInitParallel to improve the efficiency.
+  SmallVector<TileConfig, 32> initConfigs;
+  enumerateTileConfigs(maxInitParallel, [&](const TileConfig &config) {
+    initConfigs.push_back(config);
+  });
+  evaluateTileConfigs(initConfigs);
+
   LLVM_DEBUG(llvm::dbgs() << "\n\n");
   updateParetoPoints(paretoPoints);
 }
 
+/// Stream all design points evaluated afterwards to the given file.
+bool LoopDesignSpace::openPointWriter(StringRef filePath) {
+  SmallVector<std::string, 16> columnNames;
+  for (unsigned i = 0; i < tripCountList.size(); ++i)
+    columnNames.push_back("l" + std::to_string(i));
+  columnNames.append({"ii", "cycle", "dsp", "bram", "uram", "lut"});
+
+  pointWriter = std::make_shared<DesignPointWriter>(filePath, columnNames);
+  if (!pointWriter->isOpen())
+    pointWriter.reset();
+  return pointWriter != nullptr;
+}
+
 /// Dump pareto and non-pareto points which have been evaluated in the design
 /// space to a csv output file.
 void LoopDesignSpace::dumpLoopDesignSpace(StringRef csvFilePath) {
@@ -293,22 +1066,29 @@ void LoopDesignSpace::dumpLoopDesignSpace(StringRef csvFilePath) {
   // Print header row.
   for (unsigned i = 0; i < tripCountList.size(); ++i)
     os << "l" << i << ",";
-  os << "ii,cycle,dsp,type\n";
+  os << "ii,cycle,dsp,bram,uram,lut,type\n";
 
   // Print pareto design points.
   for (auto &point : paretoPoints) {
     for (auto size : getTileList(point.tileConfig))
       os << size << ",";
-    os << point.targetII << "," << point.latency << "," << point.dspNum
+    os << point.targetII << "," << point.latency << "," << point.dspNum << ","
+       << point.bramNum << "," << point.uramNum << "," << point.lutNum
        << ",pareto\n";
   }
 
-  // Print all design points.
-  for (auto &point : allPoints) {
-    for (auto size : getTileList(point.tileConfig))
-      os << size << ",";
-    os << point.targetII << "," << point.latency << "," << point.dspNum
-       << ",non-pareto\n";
+  // Print all design points streamed to the point writer.
+  if (pointWriter) {
+    pointWriter->flush();
+    SmallVector<std::string, 16> columnNames;
+    auto result = readDesignPoints(
+        pointWriter->getFilePath(), columnNames, [&](ArrayRef<int64_t> row) {
+          llvm::interleave(row, os, ",");
+          os << ",non-pareto\n";
+        });
+    if (failed(result))
+      LLVM_DEBUG(llvm::dbgs() << "Failed to read design points from file \""
+                              << pointWriter->getFilePath() << "\".\n");
   }
 
   csvFile->keep();
@@ -319,77 +1099,430 @@ void LoopDesignSpace::dumpLoopDesignSpace(StringRef csvFilePath) {
 /// Get a random tile config which is one of the closest neighbors of "point".
 Optional<TileConfig>
 LoopDesignSpace::getRandomClosestNeighbor(LoopDesignPoint point,
-                                          float maxDistance) {
-  // Traverse all unestimated tile configs and collect all neighbors.
-  SmallVector<std::pair<float, TileConfig>, 8> candidateConfigs;
-  for (auto config : unestimatedTileConfigs) {
-    auto distance = getTileConfigDistance(point.tileConfig, config);
-    if (distance <= maxDistance)
-      candidateConfigs.push_back(
-          std::pair<float, TileConfig>(distance, config));
-  }
-
-  if (candidateConfigs.empty())
-    return Optional<TileConfig>();
-
-  // Sort candidate configs and collect the closest points.
-  llvm::sort(candidateConfigs);
+                                          float maxDistance,
+                                          DSERandomEngine &rng) {
+  // Enumerate the unestimated tile configs in the closest shell. As the
+  // neighbors are enumerated in an ascending order of distance, the enumeration
+  // is stopped once a farther neighbor is found.
   SmallVector<TileConfig, 8> closestConfigs;
   float minDistance = maxDistance;
-
-  for (auto configPair : candidateConfigs) {
-    if (configPair.first <= minDistance) {
-      closestConfigs.push_back(configPair.second);
-      minDistance = configPair.first;
-    } else
-      break;
-  }
+  enumerateNeighbors(point.tileConfig, maxDistance,
+                     [&](const TileConfig &config, float distance) {
+                       if (!closestConfigs.empty() && distance > minDistance)
+                         return false;
+                       closestConfigs.push_back(config);
+                       minDistance = distance;
+                       return true;
+                     });
+
+  if (closestConfigs.empty())
+    return Optional<TileConfig>();
 
   // Randomly pick one as the return point.
-  std::srand(time(0));
-  llvm::shuffle(closestConfigs.begin(), closestConfigs.end(),
-                []() { return std::rand(); });
+  return closestConfigs[getRandomIndex(rng, closestConfigs.size())];
+}
 
-  return closestConfigs.front();
+/// Get a random unestimated tile config whose distance to "config" is not
+/// larger than "maxDistance".
+Optional<TileConfig>
+LoopDesignSpace::getRandomNeighbor(const TileConfig &config, float maxDistance,
+                                   DSERandomEngine &rng) {
+  // The neighbors are enumerated in a fixed order, thus the pick is
+  // deterministic given the random engine.
+  SmallVector<TileConfig, 32> neighborConfigs;
+  enumerateNeighbors(config, maxDistance,
+                     [&](const TileConfig &neighbor, float distance) {
+                       neighborConfigs.push_back(neighbor);
+                       return true;
+                     });
+
+  if (neighborConfigs.empty())
+    return Optional<TileConfig>();
+  return neighborConfigs[getRandomIndex(rng, neighborConfigs.size())];
+}
+
+/// Lazily enumerate all unestimated tile configs whose distance to "config" is
+/// not larger than "maxDistance" in an ascending order of distance.
+void LoopDesignSpace::enumerateNeighbors(
+    const TileConfig &config, float maxDistance,
+    function_ref<bool(const TileConfig &, float)> callback) {
+  if (neighborIndex.getDimNum() != config.size() ||
+      neighborIndex.getMaxDistance() != maxDistance)
+    neighborIndex = NeighborIndex(config.size(), maxDistance);
+
+  // Apply the offsets of each shell to the tile config. Neighbors out of the
+  // lattice or already estimated are dropped before being decoded.
+  auto neighbor = config;
+  for (unsigned shell = 0, e = neighborIndex.getNumShells(); shell < e;
+       ++shell) {
+    auto distance = neighborIndex.getShellDistance(shell);
+
+    for (unsigned i = 0, ie = neighborIndex.getShellSize(shell); i < ie; ++i) {
+      auto offset = neighborIndex.getOffset(shell, i);
+      bool isInLattice = true;
+      for (unsigned dim = 0, de = offset.size(); dim < de; ++dim) {
+        int64_t digit = (int64_t)config[dim] + offset[dim];
+        if (digit < 0 || digit >= (int64_t)validTileSizesList[dim].size()) {
+          isInLattice = false;
+          break;
+        }
+        neighbor.setDigit(dim, digit);
+      }
+
+      if (isInLattice && isUnestimatedTileConfig(neighbor))
+        if (!callback(neighbor, distance))
+          return;
+    }
+  }
 }
 
-void LoopDesignSpace::exploreLoopDesignSpace(unsigned maxIterNum,
+void LoopDesignSpace::exploreLoopDesignSpace(DSEStrategy &strategy,
+                                             unsigned maxIterNum,
                                              float maxDistance) {
   LLVM_DEBUG(llvm::dbgs() << "Explore the loop design space...\n";);
+  strategy.explore(*this, maxIterNum, maxDistance);
+  LLVM_DEBUG(llvm::dbgs() << "\n\n";);
+}
+
+//===----------------------------------------------------------------------===//
+// DSEStrategy Class Definition
+//===----------------------------------------------------------------------===//
+
+/// Return the design point of the given tile config under the minimum II.
+/// Return None if the tile config has not been estimated or failed to be
+/// estimated.
+static Optional<LoopDesignPoint> getMinIIPoint(LoopDesignSpace &space,
+                                               const TileConfig &config) {
+  auto recordIt = space.estimatedRecords.find(config);
+  if (recordIt == space.estimatedRecords.end() || !recordIt->second.isValid())
+    return Optional<LoopDesignPoint>();
+
+  // This is consistent with the design point generated with the minimum II.
+  auto record = recordIt->second;
+  int64_t iterNum = space.getIterNum(space.getTileList(config));
+  auto latency = record.latency + record.interval * (iterNum - 1) + 2;
+  return LoopDesignPoint(latency, record.dsp + 1, record.bram, record.uram,
+                         record.lut, config, record.interval);
+}
+
+void NeighborSearchStrategy::explore(LoopDesignSpace &space,
+                                     unsigned maxIterNum, float maxDistance) {
+  auto &paretoPoints = space.paretoPoints;
 
   // Exploration loop of the dse.
   for (unsigned i = 0; i < maxIterNum; ++i) {
-    std::srand(time(0));
-    llvm::shuffle(paretoPoints.begin(), paretoPoints.end(),
-                  []() { return std::rand(); });
+    llvm::shuffle(paretoPoints.begin(), paretoPoints.end(), rng);
 
-    bool foundValidNeighbor = false;
+    // Collect one neighbor from each of "batchSize" different pareto points,
+    // which are evaluated in parallel if more than one thread is available.
+    // With a batch size of one, this falls back to the evaluation of the
+    // closest neighbor of one pareto point.
+    SmallVector<TileConfig, 8> neighborConfigs;
     for (auto &point : paretoPoints) {
+      if (neighborConfigs.size() >= batchSize)
+        break;
       if (!point.isActive)
         continue;
 
-      auto closestNeighbor = getRandomClosestNeighbor(point, maxDistance);
+      auto closestNeighbor =
+          space.getRandomClosestNeighbor(point, maxDistance, rng);
       if (!closestNeighbor) {
         point.isActive = false;
         continue;
       }
 
-      foundValidNeighbor = true;
-      auto config = closestNeighbor.value();
-      auto tileList = getTileList(config);
-
-      evaluateTileConfig(config);
-      break;
+      if (!llvm::is_contained(neighborConfigs, closestNeighbor.value()))
+        neighborConfigs.push_back(closestNeighbor.value());
     }
 
     // Early termination if no valid neighbor is found.
-    if (!foundValidNeighbor)
+    if (neighborConfigs.empty())
       break;
+    space.evaluateTileConfigs(neighborConfigs);
 
     // Update pareto points after each dse iteration.
     updateParetoPoints(paretoPoints);
   }
-  LLVM_DEBUG(llvm::dbgs() << "\n\n";);
+}
+
+void SimulatedAnnealingStrategy::explore(LoopDesignSpace &space,
+                                         unsigned maxIterNum,
+                                         float maxDistance) {
+  if (space.paretoPoints.empty())
+    return;
+
+  // Start from a random pareto point.
+  auto randomIdx = getRandomIndex(rng, space.paretoPoints.size());
+  auto current = space.paretoPoints[randomIdx].tileConfig;
+  auto currentPoint = getMinIIPoint(space, current);
+  auto temperature = initialTemperature;
+
+  for (unsigned i = 0; i < maxIterNum; ++i) {
+    // Collect "batchSize" random neighbors of the current tile config.
+    SmallVector<TileConfig, 8> neighborConfigs;
+    auto collectNeighbors = [&]() {
+      for (unsigned b = 0; b < batchSize; ++b) {
+        auto neighbor = space.getRandomNeighbor(current, maxDistance, rng);
+        if (!neighbor)
+          break;
+        if (!llvm::is_contained(neighborConfigs, neighbor.value()))
+          neighborConfigs.push_back(neighbor.value());
+      }
+    };
+    collectNeighbors();
+
+    // If the current tile config has no unestimated neighbor, restart from a
+    // random pareto point which still has unestimated neighbors.
+    if (neighborConfigs.empty()) {
+      auto points = space.paretoPoints;
+      llvm::shuffle(points.begin(), points.end(), rng);
+      for (auto &point : points) {
+        current = point.tileConfig;
+        collectNeighbors();
+        if (!neighborConfigs.empty())
+          break;
+      }
+      currentPoint = getMinIIPoint(space, current);
+    }
+
+    // Early termination if no valid neighbor is found.
+    if (neighborConfigs.empty())
+      break;
+    space.evaluateTileConfigs(neighborConfigs);
+    updateParetoPoints(space.paretoPoints);
+
+    // Move to the neighbors following the Metropolis criterion, where the
+    // energy is the randomly weighted sum of the logarithmic objectives.
+    std::array<double, std::tuple_size<DesignObjectives>::value> weights;
+    double weightSum = 0;
+    for (auto &weight : weights) {
+      weight = getRandomReal(rng);
+      weightSum += weight;
+    }
+    weightSum = std::max(weightSum, 1e-9);
+
+    for (auto neighbor : neighborConfigs) {
+      auto point = getMinIIPoint(space, neighbor);
+      if (!point || !space.isWithinBudget(point.value()))
+        continue;
+
+      if (currentPoint) {
+        auto objs = point->getObjectives();
+        auto currentObjs = currentPoint->getObjectives();
+        double delta = 0;
+        for (unsigned obj = 0, e = objs.size(); obj < e; ++obj)
+          delta += weights[obj] / weightSum *
+                   std::log((double)(objs[obj] + 1) / (currentObjs[obj] + 1));
+        if (delta > 0 && getRandomReal(rng) >= std::exp(-delta / temperature))
+          continue;
+      }
+      current = neighbor;
+      currentPoint = point;
+    }
+    temperature *= coolingRate;
+  }
+}
+
+namespace {
+/// An individual of the population of NSGA-II.
+struct Individual {
+  TileConfig config;
+  DesignObjectives objectives;
+  double violation;
+
+  unsigned rank = 0;
+  double crowding = 0;
+};
+} // namespace
+
+/// Return whether individual "a" dominates individual "b". A feasible
+/// individual, whose violation is zero, always dominates an infeasible one, and
+/// infeasible individuals are compared with their violation of the budgets.
+static bool dominates(const Individual &a, const Individual &b) {
+  if (a.violation > 0 || b.violation > 0)
+    return a.violation < b.violation;
+  return dominates(a.objectives, b.objectives);
+}
+
+/// Return the total relative violation of the resource budgets.
+static double getBudgetViolation(LoopDesignSpace &space,
+                                 const LoopDesignPoint &point) {
+  double violation = 0;
+  for (auto [num, maxNum] : {std::make_pair(point.dspNum, space.maxDspNum),
+                             std::make_pair(point.bramNum, space.maxBramNum),
+                             std::make_pair(point.uramNum, space.maxUramNum),
+                             std::make_pair(point.lutNum, space.maxLutNum)})
+    if (num > maxNum)
+      violation += (double)(num - maxNum) / std::max(maxNum, 1u);
+  return violation;
+}
+
+/// Calculate the crowding distance of the individuals in the front.
+static void calculateCrowding(SmallVectorImpl<Individual> &individuals,
+                              SmallVectorImpl<unsigned> &front) {
+  for (auto idx : front)
+    individuals[idx].crowding = 0;
+
+  for (unsigned obj = 0, e = std::tuple_size<DesignObjectives>::value; obj < e;
+       ++obj) {
+    auto getObj = [&](const Individual &a) { return a.objectives[obj]; };
+    llvm::sort(front, [&](unsigned a, unsigned b) {
+      auto objA = getObj(individuals[a]), objB = getObj(individuals[b]);
+      return objA < objB ||
+             (objA == objB && individuals[a].config < individuals[b].config);
+    });
+
+    // The boundary individuals are always preferred.
+    auto minObj = getObj(individuals[front.front()]);
+    auto maxObj = getObj(individuals[front.back()]);
+    individuals[front.front()].crowding = INFINITY;
+    individuals[front.back()].crowding = INFINITY;
+    if (maxObj == minObj)
+      continue;
+
+    for (unsigned i = 1, e = front.size(); i + 1 < e; ++i) {
+      auto prevObj = getObj(individuals[front[i - 1]]);
+      auto nextObj = getObj(individuals[front[i + 1]]);
+      individuals[front[i]].crowding +=
+          (double)(nextObj - prevObj) / (maxObj - minObj);
+    }
+  }
+}
+
+/// Rank the individuals with non-dominated sorting and crowding distance, and
+/// only keep the best "size" individuals.
+static void selectIndividuals(SmallVectorImpl<Individual> &individuals,
+                              unsigned size) {
+  unsigned num = individuals.size();
+  SmallVector<SmallVector<unsigned, 8>, 32> dominatedLists(num);
+  SmallVector<unsigned, 32> dominatedCounts(num, 0);
+
+  SmallVector<unsigned, 32> front;
+  for (unsigned i = 0; i < num; ++i) {
+    for (unsigned j = 0; j < num; ++j) {
+      if (dominates(individuals[i], individuals[j]))
+        dominatedLists[i].push_back(j);
+      else if (dominates(individuals[j], individuals[i]))
+        ++dominatedCounts[i];
+    }
+    if (!dominatedCounts[i]) {
+      individuals[i].rank = 0;
+      front.push_back(i);
+    }
+  }
+
+  for (unsigned rank = 1; !front.empty(); ++rank) {
+    calculateCrowding(individuals, front);
+
+    SmallVector<unsigned, 32> nextFront;
+    for (auto i : front)
+      for (auto j : dominatedLists[i])
+        if (!--dominatedCounts[j]) {
+          individuals[j].rank = rank;
+          nextFront.push_back(j);
+        }
+    front = nextFront;
+  }
+
+  llvm::sort(individuals, [](const Individual &a, const Individual &b) {
+    if (a.rank != b.rank)
+      return a.rank < b.rank;
+    if (a.crowding != b.crowding)
+      return a.crowding > b.crowding;
+    return a.config < b.config;
+  });
+  if (individuals.size() > size)
+    individuals.resize(size);
+}
+
+void NSGA2Strategy::explore(LoopDesignSpace &space, unsigned maxIterNum,
+                            float maxDistance) {
+  auto getIndividual = [&](const TileConfig &config) -> Optional<Individual> {
+    auto point = getMinIIPoint(space, config);
+    if (!point)
+      return Optional<Individual>();
+    return Individual{config, point->getObjectives(),
+                      getBudgetViolation(space, point.value())};
+  };
+
+  // Initialize the population with all estimated tile configs.
+  SmallVector<TileConfig, 32> estimatedConfigs;
+  for (auto &pair : space.estimatedRecords)
+    estimatedConfigs.push_back(pair.first);
+  llvm::sort(estimatedConfigs);
+
+  SmallVector<Individual, 32> population;
+  for (auto config : estimatedConfigs)
+    if (auto individual = getIndividual(config))
+      population.push_back(individual.value());
+  selectIndividuals(population, populationSize);
+  if (population.empty())
+    return;
+
+  // Binary tournament selection based on the rank and crowding distance.
+  auto select = [&]() -> const Individual & {
+    auto &a = population[getRandomIndex(rng, population.size())];
+    auto &b = population[getRandomIndex(rng, population.size())];
+    if (a.rank != b.rank)
+      return a.rank < b.rank ? a : b;
+    return a.crowding >= b.crowding ? a : b;
+  };
+
+  for (unsigned i = 0; i < maxIterNum; ++i) {
+    // Generate offsprings through uniform crossover and mutation. Each loop is
+    // mutated to its neighboring tile size with a probability of 1/N, where N
+    // is the number of loops in the band.
+    SmallVector<TileConfig, 32> offspringConfigs;
+    auto loopNum = space.validTileSizesList.size();
+    for (unsigned attempt = 0; offspringConfigs.size() < populationSize &&
+                               attempt < populationSize * 8;
+         ++attempt) {
+      auto &parentA = select().config;
+      auto &parentB = select().config;
+
+      SmallVector<unsigned, 8> digits;
+      for (unsigned loop = 0; loop < loopNum; ++loop) {
+        int64_t radix = space.validTileSizesList[loop].size();
+        int64_t digit = rng() % 2 ? parentA[loop] : parentB[loop];
+        if (getRandomIndex(rng, loopNum) == 0)
+          digit += rng() % 2 ? 1 : -1;
+        digits.push_back(std::clamp(digit, (int64_t)0, radix - 1));
+      }
+
+      auto config = TileConfig(digits);
+      if (!space.isValidTileConfig(config) ||
+          llvm::is_contained(offspringConfigs, config) ||
+          llvm::any_of(population, [&](const Individual &individual) {
+            return individual.config == config;
+          }))
+        continue;
+      offspringConfigs.push_back(config);
+    }
+
+    // Early termination if no valid offspring is generated.
+    if (offspringConfigs.empty())
+      break;
+    space.evaluateTileConfigs(offspringConfigs);
+    updateParetoPoints(space.paretoPoints);
+
+    // Select the next generation from the parents and offsprings.
+    for (auto config : offspringConfigs)
+      if (auto individual = getIndividual(config))
+        population.push_back(individual.value());
+    selectIndividuals(population, populationSize);
+  }
+}
+
+std::unique_ptr<DSEStrategy>
+scalehls::createDSEStrategy(const DSEStrategyOptions &opts, uint64_t seed) {
+  if (opts.name == "neighbor")
+    return std::make_unique<NeighborSearchStrategy>(seed, opts.batchSize);
+  if (opts.name == "annealing")
+    return std::make_unique<SimulatedAnnealingStrategy>(
+        seed, opts.batchSize, opts.initialTemperature, opts.coolingRate);
+  if (opts.name == "nsga2")
+    return std::make_unique<NSGA2Strategy>(seed, opts.populationSize);
+  return nullptr;
 }
 
 //===----------------------------------------------------------------------===//
@@ -411,7 +1544,7 @@ void FuncDesignSpace::dumpFuncDesignSpace(StringRef csvFilePath) {
       os << "b" << i << "l" << j << ",";
     os << "b" << i << "ii,";
   }
-  os << "cycle,dsp,type\n";
+  os << "cycle,dsp,bram,uram,lut,type\n";
 
   // Print pareto design points.
   for (auto &funcPoint : paretoPoints) {
@@ -423,7 +1556,9 @@ void FuncDesignSpace::dumpFuncDesignSpace(StringRef csvFilePath) {
         os << size << ",";
       os << loopPoint.targetII << ",";
     }
-    os << funcPoint.latency << "," << funcPoint.dspNum << ",pareto\n";
+    os << funcPoint.latency << "," << funcPoint.dspNum << ","
+       << funcPoint.bramNum << "," << funcPoint.uramNum << ","
+       << funcPoint.lutNum << ",pareto\n";
   }
 
   csvFile->keep();
@@ -431,6 +1566,41 @@ void FuncDesignSpace::dumpFuncDesignSpace(StringRef csvFilePath) {
                           << csvFilePath << "\".\n\n");
 }
 
+void FuncDesignSpace::estimateFunc() {
+  // As only the latency and resource of the target loops are changed during
+  // the combination, the function can be incrementally re-estimated.
+  if (incremental)
+    estimator.estimateFuncIncrementally(func);
+  else
+    estimator.estimateFunc(func);
+}
+
+/// Estimate the function annotated with the given loop design points, and
+/// return the function design point. Return None if the function design point
+/// exceeds the resource budgets.
+Optional<FuncDesignPoint>
+FuncDesignSpace::getFuncDesignPoint(SmallVector<LoopDesignPoint, 4> &points) {
+  estimateFunc();
+  auto latency = getTiming(func).getLatency();
+  auto resource = getResource(func);
+
+  // The BRAM and URAM utilization of each loop design point is estimated on the
+  // whole function under its array partition, thus the maximum one is taken.
+  auto bramNum = resource.getBram();
+  auto uramNum = resource.getUram();
+  for (auto &point : points) {
+    bramNum = std::max(bramNum, point.bramNum);
+    uramNum = std::max(uramNum, point.uramNum);
+  }
+
+  auto funcPoint = FuncDesignPoint(latency, resource.getDsp(), bramNum, uramNum,
+                                   resource.getLut(), points);
+  if (funcPoint.dspNum > maxDspNum || funcPoint.bramNum > maxBramNum ||
+      funcPoint.uramNum > maxUramNum || funcPoint.lutNum > maxLutNum)
+    return Optional<FuncDesignPoint>();
+  return funcPoint;
+}
+
 void FuncDesignSpace::combLoopDesignSpaces() {
   LLVM_DEBUG(llvm::dbgs() << "Combine the loop design spaces...\n";);
 
@@ -440,15 +1610,12 @@ void FuncDesignSpace::combLoopDesignSpaces() {
     // Annotate the first loop.
     auto loop = targetLoops[0];
     setTiming(loop, -1, -1, loopPoint.latency, -1);
-    setResource(loop, -1, loopPoint.dspNum, -1);
+    setResource(loop, loopPoint.lutNum, loopPoint.dspNum, -1);
 
     // Estimate the function and generate a new function design point.
-    estimator.estimateFunc(func);
-    auto latency = getTiming(func).getLatency();
-    auto dspNum = getResource(func).getDsp();
-    auto funcPoint = FuncDesignPoint(latency, dspNum, loopPoint);
-
-    paretoPoints.push_back(funcPoint);
+    SmallVector<LoopDesignPoint, 4> loopPoints({loopPoint});
+    if (auto funcPoint = getFuncDesignPoint(loopPoints))
+      paretoPoints.push_back(funcPoint.value());
   }
 
   updateParetoPoints(paretoPoints);
@@ -468,7 +1635,7 @@ void FuncDesignSpace::combLoopDesignSpaces() {
         auto &oldLoopPoint = funcPoint.loopDesignPoints[ii];
         auto oldLoop = targetLoops[ii];
         setTiming(oldLoop, -1, -1, oldLoopPoint.latency, -1);
-        setResource(oldLoop, -1, oldLoopPoint.dspNum, -1);
+        setResource(oldLoop, oldLoopPoint.lutNum, oldLoopPoint.dspNum, -1);
       }
 
       // Traverse all design points of the NEW loop.
@@ -476,18 +1643,13 @@ void FuncDesignSpace::combLoopDesignSpaces() {
         // Annotate the new loop,
         auto loop = targetLoops[i];
         setTiming(loop, -1, -1, loopPoint.latency, -1);
-        setResource(loop, -1, loopPoint.dspNum, -1);
+        setResource(loop, loopPoint.lutNum, loopPoint.dspNum, -1);
 
         // Estimate the function and generate a new function design point.
         auto loopPoints = funcPoint.loopDesignPoints;
         loopPoints.push_back(loopPoint);
-
-        estimator.estimateFunc(func);
-        auto latency = getTiming(func).getLatency();
-        auto dspNum = getResource(func).getDsp();
-        auto newFuncPoint = FuncDesignPoint(latency, dspNum, loopPoints);
-
-        newParetoPoints.push_back(newFuncPoint);
+        if (auto newFuncPoint = getFuncDesignPoint(loopPoints))
+          newParetoPoints.push_back(newFuncPoint.value());
       }
     }
 
@@ -500,55 +1662,127 @@ void FuncDesignSpace::combLoopDesignSpaces() {
   LLVM_DEBUG(llvm::dbgs() << "\n";);
 }
 
+/// Apply the optimization of a function design point to the function named
+/// "funcName" in a clone of "snapshot", and export the whole module to MLIR
+/// and, optionally, HLS C++ files named with the sample index. Therefore, the
+/// callees and globals of the function are kept in the exported designs.
+static bool exportDesign(ModuleOp snapshot, StringRef funcName,
+                         ArrayRef<FactorList> tileLists,
+                         ArrayRef<unsigned> targetIIs,
+                         ScaleHLSEstimator &estimator, std::string filePath,
+                         bool emitCpp) {
+  // Clone a new module and apply optimization to the function.
+  OwningOpRef<ModuleOp> tmpModule = snapshot.clone();
+  auto tmpFunc = tmpModule->lookupSymbol<func::FuncOp>(funcName);
+  if (!tmpFunc || !applyOptStrategy(tmpFunc, tileLists, targetIIs))
+    return false;
+  estimator.estimateFunc(tmpFunc);
+
+  // Parse a new output file.
+  std::string errorMessage;
+  auto outputFile = mlir::openOutputFile(filePath + ".mlir", &errorMessage);
+  if (!outputFile)
+    return false;
+  outputFile->os() << *tmpModule << "\n";
+  outputFile->keep();
+
+  // Emit HLS C++ code of the module.
+  if (emitCpp) {
+    auto cppFile = mlir::openOutputFile(filePath + ".cpp", &errorMessage);
+    if (!cppFile || failed(emitHLSCpp(*tmpModule, cppFile->os())))
+      return false;
+    cppFile->keep();
+  }
+  return true;
+}
+
 bool FuncDesignSpace::exportParetoDesigns(unsigned outputNum,
-                                          StringRef outputRootPath) {
+                                          StringRef outputRootPath,
+                                          bool emitCpp) {
   unsigned paretoNum = paretoPoints.size();
   auto sampleStep = std::max(paretoNum / outputNum, (unsigned)1);
 
-  // Traverse all detected pareto points.
-  unsigned sampleIndex = 0;
-  for (auto &funcPoint : paretoPoints) {
+  // Collect the tile lists and target IIs of all sampled pareto points.
+  SmallVector<unsigned, 32> sampleIndices;
+  SmallVector<std::vector<FactorList>, 32> tileListsList;
+  SmallVector<SmallVector<unsigned, 4>, 32> targetIIsList;
+  for (unsigned sampleIndex = 0; sampleIndex < paretoNum; ++sampleIndex) {
     // Only export sampled points.
-    if (sampleIndex % sampleStep == 0) {
-      std::vector<FactorList> tileLists;
-      SmallVector<unsigned, 4> targetIIs;
-
-      for (unsigned i = 0; i < loopDesignSpaces.size(); ++i) {
-        auto &loopSpace = loopDesignSpaces[i];
-        auto &loopPoint = funcPoint.loopDesignPoints[i];
-        auto tileList = loopSpace.getTileList(loopPoint.tileConfig);
-        auto targetII = loopPoint.targetII;
+    if (sampleIndex % sampleStep != 0)
+      continue;
 
-        tileLists.push_back(tileList);
-        targetIIs.push_back(targetII);
-      }
+    auto &funcPoint = paretoPoints[sampleIndex];
+    std::vector<FactorList> tileLists;
+    SmallVector<unsigned, 4> targetIIs;
+    for (unsigned i = 0; i < loopDesignSpaces.size(); ++i) {
+      auto &loopSpace = loopDesignSpaces[i];
+      auto &loopPoint = funcPoint.loopDesignPoints[i];
+      tileLists.push_back(loopSpace.getTileList(loopPoint.tileConfig));
+      targetIIs.push_back(loopPoint.targetII);
+    }
 
-      // Clone a new function and apply optimization.
-      auto tmpFunc = func.clone();
-      if (!applyOptStrategy(tmpFunc, tileLists, targetIIs))
-        return false;
-      estimator.estimateFunc(tmpFunc);
+    sampleIndices.push_back(sampleIndex);
+    tileListsList.push_back(tileLists);
+    targetIIsList.push_back(targetIIs);
+  }
 
-      // Parse a new output file.
-      auto outputFilePath = outputRootPath.str() + func.getName().str() +
-                            "_pareto_" + std::to_string(sampleIndex) + ".mlir";
+  auto getFilePath = [&](unsigned i) {
+    return outputRootPath.str() + func.getName().str() + "_pareto_" +
+           std::to_string(sampleIndices[i]);
+  };
 
-      std::string errorMessage;
-      auto outputFile = mlir::openOutputFile(outputFilePath, &errorMessage);
-      if (!outputFile)
+  // Each design is exported from a copy of the module holding the function,
+  // where the function is replaced with its current state.
+  auto snapshot = cloneModuleWithFunc(module, func);
+  auto funcName = func.getName();
+
+  std::atomic<bool> succeeded(true);
+  auto workerNum = std::min(numThreads, (unsigned)sampleIndices.size());
+  if (workerNum <= 1) {
+    for (unsigned i = 0, e = sampleIndices.size(); i < e; ++i)
+      if (!exportDesign(*snapshot, funcName, tileListsList[i],
+                        targetIIsList[i], estimator, getFilePath(i), emitCpp))
         return false;
-
-      auto &os = outputFile->os();
-      os << tmpFunc << "\n";
-      outputFile->keep();
-    }
-    ++sampleIndex;
+  } else {
+    // Similar to the parallel evaluation of tile configs, each worker owns an
+    // MLIRContext, a module snapshot parsed into the context, and an
+    // estimator, such that each design is optimized on an isolated clone.
+    std::string snapshotString;
+    llvm::raw_string_ostream snapshotStream(snapshotString);
+    snapshot->print(snapshotStream, OpPrintingFlags().printGenericOpForm());
+    snapshotStream.flush();
+
+    auto &registry = func.getContext()->getDialectRegistry();
+    std::atomic<unsigned> nextIndex(0);
+
+    auto runWorker = [&]() {
+      MLIRContext context(registry, MLIRContext::Threading::DISABLED);
+      auto workerSnapshot =
+          parseSourceString<ModuleOp>(snapshotString, ParserConfig(&context));
+      if (!workerSnapshot) {
+        succeeded = false;
+        return;
+      }
+      auto workerEstimator = estimator.clone();
+
+      for (unsigned i = nextIndex++; i < sampleIndices.size();
+           i = nextIndex++)
+        if (!exportDesign(*workerSnapshot, funcName, tileListsList[i],
+                          targetIIsList[i], *workerEstimator, getFilePath(i),
+                          emitCpp))
+          succeeded = false;
+    };
+
+    llvm::ThreadPool threadPool(llvm::hardware_concurrency(workerNum));
+    for (unsigned i = 0; i < workerNum; ++i)
+      threadPool.async(runWorker);
+    threadPool.wait();
   }
 
   LLVM_DEBUG(
       llvm::dbgs() << "Sampled pareto points MLIR files are exported to path \""
                    << outputRootPath << "\".\n\n");
-  return true;
+  return succeeded;
 }
 
 //===----------------------------------------------------------------------===//
@@ -559,14 +1793,14 @@ bool ScaleHLSExplorer::emitQoRDebugInfo(func::FuncOp func,
                                         std::string message) {
   estimator.estimateFunc(func);
   // auto latency = getTiming(func).getLatency();
-  auto dspNum = getResource(func).getDsp();
+  auto resource = getResource(func);
 
   LLVM_DEBUG(llvm::dbgs() << message + "\n";
              //  llvm::dbgs() << "The clock cycle is " << Twine(latency)
              //               << ", DSP usage is " << Twine(dspNum) << ".\n\n";
   );
 
-  return dspNum <= maxDspNum;
+  return isWithinBudget(resource);
 }
 
 static int64_t getInnerParallelism(Block &block) {
@@ -677,7 +1911,7 @@ bool ScaleHLSExplorer::simplifyLoopNests(func::FuncOp func) {
       estimator.estimateFunc(tmpFunc);
 
       // Fully unroll the candidate loop or delve into child loops.
-      if (getResource(tmpFunc).getDsp() <= maxDspNum) {
+      if (isWithinBudget(getResource(tmpFunc))) {
         applyFullyLoopUnrolling(*candidate.getBody());
         applyMemoryOpts(func);
         applyAutoArrayPartition(func);
@@ -724,9 +1958,11 @@ bool ScaleHLSExplorer::optimizeLoopBands(func::FuncOp func,
 }
 
 /// DSE Stage3: Explore the function design space through dynamic programming.
-bool ScaleHLSExplorer::exploreDesignSpace(func::FuncOp func, bool directiveOnly,
-                                          StringRef outputRootPath,
-                                          StringRef csvRootPath) {
+/// Return failure if the exploration encounters an error.
+LogicalResult ScaleHLSExplorer::exploreDesignSpace(func::FuncOp func,
+                                                   bool directiveOnly,
+                                                   StringRef outputRootPath,
+                                                   StringRef csvRootPath) {
   LLVM_DEBUG(llvm::dbgs() << "----------\nStage3: Conduct top function design "
                              "space exploration...\n";);
 
@@ -738,26 +1974,64 @@ bool ScaleHLSExplorer::exploreDesignSpace(func::FuncOp func, bool directiveOnly,
   // Search for the pareto frontiers of each target loop band.
   SmallVector<LoopDesignSpace, 4> loopSpaces;
   for (unsigned i = 0; i < targetNum; ++i) {
-    auto space =
-        LoopDesignSpace(tmpFunc, targetBands[i], estimator, maxDspNum,
-                        maxExplParallel, maxLoopParallel, directiveOnly);
+    auto space = LoopDesignSpace(tmpFunc, targetBands[i], estimator, maxDspNum,
+                                 maxBramNum, maxUramNum, maxLutNum,
+                                 maxExplParallel, maxLoopParallel,
+                                 directiveOnly, numThreads, cache);
+    space.module = func->getParentOfType<ModuleOp>();
+
+    // Record the estimation results of the loop band into the checkpoint.
+    // Restored records that do not match the loop band are dropped.
+    if (checkpoint) {
+      space.checkpoint = checkpoint;
+      space.checkpointName =
+          func.getName().str() + "_loop_" + std::to_string(i);
+
+      SmallVector<unsigned, 8> radices;
+      for (auto &validSizes : space.validTileSizesList)
+        radices.push_back(validSizes.size());
+      if (!checkpoint->verifyBand(space.checkpointName, radices))
+        func.emitWarning("checkpoint records of loop band " +
+                         std::to_string(i) +
+                         " do not match the loop band and are dropped");
+    }
+
+    // Stream all evaluated design points of the loop band to disk. As the
+    // non-pareto points are only kept in the file, the exploration fails if
+    // the file cannot be opened.
+    auto loopPointsFilePath = csvRootPath.str() + func.getName().str() +
+                              "_loop_" + std::to_string(i) + "_points.bin";
+    if (!space.openPointWriter(loopPointsFilePath)) {
+      func.emitError("failed to open file \"" + loopPointsFilePath +
+                     "\" for streaming design points");
+      return failure();
+    }
+    space.maxRecordNum = maxRecordNum;
 
     LLVM_DEBUG(llvm::dbgs() << "Loop band " << i << ": ";);
     space.initializeLoopDesignSpace(maxInitParallel);
 
     LLVM_DEBUG(llvm::dbgs() << "Loop band " << i << ": ";);
-    space.exploreLoopDesignSpace(maxIterNum, maxDistance);
+    auto strategy = createDSEStrategy(strategyOpts, strategyOpts.seed + i);
+    assert(strategy && "unknown DSE strategy");
+    space.exploreLoopDesignSpace(*strategy, maxIterNum, maxDistance);
+    space.releaseEvaluationState();
     loopSpaces.push_back(space);
 
     // Dump design points to csv file for each loop band.
     auto loopCsvFilePath = csvRootPath.str() + func.getName().str() + "_loop_" +
                            std::to_string(i) + "_space.csv";
     space.dumpLoopDesignSpace(loopCsvFilePath);
+
+    if (checkpoint)
+      checkpoint->save();
   }
 
   // Combine all loop design spaces into a function design space.
   tmpFunc = func.clone();
-  auto funcSpace = FuncDesignSpace(tmpFunc, loopSpaces, estimator, maxDspNum);
+  auto funcSpace =
+      FuncDesignSpace(tmpFunc, loopSpaces, estimator, maxDspNum, maxBramNum,
+                      maxUramNum, maxLutNum, incremental, numThreads);
   funcSpace.combLoopDesignSpaces();
 
   // Dump design points to csv file for each function.
@@ -766,11 +2040,17 @@ bool ScaleHLSExplorer::exploreDesignSpace(func::FuncOp func, bool directiveOnly,
   funcSpace.dumpFuncDesignSpace(funcCsvFilePath);
 
   // Export sampled pareto points MLIR source.
-  funcSpace.exportParetoDesigns(outputNum, outputRootPath);
+  funcSpace.module = func->getParentOfType<ModuleOp>();
+  if (!funcSpace.exportParetoDesigns(outputNum, outputRootPath, emitCpp)) {
+    func.emitError("failed to export pareto designs to path \"" +
+                   outputRootPath.str() + "\"");
+    return failure();
+  }
 
   // Apply the best function design point under the constraints.
   for (auto &funcPoint : funcSpace.paretoPoints) {
-    if (funcPoint.dspNum <= maxDspNum) {
+    if (funcPoint.dspNum <= maxDspNum && funcPoint.bramNum <= maxBramNum &&
+        funcPoint.uramNum <= maxUramNum && funcPoint.lutNum <= maxLutNum) {
       std::vector<FactorList> tileLists;
       SmallVector<unsigned, 4> targetIIs;
 
@@ -789,38 +2069,40 @@ bool ScaleHLSExplorer::exploreDesignSpace(func::FuncOp func, bool directiveOnly,
         targetIIs.push_back(targetII);
       }
 
+      // The function is kept untouched if the strategy fails to be applied.
       if (!applyOptStrategy(func, tileLists, targetIIs))
-        return false;
+        return success();
       break;
     }
   }
 
-  return emitQoRDebugInfo(func, "\nFinish Stage3.");
+  emitQoRDebugInfo(func, "\nFinish Stage3.");
+  return success();
 }
 
 //===----------------------------------------------------------------------===//
 // DesignSpaceExplore Entry
 //===----------------------------------------------------------------------===//
 
-/// This is a temporary approach that does not scale.
-void ScaleHLSExplorer::applyDesignSpaceExplore(func::FuncOp func,
-                                               bool directiveOnly,
-                                               StringRef outputRootPath,
-                                               StringRef csvRootPath) {
+/// This is a temporary approach that does not scale. The exploration stops
+/// early if the design is out of the resource budgets, and fails if any error
+/// is encountered.
+LogicalResult ScaleHLSExplorer::applyDesignSpaceExplore(
+    func::FuncOp func, bool directiveOnly, StringRef outputRootPath,
+    StringRef csvRootPath) {
   emitQoRDebugInfo(func, "Start multiple level DSE.");
 
   // Simplify loop nests by unrolling.
   if (!simplifyLoopNests(func))
-    return;
+    return success();
 
   // Optimize loop bands by loop perfection, loop order permutation, and loop
   // rectangularization.
   if (!optimizeLoopBands(func, directiveOnly))
-    return;
+    return success();
 
   // Explore the design space through a multiple level approach.
-  if (!exploreDesignSpace(func, directiveOnly, outputRootPath, csvRootPath))
-    return;
+  return exploreDesignSpace(func, directiveOnly, outputRootPath, csvRootPath);
 }
 
 namespace {
@@ -869,8 +2151,20 @@ struct DesignSpaceExplore : public DesignSpaceExploreBase<DesignSpaceExplore> {
     unsigned maxIterNum = configObj->getInteger("max_iter_num").value_or(30);
     float maxDistance = configObj->getNumber("max_distance").value_or(3.0);
 
+    // The number of threads used in the evaluation of tile configs, where zero
+    // means using all available hardware threads.
+    unsigned numThreads = configObj->getInteger("num_threads").value_or(1);
+    if (numThreads == 0)
+      numThreads = llvm::hardware_concurrency().compute_thread_count();
+
     bool directiveOnly =
         configObj->getBoolean("directive_only").value_or(false);
+
+    // Whether to emit HLS C++ code of the exported pareto designs in addition
+    // to the MLIR files.
+    bool emitCpp = configObj->getBoolean("emit_hlscpp").value_or(false);
+    bool incremental =
+        configObj->getBoolean("incremental_estimation").value_or(false);
     bool resourceConstr =
         configObj->getBoolean("resource_constr").value_or(true);
 
@@ -880,23 +2174,108 @@ struct DesignSpaceExplore : public DesignSpaceExploreBase<DesignSpaceExplore> {
     getLatencyMap(configObj, latencyMap);
     llvm::StringMap<int64_t> dspUsageMap;
     getDspUsageMap(configObj, dspUsageMap);
+    llvm::StringMap<int64_t> lutUsageMap;
+    getLutUsageMap(configObj, lutUsageMap);
+    OperatorLibrary library;
+    if (!getOperatorLibrary(configObj, library)) {
+      llvm::errs() << "failed to parse the operator library in the target spec "
+                      "json file\n";
+      return signalPassFailure();
+    }
 
+    // Collect the budget of each resource. The DSP budget defaults to the
+    // Xilinx PYNQ-Z1 board, while the BRAM, URAM, and LUT budgets are only
+    // enforced when they are given in the target spec.
     unsigned maxDspNum = ceil(configObj->getInteger("dsp").value_or(220) * 1.1);
-    if (!resourceConstr)
+    unsigned maxBramNum = UINT_MAX;
+    if (auto bram = configObj->getInteger("bram"))
+      maxBramNum = ceil(bram.value() * 1.1);
+    unsigned maxUramNum = UINT_MAX;
+    if (auto uram = configObj->getInteger("uram"))
+      maxUramNum = ceil(uram.value() * 1.1);
+    unsigned maxLutNum = UINT_MAX;
+    if (auto lut = configObj->getInteger("lut"))
+      maxLutNum = ceil(lut.value() * 1.1);
+    if (!resourceConstr) {
       maxDspNum = UINT_MAX;
+      maxBramNum = UINT_MAX;
+      maxUramNum = UINT_MAX;
+      maxLutNum = UINT_MAX;
+    }
+
+    // Collect the search strategy of DSE, which can be "neighbor", "annealing",
+    // or "nsga2". Given the same seed, the DSE results are reproducible.
+    DSEStrategyOptions strategyOpts;
+    if (auto name = configObj->getString("dse_strategy"))
+      strategyOpts.name = name.value().str();
+    strategyOpts.seed = configObj->getInteger("seed").value_or(0);
+    strategyOpts.batchSize = configObj->getInteger("batch_size").value_or(1);
+    strategyOpts.populationSize =
+        configObj->getInteger("population_size").value_or(16);
+    strategyOpts.initialTemperature =
+        configObj->getNumber("initial_temperature").value_or(1.0);
+    strategyOpts.coolingRate =
+        configObj->getNumber("cooling_rate").value_or(0.9);
+    if (!createDSEStrategy(strategyOpts, strategyOpts.seed)) {
+      llvm::errs() << "unknown DSE strategy \"" << strategyOpts.name << "\"\n";
+      return signalPassFailure();
+    }
+
+    // Set up the checkpoint of the exploration, which is keyed by the hash of
+    // the module and the target spec. If required, the exploration is resumed
+    // from the checkpoint saved by a previous run.
+    std::string moduleString;
+    llvm::raw_string_ostream moduleStream(moduleString);
+    module->print(moduleStream, OpPrintingFlags().printGenericOpForm());
+    moduleStream.flush();
+
+    llvm::MD5 hasher;
+    hasher.update(moduleString);
+    hasher.update(configFile->getBuffer());
+    llvm::MD5::MD5Result hash;
+    hasher.final(hash);
+
+    unsigned checkpointInterval =
+        configObj->getInteger("checkpoint_interval").value_or(32);
+    auto checkpoint =
+        DSECheckpoint(csvPath + "dse_checkpoint.jsonl",
+                      hash.digest().str(), std::max(checkpointInterval, 1u));
+    std::string checkpointError;
+    if (resume && !checkpoint.restore(checkpointError))
+      llvm::errs() << "no valid checkpoint is found (" << checkpointError
+                   << "), the exploration starts from scratch\n";
+
+    // Open the persistent estimation cache if specified.
+    std::unique_ptr<EstimationCache> cache;
+    if (auto cachePath = configObj->getString("estimation_cache")) {
+      cache = std::make_unique<EstimationCache>(
+          cachePath.value(), latencyMap, dspUsageMap, lutUsageMap, library);
+      if (!cache->isOpen())
+        llvm::errs() << "failed to open the estimation cache file, the "
+                        "estimation results will not be saved\n";
+    }
 
     // Initialize an performance and resource estimator.
-    auto estimator = ScaleHLSEstimator(latencyMap, dspUsageMap, true);
-    auto explorer = ScaleHLSExplorer(estimator, outputNum, maxDspNum,
-                                     maxInitParallel, maxExplParallel,
-                                     maxLoopParallel, maxIterNum, maxDistance);
+    auto estimator =
+        ScaleHLSEstimator(latencyMap, dspUsageMap, lutUsageMap, library, true);
+    auto explorer = ScaleHLSExplorer(
+        estimator, outputNum, maxDspNum, maxBramNum, maxUramNum, maxLutNum,
+        maxInitParallel, maxExplParallel, maxLoopParallel, maxIterNum,
+        maxDistance, numThreads, cache.get(), incremental, strategyOpts,
+        &checkpoint, emitCpp);
+
+    // The maximum number of estimation records held in memory by each loop
+    // design space.
+    explorer.maxRecordNum =
+        configObj->getInteger("max_record_num").value_or(65536);
 
     // Optimize the top function.
     // TODO: Support to contain sub-functions.
     for (auto func : module.getOps<func::FuncOp>()) {
       if (hasTopFuncAttr(func))
-        explorer.applyDesignSpaceExplore(func, directiveOnly, outputPath,
-                                         csvPath);
+        if (failed(explorer.applyDesignSpaceExplore(func, directiveOnly,
+                                                    outputPath, csvPath)))
+          return signalPassFailure();
     }
   }
 };
@@ -4,6 +4,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "scalehls/Transforms/Utils.h"
 #include "llvm/Support/Debug.h"
@@ -477,10 +478,408 @@ bool scalehls::applyAutoArrayPartition(func::FuncOp func, unsigned threshold) {
   return true;
 }
 
+//===----------------------------------------------------------------------===//
+// QoR-aware Array Partition
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A group of on-chip arrays that must share the same partition layout, which
+/// are connected through the call graph by passing the arrays of callers as
+/// the arguments of callees.
+struct ArrayGroup {
+  SmallVector<Value, 4> arrays;
+  MemRefType baseType;
+  SmallVector<PartitionKind, 4> kinds;
+  SmallVector<unsigned, 4> factors;
+};
+
+/// The QoR of a partition solution, which is compared lexicographically: the
+/// BRAM utilization exceeding the budget, the latency of the top function, the
+/// sum of the resource-bound II of all pipelined loops and functions, the sum
+/// of the mux size of all accesses with uncertain partition indices, and the
+/// BRAM utilization.
+struct PartitionQoR {
+  int64_t overBramNum = 0;
+  int64_t latency = 0;
+  int64_t resII = 0;
+  int64_t muxSize = 0;
+  int64_t bramNum = 0;
+
+  bool operator<(const PartitionQoR &other) const {
+    return std::tie(overBramNum, latency, resII, muxSize, bramNum) <
+           std::tie(other.overBramNum, other.latency, other.resII,
+                    other.muxSize, other.bramNum);
+  }
+};
+
+/// Search the partition layouts of all on-chip arrays in the call graph of the
+/// top function. Arrays shared across functions are partitioned jointly, and
+/// each step of the search applies the layout change of a single array group
+/// leading to the best QoR. Only the arrays accessed in pipelined loops or
+/// functions bounded by memory ports are changed, unless the BRAM budget is
+/// exceeded.
+class ArrayPartitionSearch {
+public:
+  explicit ArrayPartitionSearch(func::FuncOp topFunc,
+                                ScaleHLSEstimator &estimator,
+                                int64_t maxBramNum, unsigned threshold)
+      : topFunc(topFunc), estimator(estimator), maxBramNum(maxBramNum),
+        threshold(threshold) {}
+
+  void run();
+
+private:
+  void collectArrayGroups();
+  void applyLayout(ArrayGroup &group);
+  int64_t getBramNum(const ArrayGroup &group);
+  PartitionQoR evaluate();
+  void report(const PartitionQoR &initQoR, const PartitionQoR &finalQoR);
+
+  func::FuncOp topFunc;
+  ScaleHLSEstimator &estimator;
+  int64_t maxBramNum;
+  unsigned threshold;
+
+  SmallVector<func::FuncOp, 8> funcs;
+  SmallVector<ArrayGroup, 16> groups;
+  DenseMap<Value, unsigned> groupMap;
+
+  // The groups accessed in port-bound pipelined loops or functions in the last
+  // evaluation.
+  llvm::SmallSetVector<unsigned, 8> portBoundGroups;
+};
+} // namespace
+
+static bool isOnChipArray(Value array) {
+  auto type = array.getType().dyn_cast<MemRefType>();
+  return type && type.hasStaticShape() && !isExtBuffer(array);
+}
+
+static void getPartitionLayout(MemRefType type,
+                               SmallVectorImpl<PartitionKind> &kinds,
+                               SmallVectorImpl<unsigned> &factors) {
+  kinds.assign(type.getRank(), PartitionKind::NONE);
+  factors.assign(type.getRank(), 1);
+  if (auto attr = type.getLayout().dyn_cast<PartitionLayoutAttr>())
+    for (int64_t dim = 0; dim < type.getRank(); ++dim) {
+      kinds[dim] = attr.getKinds()[dim];
+      factors[dim] = attr.getFactors()[dim];
+    }
+}
+
+/// Collect all on-chip arrays in the call graph of the top function and group
+/// them with the union-find of the call operands and callee arguments.
+void ArrayPartitionSearch::collectArrayGroups() {
+  llvm::SetVector<func::FuncOp> funcSet;
+  funcSet.insert(topFunc);
+  for (unsigned i = 0; i < funcSet.size(); ++i)
+    funcSet[i].walk([&](func::CallOp call) {
+      auto callee =
+          SymbolTable::lookupNearestSymbolFrom(call, call.getCalleeAttr());
+      if (auto subFunc = dyn_cast_or_null<func::FuncOp>(callee))
+        funcSet.insert(subFunc);
+    });
+  funcs.assign(funcSet.begin(), funcSet.end());
+
+  SmallVector<Value, 32> arrays;
+  SmallVector<unsigned, 32> leaders;
+  DenseMap<Value, unsigned> indexMap;
+  auto addArray = [&](Value array) {
+    if (isOnChipArray(array) &&
+        indexMap.insert({array, arrays.size()}).second) {
+      leaders.push_back(arrays.size());
+      arrays.push_back(array);
+    }
+  };
+  auto findLeader = [&](unsigned index) {
+    while (leaders[index] != index)
+      index = leaders[index] = leaders[leaders[index]];
+    return index;
+  };
+
+  for (auto func : funcs) {
+    for (auto arg : func.getArguments())
+      addArray(arg);
+    func.walk([&](Operation *op) {
+      if (isa<BufferOp, memref::AllocOp, memref::AllocaOp>(op))
+        addArray(op->getResult(0));
+    });
+  }
+
+  // Arrays passed to the same callee argument must share the same layout.
+  for (auto func : funcs)
+    func.walk([&](func::CallOp call) {
+      auto callee =
+          SymbolTable::lookupNearestSymbolFrom(call, call.getCalleeAttr());
+      auto subFunc = dyn_cast_or_null<func::FuncOp>(callee);
+      if (!subFunc)
+        return;
+      for (auto [operand, arg] :
+           llvm::zip(call.getOperands(), subFunc.getArguments())) {
+        auto operandIt = indexMap.find(operand);
+        auto argIt = indexMap.find(arg);
+        if (operandIt != indexMap.end() && argIt != indexMap.end())
+          leaders[findLeader(argIt->second)] = findLeader(operandIt->second);
+      }
+    });
+
+  DenseMap<unsigned, unsigned> leaderToGroup;
+  for (unsigned index = 0, e = arrays.size(); index < e; ++index) {
+    auto result =
+        leaderToGroup.insert({findLeader(index), (unsigned)groups.size()});
+    if (result.second)
+      groups.emplace_back();
+    groups[result.first->second].arrays.push_back(arrays[index]);
+    groupMap[arrays[index]] = result.first->second;
+  }
+
+  // Arrays with different shapes or element types cannot be partitioned
+  // jointly, thus their groups are left untouched.
+  for (auto &group : groups) {
+    auto type = group.arrays.front().getType().cast<MemRefType>();
+    if (llvm::any_of(group.arrays, [&](Value array) {
+          auto arrayType = array.getType().cast<MemRefType>();
+          return arrayType.getShape() != type.getShape() ||
+                 arrayType.getElementType() != type.getElementType();
+        }))
+      continue;
+    group.baseType = MemRefType::get(type.getShape(), type.getElementType(),
+                                     MemRefLayoutAttrInterface(),
+                                     type.getMemorySpace());
+  }
+}
+
+/// Apply the layout of the group to all its arrays.
+void ArrayPartitionSearch::applyLayout(ArrayGroup &group) {
+  auto array = group.arrays.front();
+  array.setType(group.baseType);
+  if (llvm::any_of(group.kinds, [](PartitionKind kind) {
+        return kind != PartitionKind::NONE;
+      }))
+    applyArrayPartition(array, group.factors, group.kinds, false, threshold);
+  for (auto other : llvm::drop_begin(group.arrays))
+    other.setType(array.getType());
+
+  // Align function types with entry block argument types.
+  auto builder = Builder(topFunc);
+  for (auto func : funcs) {
+    auto resultTypes = func.front().getTerminator()->getOperandTypes();
+    auto inputTypes = func.front().getArgumentTypes();
+    func.setType(builder.getFunctionType(inputTypes, resultTypes));
+  }
+}
+
+/// Return the BRAM utilization of the group, which is calculated in the same
+/// way as the estimator. Function arguments are not counted as they are
+/// instantiated by their callers.
+int64_t ArrayPartitionSearch::getBramNum(const ArrayGroup &group) {
+  int64_t bramNum = 0;
+  for (auto array : group.arrays) {
+    auto defOp = array.getDefiningOp();
+    if (!defOp)
+      continue;
+    int64_t depth = 1;
+    if (auto buffer = dyn_cast<BufferOp>(defOp))
+      depth = buffer.getDepth();
+    auto type = array.getType().cast<MemRefType>();
+    bramNum += getMemoryResource(type, depth).bram;
+  }
+  return bramNum;
+}
+
+/// Estimate the top function and all its sub-functions, and collect the QoR of
+/// the current partition solution.
+PartitionQoR ArrayPartitionSearch::evaluate() {
+  DenseMap<Operation *, int64_t> resMinIIs;
+  estimator.recordResMinII(&resMinIIs);
+  estimator.estimateFunc(topFunc);
+  estimator.recordResMinII(nullptr);
+
+  PartitionQoR qor;
+  if (auto timing = getTiming(topFunc))
+    qor.latency = timing.getLatency();
+  else
+    qor.latency = std::numeric_limits<int64_t>::max();
+
+  portBoundGroups.clear();
+  for (auto [op, resII] : resMinIIs) {
+    qor.resII += resII;
+    if (resII <= 1)
+      continue;
+
+    // Collect the arrays accessed by the port-bound loop or function.
+    auto &block = isa<func::FuncOp>(op) ? cast<func::FuncOp>(op).front()
+                                        : *cast<AffineForOp>(op).getBody();
+    MemAccessesMap accessesMap;
+    getMemAccessesMap(block, accessesMap, /*includeVectorTransfer=*/true);
+    for (auto &pair : accessesMap) {
+      auto groupIt = groupMap.find(pair.first);
+      if (groupIt != groupMap.end() && groups[groupIt->second].baseType)
+        portBoundGroups.insert(groupIt->second);
+    }
+  }
+
+  for (auto func : funcs)
+    func.walk([&](Operation *op) {
+      if (auto maxMuxSize = op->getAttrOfType<IntegerAttr>("max_mux_size"))
+        qor.muxSize += maxMuxSize.getInt();
+    });
+
+  for (auto &group : groups)
+    qor.bramNum += getBramNum(group);
+  qor.overBramNum = std::max(qor.bramNum - maxBramNum, (int64_t)0);
+  return qor;
+}
+
+void ArrayPartitionSearch::run() {
+  // Hold the types before partition, and start the search from the solution
+  // of the access pattern analysis.
+  collectArrayGroups();
+  applyAutoArrayPartition(topFunc, threshold);
+
+  for (auto &group : groups)
+    if (group.baseType) {
+      // Take the layout with the most partitions as the initial layout.
+      unsigned maxPartitionNum = 0;
+      for (auto array : group.arrays) {
+        auto type = array.getType().cast<MemRefType>();
+        auto partitionNum = (unsigned)getPartitionFactors(type);
+        if (partitionNum > maxPartitionNum) {
+          maxPartitionNum = partitionNum;
+          getPartitionLayout(type, group.kinds, group.factors);
+        }
+      }
+      applyLayout(group);
+    }
+
+  auto initQoR = evaluate();
+  auto currentQoR = initQoR;
+  while (true) {
+    // Collect the groups to be changed. If the BRAM budget is exceeded, all
+    // groups are considered for shrinking their partitions.
+    SmallVector<unsigned, 16> targetGroups;
+    if (currentQoR.overBramNum > 0) {
+      for (unsigned index = 0, e = groups.size(); index < e; ++index)
+        if (groups[index].baseType)
+          targetGroups.push_back(index);
+    } else {
+      targetGroups.assign(portBoundGroups.begin(), portBoundGroups.end());
+      llvm::sort(targetGroups);
+    }
+
+    // Try each candidate layout, which increases or decreases the factor of a
+    // dimension to its adjacent divisor of the dimension size, or switches the
+    // partition kind between "cyclic" and "block".
+    using Layout =
+        std::pair<SmallVector<PartitionKind, 4>, SmallVector<unsigned, 4>>;
+    Optional<std::pair<unsigned, Layout>> bestMove;
+    auto bestQoR = currentQoR;
+    for (auto index : targetGroups) {
+      auto &group = groups[index];
+      auto currentLayout = Layout(group.kinds, group.factors);
+
+      SmallVector<Layout, 8> candidates;
+      for (int64_t dim = 0; dim < group.baseType.getRank(); ++dim) {
+        auto size = group.baseType.getDimSize(dim);
+        auto kind = group.kinds[dim];
+        auto factor = group.factors[dim];
+        auto addCandidate = [&](PartitionKind newKind, unsigned newFactor) {
+          auto layout = currentLayout;
+          layout.first[dim] = newFactor == 1 ? PartitionKind::NONE : newKind;
+          layout.second[dim] = newFactor;
+          candidates.push_back(layout);
+        };
+
+        for (auto larger = factor + 1; larger <= size; ++larger)
+          if (size % larger == 0) {
+            if (kind == PartitionKind::NONE) {
+              addCandidate(PartitionKind::CYCLIC, larger);
+              addCandidate(PartitionKind::BLOCK, larger);
+            } else
+              addCandidate(kind, larger);
+            break;
+          }
+        for (auto smaller = factor - 1; smaller > 0; --smaller)
+          if (size % smaller == 0) {
+            addCandidate(kind, smaller);
+            break;
+          }
+        if (kind == PartitionKind::CYCLIC)
+          addCandidate(PartitionKind::BLOCK, factor);
+        else if (kind == PartitionKind::BLOCK)
+          addCandidate(PartitionKind::CYCLIC, factor);
+      }
+
+      for (auto &candidate : candidates) {
+        std::tie(group.kinds, group.factors) = candidate;
+        applyLayout(group);
+        auto qor = evaluate();
+        if (qor < bestQoR) {
+          bestQoR = qor;
+          bestMove = std::make_pair(index, candidate);
+        }
+      }
+      std::tie(group.kinds, group.factors) = currentLayout;
+      applyLayout(group);
+    }
+
+    if (!bestMove)
+      break;
+    auto &group = groups[bestMove->first];
+    std::tie(group.kinds, group.factors) = bestMove->second;
+    applyLayout(group);
+    currentQoR = evaluate();
+    LLVM_DEBUG(llvm::dbgs() << "\nUpdate layout of " << group.arrays.front()
+                            << ", latency=" << currentQoR.latency
+                            << " resII=" << currentQoR.resII
+                            << " bram=" << currentQoR.bramNum;);
+  }
+  report(initQoR, currentQoR);
+}
+
+/// Report the chosen layout of each array group as a remark attached to the
+/// array defined in the outermost function, and the overall QoR as a remark
+/// attached to the top function.
+void ArrayPartitionSearch::report(const PartitionQoR &initQoR,
+                                  const PartitionQoR &finalQoR) {
+  for (auto &group : groups) {
+    if (!group.baseType)
+      continue;
+    auto array = group.arrays.front();
+    auto type = array.getType().cast<MemRefType>();
+
+    SmallPtrSet<Operation *, 4> groupFuncs;
+    for (auto other : group.arrays)
+      groupFuncs.insert(
+          other.getParentRegion()->getParentOfType<func::FuncOp>());
+
+    auto diag = mlir::emitRemark(array.getLoc(), "array partition: ");
+    if (auto attr = type.getLayout().dyn_cast<PartitionLayoutAttr>())
+      diag << attr;
+    else
+      diag << "none";
+    diag << ", bram=" << getBramNum(group)
+         << ", functions=" << groupFuncs.size();
+    if (portBoundGroups.count(groupMap[array]))
+      diag << ", port-bound";
+  }
+
+  topFunc.emitRemark() << "array partition search: latency "
+                       << initQoR.latency << " -> " << finalQoR.latency
+                       << ", resource-bound II " << initQoR.resII << " -> "
+                       << finalQoR.resII << ", bram " << finalQoR.bramNum
+                       << "/" << maxBramNum;
+}
+
 namespace {
 struct ArrayPartition : public ArrayPartitionBase<ArrayPartition> {
   ArrayPartition() = default;
-  explicit ArrayPartition(unsigned argThreshold) { threshold = argThreshold; }
+  explicit ArrayPartition(unsigned argThreshold, bool argQoRAware,
+                          std::string partitionTargetSpec) {
+    threshold = argThreshold;
+    qorAware = argQoRAware;
+    targetSpec = partitionTargetSpec;
+  }
 
   void runOnOperation() override {
     auto module = getOperation();
@@ -500,11 +899,26 @@ struct ArrayPartition : public ArrayPartitionBase<ArrayPartition> {
       emitError(module.getLoc(), "fail to find the top function");
       return signalPassFailure();
     }
-    applyAutoArrayPartition(topFunc, threshold);
+
+    if (!qorAware) {
+      applyAutoArrayPartition(topFunc, threshold);
+      return;
+    }
+
+    TargetSpec spec;
+    if (!spec.load(targetSpec))
+      return signalPassFailure();
+    auto maxBramNum = spec.getConfig()->getInteger("bram").value_or(280);
+    auto estimator = spec.createEstimator();
+    ArrayPartitionSearch(topFunc, *estimator, maxBramNum, threshold).run();
+    removeEstimation(module);
   }
 };
 } // namespace
 
-std::unique_ptr<Pass> scalehls::createArrayPartitionPass(unsigned threshold) {
-  return std::make_unique<ArrayPartition>(threshold);
+std::unique_ptr<Pass>
+scalehls::createArrayPartitionPass(unsigned threshold, bool qorAware,
+                                   std::string partitionTargetSpec) {
+  return std::make_unique<ArrayPartition>(threshold, qorAware,
+                                          partitionTargetSpec);
 }
@@ -39,7 +39,11 @@ struct CreateAxiInterface : public CreateAxiInterfaceBase<CreateAxiInterface> {
     auto mainBlock = mainFunc.addEntryBlock();
     builder.setInsertionPointToEnd(mainBlock);
 
-    // Move all the arguments of the top function to the main function.
+    // Move all the arguments of the top function to the main function. The
+    // widened bitwidths of the arguments are recorded before moving.
+    SmallVector<IntegerAttr, 32> argBitwidths;
+    for (auto funcArg : func.getArguments())
+      argBitwidths.push_back(getMaxWidenBitwidth(funcArg));
     for (auto [funcArg, mainArg] :
          llvm::zip(func.getArguments(), mainBlock->getArguments()))
       funcArg.replaceAllUsesWith(mainArg);
@@ -67,9 +71,11 @@ struct CreateAxiInterface : public CreateAxiInterfaceBase<CreateAxiInterface> {
     // time, we also directly collect all scalar arguments into "funcPorts".
     SmallVector<Value, 32> buffers;
     SmallVector<Value, 32> funcPorts;
+    DenseMap<Value, IntegerAttr> bufferBitwidths;
     for (auto arg : mainBlock->getArguments())
       if (arg.getType().isa<MemRefType, StreamType>()) {
         buffers.push_back(getSelfOrVectorizedBuffer(arg));
+        bufferBitwidths[buffers.back()] = argBitwidths[arg.getArgNumber()];
       } else if (arg.getType().isa<ShapedType>()) {
         emitError(arg.getLoc(), "unsupported argument type");
         return signalPassFailure();
@@ -88,6 +94,8 @@ struct CreateAxiInterface : public CreateAxiInterfaceBase<CreateAxiInterface> {
       buffer->remove();
       builder.insert(buffer);
       buffers.push_back(getSelfOrVectorizedBuffer(buffer.getMemref()));
+      bufferBitwidths[buffers.back()] =
+          getMaxWidenBitwidth(buffer.getMemref());
     }
 
     // A helper to get AXI bundle type from a buffer.
@@ -116,6 +124,8 @@ struct CreateAxiInterface : public CreateAxiInterfaceBase<CreateAxiInterface> {
         auto axiPort = builder.create<AxiPortOp>(
             loc, buffer.getType(), bundle,
             func.front().addArgument(axiType, buffer.getLoc()));
+        if (auto bitwidth = bufferBitwidths.lookup(buffer))
+          axiPort->setAttr("max_widen_bitwidth", bitwidth);
         use.set(axiPort);
 
         builder.setInsertionPointToEnd(mainBlock);
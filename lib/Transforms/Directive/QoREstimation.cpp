@@ -5,16 +5,296 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Dialect/Affine/Analysis/Utils.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Support/FileUtilities.h"
 #include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include <chrono>
 
 using namespace std;
 using namespace mlir;
 using namespace scalehls;
 using namespace hls;
 
+//===----------------------------------------------------------------------===//
+// OperatorLibrary Class Definition
+//===----------------------------------------------------------------------===//
+
+void OperatorLibrary::insert(StringRef name, unsigned bitWidth,
+                             OperatorCost cost) {
+  auto &costs = operators[name];
+  auto it = llvm::partition_point(
+      costs, [&](const auto &entry) { return entry.first < bitWidth; });
+  if (it != costs.end() && it->first == bitWidth)
+    it->second = cost;
+  else
+    costs.insert(it, std::make_pair(bitWidth, cost));
+}
+
+Optional<OperatorCost> OperatorLibrary::lookup(StringRef name,
+                                               unsigned bitWidth) const {
+  auto costsIt = operators.find(name);
+  if (costsIt == operators.end() || costsIt->second.empty())
+    return Optional<OperatorCost>();
+  auto &costs = costsIt->second;
+
+  if (bitWidth <= costs.front().first)
+    return costs.front().second;
+  if (bitWidth >= costs.back().first)
+    return costs.back().second;
+
+  auto upper = llvm::partition_point(
+      costs, [&](const auto &entry) { return entry.first < bitWidth; });
+  if (upper->first == bitWidth)
+    return upper->second;
+  auto lower = std::prev(upper);
+
+  // The interpolated cost is rounded up to be conservative.
+  int64_t offset = bitWidth - lower->first;
+  int64_t range = upper->first - lower->first;
+  auto interpolate = [&](int64_t lowerValue, int64_t upperValue) {
+    auto delta = (upperValue - lowerValue) * offset;
+    return lowerValue +
+           (delta > 0 ? (delta + range - 1) / range : delta / range);
+  };
+  OperatorCost cost;
+  cost.latency = interpolate(lower->second.latency, upper->second.latency);
+  cost.dsp = interpolate(lower->second.dsp, upper->second.dsp);
+  cost.lut = interpolate(lower->second.lut, upper->second.lut);
+  return cost;
+}
+
+/// Return a string describing all characterized operators in a sorted order.
+std::string OperatorLibrary::getSignature() const {
+  SmallVector<StringRef, 16> names;
+  for (auto &entry : operators)
+    names.push_back(entry.first());
+  llvm::sort(names);
+
+  std::string signature;
+  for (auto name : names) {
+    signature += name.str() + "=";
+    for (auto &entry : operators.lookup(name))
+      signature += std::to_string(entry.first) + ":" +
+                   std::to_string(entry.second.latency) + "," +
+                   std::to_string(entry.second.dsp) + "," +
+                   std::to_string(entry.second.lut) + ",";
+    signature += ";";
+  }
+  return signature;
+}
+
+//===----------------------------------------------------------------------===//
+// EstimationCache Class Definition
+//===----------------------------------------------------------------------===//
+
+/// The cache file starts with a magic string, followed by records that are
+/// composed of a 32-bytes hex key and six 64-bits little-endian integers.
+static constexpr StringLiteral cacheMagic = "SHLSQOR3";
+static constexpr unsigned cacheKeySize = 32;
+static constexpr unsigned cacheRecordSize = cacheKeySize + 6 * 8;
+
+/// The maximum time of waiting for the lock of the cache file.
+static constexpr std::chrono::milliseconds cacheLockTimeout(10000);
+
+/// Parse all complete records of the cache file data, and call "callback" with
+/// each record. Return the size of the data holding the magic string and the
+/// complete records, which is zero if the magic string is mismatched.
+static uint64_t
+parseCacheRecords(StringRef data,
+                  function_ref<void(StringRef, EstimationRecord)> callback) {
+  if (!data.startswith(cacheMagic))
+    return 0;
+
+  uint64_t validSize = cacheMagic.size();
+  for (; validSize + cacheRecordSize <= data.size();
+       validSize += cacheRecordSize) {
+    auto ptr = data.data() + validSize;
+    auto key = StringRef(ptr, cacheKeySize);
+    ptr += cacheKeySize;
+
+    EstimationRecord record;
+    record.latency = llvm::support::endian::read64le(ptr);
+    record.interval = llvm::support::endian::read64le(ptr + 8);
+    record.dsp = llvm::support::endian::read64le(ptr + 16);
+    record.bram = llvm::support::endian::read64le(ptr + 24);
+    record.uram = llvm::support::endian::read64le(ptr + 32);
+    record.lut = llvm::support::endian::read64le(ptr + 40);
+    callback(key, record);
+  }
+  return validSize;
+}
+
+/// Read all records of the cache file. Return failure if the file cannot be
+/// read, is written in an obsolete format, or ends with an incomplete record.
+LogicalResult scalehls::readEstimationCache(
+    StringRef filePath,
+    function_ref<void(StringRef, EstimationRecord)> callback) {
+  auto buffer = llvm::MemoryBuffer::getFile(
+      filePath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return failure();
+  auto data = buffer.get()->getBuffer();
+  auto validSize = parseCacheRecords(data, callback);
+  return success(validSize != 0 && validSize == data.size());
+}
+
+EstimationCache::EstimationCache(StringRef filePath,
+                                 const llvm::StringMap<int64_t> &latencyMap,
+                                 const llvm::StringMap<int64_t> &dspUsageMap,
+                                 const llvm::StringMap<int64_t> &lutUsageMap,
+                                 const OperatorLibrary &library) {
+  // Encode the latency/DSP/LUT usage mapping and the operator library into the
+  // signature in a sorted order. The version tag must be updated once the
+  // estimator is changed.
+  auto appendMap = [&](StringRef name, const llvm::StringMap<int64_t> &map) {
+    SmallVector<std::pair<StringRef, int64_t>, 8> entries;
+    for (auto &entry : map)
+      entries.push_back({entry.first(), entry.second});
+    llvm::sort(entries);
+
+    signature += name.str() + ":";
+    for (auto entry : entries)
+      signature += entry.first.str() + "=" + std::to_string(entry.second) + ";";
+  };
+  signature = "scalehls-qor-v7;";
+  appendMap("latency", latencyMap);
+  appendMap("dsp", dspUsageMap);
+  appendMap("lut", lutUsageMap);
+  signature += "operators:" + library.getSignature();
+
+  // Open the cache file for appending new records. All accesses to the file
+  // are guarded by an advisory lock, such that parallel processes never
+  // interleave their records.
+  if (llvm::sys::fs::openFileForReadWrite(filePath, fd,
+                                          llvm::sys::fs::CD_OpenAlways,
+                                          llvm::sys::fs::OF_Append)) {
+    fd = -1;
+    return;
+  }
+  if (llvm::sys::fs::tryLockFile(fd, cacheLockTimeout)) {
+    closeFile();
+    return;
+  }
+
+  // Load all existing records. A file without the magic string is written in
+  // an obsolete format, and is overwritten with a new one.
+  uint64_t validSize = 0;
+  if (auto buffer = llvm::MemoryBuffer::getFile(
+          filePath, /*IsText=*/false, /*RequiresNullTerminator=*/false,
+          /*IsVolatile=*/true))
+    validSize = parseCacheRecords(
+        buffer.get()->getBuffer(),
+        [&](StringRef key, EstimationRecord record) { records[key] = record; });
+
+  // Drop the incomplete record at the end of the file, e.g., left by a killed
+  // process, such that new records are appended at a record boundary.
+  if (failed(truncateFile(validSize)) ||
+      (validSize == 0 && !writeFile(cacheMagic)))
+    closeFile();
+  else
+    llvm::sys::fs::unlockFile(fd);
+}
+
+EstimationCache::~EstimationCache() {
+  flush();
+  closeFile();
+}
+
+/// Truncate the cache file to the given size if the file is longer.
+LogicalResult EstimationCache::truncateFile(uint64_t size) {
+  llvm::sys::fs::file_status status;
+  if (llvm::sys::fs::status(fd, status))
+    return failure();
+  if (status.getSize() <= size)
+    return success();
+  return success(!llvm::sys::fs::resize_file(fd, size));
+}
+
+/// Write the data to the cache file with a single write.
+bool EstimationCache::writeFile(StringRef data) {
+  llvm::raw_fd_ostream os(fd, /*shouldClose=*/false, /*unbuffered=*/true);
+  os << data;
+  if (os.has_error()) {
+    os.clear_error();
+    return false;
+  }
+  return true;
+}
+
+void EstimationCache::closeFile() {
+  if (fd < 0)
+    return;
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  fd = -1;
+}
+
+/// Return the key of the given IR, tile list, and target II.
+std::string EstimationCache::getKey(StringRef ir, ArrayRef<unsigned> tileList,
+                                    unsigned targetII) const {
+  llvm::MD5 hasher;
+  hasher.update(signature);
+  hasher.update(ir);
+  for (auto tile : tileList)
+    hasher.update(std::to_string(tile) + ",");
+  hasher.update(";" + std::to_string(targetII));
+
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  return result.digest().str().str();
+}
+
+Optional<EstimationRecord> EstimationCache::lookup(StringRef key) const {
+  auto it = records.find(key);
+  if (it == records.end())
+    return Optional<EstimationRecord>();
+  return it->second;
+}
+
+void EstimationCache::insert(StringRef key, EstimationRecord record) {
+  assert(key.size() == cacheKeySize && "invalid estimation cache key");
+  if (!records.insert({key, record}).second || fd < 0)
+    return;
+
+  llvm::raw_string_ostream os(pendingRecords);
+  llvm::support::endian::Writer writer(os, llvm::support::little);
+  os << key;
+  writer.write<int64_t>(record.latency);
+  writer.write<int64_t>(record.interval);
+  writer.write<int64_t>(record.dsp);
+  writer.write<int64_t>(record.bram);
+  writer.write<int64_t>(record.uram);
+  writer.write<int64_t>(record.lut);
+}
+
+/// Flush all inserted records to the cache file. The records are appended with
+/// a single write under the file lock. If the lock cannot be acquired, the
+/// records are kept and flushed next time.
+void EstimationCache::flush() {
+  if (fd < 0 || pendingRecords.empty())
+    return;
+  if (llvm::sys::fs::tryLockFile(fd, cacheLockTimeout))
+    return;
+
+  // Another process may have been killed while appending, thus the incomplete
+  // record is dropped before appending.
+  llvm::sys::fs::file_status status;
+  if (!llvm::sys::fs::status(fd, status) &&
+      status.getSize() >= cacheMagic.size()) {
+    auto recordsSize = status.getSize() - cacheMagic.size();
+    if (succeeded(truncateFile(cacheMagic.size() + recordsSize -
+                               recordsSize % cacheRecordSize)) &&
+        writeFile(pendingRecords))
+      pendingRecords.clear();
+  }
+  llvm::sys::fs::unlockFile(fd);
+}
+
 //===----------------------------------------------------------------------===//
 // LoadOp and StoreOp Related Methods
 //===----------------------------------------------------------------------===//
@@ -90,6 +370,127 @@ void ScaleHLSEstimator::getPartitionIndices(Operation *op) {
     op->setAttr("max_mux_size", builder.getI64IntegerAttr(maxMuxSize));
 }
 
+/// Get the memory ports occupation table of the memref. If the memref has not
+/// been accessed, the table is initialized according to its storage type. Note
+/// that the default case is BRAM_S2P.
+ScaleHLSEstimator::MemPortTable &
+ScaleHLSEstimator::getMemPortTable(Value memref) {
+  auto result = memPortTables.insert({memref, MemPortTable()});
+  auto &table = result.first->second;
+  if (!result.second)
+    return table;
+
+  auto memrefType = memref.getType().cast<MemRefType>();
+  table.partitionNum = getPartitionFactors(memrefType, &table.factors);
+
+  if (isRam1P(memrefType))
+    table.rdwrPort = 1;
+  else if (isRam2P(memrefType))
+    table.rdwrPort = 1, table.rdPort = 1;
+  else if (isRamT2P(memrefType))
+    table.rdwrPort = 2;
+  else if (isRamS2P(memrefType))
+    table.rdPort = 1, table.wrPort = 1;
+  else if (isDram(memrefType))
+    table.isUnlimited = true;
+  else
+    table.rdwrPort = 2;
+
+  // LUTRAMs are read asynchronously and only the output is registered.
+  if (isLutram(memrefType))
+    table.rdLatency = 1;
+
+  table.rdNextLevels.resize(table.partitionNum);
+  table.wrNextLevels.resize(table.partitionNum);
+  return table;
+}
+
+/// Return the first schedule level no earlier than the given level where the
+/// partition has a free port, and compress the followed links.
+static int64_t getFreeLevel(DenseMap<int64_t, int64_t> &nextLevels,
+                            int64_t level) {
+  SmallVector<int64_t, 8> path;
+  for (auto it = nextLevels.find(level); it != nextLevels.end();
+       it = nextLevels.find(level)) {
+    path.push_back(level);
+    level = it->second;
+  }
+  for (auto occupiedLevel : path)
+    nextLevels[occupiedLevel] = level;
+  return level;
+}
+
+/// Occupy the memory ports of all the given partitions in the first schedule
+/// level no earlier than `begin` where all partitions have available ports, and
+/// return the level. The ports are only occupied if all partitions have
+/// available ports.
+int64_t ScaleHLSEstimator::occupyMemPorts(MemPortTable &table, int64_t begin,
+                                          ArrayRef<unsigned> partitions,
+                                          const MemRefAccess &access,
+                                          bool isRead) {
+  // Jump to the first free level of each partition in turn until all
+  // partitions agree on the level.
+  auto &nextLevels = isRead ? table.rdNextLevels : table.wrNextLevels;
+  auto level = begin;
+  for (bool isFound = false; !isFound;) {
+    isFound = true;
+    for (auto p : partitions) {
+      auto freeLevel = getFreeLevel(nextLevels[p], level);
+      if (freeLevel != level)
+        level = freeLevel, isFound = false;
+    }
+  }
+
+  // The rationale is as long as the current read operation has identical memory
+  // access information with any scheduled read operation, the schedule will
+  // success.
+  auto isIdentical = [&](const MemRefAccess &rdAccess) {
+    return access == rdAccess &&
+           access.opInst->getBlock() == rdAccess.opInst->getBlock();
+  };
+  auto rdAccessIt = table.rdAccessLevels.end();
+  if (isRead) {
+    rdAccessIt = llvm::find_if(table.rdAccessLevels, [&](auto &accessLevels) {
+      return isIdentical(accessLevels.first);
+    });
+    if (rdAccessIt != table.rdAccessLevels.end()) {
+      auto levelIt = llvm::lower_bound(rdAccessIt->second, begin);
+      if (levelIt != rdAccessIt->second.end() && *levelIt <= level)
+        return *levelIt;
+    }
+  }
+
+  // Dedicated read or write ports are preferred over read-write ports.
+  auto &row = table.getRow(level);
+  auto &used = isRead ? row.rdUsed : row.wrUsed;
+  auto portNum = isRead ? table.rdPort : table.wrPort;
+  for (auto p : partitions) {
+    if (portNum && !used.test(p))
+      used.set(p);
+    else
+      row.rdwrUsed[row.getRdwrUsedNum(p)].set(p);
+  }
+
+  // Link the level to the next level for the partitions where no read or write
+  // port is free any more.
+  for (auto p : partitions) {
+    auto hasFreeRdwrPort = row.getRdwrUsedNum(p) < table.rdwrPort;
+    if (!hasFreeRdwrPort && (!table.rdPort || row.rdUsed.test(p)))
+      table.rdNextLevels[p].insert({level, level + 1});
+    if (!hasFreeRdwrPort && (!table.wrPort || row.wrUsed.test(p)))
+      table.wrNextLevels[p].insert({level, level + 1});
+  }
+
+  if (isRead) {
+    if (rdAccessIt == table.rdAccessLevels.end())
+      rdAccessIt = table.rdAccessLevels.insert(
+          rdAccessIt, {access, SmallVector<int64_t, 4>()});
+    auto &levels = rdAccessIt->second;
+    levels.insert(llvm::lower_bound(levels, level), level);
+  }
+  return level;
+}
+
 /// Timing load/store operation honoring the memory ports number limitation.
 void ScaleHLSEstimator::estimateLoadStoreTiming(Operation *op, int64_t begin) {
   auto access = MemRefAccess(op);
@@ -103,111 +504,211 @@ void ScaleHLSEstimator::estimateLoadStoreTiming(Operation *op, int64_t begin) {
     return;
   }
 
-  SmallVector<int64_t, 8> factors;
-  auto partitionNum = getPartitionFactors(memrefType, &factors);
+  auto &table = getMemPortTable(memref);
   auto partitionIndices = getIntArrayAttrValue(op, "partition_indices");
 
-  // Try to avoid memory port violation until a legal schedule is found. Since
-  // an infinite length schedule cannot be generated, this while loop can be
-  // proofed to have an end.
-  int64_t resMinII = 1;
-  for (;; ++begin) {
-    auto &memPortInfos = memPortInfosMap[begin][memref];
-
-    // If the memory has not been occupied by the current schedule level, it
-    // should be initialized according to its storage type. Note that each
-    // partition should have one PortInfo structure, where the default case is
-    // BRAM_S2P.
-    if (memPortInfos.empty())
-      for (unsigned p = 0; p < partitionNum; ++p) {
-        MemPortInfo info;
-
-        if (isRam1P(memrefType))
-          info.rdwrPort = 1;
-        else if (isRam2P(memrefType))
-          info.rdwrPort = 1, info.rdPort = 1;
-        else if (isRamT2P(memrefType))
-          info.rdwrPort = 2;
-        else if (isRamS2P(memrefType))
-          info.rdPort = 1, info.wrPort = 1;
-        else if (isDram(memrefType))
-          info.rdPort = UINT_MAX, info.wrPort = UINT_MAX;
-        else
-          info.rdwrPort = 2;
-
-        memPortInfos.push_back(info);
-      }
+  // Directly collect the partitions occupied by the memory access. If the
+  // partition index of a dimension is -1, all partitions along the dimension
+  // will be occupied and a multiplexer will be generated in HLS.
+  SmallVector<unsigned, 8> partitions({0});
+  int64_t accumFactor = 1;
+  for (int64_t dim = 0; dim < memrefType.getRank(); ++dim) {
+    auto factor = table.factors[dim];
+    auto index = partitionIndices[dim];
+
+    SmallVector<unsigned, 8> newPartitions;
+    for (auto p : partitions) {
+      if (index == -1) {
+        for (int64_t i = 0; i < factor; ++i)
+          newPartitions.push_back(p + i * accumFactor);
+      } else if (index >= 0 && index < factor)
+        newPartitions.push_back(p + index * accumFactor);
+    }
+    partitions = newPartitions;
+    accumFactor *= factor;
+  }
 
-    // Indicate whether the memory access operation is successfully scheduled in
-    // the current schedule level.
-    bool successFlag = true;
-
-    // Walk through all partitions to check whether the current partition is
-    // occupied and whether available memory ports are enough to schedule the
-    // current memory access operation.
-    for (int64_t idx = 0; idx < partitionNum; ++idx) {
-      bool isOccupied = true;
-      int64_t accumFactor = 1;
-
-      for (int64_t dim = 0; dim < memrefType.getRank(); ++dim) {
-        // If the index is -1, all ports in the current partition will be
-        // occupied and a multiplexer will be generated in HLS.
-        if (partitionIndices[dim] != -1 &&
-            idx / accumFactor % factors[dim] != partitionIndices[dim]) {
-          isOccupied = false;
-          break;
-        }
-        accumFactor *= factors[dim];
-      }
+  // Find the first schedule level that avoids memory port violation.
+  if (!table.isUnlimited)
+    begin = occupyMemPorts(table, begin, partitions, access,
+                           isa<AffineReadOpInterface>(op));
 
-      if (isOccupied) {
-        auto &info = memPortInfos[idx];
-        if (isa<AffineReadOpInterface>(op)) {
-          bool hasIdenticalAccess = false;
-          // The rationale is as long as the current read operation has
-          // identical memory access information with any scheduled read
-          // operation, the schedule will success.
-          for (auto rdAccess : info.rdAccesses) {
-            if (access == rdAccess &&
-                op->getBlock() == rdAccess.opInst->getBlock())
-              hasIdenticalAccess = true;
-          }
+  if (isa<AffineReadOpInterface>(op))
+    setTiming(op, begin, begin + table.rdLatency, table.rdLatency, 1);
+  else
+    setTiming(op, begin, begin + 1, 1, 1);
+}
 
-          if (hasIdenticalAccess)
-            continue;
+//===----------------------------------------------------------------------===//
+// Dependence Analysis Related Methods
+//===----------------------------------------------------------------------===//
 
-          if (info.rdPort > 0) {
-            info.rdPort--;
-            info.rdAccesses.push_back(access);
-          } else if (info.rdwrPort > 0) {
-            info.rdwrPort--;
-            info.rdAccesses.push_back(access);
-          } else {
-            successFlag = false;
-            break;
-          }
-        } else if (isa<AffineWriteOpInterface>(op)) {
-          if (info.wrPort > 0)
-            info.wrPort--;
-          else if (info.rdwrPort > 0)
-            info.rdwrPort--;
-          else {
-            successFlag = false;
-            break;
-          }
-        }
-      }
+/// The maximum number of entries held by the dependence cache.
+static constexpr unsigned maxDepCacheSize = 1 << 16;
+
+/// Collect the enclosing affine for and if operations of the operation, which
+/// determine the iteration domain of the operation, from the outermost.
+static SmallVector<Operation *, 8> getEnclosingAffineOps(Operation *op) {
+  SmallVector<Operation *, 8> enclosingOps;
+  for (auto parent = op->getParentOp(); parent && !isa<func::FuncOp>(parent);
+       parent = parent->getParentOp())
+    if (isa<AffineForOp, AffineIfOp>(parent))
+      enclosingOps.push_back(parent);
+  std::reverse(enclosingOps.begin(), enclosingOps.end());
+  return enclosingOps;
+}
+
+/// Append the structural description of the memory access to the key. Uniqued
+/// affine maps and integer sets are described with their storage pointers, and
+/// loop induction variables are numbered with their nesting depth. Therefore,
+/// the description is independent from the identity of the operations, and is
+/// changed once the access or its enclosing loops are rewritten, e.g., by loop
+/// unrolling. Return false if the access depends on any value other than the
+/// induction variables and constants.
+static bool appendAccessKey(const MemRefAccess &access,
+                            ArrayRef<Operation *> enclosingOps,
+                            std::string &key) {
+  auto appendPointer = [&](const void *pointer) {
+    key += llvm::utohexstr((uintptr_t)pointer) + ":";
+  };
+  auto appendOperands = [&](ValueRange operands) {
+    for (auto operand : operands) {
+      auto ivIt = llvm::find_if(enclosingOps, [&](Operation *op) {
+        auto loop = dyn_cast<AffineForOp>(op);
+        return loop && loop.getInductionVar() == operand;
+      });
+      if (ivIt != enclosingOps.end())
+        key += "i" + std::to_string(ivIt - enclosingOps.begin()) + ",";
+      else if (auto constOp = operand.getDefiningOp<arith::ConstantIndexOp>())
+        key += "c" + std::to_string(constOp.value()) + ",";
+      else
+        return false;
+    }
+    key += ";";
+    return true;
+  };
+
+  for (auto op : enclosingOps) {
+    if (auto loop = dyn_cast<AffineForOp>(op)) {
+      key += "for:" + std::to_string(loop.getStep()) + ":";
+      appendPointer(loop.getLowerBoundMap().getAsOpaquePointer());
+      appendPointer(loop.getUpperBoundMap().getAsOpaquePointer());
+      if (!appendOperands(loop.getLowerBoundOperands()) ||
+          !appendOperands(loop.getUpperBoundOperands()))
+        return false;
+    } else {
+      auto ifOp = cast<AffineIfOp>(op);
+      key += "if:";
+      appendPointer(ifOp.getIntegerSet().getAsOpaquePointer());
+      if (!appendOperands(ifOp.getOperands()))
+        return false;
     }
+  }
+
+  AffineValueMap accessMap;
+  access.getAccessMap(&accessMap);
+  key += "access:";
+  appendPointer(accessMap.getAffineMap().getAsOpaquePointer());
+  return appendOperands(accessMap.getOperands());
+}
 
-    if (successFlag)
+/// Return whether the source access appears before the destination access in
+/// the body of their innermost common loop, or in the function body if no loop
+/// is in common. The order decides the dependence at the depths deeper than the
+/// common loops, where the two accesses are in the same iteration.
+static bool srcAppearsBeforeDst(const MemRefAccess &srcAccess,
+                                const MemRefAccess &dstAccess,
+                                ArrayRef<Operation *> commonOps) {
+  Block *commonBlock = nullptr;
+  for (auto op : llvm::reverse(commonOps))
+    if (auto loop = dyn_cast<AffineForOp>(op)) {
+      commonBlock = loop.getBody();
       break;
-    ++resMinII;
+    }
+  if (!commonBlock) {
+    commonBlock = srcAccess.opInst->getBlock();
+    while (!isa<func::FuncOp>(commonBlock->getParentOp()))
+      commonBlock = commonBlock->getParentOp()->getBlock();
   }
 
-  if (isa<AffineReadOpInterface>(op))
-    setTiming(op, begin, begin + 2, 2, 1);
-  else
-    setTiming(op, begin, begin + 1, 1, 1);
+  auto srcOp = commonBlock->findAncestorOpInBlock(*srcAccess.opInst);
+  auto dstOp = commonBlock->findAncestorOpInBlock(*dstAccess.opInst);
+  return srcOp && dstOp && srcOp->isBeforeInBlock(dstOp);
+}
+
+/// Check the dependence between the two memory accesses at the given loop
+/// depth. The results are cached with the structural description of the two
+/// accesses, such that repeated queries on unchanged accesses, e.g., in the
+/// evaluation of different design points, skip the polyhedral analysis.
+DependenceResult ScaleHLSEstimator::checkDependence(
+    const MemRefAccess &srcAccess, const MemRefAccess &dstAccess,
+    unsigned depth, SmallVector<DependenceComponent, 2> *depComps) {
+  auto computeDependence = [&]() {
+    FlatAffineValueConstraints depConstrs;
+    return checkMemrefAccessDependence(srcAccess, dstAccess, depth,
+                                       &depConstrs, depComps,
+                                       /*allowRAR=*/true);
+  };
+
+  // Storage pointers are only unique in the same context, thus the cache is
+  // cleared once the context is changed.
+  auto context = srcAccess.opInst->getContext();
+  if (depCacheContext != context || depCache.size() >= maxDepCacheSize) {
+    depCache.clear();
+    depCacheContext = context;
+  }
+
+  auto srcOps = getEnclosingAffineOps(srcAccess.opInst);
+  auto dstOps = getEnclosingAffineOps(dstAccess.opInst);
+  unsigned commonNum = 0;
+  while (commonNum < srcOps.size() && commonNum < dstOps.size() &&
+         srcOps[commonNum] == dstOps[commonNum])
+    ++commonNum;
+
+  // The order of the two accesses is part of the key, as it decides the result
+  // when the depth is deeper than the common loops.
+  auto commonOps = llvm::makeArrayRef(srcOps).take_front(commonNum);
+  auto srcBeforeDst = srcAppearsBeforeDst(srcAccess, dstAccess, commonOps);
+  std::string key = std::to_string(depth) + "/" + std::to_string(commonNum) +
+                    "/" + (srcAccess.memref == dstAccess.memref ? "1/" : "0/") +
+                    (srcBeforeDst ? "1/" : "0/");
+  if (!appendAccessKey(srcAccess, srcOps, key))
+    return computeDependence();
+  key += "/";
+  if (!appendAccessKey(dstAccess, dstOps, key))
+    return computeDependence();
+
+  // Return the cached result if the required dependence components are also
+  // cached. The components are restored with the common loops of the current
+  // accesses, which are located at the same positions.
+  auto entryIt = depCache.find(key);
+  if (entryIt != depCache.end() &&
+      (!depComps || entryIt->second.hasComponents)) {
+    auto &entry = entryIt->second;
+    if (depComps) {
+      AffineLoopBand srcLoops;
+      getLoopIVs(*srcAccess.opInst, &srcLoops);
+      depComps->clear();
+      for (unsigned i = 0, e = entry.componentBounds.size(); i < e; ++i) {
+        DependenceComponent depComp;
+        depComp.op = srcLoops[i];
+        depComp.lb = entry.componentBounds[i].first;
+        depComp.ub = entry.componentBounds[i].second;
+        depComps->push_back(depComp);
+      }
+    }
+    return DependenceResult(entry.result);
+  }
+
+  auto result = computeDependence();
+  auto &entry = depCache[key];
+  entry.result = result.value;
+  entry.hasComponents = depComps != nullptr;
+  entry.componentBounds.clear();
+  if (depComps)
+    for (auto &depComp : *depComps)
+      entry.componentBounds.push_back({depComp.lb, depComp.ub});
+  return result;
 }
 
 //===----------------------------------------------------------------------===//
@@ -235,37 +736,65 @@ int64_t ScaleHLSEstimator::getResMinII(int64_t begin, int64_t end,
   for (auto &pair : map) {
     auto memref = pair.first;
     auto memrefType = memref.getType().cast<MemRefType>();
-    auto partitionNum = getPartitionFactors(memrefType);
-
     // FIXME: Study how Vivado HLS handle AXI interfaces.
     if (isDram(memrefType))
       continue;
 
-    auto accessNum = SmallVector<int64_t, 16>(partitionNum, 0);
-    // Prepare for BRAM_S1P memory kind.
-    auto writeNum = SmallVector<int64_t, 16>(partitionNum, 0);
+    auto tableIt = memPortTables.find(memref);
+    if (tableIt == memPortTables.end())
+      continue;
+    auto &table = tableIt->second;
 
+    // Return whether a partition with the given available ports is counted as
+    // an access or a write (prepared for BRAM_S1P memory kind).
     // TODO: fine-tune for BRAM_T2P.
-    for (int64_t level = begin; level < end; ++level)
-      if (memPortInfosMap.count(level))
-        if (memPortInfosMap[level].count(memref)) {
-          auto &memPortInfos = memPortInfosMap[level][memref];
-
-          for (int64_t idx = 0; idx < partitionNum; ++idx) {
-            auto &info = memPortInfos[idx];
-            if (isRam1P(memrefType) && info.rdwrPort < 1)
-              ++accessNum[idx];
-            else if (isRamT2P(memrefType) && info.rdwrPort < 2)
-              ++accessNum[idx];
-            else if (info.rdPort < 1)
-              ++accessNum[idx];
-            else if (info.wrPort < 1)
-              ++writeNum[idx];
-          }
-        }
+    auto countPorts = [&](unsigned rdPort, unsigned wrPort,
+                          unsigned rdwrPort) -> std::pair<int64_t, int64_t> {
+      if ((isRam1P(memrefType) && rdwrPort < 1) ||
+          (isRamT2P(memrefType) && rdwrPort < 2) || rdPort < 1)
+        return {1, 0};
+      if (wrPort < 1)
+        return {0, 1};
+      return {0, 0};
+    };
+
+    // Partitions that are not occupied in a schedule level are counted with
+    // their initial ports, thus only the occupied partitions are walked
+    // through, whose deviation from the initial count is recorded.
+    auto initCount = countPorts(table.rdPort, table.wrPort, table.rdwrPort);
+    int64_t levelNum = 0;
+    DenseMap<unsigned, std::pair<int64_t, int64_t>> deviations;
+    for (auto &levelAndIndex : table.rowIndices) {
+      if (levelAndIndex.first < begin || levelAndIndex.first >= end)
+        continue;
+      ++levelNum;
+
+      auto &row = table.rows[levelAndIndex.second];
+      auto occupied = row.rdUsed;
+      occupied |= row.wrUsed;
+      occupied |= row.rdwrUsed[0];
+      for (auto p : occupied.set_bits()) {
+        auto count = countPorts(table.rdPort - row.rdUsed.test(p),
+                                table.wrPort - row.wrUsed.test(p),
+                                table.rdwrPort - row.getRdwrUsedNum(p));
+        auto &deviation = deviations[p];
+        deviation.first += count.first - initCount.first;
+        deviation.second += count.second - initCount.second;
+      }
+    }
 
-    II = max({II, *std::max_element(writeNum.begin(), writeNum.end()),
-              *std::max_element(accessNum.begin(), accessNum.end())});
+    int64_t accessNum = 0, writeNum = 0;
+    if (deviations.size() < table.partitionNum) {
+      accessNum = levelNum * initCount.first;
+      writeNum = levelNum * initCount.second;
+    }
+    for (auto &deviation : deviations) {
+      accessNum =
+          max(accessNum, levelNum * initCount.first + deviation.second.first);
+      writeNum =
+          max(writeNum, levelNum * initCount.second + deviation.second.second);
+    }
+    II = max({II, accessNum, writeNum});
   }
   return II;
 }
@@ -356,12 +885,9 @@ int64_t ScaleHLSEstimator::getDepMinII(int64_t II, AffineForOp forOp,
           continue;
 
         for (auto depth : loopDepths) {
-          FlatAffineValueConstraints depConstrs;
           SmallVector<DependenceComponent, 2> depComps;
-
-          DependenceResult result = checkMemrefAccessDependence(
-              srcAccess, dstAccess, depth, &depConstrs, &depComps,
-              /*allowRAR=*/true);
+          DependenceResult result =
+              checkDependence(srcAccess, dstAccess, depth, &depComps);
 
           if (hasDependence(result)) {
             int64_t distance = 0;
@@ -454,6 +980,8 @@ bool ScaleHLSEstimator::visitOp(AffineForOp op, int64_t begin) {
       // Calculate initial interval.
       auto targetII = loopDirect.getTargetII();
       auto resII = getResMinII(begin, end, map);
+      if (resMinIIMap)
+        (*resMinIIMap)[op] = resII;
       auto depII = getDepMinII(max(targetII, resII), op, map);
       auto II = max({targetII, resII, depII});
 
@@ -512,6 +1040,95 @@ bool ScaleHLSEstimator::visitOp(AffineForOp op, int64_t begin) {
 // Other Operation Handlers
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// The operator library entry of an operation, where "num" is the number of
+/// occupied operator instances, e.g., the lane number of a vector operation.
+struct LibraryOperator {
+  StringRef name;
+  unsigned bitWidth = 0;
+  int64_t num = 1;
+};
+} // namespace
+
+/// Return the operator library entry of the operation, or None if the operation
+/// is not implemented with any library operator. The bit width is determined by
+/// the widest operand, where index type is implemented as a 32-bits integer.
+static Optional<LibraryOperator> getLibraryOperator(Operation *op) {
+  LibraryOperator libOp;
+  libOp.name =
+      TypeSwitch<Operation *, StringRef>(op)
+          .Case<arith::AddIOp, arith::SubIOp>([](auto) { return "addi"; })
+          .Case<arith::CmpIOp>([](auto) { return "cmpi"; })
+          .Case<arith::MaxSIOp, arith::MinSIOp, arith::MaxUIOp,
+                arith::MinUIOp>([](auto) { return "minmaxi"; })
+          .Case<arith::AndIOp, arith::OrIOp, arith::XOrIOp>(
+              [](auto) { return "logici"; })
+          .Case<arith::ShLIOp, arith::ShRSIOp, arith::ShRUIOp>(
+              [](auto) { return "shifti"; })
+          .Case<arith::MulIOp>([](auto) { return "muli"; })
+          .Case<arith::DivSIOp, arith::DivUIOp>([](auto) { return "divi"; })
+          .Case<arith::RemSIOp, arith::RemUIOp>([](auto) { return "remi"; })
+          .Case<arith::SelectOp>([](auto) { return "select"; })
+          .Case<PrimMulOp>([](auto) { return "prim_mul"; })
+          .Case<arith::SIToFPOp, arith::UIToFPOp>([](auto) { return "itofp"; })
+          .Case<arith::FPToSIOp, arith::FPToUIOp>([](auto) { return "fptoi"; })
+          .Case<arith::MaxFOp, arith::MinFOp>([](auto) { return "fminmax"; })
+          .Case<arith::RemFOp>([](auto) { return "frem"; })
+          .Case<math::SqrtOp>([](auto) { return "fsqrt"; })
+          .Case<math::RsqrtOp>([](auto) { return "frsqrt"; })
+          .Case<math::LogOp, math::Log2Op, math::Log10Op>(
+              [](auto) { return "flog"; })
+          .Case<math::PowFOp>([](auto) { return "fpow"; })
+          .Case<math::SinOp, math::CosOp>([](auto) { return "fsincos"; })
+          .Case<math::TanhOp>([](auto) { return "ftanh"; })
+          .Default([](auto) { return StringRef(); });
+  if (libOp.name.empty())
+    return Optional<LibraryOperator>();
+
+  // Shifting with a constant amount is implemented with wires.
+  if (isa<arith::ShLIOp, arith::ShRSIOp, arith::ShRUIOp>(op) &&
+      matchPattern(op->getOperand(1), m_Constant()))
+    return Optional<LibraryOperator>();
+
+  for (auto type : op->getOperandTypes()) {
+    if (auto vectorType = type.dyn_cast<VectorType>()) {
+      libOp.num = max(libOp.num, vectorType.getNumElements());
+      type = vectorType.getElementType();
+    }
+    if (type.isa<IndexType>())
+      libOp.bitWidth = max(libOp.bitWidth, 32u);
+    else if (type.isIntOrFloat())
+      libOp.bitWidth = max(libOp.bitWidth, type.getIntOrFloatBitWidth());
+  }
+
+  // Packed multiplications share one operator instance.
+  if (auto primMul = dyn_cast<PrimMulOp>(op))
+    if (primMul.isPackMul())
+      libOp.num = 1;
+  return libOp;
+}
+
+bool ScaleHLSEstimator::visitUnhandledOp(Operation *op, int64_t begin) {
+  // Default latency of any unhandled operation that is not characterized by
+  // the operator library is 0.
+  auto libOp = getLibraryOperator(op);
+  auto cost = libOp ? library.lookup(libOp->name, libOp->bitWidth)
+                    : Optional<OperatorCost>();
+  if (!cost)
+    return setTiming(op, begin, begin, 0, 0), true;
+
+  auto key = (libOp->name + "_" + Twine(libOp->bitWidth)).str();
+  libraryCostMap[key] = cost.value();
+
+  // Combinational operators also occupy their instances in the schedule level.
+  auto latency = cost.value().latency;
+  setTiming(op, begin, begin + latency, latency, latency ? 1 : 0);
+  for (int64_t i = 0, e = max(latency, (int64_t)1); i < e; ++i)
+    numOperatorMap[begin + i][key] += libOp->num;
+  totalNumOperatorMap[key] += libOp->num;
+  return true;
+}
+
 bool ScaleHLSEstimator::visitOp(AffineIfOp op, int64_t begin) {
   auto end = begin;
   auto thenBlock = op.getThenBlock();
@@ -567,7 +1184,9 @@ bool ScaleHLSEstimator::visitOp(func::CallOp op, int64_t begin) {
   auto subFunc = dyn_cast<func::FuncOp>(callee);
   assert(subFunc && "callable is not a function operation");
 
-  ScaleHLSEstimator estimator(latencyMap, dspUsageMap, depAnalysis);
+  ScaleHLSEstimator estimator(latencyMap, dspUsageMap, lutUsageMap, library,
+                              depAnalysis);
+  estimator.recordResMinII(resMinIIMap);
   estimator.estimateFunc(subFunc);
 
   // We assume enter and leave the subfunction require extra 2 clock cycles.
@@ -580,6 +1199,261 @@ bool ScaleHLSEstimator::visitOp(func::CallOp op, int64_t begin) {
     return false;
 }
 
+//===----------------------------------------------------------------------===//
+// Dataflow Schedule Related Methods
+//===----------------------------------------------------------------------===//
+
+/// Stream channels deeper than this are implemented with BRAMs, otherwise with
+/// shift registers (SRL32) in LUTs.
+static constexpr int64_t maxSrlStreamDepth = 32;
+
+/// Return the bit width of the data held by the stream channel, where index
+/// type and other unknown types are implemented as 32-bits integers.
+static int64_t getStreamBitWidth(StreamOp stream) {
+  auto elementType =
+      stream.getChannel().getType().cast<StreamType>().getElementType();
+  int64_t elementNum = 1;
+  if (auto vectorType = elementType.dyn_cast<VectorType>()) {
+    elementNum = vectorType.getNumElements();
+    elementType = vectorType.getElementType();
+  }
+  if (elementType.isIntOrFloat())
+    return elementType.getIntOrFloatBitWidth() * elementNum;
+  return 32 * elementNum;
+}
+
+/// Return the LUT utilization of the stream channel.
+static int64_t getStreamLutNum(StreamOp stream) {
+  if (stream.getDepth() > maxSrlStreamDepth)
+    return 0;
+  return getStreamBitWidth(stream);
+}
+
+/// Return the interval of a function or node with the given latency. Dataflow
+/// schedules in the block can accept new inputs once their slowest nodes are
+/// ready, thus the overlapped latency of the schedules is excluded.
+static int64_t getDataflowInterval(Block &block, int64_t latency) {
+  auto interval = latency;
+  for (auto schedule : block.getOps<ScheduleOp>())
+    if (auto timing = getTiming(schedule))
+      interval -= timing.getLatency() - timing.getInterval();
+  return max(interval, (int64_t)1);
+}
+
+/// Return the interval of a function that is not pipelined with the given
+/// latency. A dataflowed function accepts new inputs once its slowest callee is
+/// ready, where the latency of each call is returned by "getCallLatency".
+static int64_t
+getFuncInterval(func::FuncOp func, int64_t latency,
+                function_ref<int64_t(func::CallOp)> getCallLatency) {
+  auto funcDirect = getFuncDirective(func);
+  if (!funcDirect || !funcDirect.getDataflow())
+    return getDataflowInterval(func.front(), latency);
+
+  int64_t interval = 1;
+  for (auto callOp : func.getOps<func::CallOp>())
+    interval = max(interval, getCallLatency(callOp));
+  return interval;
+}
+
+/// Return the dataflow stage of each node in the schedule, where nodes in the
+/// same stage are executed concurrently and stages are executed in order. If
+/// all nodes are scheduled, stages are ordered by the descending node levels.
+/// Otherwise, each node is placed in the stage next to its latest producer.
+static DenseMap<Operation *, unsigned> getDataflowStages(ScheduleOp schedule) {
+  DenseMap<Operation *, unsigned> stages;
+  auto nodes = schedule.getOps<NodeOp>();
+  if (llvm::all_of(nodes, [](NodeOp node) { return (bool)node.getLevel(); })) {
+    unsigned maxLevel = 0;
+    for (auto node : nodes)
+      maxLevel = max(maxLevel, (unsigned)node.getLevel().value());
+    for (auto node : nodes)
+      stages[node] = maxLevel - node.getLevel().value();
+    return stages;
+  }
+
+  for (auto node : nodes) {
+    unsigned stage = 0;
+    for (auto input : node.getInputs())
+      for (auto producer : getProducersExcept(input, node))
+        if (producer->isBeforeInBlock(node))
+          stage = max(stage, stages.lookup(producer) + 1);
+    stages[node] = stage;
+  }
+  return stages;
+}
+
+Optional<int64_t> scalehls::getStreamTokenNum(Value channel, bool isPush) {
+  auto scope = channel.getParentRegion()->getParentOp();
+  int64_t tokenNum = 0;
+  for (auto &use : channel.getUses()) {
+    auto user = use.getOwner();
+    int64_t num = 0;
+    if (isPush ? isa<StreamWriteOp>(user) : isa<StreamReadOp>(user))
+      num = 1;
+    else if (isa<NodeOp, ScheduleOp>(user)) {
+      auto arg = user->getRegion(0).getArgument(use.getOperandNumber());
+      auto nestedNum = getStreamTokenNum(arg, isPush);
+      if (!nestedNum)
+        return Optional<int64_t>();
+      num = nestedNum.value();
+    }
+    if (!num)
+      continue;
+
+    for (auto parent = user->getParentOp(); parent && parent != scope;
+         parent = parent->getParentOp())
+      if (auto loop = dyn_cast<AffineForOp>(parent)) {
+        auto tripCount = getAverageTripCount(loop);
+        if (!tripCount)
+          return Optional<int64_t>();
+        num *= tripCount.value();
+      }
+    tokenNum += num;
+  }
+  return tokenNum;
+}
+
+/// Return the minimum depth of a stream channel that does not stall its
+/// producer. The producer pushes the tokens evenly during its latency, while
+/// the consumer starts "delay" cycles after the producer and pops the tokens
+/// evenly during its latency. Therefore, the backlog of tokens peaks either
+/// when the consumer starts or when the producer finishes.
+static int64_t getRequiredStreamDepth(int64_t tokenNum, int64_t producerLatency,
+                                      int64_t consumerLatency, int64_t delay) {
+  auto getBacklog = [&](int64_t time) {
+    auto pushed = min(1.0, (double)time / max(producerLatency, (int64_t)1));
+    auto popped = std::clamp(
+        (double)(time - delay) / max(consumerLatency, (int64_t)1), 0.0, 1.0);
+    return tokenNum * (pushed - popped);
+  };
+  auto backlog = max(getBacklog(delay), getBacklog(producerLatency));
+  return std::clamp((int64_t)ceil(backlog), (int64_t)1,
+                    max(tokenNum, (int64_t)1));
+}
+
+/// Annotate each stream channel defined in the schedule with its required
+/// depth. A consumer at a later stage starts once the stages between the
+/// producer and itself are done, while a consumer at the same stage starts
+/// together with the producer.
+static void annotateStreamDepths(ScheduleOp schedule,
+                                 DenseMap<Operation *, unsigned> &stages,
+                                 ArrayRef<int64_t> stageBegins) {
+  auto builder = Builder(schedule.getContext());
+  for (auto node : schedule.getOps<NodeOp>())
+    for (auto [output, arg] :
+         llvm::zip(node.getOutputs(), node.getOutputArgs())) {
+      auto stream = output.getDefiningOp<StreamOp>();
+      if (!stream)
+        continue;
+      auto tokenNum = getStreamTokenNum(arg, /*isPush=*/true);
+      if (!tokenNum)
+        continue;
+
+      auto producerStage = stages.lookup(node);
+      int64_t requiredDepth = 1;
+      for (auto consumer : getConsumersExcept(output, node)) {
+        // Consumers at earlier stages read the tokens produced by the previous
+        // execution of the schedule, which are not considered.
+        auto consumerStage = stages.lookup(consumer);
+        if (consumerStage < producerStage)
+          continue;
+
+        int64_t delay = 0;
+        if (consumerStage > producerStage)
+          delay = stageBegins[consumerStage] - stageBegins[producerStage + 1];
+        requiredDepth = max(requiredDepth,
+                            getRequiredStreamDepth(
+                                tokenNum.value(), getTiming(node).getLatency(),
+                                getTiming(consumer).getLatency(), delay));
+      }
+      stream->setAttr("required_depth",
+                      builder.getI32IntegerAttr(requiredDepth));
+    }
+}
+
+bool ScaleHLSEstimator::visitOp(ScheduleOp op, int64_t begin) {
+  // Each node is a dataflow process, which is estimated independently with its
+  // own scheduling states.
+  for (auto node : op.getOps<NodeOp>()) {
+    ScaleHLSEstimator estimator(latencyMap, dspUsageMap, lutUsageMap, library,
+                                depAnalysis);
+    estimator.estimateNode(node);
+    if (!getTiming(node))
+      return false;
+  }
+
+  // The latency of each stage is determined by its slowest node.
+  auto stages = getDataflowStages(op);
+  SmallVector<int64_t, 16> stageLatencies;
+  for (auto node : op.getOps<NodeOp>()) {
+    auto stage = stages.lookup(node);
+    if (stage >= stageLatencies.size())
+      stageLatencies.resize(stage + 1, 0);
+    stageLatencies[stage] =
+        max(stageLatencies[stage], getTiming(node).getLatency());
+  }
+  SmallVector<int64_t, 16> stageBegins({begin});
+  for (auto latency : stageLatencies)
+    stageBegins.push_back(stageBegins.back() + latency);
+
+  // Nodes are executed concurrently on different executions of the schedule,
+  // thus the interval of the schedule is determined by the slowest node. The
+  // resource utilization of nodes is not shareable.
+  int64_t interval = 0;
+  int64_t lutNum = 0;
+  int64_t dspNum = 0;
+  for (auto node : op.getOps<NodeOp>()) {
+    auto timing = getTiming(node);
+    auto nodeBegin = stageBegins[stages.lookup(node)];
+    setTiming(node, nodeBegin, nodeBegin + timing.getLatency(),
+              timing.getLatency(), timing.getInterval());
+    interval = max(interval, timing.getInterval());
+
+    auto resource = getResource(node);
+    lutNum += max(resource.getLut(), (int64_t)0);
+    dspNum += resource.getDsp();
+  }
+  for (auto stream : op.getOps<StreamOp>())
+    lutNum += getStreamLutNum(stream);
+  for (auto buffer : op.getOps<BufferOp>()) {
+    auto memrefType = buffer.getMemref().getType().cast<MemRefType>();
+    lutNum += getMemoryResource(memrefType, buffer.getDepth()).lut;
+  }
+
+  auto end = stageBegins.back();
+  setTiming(op, begin, end, end - begin, interval);
+  setResource(op, ResourceAttr::get(op.getContext(), lutNum, dspNum,
+                                    estimateBram(op), estimateUram(op)));
+  annotateStreamDepths(op, stages, stageBegins);
+  return true;
+}
+
+/// Estimate the dataflow node in the same way as a function, as each node will
+/// be converted to a sub-function eventually.
+void ScaleHLSEstimator::estimateNode(NodeOp node) {
+  trackedFunc = func::FuncOp();
+  auto &block = node.getBody().front();
+  initEstimator(block);
+  DT = DominanceInfo(node);
+
+  auto timing = estimateBlock(block);
+  if (!timing)
+    return;
+
+  // We assume enter and leave the node require extra 2 clock cycles.
+  auto latency = timing.getEnd() + 2;
+  setTiming(node, 0, latency, latency, getDataflowInterval(block, latency));
+  setResource(node, calculateResource(node));
+  reverseTiming(block);
+}
+
+void ScaleHLSEstimator::estimateSchedule(ScheduleOp schedule) {
+  trackedFunc = func::FuncOp();
+  initEstimator(schedule.getBody().front());
+  visitOp(schedule, 0);
+}
+
 //===----------------------------------------------------------------------===//
 // Block Scheduler and Estimator
 //===----------------------------------------------------------------------===//
@@ -647,6 +1521,7 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
     for (auto user : op->getUsers()) {
       auto sameLevelUser = getSameLevelDstOp(op, user);
       opBegin = max(opBegin, getTiming(sameLevelUser).getEnd());
+      trackScheduleDep(op, sameLevelUser);
     }
 
     // Loop shouldn't overlap with any other scheduled operations. The rationale
@@ -669,7 +1544,12 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
             continue;
 
           auto depOpEnd = depOpTiming.getEnd();
-          if (depOpEnd <= opBegin || !DT.properlyDominates(op, depOp))
+          if (!DT.properlyDominates(op, depOp))
+            continue;
+
+          // Unless the schedule dependencies are tracked, skip the analysis if
+          // the depOp will not impact the current schedule level.
+          if (depOpEnd <= opBegin && !trackSchedule)
             continue;
 
           // If either the depOp or the current operation is a function call,
@@ -677,6 +1557,7 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
           if (isa<func::CallOp, memref::CopyOp>(op) ||
               isa<func::CallOp, memref::CopyOp>(depOp)) {
             opBegin = max(opBegin, depOpEnd);
+            trackScheduleDep(op, sameLevelDstOp);
             continue;
           }
 
@@ -712,13 +1593,12 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
                 hasParallelAttr(commonLoops[depth - 1]))
               continue;
 
-            FlatAffineValueConstraints dependConstrs;
-            DependenceResult result = checkMemrefAccessDependence(
-                opAccess, depOpAccess, depth, &dependConstrs,
-                /*dependenceComponents=*/nullptr, /*allowRAR=*/true);
+            DependenceResult result = checkDependence(
+                opAccess, depOpAccess, depth, /*depComps=*/nullptr);
 
             if (hasDependence(result)) {
               opBegin = max(opBegin, depOpEnd);
+              trackScheduleDep(op, sameLevelDstOp);
               break;
             }
           }
@@ -733,6 +1613,9 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
       return TimingAttr();
     }
 
+    if (trackSchedule)
+      scheduleLevelsMap[op] = {opBegin, opEnd};
+
     // Update the block schedule end and begin.
     if (i == block.rbegin())
       blockBegin = opBegin;
@@ -747,15 +1630,16 @@ TimingAttr ScaleHLSEstimator::estimateBlock(Block &block, int64_t begin) {
                          blockEnd - blockBegin);
 }
 
-/// Get the innermost surrounding operation, either an AffineForOp or a
-/// func::FuncOp. In this method, AffineIfOp is transparent as well.
+/// Get the innermost surrounding operation, either an AffineForOp, a
+/// func::FuncOp, or a NodeOp. In this method, AffineIfOp is transparent as
+/// well.
 static Operation *getSurroundingOp(Operation *op) {
   auto currentOp = op;
   while (true) {
     auto parentOp = currentOp->getParentOp();
     if (isa<AffineIfOp, scf::IfOp>(parentOp))
       currentOp = parentOp;
-    else if (isa<AffineForOp, func::FuncOp>(parentOp))
+    else if (isa<AffineForOp, func::FuncOp, NodeOp>(parentOp))
       return parentOp;
     else
       return nullptr;
@@ -764,6 +1648,12 @@ static Operation *getSurroundingOp(Operation *op) {
 
 void ScaleHLSEstimator::reverseTiming(Block &block) {
   block.walk([&](Operation *op) {
+    // Nodes of dataflow schedules in the block have been reversed when they are
+    // estimated.
+    auto schedule = op->getParentOfType<ScheduleOp>();
+    if (schedule && block.getParentOp()->isProperAncestor(schedule))
+      return;
+
     // Get schedule level.
     if (auto timing = getTiming(op)) {
       auto begin = timing.getBegin();
@@ -786,7 +1676,7 @@ void ScaleHLSEstimator::reverseTiming(Block &block) {
             if (srdDirect.getFlatten())
               setTiming(op, srdBegin, srdBegin + latency, latency, interval);
           }
-        } else if (isa<func::FuncOp>(srd)) {
+        } else if (isa<func::FuncOp, NodeOp>(srd)) {
           auto srdLatency = getTiming(srd).getLatency() - 2;
           setTiming(op, srdLatency - end, srdLatency - begin, latency,
                     interval);
@@ -799,7 +1689,7 @@ void ScaleHLSEstimator::reverseTiming(Block &block) {
 
 void ScaleHLSEstimator::initEstimator(Block &block) {
   // Clear global maps and scheduling information.
-  memPortInfosMap.clear();
+  memPortTables.clear();
   numOperatorMap.clear();
 
   block.walk([&](Operation *op) {
@@ -807,38 +1697,100 @@ void ScaleHLSEstimator::initEstimator(Block &block) {
       op->removeAttr("resource");
       op->removeAttr("timing");
       op->removeAttr("loop_info");
+      op->removeAttr("required_depth");
     }
   });
 }
 
+void scalehls::removeEstimation(Operation *op) {
+  op->walk([&](Operation *nestedOp) {
+    for (auto name : {"timing", "resource", "loop_info", "partition_indices",
+                      "max_mux_size", "required_depth"})
+      nestedOp->removeAttr(name);
+  });
+}
+
+MemoryResource scalehls::getMemoryResource(MemRefType type, int64_t depth) {
+  MemoryResource resource;
+  if (type.getNumElements() <= 1 || isDram(type))
+    return resource;
+
+  // TODO: handle index types.
+  auto partitionNum = getPartitionFactors(type);
+  int64_t bitWidth = type.getElementTypeBitWidth();
+  int64_t elementNum =
+      (type.getNumElements() + partitionNum - 1) / partitionNum;
+  auto copyNum = partitionNum * depth;
+
+  if (isLutram(type)) {
+    // Each LUT holds 64 x 1 bits, while dual-port LUTRAMs are duplicated for
+    // the additional read port.
+    auto lutNum = (elementNum + 64 - 1) / 64 * bitWidth;
+    resource.lut = lutNum * (isRam1P(type) ? 1 : 2) * copyNum;
+  } else if (isUram(type)) {
+    // URAMs have a fixed aspect ratio and are cascaded in both dimensions.
+    resource.uram =
+        (elementNum + 4096 - 1) / 4096 * ((bitWidth + 72 - 1) / 72) * copyNum;
+  } else {
+    int64_t memrefSize = bitWidth * type.getNumElements() / partitionNum;
+    resource.bram = (memrefSize + 18000 - 1) / 18000 * copyNum;
+  }
+  return resource;
+}
+
+int64_t ScaleHLSEstimator::estimateBram(Operation *op) {
+  int64_t bramNum = 0;
+  op->walk([&](BufferOp buffer) {
+    // TODO: Support interface BRAMs?
+    auto memrefType = buffer.getMemref().getType().cast<MemRefType>();
+    bramNum += getMemoryResource(memrefType, buffer.getDepth()).bram;
+  });
+  op->walk([&](StreamOp stream) {
+    if (stream.getDepth() > maxSrlStreamDepth) {
+      int64_t streamSize = getStreamBitWidth(stream) * stream.getDepth();
+      bramNum += (streamSize + 18000 - 1) / 18000;
+    }
+  });
+  return bramNum;
+}
+
+int64_t ScaleHLSEstimator::estimateUram(Operation *op) {
+  int64_t uramNum = 0;
+  op->walk([&](BufferOp buffer) {
+    auto memrefType = buffer.getMemref().getType().cast<MemRefType>();
+    uramNum += getMemoryResource(memrefType, buffer.getDepth()).uram;
+  });
+  return uramNum;
+}
+
 ResourceAttr ScaleHLSEstimator::calculateResource(Operation *funcOrLoop) {
-  // Calculate the static DSP and BRAM utilization.
+  // Calculate the static LUT, DSP, BRAM, and URAM utilization.
+  int64_t lutNum = 0;
   int64_t dspNum = 0;
-  int64_t bramNum = 0;
-  funcOrLoop->walk([&](Operation *op) {
-    if (isa<func::CallOp>(op) || isNoTouch(op)) {
+  int64_t bramNum = estimateBram(funcOrLoop);
+  int64_t uramNum = estimateUram(funcOrLoop);
+  funcOrLoop->walk<WalkOrder::PreOrder>([&](Operation *op) {
+    if (isa<func::CallOp, ScheduleOp>(op) || isNoTouch(op)) {
       // TODO: For now, we consider the resource utilization of sub-fuctions are
       // static and not shareable. But actually this is not the truth. The
       // resource can be shared between different sub-functions to some extent,
       // whose shareing scheme has not been characterized by the estimator.
-      if (auto resource = getResource(op))
+      if (auto resource = getResource(op)) {
+        lutNum += max(resource.getLut(), (int64_t)0);
         dspNum += resource.getDsp();
-
-    } else if (isa<BufferOp>(op)) {
-      auto memrefType = op->getResult(0).getType().cast<MemRefType>();
-      if (memrefType.getNumElements() > 1) {
-        auto partitionNum = getPartitionFactors(memrefType);
-
-        // TODO: Support URAM and interface BRAMs?
-        if (!isDram(memrefType)) {
-          // Multiply bit width of type.
-          // TODO: handle index types.
-          int64_t memrefSize = memrefType.getElementTypeBitWidth() *
-                               memrefType.getNumElements() / partitionNum;
-          bramNum += ((memrefSize + 18000 - 1) / 18000) * partitionNum;
-        }
       }
+    } else if (auto stream = dyn_cast<StreamOp>(op))
+      lutNum += getStreamLutNum(stream);
+    else if (auto buffer = dyn_cast<BufferOp>(op)) {
+      auto memrefType = buffer.getMemref().getType().cast<MemRefType>();
+      lutNum += getMemoryResource(memrefType, buffer.getDepth()).lut;
     }
+
+    // The resource utilization of dataflow schedules has included all nested
+    // operations.
+    if (isa<ScheduleOp>(op))
+      return WalkResult::skip();
+    return WalkResult::advance();
   });
 
   auto timing = getTiming(funcOrLoop);
@@ -854,13 +1806,24 @@ ResourceAttr ScaleHLSEstimator::calculateResource(Operation *funcOrLoop) {
       num = max(num, nameAndNum.second);
     }
   }
-  for (auto &nameAndNum : operatorNums)
+  for (auto &nameAndNum : operatorNums) {
+    auto costIt = libraryCostMap.find(nameAndNum.first());
+    if (costIt != libraryCostMap.end()) {
+      lutNum += costIt->second.lut * nameAndNum.second;
+      dspNum += costIt->second.dsp * nameAndNum.second;
+      continue;
+    }
+    lutNum += lutUsageMap[nameAndNum.first()] * nameAndNum.second;
     dspNum += dspUsageMap[nameAndNum.first()] * nameAndNum.second;
+  }
 
-  return ResourceAttr::get(funcOrLoop->getContext(), 0, dspNum, bramNum);
+  return ResourceAttr::get(funcOrLoop->getContext(), lutNum, dspNum, bramNum,
+                           uramNum);
 }
 
 void ScaleHLSEstimator::estimateFunc(func::FuncOp func) {
+  if (!trackSchedule)
+    trackedFunc = func::FuncOp();
   initEstimator(func.front());
   DT = DominanceInfo(func);
 
@@ -874,27 +1837,21 @@ void ScaleHLSEstimator::estimateFunc(func::FuncOp func) {
     return;
 
   auto latency = timing.getEnd() + 2;
-  auto interval = latency;
-
-  // Handle pipelined or dataflowed loops.
-  if (auto funcDirect = getFuncDirective(func)) {
-    if (funcDirect.getDataflow()) {
-      interval = 1;
-      for (auto callOp : func.getOps<func::CallOp>()) {
-        auto subFuncLatency =
-            getTiming(callOp).getEnd() - getTiming(callOp).getBegin();
-        interval = max(interval, subFuncLatency);
-      }
+  auto interval = getFuncInterval(func, latency, [&](func::CallOp callOp) {
+    return getTiming(callOp).getEnd() - getTiming(callOp).getBegin();
+  });
 
-    } else if (funcDirect.getPipeline()) {
-      // TODO: support CallOp inside of the function.
-      auto targetInterval = funcDirect.getTargetInterval();
-      auto resInterval = getResMinII(0, timing.getEnd(), map);
-      auto depInterval =
-          getDepMinII(max(targetInterval, resInterval), func, map);
-      interval = max({targetInterval, resInterval, depInterval});
-      // TODO: Tune numOperatorMap like visitOp(AffineForOp op);
-    }
+  // Handle pipelined functions.
+  auto funcDirect = getFuncDirective(func);
+  if (funcDirect && !funcDirect.getDataflow() && funcDirect.getPipeline()) {
+    // TODO: support CallOp inside of the function.
+    auto targetInterval = funcDirect.getTargetInterval();
+    auto resInterval = getResMinII(0, timing.getEnd(), map);
+    if (resMinIIMap)
+      (*resMinIIMap)[func] = resInterval;
+    auto depInterval = getDepMinII(max(targetInterval, resInterval), func, map);
+    interval = max({targetInterval, resInterval, depInterval});
+    // TODO: Tune numOperatorMap like visitOp(AffineForOp op);
   }
 
   // Estimate and set timing and resource attributes.
@@ -909,12 +1866,219 @@ void ScaleHLSEstimator::estimateFunc(func::FuncOp func) {
 }
 
 void ScaleHLSEstimator::estimateLoop(AffineForOp loop, func::FuncOp func) {
+  trackedFunc = func::FuncOp();
   initEstimator(func.getBody().front());
   DT = DominanceInfo(loop);
   visitOp(loop, 0);
   setResource(loop, calculateResource(loop));
 }
 
+//===----------------------------------------------------------------------===//
+// Incremental Estimation
+//===----------------------------------------------------------------------===//
+
+/// Return whether the no_touch operation has been annotated with timing and
+/// resource, which means its estimation will be skipped.
+static bool isAnnotatedNoTouch(Operation *op) {
+  return isNoTouch(op) && getTiming(op) && getResource(op);
+}
+
+/// Return whether the operation or any of its nested operations occupies
+/// operators or memory ports, whose utilization depends on the schedule level.
+/// Annotated no_touch operations and function calls are excluded because their
+/// resource utilization is static.
+static bool hasLevelDependentResource(Operation *op) {
+  return op
+      ->walk<WalkOrder::PreOrder>([&](Operation *child) {
+        if (isAnnotatedNoTouch(child) || isa<func::CallOp>(child))
+          return WalkResult::skip();
+        if (isa<AffineReadOpInterface, AffineWriteOpInterface, memref::LoadOp,
+                memref::StoreOp, memref::CopyOp, arith::AddFOp, arith::SubFOp,
+                arith::MulFOp, arith::DivFOp, arith::CmpFOp, math::ExpOp>(
+                child) ||
+            getLibraryOperator(child))
+          return WalkResult::interrupt();
+        return WalkResult::advance();
+      })
+      .wasInterrupted();
+}
+
+/// Return the {latency, DSP usage, LUT usage} of an annotated no_touch
+/// operation.
+static std::tuple<int64_t, int64_t, int64_t> getNoTouchState(Operation *op) {
+  auto resource = getResource(op);
+  return {getTiming(op).getLatency(), resource.getDsp(), resource.getLut()};
+}
+
+void ScaleHLSEstimator::trackScheduleDep(Operation *op, Operation *depOp) {
+  if (trackSchedule && depOp)
+    scheduleDepsMap[op].push_back(depOp);
+}
+
+/// Conduct a full estimation of the function and track its schedule.
+void ScaleHLSEstimator::trackFuncSchedule(func::FuncOp func) {
+  scheduleDepsMap.clear();
+  scheduleLevelsMap.clear();
+  noTouchStateMap.clear();
+
+  trackSchedule = true;
+  estimateFunc(func);
+  trackSchedule = false;
+  if (!getTiming(func))
+    return;
+  trackedFunc = func;
+
+  // Record the state of all no_touch operations, where unannotated operations
+  // are recorded as {-1, -1, -1}.
+  func.walk([&](Operation *op) {
+    if (!isNoTouch(op))
+      return;
+    if (isAnnotatedNoTouch(op))
+      noTouchStateMap[op] = getNoTouchState(op);
+    else
+      noTouchStateMap[op] = {-1, -1, -1};
+  });
+}
+
+/// Reschedule the block with the tracked schedule dependencies and return the
+/// schedule end of the block. Only updated operations and their ancestors are
+/// re-estimated, while other operations are shifted if required. Return None if
+/// the incremental estimation is not applicable.
+Optional<int64_t> ScaleHLSEstimator::rescheduleBlock(Block &block,
+                                                     int64_t begin) {
+  auto blockEnd = begin;
+
+  // Reversely walk through all operations in the block, which is consistent
+  // with the estimateBlock method.
+  for (auto &op : llvm::reverse(block)) {
+    auto levels = scheduleLevelsMap.find(&op);
+    if (levels == scheduleLevelsMap.end())
+      return Optional<int64_t>();
+    auto [oldBegin, oldEnd] = levels->second;
+
+    // Calculate the schedule begin from the tracked schedule dependencies.
+    auto opBegin = begin;
+    for (auto depOp : scheduleDepsMap.lookup(&op)) {
+      auto depLevels = scheduleLevelsMap.find(depOp);
+      if (depLevels == scheduleLevelsMap.end())
+        return Optional<int64_t>();
+      opBegin = max(opBegin, depLevels->second.second);
+    }
+    if (isa<AffineForOp>(op))
+      opBegin = max(opBegin, blockEnd);
+
+    auto opEnd = opBegin;
+    if (updatedOps.count(&op)) {
+      // Updated no_touch operations are scheduled with their new latency.
+      opEnd = opBegin + getTiming(&op).getLatency();
+
+    } else if (updatedAncestors.count(&op)) {
+      // Ancestors of updated operations are re-estimated by rescheduling their
+      // contained blocks.
+      if (auto loop = dyn_cast<AffineForOp>(op)) {
+        if (auto loopDirect = getLoopDirective(loop))
+          if (loopDirect.getPipeline() || loopDirect.getFlatten())
+            return Optional<int64_t>();
+
+        auto tripCount = getAverageTripCount(loop);
+        auto end = rescheduleBlock(*loop.getBody(), opBegin);
+        if (!tripCount || !end)
+          return Optional<int64_t>();
+        opEnd = opBegin + (end.value() - opBegin) * tripCount.value() + 2;
+
+      } else if (isa<AffineIfOp, scf::IfOp>(op)) {
+        for (auto &region : op.getRegions())
+          for (auto &regionBlock : region) {
+            auto end = rescheduleBlock(regionBlock, opBegin);
+            if (!end)
+              return Optional<int64_t>();
+            opEnd = max(opEnd, end.value());
+          }
+      } else
+        return Optional<int64_t>();
+
+    } else if (opBegin == oldBegin) {
+      // Unaffected operations keep their schedule.
+      opEnd = oldEnd;
+
+    } else {
+      // Operations that are not updated but shifted keep their latency. This is
+      // only legal when no level dependent resource is occupied.
+      if (hasLevelDependentResource(&op))
+        return Optional<int64_t>();
+      opEnd = opBegin + (oldEnd - oldBegin);
+    }
+
+    levels->second = {opBegin, opEnd};
+    blockEnd = max(blockEnd, opEnd);
+  }
+  return blockEnd;
+}
+
+void ScaleHLSEstimator::estimateFuncIncrementally(func::FuncOp func) {
+  // Pipelined function is not supported as its interval depends on the memory
+  // ports occupation of all operations.
+  auto funcDirect = getFuncDirective(func);
+  if (trackedFunc != func || (funcDirect && funcDirect.getPipeline()))
+    return trackFuncSchedule(func);
+
+  // Collect all updated no_touch operations and their ancestors. If any
+  // no_touch operation is annotated or unannotated since the last estimation,
+  // the estimation of its body is skipped or required, thus the incremental
+  // estimation is not applicable.
+  updatedOps.clear();
+  updatedAncestors.clear();
+  int64_t dspDelta = 0;
+  int64_t lutDelta = 0;
+  for (auto &pair : noTouchStateMap) {
+    auto op = pair.first;
+    auto [oldLatency, oldDsp, oldLut] = pair.second;
+    auto newState = NoTouchState(-1, -1, -1);
+    if (isAnnotatedNoTouch(op))
+      newState = getNoTouchState(op);
+    auto [newLatency, newDsp, newLut] = newState;
+
+    if (newState == pair.second)
+      continue;
+    if (newLatency < 0 || oldLatency < 0)
+      return trackFuncSchedule(func);
+
+    updatedOps.insert(op);
+    for (auto parent = op->getParentOp(); parent != func;
+         parent = parent->getParentOp())
+      updatedAncestors.insert(parent);
+    dspDelta += newDsp - oldDsp;
+    lutDelta += max(newLut, (int64_t)0) - max(oldLut, (int64_t)0);
+  }
+
+  if (updatedOps.empty())
+    return;
+
+  // Reschedule the function block.
+  auto end = rescheduleBlock(func.front(), 0);
+  if (!end)
+    return trackFuncSchedule(func);
+
+  // The interval is calculated in the same way as the full estimation, where
+  // the latency of each call is given by its rescheduled levels.
+  auto latency = end.value() + 2;
+  auto interval = getFuncInterval(func, latency, [&](func::CallOp callOp) {
+    auto levels = scheduleLevelsMap.lookup(callOp);
+    return levels.second - levels.first;
+  });
+
+  // Update timing and resource attributes. Resource utilization of no_touch
+  // operations is static, thus the LUT and DSP utilization is updated with the
+  // delta.
+  auto resource = getResource(func);
+  setTiming(func, 0, latency, latency, interval);
+  setResource(func, resource.getLut() + lutDelta, resource.getDsp() + dspDelta,
+              resource.getBram(), resource.getUram());
+
+  for (auto op : updatedOps)
+    noTouchStateMap[op] = getNoTouchState(op);
+}
+
 //===----------------------------------------------------------------------===//
 // Entry of scalehls-opt
 //===----------------------------------------------------------------------===//
@@ -942,6 +2106,125 @@ void scalehls::getDspUsageMap(llvm::json::Object *config,
   dspUsageMap["fexp"] = dspUsage->getInteger("fexp").value_or(7);
 }
 
+void scalehls::getLutUsageMap(llvm::json::Object *config,
+                              llvm::StringMap<int64_t> &lutUsageMap) {
+  // The LUT usage is optional in the target spec, where default values are
+  // based on Xilinx PYNQ-Z1 board.
+  auto lutUsage = config->getObject("lut_usage");
+  auto getLutUsage = [&](StringRef name, int64_t defaultUsage) {
+    if (!lutUsage)
+      return defaultUsage;
+    return lutUsage->getInteger(name).value_or(defaultUsage);
+  };
+
+  lutUsageMap["fadd"] = getLutUsage("fadd", 205);
+  lutUsageMap["fmul"] = getLutUsage("fmul", 78);
+  lutUsageMap["fdiv"] = getLutUsage("fdiv", 761);
+  lutUsageMap["fcmp"] = getLutUsage("fcmp", 66);
+  lutUsageMap["fexp"] = getLutUsage("fexp", 1053);
+}
+
+bool scalehls::getOperatorLibrary(llvm::json::Object *config,
+                                  OperatorLibrary &library) {
+  // The operator library in the target spec is indexed by the frequency, where
+  // each operator holds a list of costs characterized at different bit widths,
+  // e.g., "muli": [{"width": 8, "latency": 0, "dsp": 0, "lut": 49}, ...].
+  auto operators = config->getObject("operators");
+  auto frequency = config->getString("frequency").value_or("100MHz");
+  if (auto frequencyOps = operators ? operators->getObject(frequency) : nullptr)
+    for (auto &nameAndCosts : *frequencyOps) {
+      auto costs = nameAndCosts.second.getAsArray();
+      if (!costs)
+        return false;
+
+      for (auto &costValue : *costs) {
+        auto costObj = costValue.getAsObject();
+        auto bitWidth =
+            costObj ? costObj->getInteger("width") : Optional<int64_t>();
+        if (!bitWidth || bitWidth.value() <= 0)
+          return false;
+
+        OperatorCost cost;
+        cost.latency = costObj->getInteger("latency").value_or(0);
+        cost.dsp = costObj->getInteger("dsp").value_or(0);
+        cost.lut = costObj->getInteger("lut").value_or(0);
+        library.insert(nameAndCosts.first, bitWidth.value(), cost);
+      }
+    }
+
+  // Built-in operators are based on Xilinx PYNQ-Z1 board under 100MHz, which
+  // are only used if not characterized in the target spec.
+  using CostList = ArrayRef<std::pair<unsigned, OperatorCost>>;
+  auto insertBuiltin = [&](StringRef name, CostList costs) {
+    if (library.contains(name))
+      return;
+    for (auto &cost : costs)
+      library.insert(name, cost.first, cost.second);
+  };
+  insertBuiltin("addi", {{1, {0, 0, 1}}, {64, {0, 0, 64}}});
+  insertBuiltin("cmpi", {{1, {0, 0, 1}}, {64, {0, 0, 22}}});
+  insertBuiltin("minmaxi", {{1, {0, 0, 2}}, {64, {0, 0, 86}}});
+  insertBuiltin("logici", {{1, {0, 0, 1}}, {64, {0, 0, 64}}});
+  insertBuiltin("shifti", {{8, {0, 0, 24}}, {32, {0, 0, 160}},
+                           {64, {0, 0, 384}}});
+  insertBuiltin("select", {{1, {0, 0, 1}}, {64, {0, 0, 32}}});
+  insertBuiltin("muli", {{8, {0, 0, 49}}, {16, {0, 1, 0}}, {32, {1, 3, 20}},
+                         {64, {4, 10, 100}}});
+  insertBuiltin("divi", {{8, {12, 0, 92}}, {16, {20, 0, 350}},
+                         {32, {36, 0, 1200}}, {64, {68, 0, 4400}}});
+  insertBuiltin("remi", {{8, {12, 0, 92}}, {16, {20, 0, 350}},
+                         {32, {36, 0, 1200}}, {64, {68, 0, 4400}}});
+  insertBuiltin("prim_mul", {{8, {2, 1, 0}}});
+  insertBuiltin("itofp", {{32, {5, 0, 200}}, {64, {5, 0, 400}}});
+  insertBuiltin("fptoi", {{32, {5, 0, 200}}, {64, {5, 0, 400}}});
+  insertBuiltin("fminmax", {{32, {1, 0, 98}}, {64, {1, 0, 164}}});
+  insertBuiltin("frem", {{32, {30, 0, 1500}}});
+  insertBuiltin("fsqrt", {{32, {15, 0, 500}}, {64, {30, 0, 1600}}});
+  insertBuiltin("frsqrt", {{32, {20, 0, 700}}});
+  insertBuiltin("flog", {{32, {12, 4, 900}}});
+  insertBuiltin("fpow", {{32, {30, 11, 2200}}});
+  insertBuiltin("fsincos", {{32, {30, 8, 2500}}});
+  insertBuiltin("ftanh", {{32, {25, 7, 1800}}});
+  return true;
+}
+
+bool TargetSpec::load(StringRef filePath) {
+  // Read target specification JSON file.
+  std::string errorMessage;
+  auto configFile = mlir::openInputFile(filePath, &errorMessage);
+  if (!configFile) {
+    llvm::errs() << errorMessage << "\n";
+    return false;
+  }
+
+  // Parse JSON file into memory.
+  auto parsedConfig = llvm::json::parse(configFile->getBuffer());
+  if (!parsedConfig) {
+    llvm::consumeError(parsedConfig.takeError());
+    llvm::errs() << "failed to parse the target spec json file\n";
+    return false;
+  }
+  config = std::move(parsedConfig.get());
+  auto configObj = config.getAsObject();
+  if (!configObj) {
+    llvm::errs() << "support an object in the target spec json file, found "
+                    "something else\n";
+    return false;
+  }
+
+  // Collect profiling latency and DSP usage data, where default values are
+  // based on Xilinx PYNQ-Z1 board.
+  getLatencyMap(configObj, latencyMap);
+  getDspUsageMap(configObj, dspUsageMap);
+  getLutUsageMap(configObj, lutUsageMap);
+  if (!getOperatorLibrary(configObj, library)) {
+    llvm::errs() << "failed to parse the operator library in the target spec "
+                    "json file\n";
+    return false;
+  }
+  return true;
+}
+
 namespace {
 struct QoREstimation : public scalehls::QoREstimationBase<QoREstimation> {
   QoREstimation() = default;
@@ -949,41 +2232,16 @@ struct QoREstimation : public scalehls::QoREstimationBase<QoREstimation> {
 
   void runOnOperation() override {
     auto module = getOperation();
-
-    // Read target specification JSON file.
-    std::string errorMessage;
-    auto configFile = mlir::openInputFile(targetSpec, &errorMessage);
-    if (!configFile) {
-      llvm::errs() << errorMessage << "\n";
-      return signalPassFailure();
-    }
-
-    // Parse JSON file into memory.
-    auto config = llvm::json::parse(configFile->getBuffer());
-    if (!config) {
-      llvm::errs() << "failed to parse the target spec json file\n";
+    TargetSpec spec;
+    if (!spec.load(targetSpec))
       return signalPassFailure();
-    }
-    auto configObj = config.get().getAsObject();
-    if (!configObj) {
-      llvm::errs() << "support an object in the target spec json file, found "
-                      "something else\n";
-      return signalPassFailure();
-    }
-
-    // Collect profiling latency and DSP usage data, where default values are
-    // based on Xilinx PYNQ-Z1 board.
-    llvm::StringMap<int64_t> latencyMap;
-    getLatencyMap(configObj, latencyMap);
-    llvm::StringMap<int64_t> dspUsageMap;
-    getDspUsageMap(configObj, dspUsageMap);
 
     // Estimate performance and resource utilization. If any other functions are
     // called by the top function, it will be estimated in the procedure of
     // estimating the top function.
     for (auto func : module.getOps<func::FuncOp>())
       if (hasTopFuncAttr(func))
-        ScaleHLSEstimator(latencyMap, dspUsageMap, true).estimateFunc(func);
+        spec.createEstimator()->estimateFunc(func);
   }
 };
 } // namespace
@@ -0,0 +1,1496 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "scalehls/Transforms/Interpreter.h"
+#include "mlir/Support/MathExtras.h"
+#include "scalehls/InitAllDialects.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/Format.h"
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <random>
+
+using namespace mlir;
+using namespace scalehls;
+using namespace hls;
+
+//===----------------------------------------------------------------------===//
+// Runtime Values
+//===----------------------------------------------------------------------===//
+
+/// Return the scalar type of a scalar or vector type.
+static Type getScalarType(Type type) {
+  if (auto vectorType = type.dyn_cast<VectorType>())
+    return vectorType.getElementType();
+  return type;
+}
+
+/// Return the number of lanes of a scalar or vector type.
+static unsigned getLaneNum(Type type) {
+  if (auto vectorType = type.dyn_cast<VectorType>())
+    return vectorType.getNumElements();
+  return 1;
+}
+
+static unsigned getBitWidth(Type type) {
+  if (type.isIndex())
+    return 64;
+  return type.getIntOrFloatBitWidth();
+}
+
+static double toDouble(int64_t raw) {
+  double value;
+  std::memcpy(&value, &raw, sizeof(value));
+  return value;
+}
+
+static int64_t fromDouble(double value) {
+  int64_t raw;
+  std::memcpy(&raw, &value, sizeof(raw));
+  return raw;
+}
+
+/// Return the unsigned interpretation of a sign-extended integer.
+static uint64_t toUnsigned(int64_t raw, Type type) {
+  auto width = getBitWidth(type);
+  if (width >= 64)
+    return raw;
+  return (uint64_t)raw & ((1ULL << width) - 1);
+}
+
+/// Normalize a raw value to the scalar type. Integers are wrapped to their bit
+/// width and sign-extended, except that i1 is held as 0 or 1. Floats are
+/// rounded to their precision.
+static int64_t normalize(int64_t raw, Type type) {
+  if (type.isa<FloatType>()) {
+    if (getBitWidth(type) <= 32)
+      return fromDouble((double)(float)toDouble(raw));
+    return raw;
+  }
+  auto width = getBitWidth(type);
+  if (width == 1)
+    return raw & 1;
+  if (width >= 64)
+    return raw;
+  auto shift = 64 - width;
+  return (int64_t)((uint64_t)raw << shift) >> shift;
+}
+
+/// Return the raw value of an integer or float attribute.
+static int64_t getRawValue(Attribute attr, Type type) {
+  if (auto intAttr = attr.dyn_cast<IntegerAttr>())
+    return normalize(intAttr.getValue().getSExtValue(), type);
+  if (auto floatAttr = attr.dyn_cast<FloatAttr>())
+    return normalize(fromDouble(floatAttr.getValueAsDouble()), type);
+  return 0;
+}
+
+/// Return a random value of the scalar type. Integers are limited to 8 bits to
+/// avoid the overflow of accumulations being dominant.
+static int64_t getRandomValue(Type type, std::mt19937_64 &rng) {
+  if (type.isa<FloatType>())
+    return normalize(
+        fromDouble(std::uniform_real_distribution<double>(-1.0, 1.0)(rng)),
+        type);
+  if (type.isIndex())
+    return std::uniform_int_distribution<int64_t>(0, 15)(rng);
+  auto width = std::min(getBitWidth(type), 8u);
+  if (width == 1)
+    return rng() & 1;
+  auto bound = (int64_t)1 << (width - 1);
+  return normalize(
+      std::uniform_int_distribution<int64_t>(-bound, bound - 1)(rng), type);
+}
+
+/// Call the function with each index of the shape in the row-major order.
+static void forEachIndex(ArrayRef<int64_t> shape,
+                         function_ref<void(ArrayRef<int64_t>)> func) {
+  if (llvm::any_of(shape, [](int64_t size) { return size <= 0; }))
+    return;
+  SmallVector<int64_t, 4> indices(shape.size(), 0);
+  while (true) {
+    func(indices);
+    int64_t dim = shape.size() - 1;
+    for (; dim >= 0; --dim) {
+      if (++indices[dim] < shape[dim])
+        break;
+      indices[dim] = 0;
+    }
+    if (dim < 0)
+      return;
+  }
+}
+
+/// Split the linear lane into the coordinates of the vector shape.
+static SmallVector<int64_t, 4> delinearizeLane(unsigned lane,
+                                               ArrayRef<int64_t> shape) {
+  SmallVector<int64_t, 4> coords(shape.size(), 0);
+  for (int64_t dim = shape.size() - 1; dim >= 0; --dim) {
+    coords[dim] = lane % shape[dim];
+    lane /= shape[dim];
+  }
+  return coords;
+}
+
+namespace {
+/// The storage of a memory object.
+struct RtStorage {
+  std::vector<int64_t> data;
+  std::shared_ptr<MemoryProfile> profile;
+};
+
+/// A memref held by the interpreter, which is a view of a storage. The position
+/// function maps the indices and the lane of an element to the position of the
+/// lane in the storage, such that views can be composed with each other.
+struct RtMemRef {
+  using PositionFn = std::function<int64_t(ArrayRef<int64_t>, unsigned)>;
+
+  std::shared_ptr<RtStorage> storage;
+  SmallVector<int64_t, 4> shape;
+  unsigned laneNum = 1;
+  PositionFn position;
+
+  /// Return the position of the lane of the element, or -1 if the indices are
+  /// out of bounds.
+  int64_t getPosition(ArrayRef<int64_t> indices, unsigned lane) const {
+    if (indices.size() != shape.size())
+      return -1;
+    for (auto [index, size] : llvm::zip(indices, shape))
+      if (index < 0 || index >= size)
+        return -1;
+    return position(indices, lane);
+  }
+};
+
+/// A stream channel held by the interpreter.
+struct RtStream {
+  std::deque<SmallVector<int64_t, 2>> tokens;
+  std::shared_ptr<MemoryProfile> profile;
+};
+
+/// A runtime value, which is either a scalar or vector held as lanes, a memref,
+/// or a stream channel.
+struct RtValue {
+  SmallVector<int64_t, 2> lanes;
+  std::shared_ptr<RtMemRef> memref;
+  std::shared_ptr<RtStream> stream;
+};
+} // namespace
+
+/// Create a memref with a row-major storage initialized as zeros.
+static std::shared_ptr<RtMemRef>
+createMemRef(MemRefType type, std::shared_ptr<MemoryProfile> profile) {
+  auto memref = std::make_shared<RtMemRef>();
+  memref->shape.assign(type.getShape().begin(), type.getShape().end());
+  memref->laneNum = getLaneNum(type.getElementType());
+  memref->storage = std::make_shared<RtStorage>();
+  memref->storage->data.assign(type.getNumElements() * memref->laneNum, 0);
+  memref->storage->profile = profile;
+
+  SmallVector<int64_t, 4> strides(memref->shape.size(), 1);
+  for (int64_t dim = (int64_t)strides.size() - 2; dim >= 0; --dim)
+    strides[dim] = strides[dim + 1] * memref->shape[dim + 1];
+  memref->position = [strides, laneNum = memref->laneNum](
+                         ArrayRef<int64_t> indices, unsigned lane) {
+    int64_t position = 0;
+    for (auto [index, stride] : llvm::zip(indices, strides))
+      position += index * stride;
+    return position * laneNum + lane;
+  };
+  return memref;
+}
+
+/// Fill the storage with the elements in row-major order.
+static void fillStorage(RtStorage &storage, DenseElementsAttr elements,
+                        Type type) {
+  unsigned position = 0;
+  for (auto element : elements.getValues<Attribute>()) {
+    if (position >= storage.data.size())
+      return;
+    storage.data[position++] = getRawValue(element, type);
+  }
+}
+
+/// Return the positions of all lanes accessed at the indices. If the vector
+/// shape is not empty, the lanes are accessed from the trailing dimensions of
+/// a scalar memref. The position of an out-of-bounds lane is -1.
+static SmallVector<int64_t, 8>
+getLanePositions(const RtMemRef &memref, ArrayRef<int64_t> indices,
+                 ArrayRef<int64_t> vectorShape) {
+  SmallVector<int64_t, 8> positions;
+  if (vectorShape.empty()) {
+    for (unsigned lane = 0; lane < memref.laneNum; ++lane)
+      positions.push_back(memref.getPosition(indices, lane));
+    return positions;
+  }
+  if (vectorShape.size() > indices.size())
+    return {-1};
+
+  auto offset = indices.size() - vectorShape.size();
+  SmallVector<int64_t, 4> laneIndices(indices.begin(), indices.end());
+  forEachIndex(vectorShape, [&](ArrayRef<int64_t> coords) {
+    for (unsigned dim = 0; dim < coords.size(); ++dim)
+      laneIndices[offset + dim] = indices[offset + dim] + coords[dim];
+    positions.push_back(memref.getPosition(laneIndices, 0));
+  });
+  return positions;
+}
+
+//===----------------------------------------------------------------------===//
+// Lane Evaluation Utils
+//===----------------------------------------------------------------------===//
+
+static int64_t evalAffineExpr(AffineExpr expr, ArrayRef<int64_t> dims,
+                              ArrayRef<int64_t> syms) {
+  if (auto constExpr = expr.dyn_cast<AffineConstantExpr>())
+    return constExpr.getValue();
+  if (auto dimExpr = expr.dyn_cast<AffineDimExpr>())
+    return dims[dimExpr.getPosition()];
+  if (auto symExpr = expr.dyn_cast<AffineSymbolExpr>())
+    return syms[symExpr.getPosition()];
+
+  auto binaryExpr = expr.cast<AffineBinaryOpExpr>();
+  auto lhs = evalAffineExpr(binaryExpr.getLHS(), dims, syms);
+  auto rhs = evalAffineExpr(binaryExpr.getRHS(), dims, syms);
+  switch (expr.getKind()) {
+  case AffineExprKind::Add:
+    return lhs + rhs;
+  case AffineExprKind::Mul:
+    return lhs * rhs;
+  case AffineExprKind::Mod:
+    return mod(lhs, rhs);
+  case AffineExprKind::FloorDiv:
+    return floorDiv(lhs, rhs);
+  case AffineExprKind::CeilDiv:
+    return ceilDiv(lhs, rhs);
+  default:
+    llvm_unreachable("unexpected affine expression");
+  }
+}
+
+static bool evalCmpI(arith::CmpIPredicate predicate, int64_t lhs, int64_t rhs,
+                     Type type) {
+  auto ulhs = toUnsigned(lhs, type), urhs = toUnsigned(rhs, type);
+  switch (predicate) {
+  case arith::CmpIPredicate::eq:
+    return lhs == rhs;
+  case arith::CmpIPredicate::ne:
+    return lhs != rhs;
+  case arith::CmpIPredicate::slt:
+    return lhs < rhs;
+  case arith::CmpIPredicate::sle:
+    return lhs <= rhs;
+  case arith::CmpIPredicate::sgt:
+    return lhs > rhs;
+  case arith::CmpIPredicate::sge:
+    return lhs >= rhs;
+  case arith::CmpIPredicate::ult:
+    return ulhs < urhs;
+  case arith::CmpIPredicate::ule:
+    return ulhs <= urhs;
+  case arith::CmpIPredicate::ugt:
+    return ulhs > urhs;
+  case arith::CmpIPredicate::uge:
+    return ulhs >= urhs;
+  }
+  llvm_unreachable("unexpected predicate");
+}
+
+static bool evalCmpF(arith::CmpFPredicate predicate, double lhs, double rhs) {
+  auto unordered = std::isnan(lhs) || std::isnan(rhs);
+  switch (predicate) {
+  case arith::CmpFPredicate::AlwaysFalse:
+    return false;
+  case arith::CmpFPredicate::OEQ:
+    return !unordered && lhs == rhs;
+  case arith::CmpFPredicate::OGT:
+    return !unordered && lhs > rhs;
+  case arith::CmpFPredicate::OGE:
+    return !unordered && lhs >= rhs;
+  case arith::CmpFPredicate::OLT:
+    return !unordered && lhs < rhs;
+  case arith::CmpFPredicate::OLE:
+    return !unordered && lhs <= rhs;
+  case arith::CmpFPredicate::ONE:
+    return !unordered && lhs != rhs;
+  case arith::CmpFPredicate::ORD:
+    return !unordered;
+  case arith::CmpFPredicate::UEQ:
+    return unordered || lhs == rhs;
+  case arith::CmpFPredicate::UGT:
+    return unordered || lhs > rhs;
+  case arith::CmpFPredicate::UGE:
+    return unordered || lhs >= rhs;
+  case arith::CmpFPredicate::ULT:
+    return unordered || lhs < rhs;
+  case arith::CmpFPredicate::ULE:
+    return unordered || lhs <= rhs;
+  case arith::CmpFPredicate::UNE:
+    return unordered || lhs != rhs;
+  case arith::CmpFPredicate::UNO:
+    return unordered;
+  case arith::CmpFPredicate::AlwaysTrue:
+    return true;
+  }
+  llvm_unreachable("unexpected predicate");
+}
+
+/// Signed division rounded towards zero, floor, or ceiling. The division by
+/// zero is undefined in the IR and evaluated as zero here.
+static int64_t evalDivSI(int64_t lhs, int64_t rhs, int rounding = 0) {
+  if (rhs == 0)
+    return 0;
+  if (rhs == -1)
+    return (int64_t)(0 - (uint64_t)lhs);
+  auto quotient = lhs / rhs;
+  if (lhs % rhs != 0) {
+    if (rounding < 0 && (lhs < 0) != (rhs < 0))
+      --quotient;
+    if (rounding > 0 && (lhs < 0) == (rhs < 0))
+      ++quotient;
+  }
+  return quotient;
+}
+
+static int64_t evalRemSI(int64_t lhs, int64_t rhs) {
+  if (rhs == 0 || rhs == -1)
+    return 0;
+  return lhs % rhs;
+}
+
+static int64_t evalFPToSI(double value) {
+  if (std::isnan(value))
+    return 0;
+  if (value >= 9.2e18)
+    return std::numeric_limits<int64_t>::max();
+  if (value <= -9.2e18)
+    return std::numeric_limits<int64_t>::min();
+  return (int64_t)value;
+}
+
+static double evalMaxMinF(double lhs, double rhs, bool isMax) {
+  if (std::isnan(lhs) || std::isnan(rhs))
+    return std::nan("");
+  return isMax ? std::max(lhs, rhs) : std::min(lhs, rhs);
+}
+
+static double evalMathUnary(Operation *op, double x) {
+  return TypeSwitch<Operation *, double>(op)
+      .Case<math::AbsFOp>([&](auto) { return std::abs(x); })
+      .Case<math::CeilOp>([&](auto) { return std::ceil(x); })
+      .Case<math::FloorOp>([&](auto) { return std::floor(x); })
+      .Case<math::CosOp>([&](auto) { return std::cos(x); })
+      .Case<math::SinOp>([&](auto) { return std::sin(x); })
+      .Case<math::TanhOp>([&](auto) { return std::tanh(x); })
+      .Case<math::SqrtOp>([&](auto) { return std::sqrt(x); })
+      .Case<math::RsqrtOp>([&](auto) { return 1.0 / std::sqrt(x); })
+      .Case<math::ExpOp>([&](auto) { return std::exp(x); })
+      .Case<math::Exp2Op>([&](auto) { return std::exp2(x); })
+      .Case<math::LogOp>([&](auto) { return std::log(x); })
+      .Case<math::Log2Op>([&](auto) { return std::log2(x); })
+      .Case<math::Log10Op>([&](auto) { return std::log10(x); })
+      .Case<math::ErfOp>([&](auto) { return std::erf(x); })
+      .Default([&](auto) { return std::nan(""); });
+}
+
+/// Return the raw value holding the same bits as the given raw value, where
+/// only 32-bits and 64-bits floats are supported.
+static int64_t evalBitcast(int64_t raw, Type fromType, Type toType) {
+  uint64_t bits = toUnsigned(raw, fromType);
+  if (fromType.isF32()) {
+    float value = toDouble(raw);
+    uint32_t floatBits;
+    std::memcpy(&floatBits, &value, sizeof(floatBits));
+    bits = floatBits;
+  } else if (fromType.isF64())
+    bits = raw;
+
+  if (toType.isF32()) {
+    uint32_t floatBits = bits;
+    float value;
+    std::memcpy(&value, &floatBits, sizeof(value));
+    return fromDouble(value);
+  } else if (toType.isF64())
+    return bits;
+  return normalize(bits, toType);
+}
+
+//===----------------------------------------------------------------------===//
+// Interpreter Class Definition
+//===----------------------------------------------------------------------===//
+
+namespace {
+class Interpreter {
+public:
+  explicit Interpreter(ModuleOp module) : module(module) {}
+
+  LogicalResult call(func::FuncOp func, ArrayRef<RtValue> args,
+                     SmallVectorImpl<RtValue> &results);
+
+  /// Return the profile of the memory objects created by the operation, or
+  /// the profile of a function argument if the operation is null.
+  std::shared_ptr<MemoryProfile> getProfile(Operation *op, StringRef name);
+
+  SmallVector<MemoryProfile, 16> getProfiles() const {
+    SmallVector<MemoryProfile, 16> profiles;
+    for (auto &profile : profileList)
+      profiles.push_back(*profile);
+    return profiles;
+  }
+
+private:
+  LogicalResult executeBlock(Block &block, SmallVectorImpl<RtValue> &results);
+  LogicalResult execute(Operation *op);
+
+  /// Apply the function to each lane of the operands, where scalar operands
+  /// are broadcasted to all lanes. The results are normalized to the result
+  /// type of the operation.
+  LogicalResult mapLanes(Operation *op,
+                         function_ref<int64_t(ArrayRef<int64_t>)> func);
+
+  /// Evaluate the results of the affine map with the operand values.
+  SmallVector<int64_t, 4> evalAffineMap(AffineMap map, ValueRange operands);
+  bool evalIntegerSet(IntegerSet set, ValueRange operands);
+
+  /// Load from or store to the memref. If the vector shape is not empty, the
+  /// lanes are accessed from the trailing dimensions of a scalar memref.
+  LogicalResult load(Operation *op, Value memref, ArrayRef<int64_t> indices,
+                     Value result, ArrayRef<int64_t> vectorShape = {});
+  LogicalResult store(Operation *op, Value memref, ArrayRef<int64_t> indices,
+                      Value value, ArrayRef<int64_t> vectorShape = {});
+
+  LogicalResult executeAffineFor(AffineForOp loop);
+  LogicalResult executeScfFor(scf::ForOp loop);
+  LogicalResult executeRegionOp(Operation *op, Block &block,
+                                ValueRange blockArgs);
+  LogicalResult executeConstant(arith::ConstantOp op);
+  LogicalResult executeSubView(memref::SubViewOp op);
+  LogicalResult executeReshape(Operation *op, Value source,
+                               ArrayRef<ReassociationIndices> reassociation,
+                               bool isCollapse);
+  LogicalResult executeVectorize(Operation *op, Value source,
+                                 ArrayRef<int64_t> vectorShape,
+                                 bool isVectorize);
+  LogicalResult executeGetGlobal(memref::GetGlobalOp op);
+
+  int64_t getScalar(Value value) {
+    auto &lanes = values[value].lanes;
+    return lanes.empty() ? 0 : lanes.front();
+  }
+  SmallVector<int64_t, 8> getScalars(ValueRange operands) {
+    SmallVector<int64_t, 8> scalars;
+    for (auto operand : operands)
+      scalars.push_back(getScalar(operand));
+    return scalars;
+  }
+  std::shared_ptr<RtMemRef> getMemRef(Value value) {
+    return values[value].memref;
+  }
+  void setScalar(Value value, int64_t scalar) {
+    RtValue rtValue;
+    rtValue.lanes.push_back(scalar);
+    values[value] = std::move(rtValue);
+  }
+  void setMemRef(Value value, std::shared_ptr<RtMemRef> memref) {
+    RtValue rtValue;
+    rtValue.memref = std::move(memref);
+    values[value] = std::move(rtValue);
+  }
+
+  ModuleOp module;
+  llvm::DenseMap<Value, RtValue> values;
+  llvm::DenseMap<Operation *, std::shared_ptr<MemoryProfile>> opProfiles;
+  std::vector<std::shared_ptr<MemoryProfile>> profileList;
+};
+} // namespace
+
+std::shared_ptr<MemoryProfile> Interpreter::getProfile(Operation *op,
+                                                       StringRef name) {
+  if (op && opProfiles.count(op))
+    return opProfiles.lookup(op);
+
+  auto profile = std::make_shared<MemoryProfile>();
+  if (op) {
+    llvm::raw_string_ostream os(profile->name);
+    os << op->getName();
+    if (auto loc = op->getLoc().dyn_cast<FileLineColLoc>())
+      os << " at line " << loc.getLine();
+    opProfiles[op] = profile;
+  } else
+    profile->name = name.str();
+  profileList.push_back(profile);
+  return profile;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Interpreter Class Implementation
+//===----------------------------------------------------------------------===//
+
+LogicalResult Interpreter::call(func::FuncOp func, ArrayRef<RtValue> args,
+                                SmallVectorImpl<RtValue> &results) {
+  if (func.isExternal())
+    return func.emitOpError("external function cannot be interpreted");
+  for (auto [arg, value] : llvm::zip(func.getArguments(), args))
+    values[arg] = value;
+  return executeBlock(func.front(), results);
+}
+
+LogicalResult Interpreter::executeBlock(Block &block,
+                                        SmallVectorImpl<RtValue> &results) {
+  for (auto &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>()) {
+      for (auto operand : op.getOperands())
+        results.push_back(values.lookup(operand));
+      return success();
+    }
+    if (failed(execute(&op)))
+      return failure();
+  }
+  return success();
+}
+
+/// Execute the block of a region operation with the block arguments bound to
+/// the given operands, and bind the yielded values to the operation results.
+LogicalResult Interpreter::executeRegionOp(Operation *op, Block &block,
+                                           ValueRange operands) {
+  for (auto [arg, operand] : llvm::zip(block.getArguments(), operands))
+    values[arg] = values.lookup(operand);
+  SmallVector<RtValue, 4> results;
+  if (failed(executeBlock(block, results)))
+    return failure();
+  for (auto [result, value] : llvm::zip(op->getResults(), results))
+    values[result] = value;
+  return success();
+}
+
+LogicalResult
+Interpreter::mapLanes(Operation *op,
+                      function_ref<int64_t(ArrayRef<int64_t>)> func) {
+  auto type = op->getResult(0).getType();
+  auto laneNum = getLaneNum(type);
+  SmallVector<const RtValue *, 3> operands;
+  for (auto operand : op->getOperands()) {
+    auto it = values.find(operand);
+    if (it == values.end() || (it->second.lanes.size() != 1 &&
+                               it->second.lanes.size() != laneNum))
+      return op->emitOpError("has operands with mismatched lanes");
+    operands.push_back(&it->second);
+  }
+
+  RtValue result;
+  SmallVector<int64_t, 3> args;
+  for (unsigned lane = 0; lane < laneNum; ++lane) {
+    args.clear();
+    for (auto operand : operands)
+      args.push_back(operand->lanes.size() == 1 ? operand->lanes.front()
+                                                : operand->lanes[lane]);
+    result.lanes.push_back(normalize(func(args), getScalarType(type)));
+  }
+  values[op->getResult(0)] = std::move(result);
+  return success();
+}
+
+SmallVector<int64_t, 4> Interpreter::evalAffineMap(AffineMap map,
+                                                   ValueRange operands) {
+  auto scalars = getScalars(operands);
+  auto dims = ArrayRef<int64_t>(scalars).take_front(map.getNumDims());
+  auto syms = ArrayRef<int64_t>(scalars).drop_front(map.getNumDims());
+  SmallVector<int64_t, 4> results;
+  for (auto expr : map.getResults())
+    results.push_back(evalAffineExpr(expr, dims, syms));
+  return results;
+}
+
+bool Interpreter::evalIntegerSet(IntegerSet set, ValueRange operands) {
+  auto scalars = getScalars(operands);
+  auto dims = ArrayRef<int64_t>(scalars).take_front(set.getNumDims());
+  auto syms = ArrayRef<int64_t>(scalars).drop_front(set.getNumDims());
+  for (unsigned i = 0, e = set.getNumConstraints(); i < e; ++i) {
+    auto value = evalAffineExpr(set.getConstraint(i), dims, syms);
+    if (set.isEq(i) ? value != 0 : value < 0)
+      return false;
+  }
+  return true;
+}
+
+LogicalResult Interpreter::load(Operation *op, Value memref,
+                                ArrayRef<int64_t> indices, Value result,
+                                ArrayRef<int64_t> vectorShape) {
+  auto view = getMemRef(memref);
+  if (!view)
+    return op->emitOpError("accesses an unevaluated memref");
+  auto positions = getLanePositions(*view, indices, vectorShape);
+  if (llvm::is_contained(positions, -1))
+    return op->emitOpError("accesses out of bounds");
+
+  RtValue value;
+  for (auto position : positions)
+    value.lanes.push_back(view->storage->data[position]);
+  view->storage->profile->loadNum++;
+  values[result] = std::move(value);
+  return success();
+}
+
+LogicalResult Interpreter::store(Operation *op, Value memref,
+                                 ArrayRef<int64_t> indices, Value value,
+                                 ArrayRef<int64_t> vectorShape) {
+  auto view = getMemRef(memref);
+  if (!view)
+    return op->emitOpError("accesses an unevaluated memref");
+  auto positions = getLanePositions(*view, indices, vectorShape);
+  if (llvm::is_contained(positions, -1))
+    return op->emitOpError("accesses out of bounds");
+  auto &lanes = values[value].lanes;
+  if (lanes.size() != positions.size())
+    return op->emitOpError("stores a value with mismatched lanes");
+
+  for (auto [position, lane] : llvm::zip(positions, lanes))
+    view->storage->data[position] = lane;
+  view->storage->profile->storeNum++;
+  return success();
+}
+
+LogicalResult Interpreter::executeAffineFor(AffineForOp loop) {
+  auto lbs = evalAffineMap(loop.getLowerBoundMap(),
+                           loop.getLowerBoundOperands());
+  auto ubs = evalAffineMap(loop.getUpperBoundMap(),
+                           loop.getUpperBoundOperands());
+  auto lb = *std::max_element(lbs.begin(), lbs.end());
+  auto ub = *std::min_element(ubs.begin(), ubs.end());
+
+  SmallVector<RtValue, 4> iterValues;
+  for (auto operand : loop.getIterOperands())
+    iterValues.push_back(values.lookup(operand));
+
+  for (auto iv = lb; iv < ub; iv += loop.getStep()) {
+    setScalar(loop.getInductionVar(), iv);
+    for (auto [arg, value] : llvm::zip(loop.getRegionIterArgs(), iterValues))
+      values[arg] = value;
+    SmallVector<RtValue, 4> yieldValues;
+    if (failed(executeBlock(*loop.getBody(), yieldValues)))
+      return failure();
+    iterValues = std::move(yieldValues);
+  }
+
+  for (auto [result, value] : llvm::zip(loop.getResults(), iterValues))
+    values[result] = value;
+  return success();
+}
+
+LogicalResult Interpreter::executeScfFor(scf::ForOp loop) {
+  auto lb = getScalar(loop.getLowerBound());
+  auto ub = getScalar(loop.getUpperBound());
+  auto step = getScalar(loop.getStep());
+  if (step <= 0)
+    return loop.emitOpError("has a non-positive step");
+
+  SmallVector<RtValue, 4> iterValues;
+  for (auto operand : loop.getInitArgs())
+    iterValues.push_back(values.lookup(operand));
+
+  for (auto iv = lb; iv < ub; iv += step) {
+    setScalar(loop.getInductionVar(), iv);
+    for (auto [arg, value] : llvm::zip(loop.getRegionIterArgs(), iterValues))
+      values[arg] = value;
+    SmallVector<RtValue, 4> yieldValues;
+    if (failed(executeBlock(*loop.getBody(), yieldValues)))
+      return failure();
+    iterValues = std::move(yieldValues);
+  }
+
+  for (auto [result, value] : llvm::zip(loop.getResults(), iterValues))
+    values[result] = value;
+  return success();
+}
+
+LogicalResult Interpreter::executeConstant(arith::ConstantOp op) {
+  auto type = getScalarType(op.getType());
+  if (!type.isIntOrIndexOrFloat())
+    return op.emitOpError("is not a scalar or vector constant");
+
+  RtValue value;
+  if (auto elements = op.getValue().dyn_cast<DenseElementsAttr>()) {
+    for (auto element : elements.getValues<Attribute>())
+      value.lanes.push_back(getRawValue(element, type));
+  } else
+    value.lanes.push_back(getRawValue(op.getValue(), type));
+  values[op.getResult()] = std::move(value);
+  return success();
+}
+
+LogicalResult Interpreter::executeSubView(memref::SubViewOp op) {
+  auto source = getMemRef(op.getSource());
+  if (!source || !op.getType().hasStaticShape())
+    return op.emitOpError("cannot be interpreted");
+
+  auto getConstant = [&](OpFoldResult value) {
+    if (auto attr = value.dyn_cast<Attribute>())
+      return attr.cast<IntegerAttr>().getInt();
+    return getScalar(value.get<Value>());
+  };
+  SmallVector<int64_t, 4> offsets, strides;
+  for (auto offset : op.getMixedOffsets())
+    offsets.push_back(getConstant(offset));
+  for (auto stride : op.getMixedStrides())
+    strides.push_back(getConstant(stride));
+  auto droppedDims = op.getDroppedDims();
+
+  auto view = std::make_shared<RtMemRef>(*source);
+  view->shape.assign(op.getType().getShape().begin(),
+                     op.getType().getShape().end());
+  view->position = [source, offsets, strides, droppedDims](
+                       ArrayRef<int64_t> indices, unsigned lane) {
+    SmallVector<int64_t, 4> sourceIndices;
+    unsigned dim = 0;
+    for (unsigned i = 0, e = offsets.size(); i < e; ++i) {
+      auto index = droppedDims.test(i) ? 0 : indices[dim++];
+      sourceIndices.push_back(offsets[i] + index * strides[i]);
+    }
+    return source->position(sourceIndices, lane);
+  };
+  setMemRef(op.getResult(), view);
+  return success();
+}
+
+/// Execute a collapse or expand shape operation, where each reassociation
+/// group indexes the dimensions of the higher-ranked memref.
+LogicalResult
+Interpreter::executeReshape(Operation *op, Value source,
+                            ArrayRef<ReassociationIndices> reassociation,
+                            bool isCollapse) {
+  auto sourceView = getMemRef(source);
+  auto type = op->getResult(0).getType().cast<MemRefType>();
+  if (!sourceView || !type.hasStaticShape())
+    return op->emitOpError("cannot be interpreted");
+
+  auto view = std::make_shared<RtMemRef>(*sourceView);
+  view->shape.assign(type.getShape().begin(), type.getShape().end());
+  SmallVector<ReassociationIndices, 4> groups(reassociation.begin(),
+                                              reassociation.end());
+  auto sourceShape = sourceView->shape;
+  auto shape = view->shape;
+  view->position = [sourceView, groups, sourceShape, shape, isCollapse](
+                       ArrayRef<int64_t> indices, unsigned lane) {
+    SmallVector<int64_t, 4> sourceIndices(sourceShape.size(), 0);
+    for (unsigned group = 0, e = groups.size(); group < e; ++group) {
+      if (isCollapse) {
+        auto linearIndex = indices[group];
+        for (auto dim : llvm::reverse(groups[group])) {
+          sourceIndices[dim] = linearIndex % sourceShape[dim];
+          linearIndex /= sourceShape[dim];
+        }
+      } else {
+        int64_t linearIndex = 0;
+        for (auto dim : groups[group])
+          linearIndex = linearIndex * shape[dim] + indices[dim];
+        sourceIndices[group] = linearIndex;
+      }
+    }
+    return sourceView->position(sourceIndices, lane);
+  };
+  setMemRef(op->getResult(0), view);
+  return success();
+}
+
+/// Execute a buffer vectorize or devectorize operation, where each dimension of
+/// the scalar buffer is split by the vector shape.
+LogicalResult Interpreter::executeVectorize(Operation *op, Value source,
+                                            ArrayRef<int64_t> vectorShape,
+                                            bool isVectorize) {
+  auto sourceView = getMemRef(source);
+  if (!sourceView)
+    return op->emitOpError("cannot be interpreted");
+  auto type = op->getResult(0).getType().cast<MemRefType>();
+
+  auto view = std::make_shared<RtMemRef>(*sourceView);
+  view->shape.assign(type.getShape().begin(), type.getShape().end());
+  view->laneNum = getLaneNum(type.getElementType());
+  SmallVector<int64_t, 4> shape(vectorShape.begin(), vectorShape.end());
+  view->position = [sourceView, shape, isVectorize](ArrayRef<int64_t> indices,
+                                                    unsigned lane) {
+    SmallVector<int64_t, 4> sourceIndices(indices.begin(), indices.end());
+    if (isVectorize) {
+      auto coords = delinearizeLane(lane, shape);
+      for (unsigned dim = 0, e = shape.size(); dim < e; ++dim)
+        sourceIndices[dim] = indices[dim] * shape[dim] + coords[dim];
+      return sourceView->position(sourceIndices, 0);
+    }
+    unsigned sourceLane = 0;
+    for (unsigned dim = 0, e = shape.size(); dim < e; ++dim) {
+      sourceIndices[dim] = indices[dim] / shape[dim];
+      sourceLane = sourceLane * shape[dim] + indices[dim] % shape[dim];
+    }
+    return sourceView->position(sourceIndices, sourceLane);
+  };
+  setMemRef(op->getResult(0), view);
+  return success();
+}
+
+LogicalResult Interpreter::executeGetGlobal(memref::GetGlobalOp op) {
+  auto global = SymbolTable::lookupNearestSymbolFrom<memref::GlobalOp>(
+      op, op.getNameAttr());
+  if (!global || !global.getInitialValue() || !op.getType().hasStaticShape())
+    return op.emitOpError("refers to an uninitialized global memref");
+
+  auto memref = createMemRef(op.getType(), getProfile(op, ""));
+  if (auto elements = global.getInitialValue()->dyn_cast<DenseElementsAttr>())
+    fillStorage(*memref->storage, elements,
+                getScalarType(op.getType().getElementType()));
+  setMemRef(op.getResult(), memref);
+  return success();
+}
+
+LogicalResult Interpreter::execute(Operation *op) {
+  using Lanes = ArrayRef<int64_t>;
+  auto map = [&](function_ref<int64_t(Lanes)> func) {
+    return mapLanes(op, func);
+  };
+
+  // The scalar type of the first operand, which is used for evaluating the
+  // unsigned and floating point lanes.
+  Type type;
+  if (op->getNumOperands())
+    type = getScalarType(op->getOperand(0).getType());
+  auto width = type && type.isIntOrIndexOrFloat() ? getBitWidth(type) : 0;
+  auto toUnsignedLane = [&](int64_t raw) { return toUnsigned(raw, type); };
+
+  return TypeSwitch<Operation *, LogicalResult>(op)
+      // Integer operations.
+      .Case<arith::AddIOp>([&](auto) {
+        return map([](Lanes a) -> int64_t {
+          return (uint64_t)a[0] + (uint64_t)a[1];
+        });
+      })
+      .Case<arith::SubIOp>([&](auto) {
+        return map([](Lanes a) -> int64_t {
+          return (uint64_t)a[0] - (uint64_t)a[1];
+        });
+      })
+      .Case<arith::MulIOp>([&](auto) {
+        return map([](Lanes a) -> int64_t {
+          return (uint64_t)a[0] * (uint64_t)a[1];
+        });
+      })
+      .Case<arith::DivSIOp>([&](auto) {
+        return map([](Lanes a) { return evalDivSI(a[0], a[1]); });
+      })
+      .Case<arith::FloorDivSIOp>([&](auto) {
+        return map([](Lanes a) { return evalDivSI(a[0], a[1], -1); });
+      })
+      .Case<arith::CeilDivSIOp>([&](auto) {
+        return map([](Lanes a) { return evalDivSI(a[0], a[1], 1); });
+      })
+      .Case<arith::RemSIOp>([&](auto) {
+        return map([](Lanes a) { return evalRemSI(a[0], a[1]); });
+      })
+      .Case<arith::DivUIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto rhs = toUnsignedLane(a[1]);
+          return rhs ? toUnsignedLane(a[0]) / rhs : 0;
+        });
+      })
+      .Case<arith::CeilDivUIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto lhs = toUnsignedLane(a[0]), rhs = toUnsignedLane(a[1]);
+          return rhs ? lhs / rhs + (lhs % rhs != 0) : 0;
+        });
+      })
+      .Case<arith::RemUIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto rhs = toUnsignedLane(a[1]);
+          return rhs ? toUnsignedLane(a[0]) % rhs : 0;
+        });
+      })
+      .Case<arith::AndIOp>([&](auto) {
+        return map([](Lanes a) { return a[0] & a[1]; });
+      })
+      .Case<arith::OrIOp>([&](auto) {
+        return map([](Lanes a) { return a[0] | a[1]; });
+      })
+      .Case<arith::XOrIOp>([&](auto) {
+        return map([](Lanes a) { return a[0] ^ a[1]; });
+      })
+      .Case<arith::ShLIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto shift = toUnsignedLane(a[1]);
+          return shift < width ? (uint64_t)a[0] << shift : 0;
+        });
+      })
+      .Case<arith::ShRSIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto shift = toUnsignedLane(a[1]);
+          return shift < width ? a[0] >> shift : (a[0] < 0 ? -1 : 0);
+        });
+      })
+      .Case<arith::ShRUIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t {
+          auto shift = toUnsignedLane(a[1]);
+          return shift < width ? toUnsignedLane(a[0]) >> shift : 0;
+        });
+      })
+      .Case<arith::MaxSIOp>([&](auto) {
+        return map([](Lanes a) { return std::max(a[0], a[1]); });
+      })
+      .Case<arith::MinSIOp>([&](auto) {
+        return map([](Lanes a) { return std::min(a[0], a[1]); });
+      })
+      .Case<arith::MaxUIOp>([&](auto) {
+        return map([&](Lanes a) {
+          return toUnsignedLane(a[0]) > toUnsignedLane(a[1]) ? a[0] : a[1];
+        });
+      })
+      .Case<arith::MinUIOp>([&](auto) {
+        return map([&](Lanes a) {
+          return toUnsignedLane(a[0]) < toUnsignedLane(a[1]) ? a[0] : a[1];
+        });
+      })
+      .Case<arith::CmpIOp>([&](arith::CmpIOp cmp) {
+        return map([&](Lanes a) -> int64_t {
+          return evalCmpI(cmp.getPredicate(), a[0], a[1], type);
+        });
+      })
+      .Case<math::AbsIOp>([&](auto) {
+        return map([](Lanes a) -> int64_t {
+          return a[0] < 0 ? 0 - (uint64_t)a[0] : a[0];
+        });
+      })
+
+      // Float operations.
+      .Case<arith::AddFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(toDouble(a[0]) + toDouble(a[1]));
+        });
+      })
+      .Case<arith::SubFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(toDouble(a[0]) - toDouble(a[1]));
+        });
+      })
+      .Case<arith::MulFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(toDouble(a[0]) * toDouble(a[1]));
+        });
+      })
+      .Case<arith::DivFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(toDouble(a[0]) / toDouble(a[1]));
+        });
+      })
+      .Case<arith::RemFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(std::fmod(toDouble(a[0]), toDouble(a[1])));
+        });
+      })
+      .Case<arith::MaxFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(evalMaxMinF(toDouble(a[0]), toDouble(a[1]), true));
+        });
+      })
+      .Case<arith::MinFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(
+              evalMaxMinF(toDouble(a[0]), toDouble(a[1]), false));
+        });
+      })
+      .Case<arith::NegFOp>([&](auto) {
+        return map([](Lanes a) { return fromDouble(-toDouble(a[0])); });
+      })
+      .Case<arith::CmpFOp>([&](arith::CmpFOp cmp) {
+        return map([&](Lanes a) -> int64_t {
+          return evalCmpF(cmp.getPredicate(), toDouble(a[0]),
+                          toDouble(a[1]));
+        });
+      })
+      .Case<math::PowFOp>([&](auto) {
+        return map([](Lanes a) {
+          return fromDouble(std::pow(toDouble(a[0]), toDouble(a[1])));
+        });
+      })
+      .Case<math::AbsFOp, math::CeilOp, math::FloorOp, math::CosOp,
+            math::SinOp, math::TanhOp, math::SqrtOp, math::RsqrtOp,
+            math::ExpOp, math::Exp2Op, math::LogOp, math::Log2Op,
+            math::Log10Op, math::ErfOp>([&](auto) {
+        return map([&](Lanes a) {
+          return fromDouble(evalMathUnary(op, toDouble(a[0])));
+        });
+      })
+
+      // Cast and select operations.
+      .Case<arith::ExtSIOp, arith::TruncIOp, arith::ExtFOp, arith::TruncFOp,
+            arith::IndexCastOp, PrimCastOp>(
+          [&](auto) { return map([](Lanes a) { return a[0]; }); })
+      .Case<arith::ExtUIOp, arith::IndexCastUIOp>([&](auto) {
+        return map([&](Lanes a) -> int64_t { return toUnsignedLane(a[0]); });
+      })
+      .Case<arith::SIToFPOp>([&](auto) {
+        return map([](Lanes a) { return fromDouble((double)a[0]); });
+      })
+      .Case<arith::UIToFPOp>([&](auto) {
+        return map([&](Lanes a) {
+          return fromDouble((double)toUnsignedLane(a[0]));
+        });
+      })
+      .Case<arith::FPToSIOp, arith::FPToUIOp>([&](auto) {
+        return map([](Lanes a) { return evalFPToSI(toDouble(a[0])); });
+      })
+      .Case<arith::BitcastOp>([&](arith::BitcastOp cast) {
+        auto resultType = getScalarType(cast.getType());
+        return map(
+            [&](Lanes a) { return evalBitcast(a[0], type, resultType); });
+      })
+      .Case<arith::SelectOp>([&](auto) {
+        return map([](Lanes a) { return a[0] ? a[1] : a[2]; });
+      })
+      .Case<arith::ConstantOp>(
+          [&](arith::ConstantOp op) { return executeConstant(op); })
+      .Case<PrimMulOp>([&](auto) {
+        return map([](Lanes a) { return a[0] * a[1]; });
+      })
+
+      // Affine and SCF operations.
+      .Case<AffineForOp>([&](AffineForOp op) { return executeAffineFor(op); })
+      .Case<AffineIfOp>([&](AffineIfOp op) -> LogicalResult {
+        if (evalIntegerSet(op.getIntegerSet(), op.getOperands()))
+          return executeRegionOp(op, *op.getThenBlock(), ValueRange());
+        if (op.hasElse())
+          return executeRegionOp(op, *op.getElseBlock(), ValueRange());
+        return success();
+      })
+      .Case<AffineLoadOp>([&](AffineLoadOp op) {
+        return load(op, op.getMemRef(),
+                    evalAffineMap(op.getAffineMap(), op.getMapOperands()),
+                    op.getResult());
+      })
+      .Case<AffineStoreOp>([&](AffineStoreOp op) {
+        return store(op, op.getMemRef(),
+                     evalAffineMap(op.getAffineMap(), op.getMapOperands()),
+                     op.getValueToStore());
+      })
+      .Case<AffineVectorLoadOp>([&](AffineVectorLoadOp op) {
+        return load(op, op.getMemRef(),
+                    evalAffineMap(op.getAffineMap(), op.getMapOperands()),
+                    op.getResult(), op.getVectorType().getShape());
+      })
+      .Case<AffineVectorStoreOp>([&](AffineVectorStoreOp op) {
+        return store(op, op.getMemRef(),
+                     evalAffineMap(op.getAffineMap(), op.getMapOperands()),
+                     op.getValueToStore(), op.getVectorType().getShape());
+      })
+      .Case<AffineApplyOp>([&](AffineApplyOp op) {
+        setScalar(op.getResult(), evalAffineMap(op.getAffineMap(),
+                                                op.getMapOperands())[0]);
+        return success();
+      })
+      .Case<AffineMinOp, AffineMaxOp>([&](auto op) {
+        auto results = evalAffineMap(op.getMap(), op->getOperands());
+        setScalar(op.getResult(),
+                  isa<AffineMinOp>(op)
+                      ? *std::min_element(results.begin(), results.end())
+                      : *std::max_element(results.begin(), results.end()));
+        return success();
+      })
+      .Case<scf::ForOp>([&](scf::ForOp op) { return executeScfFor(op); })
+      .Case<scf::IfOp>([&](scf::IfOp op) -> LogicalResult {
+        if (getScalar(op.getCondition()))
+          return executeRegionOp(op, op.getThenRegion().front(), ValueRange());
+        if (!op.getElseRegion().empty())
+          return executeRegionOp(op, op.getElseRegion().front(), ValueRange());
+        return success();
+      })
+
+      // Memref operations.
+      .Case<memref::AllocOp, memref::AllocaOp>([&](auto op) -> LogicalResult {
+        if (!op.getType().hasStaticShape())
+          return op.emitOpError("has a dynamic shape");
+        setMemRef(op.getResult(),
+                  createMemRef(op.getType(), getProfile(op, "")));
+        return success();
+      })
+      .Case<memref::LoadOp>([&](memref::LoadOp op) {
+        return load(op, op.getMemRef(), getScalars(op.getIndices()),
+                    op.getResult());
+      })
+      .Case<memref::StoreOp>([&](memref::StoreOp op) {
+        return store(op, op.getMemRef(), getScalars(op.getIndices()),
+                     op.getValueToStore());
+      })
+      .Case<memref::CopyOp>([&](memref::CopyOp op) -> LogicalResult {
+        auto source = getMemRef(op.getSource());
+        auto target = getMemRef(op.getTarget());
+        if (!source || !target || source->shape != target->shape ||
+            source->laneNum != target->laneNum)
+          return op.emitOpError("copies between mismatched memrefs");
+
+        int64_t elementNum = 0;
+        forEachIndex(source->shape, [&](ArrayRef<int64_t> indices) {
+          for (unsigned lane = 0; lane < source->laneNum; ++lane)
+            target->storage->data[target->position(indices, lane)] =
+                source->storage->data[source->position(indices, lane)];
+          ++elementNum;
+        });
+        source->storage->profile->loadNum += elementNum;
+        target->storage->profile->storeNum += elementNum;
+        return success();
+      })
+      .Case<memref::SubViewOp>(
+          [&](memref::SubViewOp op) { return executeSubView(op); })
+      .Case<memref::CollapseShapeOp>([&](memref::CollapseShapeOp op) {
+        return executeReshape(op, op.getSrc(), op.getReassociationIndices(),
+                              /*isCollapse=*/true);
+      })
+      .Case<memref::ExpandShapeOp>([&](memref::ExpandShapeOp op) {
+        return executeReshape(op, op.getSrc(), op.getReassociationIndices(),
+                              /*isCollapse=*/false);
+      })
+      .Case<memref::CastOp>([&](memref::CastOp op) {
+        values[op.getResult()] = values.lookup(op.getSource());
+        return success();
+      })
+      .Case<memref::GetGlobalOp>(
+          [&](memref::GetGlobalOp op) { return executeGetGlobal(op); })
+      .Case<memref::DeallocOp>([&](auto) { return success(); })
+
+      // Vector operations.
+      .Case<vector::TransferReadOp>(
+          [&](vector::TransferReadOp op) -> LogicalResult {
+            auto view = getMemRef(op.getSource());
+            if (!view || op.getMask() ||
+                !op.getPermutationMap().isMinorIdentity())
+              return op.emitOpError("cannot be interpreted");
+
+            auto padding = getScalar(op.getPadding());
+            RtValue value;
+            for (auto position :
+                 getLanePositions(*view, getScalars(op.getIndices()),
+                                  op.getVectorType().getShape()))
+              value.lanes.push_back(
+                  position < 0 ? padding : view->storage->data[position]);
+            view->storage->profile->loadNum++;
+            values[op.getResult()] = std::move(value);
+            return success();
+          })
+      .Case<vector::TransferWriteOp>(
+          [&](vector::TransferWriteOp op) -> LogicalResult {
+            auto view = getMemRef(op.getSource());
+            if (!view || op.getMask() ||
+                !op.getPermutationMap().isMinorIdentity())
+              return op.emitOpError("cannot be interpreted");
+
+            auto lanes = values[op.getVector()].lanes;
+            auto positions =
+                getLanePositions(*view, getScalars(op.getIndices()),
+                                 op.getVectorType().getShape());
+            for (auto [position, lane] : llvm::zip(positions, lanes))
+              if (position >= 0)
+                view->storage->data[position] = lane;
+            view->storage->profile->storeNum++;
+            return success();
+          })
+      .Case<vector::BroadcastOp>([&](auto) {
+        return map([](Lanes a) { return a[0]; });
+      })
+      .Case<vector::ExtractElementOp>([&](vector::ExtractElementOp op) {
+        auto position = op.getPosition() ? getScalar(op.getPosition()) : 0;
+        auto lanes = values[op.getVector()].lanes;
+        if (position < 0 || position >= (int64_t)lanes.size())
+          return op.emitOpError("extracts out of bounds");
+        setScalar(op.getResult(), lanes[position]);
+        return success();
+      })
+      .Case<vector::InsertElementOp>([&](vector::InsertElementOp op) {
+        auto position = op.getPosition() ? getScalar(op.getPosition()) : 0;
+        auto value = values.lookup(op.getDest());
+        if (position < 0 || position >= (int64_t)value.lanes.size())
+          return op.emitOpError("inserts out of bounds");
+        value.lanes[position] = getScalar(op.getSource());
+        values[op.getResult()] = std::move(value);
+        return success();
+      })
+      .Case<VectorInitOp>([&](VectorInitOp op) {
+        RtValue value;
+        value.lanes.assign(getLaneNum(op.getType()), 0);
+        values[op.getResult()] = std::move(value);
+        return success();
+      })
+
+      // Dataflow operations, where nodes are executed sequentially.
+      .Case<ScheduleOp, NodeOp>([&](auto op) {
+        return executeRegionOp(op, op->getRegion(0).front(),
+                               op->getOperands());
+      })
+      .Case<DispatchOp, TaskOp>([&](auto op) {
+        return executeRegionOp(op, op->getRegion(0).front(), ValueRange());
+      })
+      .Case<BufferOp>([&](BufferOp op) {
+        auto memref = createMemRef(op.getType(), getProfile(op, ""));
+        if (auto initValue = op.getInitValue())
+          for (auto &lane : memref->storage->data)
+            lane = getRawValue(initValue.value(),
+                               getScalarType(op.getType().getElementType()));
+        setMemRef(op.getResult(), memref);
+        return success();
+      })
+      .Case<ConstBufferOp>([&](ConstBufferOp op) {
+        auto memref = createMemRef(op.getType(), getProfile(op, ""));
+        if (auto elements = op.getValue().dyn_cast<DenseElementsAttr>())
+          fillStorage(*memref->storage, elements,
+                      getScalarType(op.getType().getElementType()));
+        setMemRef(op.getResult(), memref);
+        return success();
+      })
+      .Case<StreamOp>([&](StreamOp op) {
+        RtValue value;
+        value.stream = std::make_shared<RtStream>();
+        value.stream->profile = getProfile(op, "");
+        values[op.getChannel()] = std::move(value);
+        return success();
+      })
+      .Case<StreamReadOp>([&](StreamReadOp op) -> LogicalResult {
+        auto stream = values[op.getChannel()].stream;
+        if (!stream)
+          return op.emitOpError("reads an unevaluated stream channel");
+        if (stream->tokens.empty())
+          return op.emitOpError("reads an empty stream channel");
+
+        RtValue value;
+        value.lanes = stream->tokens.front();
+        stream->tokens.pop_front();
+        stream->profile->loadNum++;
+        if (op.getResult())
+          values[op.getResult()] = std::move(value);
+        return success();
+      })
+      .Case<StreamWriteOp>([&](StreamWriteOp op) -> LogicalResult {
+        auto stream = values[op.getChannel()].stream;
+        if (!stream)
+          return op.emitOpError("writes an unevaluated stream channel");
+
+        stream->tokens.push_back(values[op.getValue()].lanes);
+        stream->profile->storeNum++;
+        stream->profile->peakOccupancy =
+            std::max(stream->profile->peakOccupancy,
+                     (int64_t)stream->tokens.size());
+        return success();
+      })
+      .Case<ToStreamOp>([&](ToStreamOp op) {
+        RtValue value;
+        value.stream = std::make_shared<RtStream>();
+        value.stream->profile = getProfile(op, "");
+        value.stream->tokens.push_back(values[op.getValue()].lanes);
+        values[op.getStream()] = std::move(value);
+        return success();
+      })
+      .Case<ToValueOp>([&](ToValueOp op) -> LogicalResult {
+        auto stream = values[op.getStream()].stream;
+        if (!stream || stream->tokens.empty())
+          return op.emitOpError("reads an empty stream channel");
+        RtValue value;
+        value.lanes = stream->tokens.front();
+        values[op.getValue()] = std::move(value);
+        return success();
+      })
+      .Case<BufferVectorizeOp>([&](BufferVectorizeOp op) {
+        auto layout = op.getInputType().getLayout().cast<TileLayoutAttr>();
+        return executeVectorize(op, op.getInput(), layout.getVectorShape(),
+                                /*isVectorize=*/true);
+      })
+      .Case<BufferDevectorizeOp>([&](BufferDevectorizeOp op) {
+        auto layout = op.getType().getLayout().cast<TileLayoutAttr>();
+        return executeVectorize(op, op.getInput(), layout.getVectorShape(),
+                                /*isVectorize=*/false);
+      })
+      .Case<AffineSelectOp>([&](AffineSelectOp op) {
+        auto value = evalIntegerSet(op.getIntegerSet(), op.getArgs())
+                         ? op.getTrueValue()
+                         : op.getFalseValue();
+        values[op.getResult()] = values.lookup(value);
+        return success();
+      })
+
+      // AXI interfaces are transparent to the interpreter.
+      .Case<AxiBundleOp>([&](auto) { return success(); })
+      .Case<AxiPortOp>([&](AxiPortOp op) {
+        values[op.getElement()] = values.lookup(op.getAxi());
+        return success();
+      })
+      .Case<AxiPackOp>([&](AxiPackOp op) {
+        values[op.getAxi()] = values.lookup(op.getElement());
+        return success();
+      })
+
+      // Function calls.
+      .Case<func::CallOp>([&](func::CallOp op) -> LogicalResult {
+        auto callee = module.lookupSymbol<func::FuncOp>(op.getCallee());
+        if (!callee)
+          return op.emitOpError("calls an unknown function");
+        SmallVector<RtValue, 8> args;
+        for (auto operand : op.getOperands())
+          args.push_back(values.lookup(operand));
+        SmallVector<RtValue, 4> results;
+        if (failed(call(callee, args, results)))
+          return failure();
+        for (auto [result, value] : llvm::zip(op.getResults(), results))
+          values[result] = value;
+        return success();
+      })
+
+      .Default([&](Operation *op) {
+        return op->emitOpError("is not supported by the interpreter");
+      });
+}
+
+//===----------------------------------------------------------------------===//
+// Entry Points
+//===----------------------------------------------------------------------===//
+
+/// Return the data held by the runtime value in row-major order.
+static InterpretData getInterpretData(Type type, const RtValue &value) {
+  InterpretData data;
+  if (auto memrefType = type.dyn_cast<MemRefType>()) {
+    data.elementType = getScalarType(memrefType.getElementType());
+    auto &memref = *value.memref;
+    forEachIndex(memref.shape, [&](ArrayRef<int64_t> indices) {
+      for (unsigned lane = 0; lane < memref.laneNum; ++lane)
+        data.lanes.push_back(
+            memref.storage->data[memref.position(indices, lane)]);
+    });
+    return data;
+  }
+  data.elementType = getScalarType(type);
+  data.lanes.assign(value.lanes.begin(), value.lanes.end());
+  return data;
+}
+
+FailureOr<InterpretResult> scalehls::interpretFunc(func::FuncOp func,
+                                                   unsigned seed) {
+  Interpreter interpreter(func->getParentOfType<ModuleOp>());
+  std::mt19937_64 rng(seed);
+
+  // Feed each argument with random values.
+  SmallVector<RtValue, 8> args;
+  for (auto arg : func.getArguments()) {
+    RtValue value;
+    auto type = arg.getType();
+    if (auto memrefType = type.dyn_cast<MemRefType>()) {
+      if (!memrefType.hasStaticShape()) {
+        func.emitOpError("has a dynamically shaped argument");
+        return failure();
+      }
+      auto name = "argument #" + std::to_string(arg.getArgNumber());
+      value.memref =
+          createMemRef(memrefType, interpreter.getProfile(nullptr, name));
+      auto elementType = getScalarType(memrefType.getElementType());
+      for (auto &lane : value.memref->storage->data)
+        lane = getRandomValue(elementType, rng);
+    } else if (getScalarType(type).isIntOrIndexOrFloat()) {
+      for (unsigned i = 0, e = getLaneNum(type); i < e; ++i)
+        value.lanes.push_back(getRandomValue(getScalarType(type), rng));
+    } else {
+      func.emitOpError("has an argument of unsupported type ") << type;
+      return failure();
+    }
+    args.push_back(value);
+  }
+
+  SmallVector<RtValue, 4> results;
+  if (failed(interpreter.call(func, args, results)))
+    return failure();
+
+  InterpretResult result;
+  for (auto [arg, value] : llvm::zip(func.getArguments(), args))
+    result.arguments.push_back(getInterpretData(arg.getType(), value));
+  for (auto [type, value] : llvm::zip(func.getResultTypes(), results)) {
+    if (type.isa<MemRefType>() && !value.memref) {
+      func.emitOpError("returns an unevaluated memref");
+      return failure();
+    }
+    result.results.push_back(getInterpretData(type, value));
+  }
+  result.profiles = interpreter.getProfiles();
+  return result;
+}
+
+static void printLane(int64_t lane, Type type, raw_ostream &os) {
+  if (type.isa<FloatType>())
+    os << llvm::format("%g", toDouble(lane));
+  else
+    os << lane;
+}
+
+/// Compare a list of data with the golden list, and return the number of
+/// mismatched lanes. The first few mismatches are printed.
+static int64_t compareDataList(ArrayRef<InterpretData> dataList,
+                               ArrayRef<InterpretData> goldenList,
+                               StringRef kind, double tolerance,
+                               raw_ostream &os) {
+  if (dataList.size() != goldenList.size()) {
+    os << "number of " << kind << "s mismatch: " << dataList.size() << " vs "
+       << goldenList.size() << "\n";
+    return 1;
+  }
+
+  int64_t mismatchNum = 0;
+  for (unsigned i = 0, e = dataList.size(); i < e; ++i) {
+    auto &data = dataList[i];
+    auto &golden = goldenList[i];
+    if (data.elementType != golden.elementType ||
+        data.lanes.size() != golden.lanes.size()) {
+      os << kind << " #" << i << ": type mismatch\n";
+      mismatchNum += std::max<int64_t>(golden.lanes.size(), 1);
+      continue;
+    }
+
+    auto isFloat = golden.elementType.isa<FloatType>();
+    for (unsigned j = 0, je = data.lanes.size(); j < je; ++j) {
+      auto lane = data.lanes[j], goldenLane = golden.lanes[j];
+      auto matched = lane == goldenLane;
+      if (isFloat && !matched) {
+        auto value = toDouble(lane), goldenValue = toDouble(goldenLane);
+        matched = std::isnan(value)
+                      ? std::isnan(goldenValue)
+                      : std::abs(value - goldenValue) <=
+                            tolerance * std::max({std::abs(value),
+                                                  std::abs(goldenValue), 1.0});
+      }
+      if (matched)
+        continue;
+
+      if (mismatchNum++ < 10) {
+        os << kind << " #" << i << " lane " << j << ": got ";
+        printLane(lane, data.elementType, os);
+        os << ", expected ";
+        printLane(goldenLane, golden.elementType, os);
+        os << "\n";
+      }
+    }
+  }
+  return mismatchNum;
+}
+
+int64_t scalehls::compareInterpretResults(const InterpretResult &result,
+                                          const InterpretResult &golden,
+                                          double tolerance, raw_ostream &os) {
+  return compareDataList(result.arguments, golden.arguments, "argument",
+                         tolerance, os) +
+         compareDataList(result.results, golden.results, "result", tolerance,
+                         os);
+}
+
+void scalehls::printMemoryProfiles(const InterpretResult &result,
+                                   raw_ostream &os) {
+  os << "Memory profiles:\n";
+  for (auto &profile : result.profiles) {
+    os << "  " << profile.name << ": " << profile.loadNum << " loads, "
+       << profile.storeNum << " stores";
+    if (profile.peakOccupancy)
+      os << ", peak occupancy " << profile.peakOccupancy;
+    os << "\n";
+  }
+}
@@ -21,6 +21,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/Transforms/Passes.h"
 #include "scalehls/Dialect/HLS/Utils.h"
+#include "scalehls/Transforms/Estimator.h"
 #include "scalehls/Transforms/Passes.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
@@ -50,12 +51,15 @@ struct LoopFusion : public AffineLoopFusionBase<LoopFusion> {
   LoopFusion() = default;
   LoopFusion(double computeToleranceThreshold, unsigned fastMemorySpace,
              uint64_t localBufSizeThresholdBytes, bool maximalFusion,
-             enum AffineFusionMode affineFusionMode) {
+             enum AffineFusionMode affineFusionMode, bool qorAware,
+             std::string fusionTargetSpec) {
     this->computeToleranceThreshold = computeToleranceThreshold;
     this->fastMemorySpace = fastMemorySpace;
     this->localBufSizeThreshold = localBufSizeThresholdBytes / 1024;
     this->maximalFusion = maximalFusion;
     this->affineFusionMode = affineFusionMode;
+    this->qorAware = qorAware;
+    this->targetSpec = fusionTargetSpec;
   }
 
   void runOnOperation() override;
@@ -66,10 +70,11 @@ struct LoopFusion : public AffineLoopFusionBase<LoopFusion> {
 std::unique_ptr<Pass> scalehls::createAffineLoopFusionPass(
     double computeToleranceThreshold, unsigned fastMemorySpace,
     uint64_t localBufSizeThreshold, bool maximalFusion,
-    enum AffineFusionMode affineFusionMode) {
-  return std::make_unique<LoopFusion>(computeToleranceThreshold,
-                                      fastMemorySpace, localBufSizeThreshold,
-                                      maximalFusion, affineFusionMode);
+    enum AffineFusionMode affineFusionMode, bool qorAware,
+    std::string fusionTargetSpec) {
+  return std::make_unique<LoopFusion>(
+      computeToleranceThreshold, fastMemorySpace, localBufSizeThreshold,
+      maximalFusion, affineFusionMode, qorAware, fusionTargetSpec);
 }
 
 namespace {
@@ -1317,6 +1322,132 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
   return true;
 }
 
+/// Return the latency of the loop nest and the maximum II of its pipelined
+/// loops estimated by the estimator.
+static std::pair<int64_t, int64_t>
+estimateLoopNestQoR(AffineForOp loop, ScaleHLSEstimator &estimator) {
+  estimator.estimateLoop(loop, loop->getParentOfType<func::FuncOp>());
+  int64_t maxII = 0;
+  loop.walk([&](AffineForOp nestedLoop) {
+    auto directive = getLoopDirective(nestedLoop);
+    auto info = getLoopInfo(nestedLoop);
+    if (directive && directive.getPipeline() && info)
+      maxII = std::max(maxII, info.getMinII());
+  });
+  auto timing = getTiming(loop);
+  return {timing ? timing.getLatency() : 0, maxII};
+}
+
+/// Return the BRAM utilization of a private buffer of 'memref' with the given
+/// type, which is estimated with a temporary buffer created before 'op'.
+static int64_t estimatePrivateBram(Value memref, MemRefType type,
+                                   Operation *op,
+                                   ScaleHLSEstimator &estimator) {
+  Attribute initValue;
+  unsigned depth = 1;
+  if (auto oldBuffer = memref.getDefiningOp<BufferOp>())
+    depth = oldBuffer.getDepth();
+  OpBuilder builder(op);
+  auto buffer =
+      builder.create<BufferOp>(op->getLoc(), type, depth, initValue);
+  auto bramNum = estimator.estimateBram(buffer);
+  buffer.erase();
+  return bramNum;
+}
+
+/// Return whether fusing 'srcLoop' into 'dstLoop' at 'dstLoopDepth' improves
+/// the QoR estimated by the estimator. The fusion is tried on clones of the two
+/// loop nests, which are erased afterwards, and all estimation attributes are
+/// removed from the IR before returning. 'srcLoop' is removed after fusion
+/// if 'removeSrcLoop' is true, and each memref in 'privateMemrefs' is replaced
+/// with a private buffer holding the region written in the fused loop nest.
+/// The fusion is profitable if none of the latency, the II of pipelined loops,
+/// and the BRAM utilization of the private buffers are degraded, and at least
+/// one of them is improved.
+static bool isFusionQoRProfitable(AffineForOp srcLoop, AffineForOp dstLoop,
+                                  unsigned dstLoopDepth,
+                                  FusionStrategy strategy, bool removeSrcLoop,
+                                  const DenseSet<Value> &privateMemrefs,
+                                  ScaleHLSEstimator &estimator) {
+  auto [srcLatency, srcII] = estimateLoopNestQoR(srcLoop, estimator);
+  auto [dstLatency, dstII] = estimateLoopNestQoR(dstLoop, estimator);
+
+  // Place the clones after both loop nests, such that no operation lies
+  // between them.
+  OpBuilder builder(srcLoop);
+  builder.setInsertionPointAfter(srcLoop->isBeforeInBlock(dstLoop) ? dstLoop
+                                                                  : srcLoop);
+  auto srcClone = cast<AffineForOp>(builder.clone(*srcLoop));
+  auto dstClone = cast<AffineForOp>(builder.clone(*dstLoop));
+
+  ComputationSliceState slice;
+  if (mlir::canFuseLoops(srcClone, dstClone, dstLoopDepth, &slice, strategy)
+          .value != FusionResult::Success) {
+    dstClone.erase();
+    srcClone.erase();
+    return false;
+  }
+  mlir::fuseLoops(srcClone, dstClone, slice);
+
+  auto [fusedLatency, fusedII] = estimateLoopNestQoR(dstClone, estimator);
+  if (!removeSrcLoop) {
+    fusedLatency += srcLatency;
+    fusedII = std::max(fusedII, srcII);
+  }
+
+  // The original buffer is eliminated after privatization if it is only
+  // accessed by the two loop nests.
+  int64_t bramNum = 0;
+  int64_t fusedBramNum = 0;
+  for (auto memref : privateMemrefs) {
+    auto oldBuffer = memref.getDefiningOp<BufferOp>();
+    auto oldBramNum = oldBuffer ? estimator.estimateBram(oldBuffer) : 0;
+    bramNum += oldBramNum;
+
+    AffineWriteOpInterface storeOp;
+    dstClone.walk([&](AffineWriteOpInterface op) {
+      if (!storeOp && op.getMemRef() == memref)
+        storeOp = op;
+    });
+    MemRefRegion region(dstClone.getLoc());
+    SmallVector<int64_t, 4> newShape;
+    auto oldType = memref.getType().cast<MemRefType>();
+    if (!storeOp || failed(region.compute(storeOp, dstLoopDepth)) ||
+        !region.getConstantBoundingSizeAndShape(&newShape) ||
+        llvm::all_of(newShape, [](int64_t size) { return size == 1; })) {
+      fusedBramNum += oldBramNum;
+      continue;
+    }
+
+    auto isOldBufferDead =
+        removeSrcLoop && llvm::all_of(memref.getUsers(), [&](Operation *user) {
+          return srcLoop->isAncestor(user) || dstLoop->isAncestor(user) ||
+                 srcClone->isAncestor(user) || dstClone->isAncestor(user);
+        });
+    if (!isOldBufferDead)
+      fusedBramNum += oldBramNum;
+    auto newType = MemRefType::get(newShape, oldType.getElementType(),
+                                   AffineMap(), oldType.getMemorySpace());
+    fusedBramNum += estimatePrivateBram(memref, newType, srcLoop, estimator);
+  }
+  dstClone.erase();
+  srcClone.erase();
+
+  // The estimator annotates the original loop nests and the memory accesses of
+  // the whole function, which would otherwise be carried into fused loops.
+  removeEstimation(srcLoop->getParentOfType<func::FuncOp>());
+
+  auto latency = srcLatency + dstLatency;
+  auto ii = std::max(srcII, dstII);
+  LLVM_DEBUG(llvm::dbgs() << "QoR of fusion: latency " << latency << " -> "
+                          << fusedLatency << ", II " << ii << " -> " << fusedII
+                          << ", BRAM " << bramNum << " -> " << fusedBramNum
+                          << "\n");
+  if (fusedLatency > latency || fusedII > ii || fusedBramNum > bramNum)
+    return false;
+  return fusedLatency < latency || fusedII < ii || fusedBramNum < bramNum;
+}
+
 namespace {
 
 // GreedyFusion greedily fuses loop nests which have a producer/consumer or
@@ -1381,6 +1512,9 @@ public:
   // The amount of additional computation that is tolerated while fusing
   // pair-wise as a fraction of the total computation.
   double computeToleranceThreshold;
+  // If not null, loop nests are only fused when the QoR estimated by the
+  // estimator is improved.
+  ScaleHLSEstimator *estimator = nullptr;
 
   using Node = MemRefDependenceGraph::Node;
 
@@ -1639,6 +1773,13 @@ public:
             privateMemrefs.insert(memref);
           }
 
+          // Skip if the fusion doesn't improve the estimated QoR.
+          if (estimator &&
+              !isFusionQoRProfitable(srcAffineForOp, dstAffineForOp,
+                                     bestDstLoopDepth, strategy, removeSrcNode,
+                                     privateMemrefs, *estimator))
+            continue;
+
           // Fuse computation slice of 'srcLoopNest' into 'dstLoopNest'.
           fuseLoops(srcAffineForOp, dstAffineForOp, bestSlice);
           dstNodeChanged = true;
@@ -1819,6 +1960,16 @@ public:
       assert(bestDstLoopDepth > 0 && "Unexpected loop fusion depth");
       assert(!depthSliceUnions[bestDstLoopDepth - 1].isEmpty() &&
              "Fusion depth has no computed slice union");
+
+      // Skip if the fusion doesn't improve the estimated QoR. The sibling loop
+      // nest is always removed after fusion, see
+      // updateStateAfterSiblingFusion.
+      if (estimator &&
+          !isFusionQoRProfitable(sibAffineForOp, dstAffineForOp,
+                                 bestDstLoopDepth, strategy,
+                                 /*removeSrcLoop=*/true, DenseSet<Value>(),
+                                 *estimator))
+        continue;
       // Check if source loop is being inserted in the innermost
       // destination loop. Based on this, the fused loop may be optimized
       // further inside `fuseLoops`.
@@ -1976,14 +2127,14 @@ public:
     mdg->clearNodeLoadAndStores(dstNode->id);
     mdg->addToNode(dstNode->id, dstLoopCollector.loadOpInsts,
                    dstLoopCollector.storeOpInsts);
-    // Remove old sibling loop nest if it no longer has outgoing dependence
-    // edges, and it does not write to a memref which escapes the
-    // function.
-    if (mdg->getOutEdgeCount(sibNode->id) == 0) {
-      Operation *op = sibNode->op;
-      mdg->removeNode(sibNode->id);
-      op->erase();
-    }
+    // Remove old sibling loop nest. All its outgoing dependence edges have
+    // been remapped to 'dstNode', as its computation is entirely fused into
+    // 'dstNode'. The QoR-aware fusion relies on this removal.
+    assert(mdg->getOutEdgeCount(sibNode->id) == 0 &&
+           "sibling node still has outgoing edges after fusion");
+    Operation *op = sibNode->op;
+    mdg->removeNode(sibNode->id);
+    op->erase();
   }
 
   // Clean up any allocs with no users.
@@ -2006,6 +2157,16 @@ public:
 } // namespace
 
 void LoopFusion::runOnOperation() {
+  // In the QoR-aware mode, fusion candidates are estimated with the target
+  // spec. The estimation results are removed after fusion.
+  TargetSpec spec;
+  std::unique_ptr<ScaleHLSEstimator> estimator;
+  if (qorAware) {
+    if (!spec.load(targetSpec))
+      return signalPassFailure();
+    estimator = spec.createEstimator();
+  }
+
   getOperation().walk([&](hls::StageLikeInterface stage) {
     if (stage.hasHierarchy())
       return WalkResult::advance();
@@ -2022,6 +2183,7 @@ void LoopFusion::runOnOperation() {
     unsigned localBufSizeThresholdBytes = localBufSizeThreshold * 1024;
     GreedyFusion fusion(&g, localBufSizeThresholdBytes, fastMemorySpaceOpt,
                         maximalFusion, computeToleranceThreshold);
+    fusion.estimator = estimator.get();
 
     if (affineFusionMode == AffineFusionMode::ProducerConsumer)
       fusion.runProducerConsumerFusionOnly();
@@ -2031,4 +2193,7 @@ void LoopFusion::runOnOperation() {
       fusion.runGreedyFusion();
     return WalkResult::advance();
   });
+
+  if (qorAware)
+    removeEstimation(getOperation());
 }
@@ -344,72 +344,142 @@ struct VectorizeTransferWrite
 };
 } // namespace
 
+/// Return whether the value is an induction variable that is always a multiple
+/// of the given vector size.
+static bool isAlignedInductionVar(Value value, int64_t vectorSize) {
+  auto loop = getForInductionVarOwner(value);
+  return loop && loop.hasConstantLowerBound() &&
+         loop.getConstantLowerBound() % vectorSize == 0 &&
+         loop.getStep() % vectorSize == 0;
+}
+
+/// Calculate the map for loading the vector that contains the element accessed
+/// by the given load, and the map for calculating the offset of the element in
+/// the vector. Both maps share the returned operands. Given a vector size v,
+/// each index is split into an aligned part, which only contributes to the
+/// vector index, and the remaining part r, which contributes r floordiv v to
+/// the vector index and r mod v to the offset. Terms with coefficients that are
+/// multiples of v and induction variables aligned to v are aligned, such that
+/// the loads of adjacent elements in an unrolled loop share the same vector.
+static LogicalResult getVectorLoadMaps(AffineLoadOp load,
+                                       ArrayRef<int64_t> vectorShape,
+                                       AffineMap &vectorMap,
+                                       AffineMap &offsetMap,
+                                       SmallVectorImpl<Value> &operands) {
+  auto map = load.getAffineMap();
+  operands.assign(load.getMapOperands().begin(), load.getMapOperands().end());
+  fullyComposeAffineMapAndOperands(&map, &operands);
+  map = simplifyAffineMap(map);
+  canonicalizeMapAndOperands(&map, &operands);
+
+  auto context = load.getContext();
+  auto numDims = map.getNumDims();
+  auto numSyms = map.getNumSymbols();
+
+  SmallVector<AffineExpr, 4> vectorExprs;
+  SmallVector<AffineExpr, 4> offsetExprs;
+  for (auto [expr, vectorSize] : llvm::zip(map.getResults(), vectorShape)) {
+    SmallVector<int64_t> flatExpr;
+    if (failed(getFlattenedAffineExpr(expr, numDims, numSyms, &flatExpr)))
+      return failure();
+
+    auto vectorExpr = getAffineConstantExpr(0, context);
+    auto remainExpr = getAffineConstantExpr(flatExpr.back(), context);
+    for (unsigned i = 0, e = numDims + numSyms; i < e; ++i) {
+      auto coeff = flatExpr[i];
+      auto termExpr = i < numDims ? getAffineDimExpr(i, context)
+                                  : getAffineSymbolExpr(i - numDims, context);
+      if (coeff % vectorSize == 0)
+        vectorExpr = vectorExpr + termExpr * (coeff / vectorSize);
+      else if (isAlignedInductionVar(operands[i], vectorSize))
+        vectorExpr = vectorExpr + termExpr.floorDiv(vectorSize) * coeff;
+      else
+        remainExpr = remainExpr + termExpr * coeff;
+    }
+    vectorExprs.push_back(vectorExpr + remainExpr.floorDiv(vectorSize));
+    offsetExprs.push_back(remainExpr % vectorSize);
+  }
+
+  // Linearize the offsets following the row-major order of the vector shape.
+  auto offsetExpr = getAffineConstantExpr(0, context);
+  int64_t accumSize = 1;
+  for (auto [expr, vectorSize] :
+       llvm::reverse(llvm::zip(offsetExprs, vectorShape))) {
+    offsetExpr = offsetExpr + expr * accumSize;
+    accumSize *= vectorSize;
+  }
+
+  vectorMap = simplifyAffineMap(
+      AffineMap::get(numDims, numSyms, vectorExprs, context));
+  offsetMap =
+      simplifyAffineMap(AffineMap::get(numDims, numSyms, offsetExpr, context));
+  return success();
+}
+
 namespace {
+/// Convert affine loads of a vectorized buffer into vector loads and element
+/// extractions. Loads in the same block that access the same vector without
+/// any write in between share one vector load, such that each packed word is
+/// only loaded once.
 struct VectorizeLoad : public OpRewritePattern<AffineLoadOp> {
   using OpRewritePattern<AffineLoadOp>::OpRewritePattern;
 
   LogicalResult matchAndRewrite(AffineLoadOp load,
                                 PatternRewriter &rewriter) const override {
     auto type = load.getMemRefType();
-    if (auto vectorizedType = getVectorizedType(type)) {
-      auto layout = type.getLayout().cast<TileLayoutAttr>();
-      auto numDims = load.getAffineMap().getNumDims();
-      auto numSyms = load.getAffineMap().getNumSymbols();
-
-      // Get the expressions for calculating the indices of vector load.
-      SmallVector<AffineExpr, 4> vectorExprs;
-      for (auto [expr, vectorSize] :
-           llvm::zip(load.getAffineMap().getResults(), layout.getVectorShape()))
-        vectorExprs.push_back(expr.floorDiv(vectorSize));
-
-      // Get the expressions for calculating the offsets of the vector extract.
-      AffineExpr offsetExpr = rewriter.getAffineConstantExpr(0);
-      unsigned accumSize = 1;
-      for (auto [expr, vectorSize] : llvm::reverse(llvm::zip(
-               load.getAffineMap().getResults(), layout.getVectorShape()))) {
-        SmallVector<int64_t> flatExpr;
-        if (failed(getFlattenedAffineExpr(expr, numDims, numSyms, &flatExpr)))
-          return failure();
-        auto offset = rewriter.getAffineConstantExpr(0);
-
-        for (auto coeff : llvm::enumerate(llvm::make_range(
-                 flatExpr.begin(), flatExpr.begin() + numDims)))
-          if (coeff.value() % vectorSize != 0)
-            offset = offset + rewriter.getAffineDimExpr(coeff.index()) *
-                                  coeff.value() % vectorSize;
-
-        for (auto coeff : llvm::enumerate(
-                 llvm::make_range(flatExpr.begin() + numDims,
-                                  flatExpr.begin() + numDims + numSyms)))
-          if (coeff.value() % vectorSize != 0)
-            offset = offset + rewriter.getAffineSymbolExpr(coeff.index()) *
-                                  coeff.value() % vectorSize;
-
-        offsetExpr = offsetExpr + offset * accumSize;
-        accumSize *= vectorSize;
-      }
+    auto vectorizedType = getVectorizedType(type);
+    if (!vectorizedType)
+      return failure();
+    auto vectorShape = type.getLayout().cast<TileLayoutAttr>().getVectorShape();
+
+    AffineMap vectorMap, offsetMap;
+    SmallVector<Value, 4> operands;
+    if (failed(getVectorLoadMaps(load, vectorShape, vectorMap, offsetMap,
+                                 operands)))
+      return failure();
 
-      // Generate a vectorized buffer and a vector load.
-      rewriter.setInsertionPoint(load);
-      auto vectorMap =
-          AffineMap::get(numDims, numSyms, vectorExprs, rewriter.getContext());
-      auto vectorBuffer = rewriter.create<BufferVectorizeOp>(
-          load.getLoc(), vectorizedType, load.getMemRef());
-      auto vectorLoad = rewriter.create<AffineLoadOp>(
-          load.getLoc(), vectorBuffer, vectorMap, load.getMapOperands());
+    // Collect the loads sharing the same vector with the current load. Any op
+    // that may write memory separates the block into independent segments.
+    SmallVector<std::pair<AffineLoadOp, AffineMap>, 16> loads;
+    bool hasCurrentLoad = false;
+    for (auto &op : *load->getBlock()) {
+      if (op.getNumRegions() != 0 || hasEffect<MemoryEffects::Write>(&op)) {
+        if (hasCurrentLoad)
+          break;
+        loads.clear();
+        continue;
+      }
 
-      // Extract the original output from the loaded vector.
-      auto offsetMap =
-          AffineMap::get(numDims, numSyms, offsetExpr, rewriter.getContext());
+      auto otherLoad = dyn_cast<AffineLoadOp>(op);
+      if (!otherLoad || otherLoad.getMemRef() != load.getMemRef())
+        continue;
+      AffineMap otherVectorMap, otherOffsetMap;
+      SmallVector<Value, 4> otherOperands;
+      if (succeeded(getVectorLoadMaps(otherLoad, vectorShape, otherVectorMap,
+                                      otherOffsetMap, otherOperands)) &&
+          otherVectorMap == vectorMap && otherOperands == operands) {
+        loads.push_back({otherLoad, otherOffsetMap});
+        hasCurrentLoad |= otherLoad == load;
+      }
+    }
 
+    // Generate a vectorized buffer and a vector load before the first load.
+    auto loc = load.getLoc();
+    rewriter.setInsertionPoint(loads.front().first);
+    auto vectorBuffer = rewriter.create<BufferVectorizeOp>(
+        loc, vectorizedType, load.getMemRef());
+    auto vectorLoad =
+        rewriter.create<AffineLoadOp>(loc, vectorBuffer, vectorMap, operands);
+
+    // Extract the original output of each load from the loaded vector.
+    for (auto [scalarLoad, scalarOffsetMap] : loads) {
+      rewriter.setInsertionPoint(scalarLoad);
       auto offsetApply = rewriter.create<AffineApplyOp>(
-          load.getLoc(), offsetMap, load.getMapOperands());
-
-      rewriter.replaceOpWithNewOp<vector::ExtractElementOp>(load, vectorLoad,
-                                                            offsetApply);
-      return success();
+          scalarLoad.getLoc(), scalarOffsetMap, operands);
+      rewriter.replaceOpWithNewOp<vector::ExtractElementOp>(
+          scalarLoad, vectorLoad, offsetApply);
     }
-    return failure();
+    return success();
   }
 };
 } // namespace
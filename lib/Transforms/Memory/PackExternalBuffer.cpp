@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Affine/Analysis/AffineStructures.h"
+#include "mlir/Dialect/Affine/LoopUtils.h"
+#include "scalehls/Transforms/Passes.h"
+#include "scalehls/Transforms/Utils.h"
+
+using namespace mlir;
+using namespace scalehls;
+using namespace hls;
+
+/// Collect all affine loads and stores of the memref, which are traced through
+/// the block arguments of schedules and nodes. Return failure if the memref has
+/// any other user.
+static LogicalResult getAccesses(Value memref,
+                                 SmallVectorImpl<Operation *> &accesses) {
+  for (auto &use : memref.getUses()) {
+    auto user = use.getOwner();
+    if (isa<AffineLoadOp, AffineStoreOp>(user))
+      accesses.push_back(user);
+    else if (isa<NodeOp, ScheduleOp>(user)) {
+      auto arg = user->getRegion(0).getArgument(use.getOperandNumber());
+      if (failed(getAccesses(arg, accesses)))
+        return failure();
+    } else
+      return failure();
+  }
+  return success();
+}
+
+/// Return the innermost loop surrounding the access if the access can be packed
+/// with the given factor, otherwise return a null loop. The loop must walk
+/// through the innermost dimension of the memref element by element, and each
+/// group of `factor` elements accessed by consecutive iterations must be
+/// aligned to a packed word.
+static AffineForOp getPackableLoop(Operation *access, int64_t factor) {
+  AffineMap map;
+  SmallVector<Value, 4> operands;
+  if (auto load = dyn_cast<AffineLoadOp>(access)) {
+    map = load.getAffineMap();
+    operands = load.getMapOperands();
+  } else {
+    auto store = cast<AffineStoreOp>(access);
+    map = store.getAffineMap();
+    operands = store.getMapOperands();
+  }
+  fullyComposeAffineMapAndOperands(&map, &operands);
+  map = simplifyAffineMap(map);
+  canonicalizeMapAndOperands(&map, &operands);
+
+  auto numDims = map.getNumDims();
+  auto numSyms = map.getNumSymbols();
+  SmallVector<int64_t> flatExpr;
+  if (failed(getFlattenedAffineExpr(map.getResults().back(), numDims, numSyms,
+                                    &flatExpr)) ||
+      flatExpr.size() != numDims + numSyms + 1)
+    return AffineForOp();
+
+  // Symbols and the constant term only shift the packed word.
+  for (unsigned i = numDims, e = flatExpr.size(); i < e; ++i)
+    if (flatExpr[i] % factor != 0)
+      return AffineForOp();
+
+  auto innermostLoop = access->getParentOfType<AffineForOp>();
+  bool hasContiguousDim = false;
+  for (unsigned i = 0; i < numDims; ++i) {
+    if (flatExpr[i] % factor == 0)
+      continue;
+    auto loop = getForInductionVarOwner(operands[i]);
+    if (flatExpr[i] != 1 || !loop || loop != innermostLoop ||
+        loop.getStep() != 1 || !loop.hasConstantBounds() ||
+        loop.getConstantLowerBound() % factor != 0 ||
+        loop.getConstantUpperBound() % factor != 0)
+      return AffineForOp();
+    hasContiguousDim = true;
+  }
+  return hasContiguousDim ? innermostLoop : AffineForOp();
+}
+
+/// Pack the given external buffer to the bus width, and return whether the
+/// buffer is packed. A read-only buffer is packed through a vectorized tile
+/// layout, which is materialized by the buffer vectorization later. To load
+/// each packed word only once, the loops walking through the buffer are
+/// recorded in "unrollFactors" with the packing factor, such that `factor`
+/// adjacent elements are accessed in each iteration after unrolling. Because
+/// masked vector stores are not supported, a written buffer is only annotated
+/// with the widened bitwidth, such that the HLS tool can widen the port.
+static bool packExternalBuffer(Value memref, unsigned busWidth,
+                               DenseMap<Operation *, int64_t> &unrollFactors) {
+  auto type = memref.getType().dyn_cast<MemRefType>();
+  if (!type || !type.hasStaticShape() || type.getRank() == 0 ||
+      !type.getLayout().isIdentity() || !type.getElementType().isIntOrFloat())
+    return false;
+  auto bitwidth = type.getElementTypeBitWidth();
+
+  // If the buffer has already been vectorized, only annotate the bitwidth.
+  auto layout = getTileLayout(memref);
+  if (layout && layout.isVectorized()) {
+    int64_t vectorWidth = bitwidth;
+    for (auto vectorSize : layout.getVectorShape())
+      vectorWidth *= vectorSize;
+    if (vectorWidth > busWidth)
+      return false;
+    setMaxWidenBitwidth(memref, vectorWidth);
+    return true;
+  }
+
+  SmallVector<Operation *, 16> accesses;
+  if (failed(getAccesses(memref, accesses)) || accesses.empty())
+    return false;
+
+  // Find the largest packing factor that is a power of two and divides the
+  // innermost tile size.
+  auto tileShape = layout ? SmallVector<int64_t>(layout.getTileShape())
+                          : SmallVector<int64_t>(type.getShape());
+  int64_t factor = llvm::PowerOf2Floor(busWidth / bitwidth);
+  SmallVector<AffineForOp, 16> loops;
+  for (; factor > 1; factor /= 2) {
+    loops.clear();
+    if (tileShape.back() % factor == 0 &&
+        llvm::all_of(accesses, [&](Operation *access) {
+          loops.push_back(getPackableLoop(access, factor));
+          return bool(loops.back());
+        }))
+      break;
+  }
+  if (factor <= 1)
+    return false;
+
+  setMaxWidenBitwidth(memref, bitwidth * factor);
+  if (llvm::none_of(accesses, [](Operation *access) {
+        return isa<AffineStoreOp>(access);
+      })) {
+    auto vectorShape = SmallVector<int64_t>(type.getRank(), 1);
+    vectorShape.back() = factor;
+    setTileLayout(memref, tileShape, vectorShape);
+
+    // Because all factors are powers of two, unrolling a loop with the largest
+    // factor also aligns the accesses of other buffers with smaller factors.
+    for (auto loop : loops) {
+      auto &unrollFactor = unrollFactors[loop];
+      unrollFactor = std::max(unrollFactor, factor);
+    }
+  }
+  return true;
+}
+
+namespace {
+struct PackExternalBuffer : public PackExternalBufferBase<PackExternalBuffer> {
+  PackExternalBuffer() = default;
+  explicit PackExternalBuffer(unsigned argBusWidth) { busWidth = argBusWidth; }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+
+    SmallVector<Value, 16> buffers;
+    for (auto arg : func.getArguments())
+      if (isExtBuffer(arg))
+        buffers.push_back(arg);
+    func.walk([&](hls::BufferLikeInterface buffer) {
+      if (isExtBuffer(buffer.getMemref()))
+        buffers.push_back(buffer.getMemref());
+    });
+
+    unsigned packedNum = 0;
+    DenseMap<Operation *, int64_t> unrollFactors;
+    for (auto buffer : buffers)
+      if (packExternalBuffer(buffer, busWidth, unrollFactors))
+        ++packedNum;
+
+    // Unroll the loops walking through the packed buffers, such that each
+    // iteration consumes whole packed words. Inner loops are unrolled first,
+    // such that their copies created by unrolling outer loops are unrolled.
+    SmallVector<AffineForOp, 16> loops;
+    func.walk([&](AffineForOp loop) {
+      if (unrollFactors.count(loop))
+        loops.push_back(loop);
+    });
+    for (auto loop : loops)
+      if (failed(loopUnrollByFactor(loop, unrollFactors.lookup(loop)))) {
+        loop.emitOpError("failed to unroll for external buffer packing");
+        return signalPassFailure();
+      }
+
+    if (!buffers.empty())
+      func.emitRemark() << "external buffer packing: " << packedNum << "/"
+                        << buffers.size() << " buffers packed to "
+                        << busWidth << " bits";
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass>
+scalehls::createPackExternalBufferPass(unsigned busWidth) {
+  return std::make_unique<PackExternalBuffer>(busWidth);
+}
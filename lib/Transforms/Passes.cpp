@@ -121,6 +121,11 @@ struct HIDAPyTorchPipelineOptions
   Option<bool> axiInterface{*this, "axi-interface", llvm::cl::init(true),
                             llvm::cl::desc("Create AXI interface")};
 
+  Option<unsigned> axiBusWidth{
+      *this, "axi-bus-width", llvm::cl::init(0),
+      llvm::cl::desc("Pack external buffers to the AXI bus width (set 0 to "
+                     "disable)")};
+
   Option<bool> vectorize{*this, "vectorize", llvm::cl::init(false),
                          llvm::cl::desc("Vectorize with factor of 2")};
 
@@ -283,6 +288,8 @@ void scalehls::registerHIDAPyTorchPipeline() {
         pm.addPass(scalehls::createSimplifyAffineIfPass());
         pm.addPass(scalehls::createAffineStoreForwardPass());
         pm.addPass(scalehls::createReduceInitialIntervalPass());
+        if (opts.axiBusWidth)
+          pm.addPass(scalehls::createPackExternalBufferPass(opts.axiBusWidth));
         pm.addPass(scalehls::createBufferVectorizePass());
         pm.addPass(mlir::createCanonicalizerPass());
 
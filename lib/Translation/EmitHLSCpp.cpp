@@ -738,9 +738,12 @@ void ModuleEmitter::emitAxiPort(AxiPortOp op) {
   indent() << "#pragma HLS interface";
 
   if (op.getBundleType().getKind() == AxiKind::MM) {
-    if (isExtBuffer(op.getElement()))
+    if (isExtBuffer(op.getElement())) {
       os << " m_axi offset=slave";
-    else {
+      if (auto bitwidth =
+              op->getAttrOfType<IntegerAttr>("max_widen_bitwidth"))
+        os << " max_widen_bitwidth=" << bitwidth.getInt();
+    } else {
       os << " bram ";
       auto kind = getMemoryKind(op.getElement().getType().cast<MemRefType>());
       os << getStorageTypeAndImpl(kind, "storage_type", "storage_impl");
@@ -1872,9 +1875,11 @@ void ModuleEmitter::emitFunctionDirectives(func::FuncOp func,
         indent() << "#pragma HLS interface";
 
         if (auto memrefPortType = port.getType().dyn_cast<MemRefType>()) {
-          if (getMemoryKind(memrefPortType) == MemoryKind::DRAM)
+          if (getMemoryKind(memrefPortType) == MemoryKind::DRAM) {
             os << " m_axi offset=slave";
-          else
+            if (auto bitwidth = getMaxWidenBitwidth(port))
+              os << " max_widen_bitwidth=" << bitwidth.getInt();
+          } else
             os << " bram";
         } else
           os << " axis";
@@ -1930,6 +1935,8 @@ void ModuleEmitter::emitFunction(func::FuncOp func) {
   if (auto resource = getResource(func)) {
     os << "/// DSP=" << resource.getDsp();
     os << ", BRAM=" << resource.getBram();
+    if (resource.getUram())
+      os << ", URAM=" << resource.getUram();
     // os << ", LUT=" << resource.getLut();
     os << "\n";
   }
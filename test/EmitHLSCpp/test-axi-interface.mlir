@@ -0,0 +1,23 @@
+// RUN: scalehls-translate -scalehls-emit-hlscpp %s | FileCheck %s
+
+// CHECK-LABEL: void test_memref_port(
+func.func @test_memref_port(%arg0: memref<64xi32, #hls.mem<dram>> {hls.max_widen_bitwidth = 512 : i64}, %arg1: memref<64xi32, #hls.mem<dram>>) attributes {top_func} {
+  // CHECK: #pragma HLS interface m_axi offset=slave max_widen_bitwidth=512 port=[[VAL_0:.*]]
+  // CHECK: #pragma HLS interface m_axi offset=slave port=[[VAL_1:.*]]
+  %0 = affine.load %arg0[0] : memref<64xi32, #hls.mem<dram>>
+  affine.store %0, %arg1[0] : memref<64xi32, #hls.mem<dram>>
+  return
+}
+
+// CHECK-LABEL: void test_axi_port(
+func.func @test_axi_port(%arg0: !hls.axi<memref<64xi32, #hls.mem<dram>>>, %arg1: !hls.axi<memref<64xi32, #hls.mem<dram>>>) attributes {top_func} {
+  // CHECK: #pragma HLS interface m_axi offset=slave max_widen_bitwidth=256 port=[[VAL_2:.*]] bundle=axi_0
+  // CHECK: #pragma HLS interface m_axi offset=slave port=[[VAL_3:.*]] bundle=axi_1
+  %0 = hls.axi.bundle "axi_0" : <i32, mm>
+  %1 = hls.axi.port %0, %arg0 {max_widen_bitwidth = 256 : i64} : <i32, mm>, (!hls.axi<memref<64xi32, #hls.mem<dram>>>) -> memref<64xi32, #hls.mem<dram>>
+  %2 = hls.axi.bundle "axi_1" : <i32, mm>
+  %3 = hls.axi.port %2, %arg1 : <i32, mm>, (!hls.axi<memref<64xi32, #hls.mem<dram>>>) -> memref<64xi32, #hls.mem<dram>>
+  %4 = affine.load %1[0] : memref<64xi32, #hls.mem<dram>>
+  affine.store %4, %3[0] : memref<64xi32, #hls.mem<dram>>
+  return
+}
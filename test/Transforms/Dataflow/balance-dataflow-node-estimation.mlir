@@ -0,0 +1,53 @@
+// RUN: scalehls-opt -scalehls-balance-dataflow-node %s | FileCheck %s --check-prefix=LEVEL
+// RUN: scalehls-opt -scalehls-balance-dataflow-node="target-spec=%S/../Directive/config.json" %s | FileCheck %s --check-prefix=ESTIMATE
+
+// The buffer produced by the first node is consumed two levels later by the
+// last node. The level differences require a copy node to hold the buffer for
+// one more level, while the estimated timing shows that the two short leading
+// nodes finish before the next execution of the long last node, thus the
+// ping-pong buffer is enough. The estimation attributes are removed afterwards.
+
+// LEVEL: hls.dataflow.node
+// LEVEL: hls.dataflow.node
+// LEVEL-SAME: level = 1 : i32
+// LEVEL: memref.copy
+// LEVEL: hls.dataflow.node
+// LEVEL: hls.dataflow.node
+// LEVEL-NOT: memref.copy
+
+// ESTIMATE-NOT: memref.copy
+// ESTIMATE-NOT: timing
+func.func @test_estimation(%arg0: memref<16xi32>, %arg1: memref<1024xi32>) {
+  hls.dataflow.schedule(%arg0, %arg1) : memref<16xi32>, memref<1024xi32> {
+  ^bb0(%arg2: memref<16xi32>, %arg3: memref<1024xi32>):
+    %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<16xi32>
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32], level = 2 : i32} : (memref<16xi32>) -> memref<16xi32> {
+    ^bb0(%arg4: memref<16xi32>, %arg5: memref<16xi32>):
+      affine.for %arg6 = 0 to 16 {
+        %2 = affine.load %arg4[%arg6] : memref<16xi32>
+        affine.store %2, %arg5[%arg6] : memref<16xi32>
+      }
+    }
+    %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<16xi32>
+    hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32], level = 1 : i32} : (memref<16xi32>) -> memref<16xi32> {
+    ^bb0(%arg4: memref<16xi32>, %arg5: memref<16xi32>):
+      affine.for %arg6 = 0 to 16 {
+        %2 = affine.load %arg4[%arg6] : memref<16xi32>
+        %3 = arith.addi %2, %2 : i32
+        affine.store %3, %arg5[%arg6] : memref<16xi32>
+      }
+    }
+    hls.dataflow.node(%0, %1) -> (%arg3) {inputTaps = [0 : i32, 0 : i32], level = 0 : i32} : (memref<16xi32>, memref<16xi32>) -> memref<1024xi32> {
+    ^bb0(%arg4: memref<16xi32>, %arg5: memref<16xi32>, %arg6: memref<1024xi32>):
+      affine.for %arg7 = 0 to 64 {
+        affine.for %arg8 = 0 to 16 {
+          %2 = affine.load %arg4[%arg8] : memref<16xi32>
+          %3 = affine.load %arg5[%arg8] : memref<16xi32>
+          %4 = arith.muli %2, %3 : i32
+          affine.store %4, %arg6[%arg7 * 16 + %arg8] : memref<1024xi32>
+        }
+      }
+    }
+  }
+  return
+}
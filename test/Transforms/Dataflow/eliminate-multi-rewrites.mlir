@@ -0,0 +1,103 @@
+// RUN: scalehls-opt -scalehls-eliminate-multi-producer %s | FileCheck %s --check-prefix=PRODUCER
+// RUN: scalehls-opt -scalehls-eliminate-multi-consumer %s | FileCheck %s --check-prefix=CONSUMER
+
+// Each buffer rewrite of a schedule must see the nodes and buffers updated by
+// the previous rewrites of the same schedule.
+
+// PRODUCER-LABEL: func.func @test_multi_producer
+// PRODUCER: %0 = hls.dataflow.buffer
+// PRODUCER: hls.dataflow.node(%arg2) -> (%0)
+// PRODUCER: %1 = hls.dataflow.buffer
+// PRODUCER: hls.dataflow.node(%arg2, %0) -> (%1)
+// PRODUCER: %2 = hls.dataflow.buffer
+// PRODUCER: hls.dataflow.node(%arg2, %1) -> (%2)
+// PRODUCER: hls.dataflow.node(%2) -> (%arg3)
+func.func @test_multi_producer(%arg0: memref<16xf32>, %arg1: memref<16xf32>) {
+  hls.dataflow.schedule(%arg0, %arg1) : memref<16xf32>, memref<16xf32> {
+  ^bb0(%arg2: memref<16xf32>, %arg3: memref<16xf32>):
+    %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<16xf32>
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = affine.load %arg4[%arg6] : memref<16xf32>
+        affine.store %1, %arg5[%arg6] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = affine.load %arg4[%arg6] : memref<16xf32>
+        %2 = arith.addf %1, %1 : f32
+        affine.store %2, %arg5[%arg6] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = affine.load %arg4[%arg6] : memref<16xf32>
+        %2 = arith.mulf %1, %1 : f32
+        affine.store %2, %arg5[%arg6] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg3) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = affine.load %arg4[%arg6] : memref<16xf32>
+        affine.store %1, %arg5[%arg6] : memref<16xf32>
+      }
+    }
+  }
+  return
+}
+
+// CONSUMER-LABEL: func.func @test_multi_consumer
+// CONSUMER: hls.dataflow.node(%arg4) -> (%0, %1)
+// CONSUMER: %2 = hls.dataflow.buffer
+// CONSUMER: %3 = hls.dataflow.buffer
+// CONSUMER: hls.dataflow.node(%1) -> (%2, %3)
+// CONSUMER: %4 = hls.dataflow.buffer
+// CONSUMER: %5 = hls.dataflow.buffer
+// CONSUMER: hls.dataflow.node(%0) -> (%4, %5)
+// CONSUMER: hls.dataflow.node(%4) -> (%arg5)
+// CONSUMER: hls.dataflow.node(%5, %2) -> (%arg6)
+// CONSUMER: hls.dataflow.node(%3) -> (%arg7)
+// CONSUMER-NOT: hls.dataflow.node
+func.func @test_multi_consumer(%arg0: memref<16xf32>, %arg1: memref<16xf32>, %arg2: memref<16xf32>, %arg3: memref<16xf32>) {
+  hls.dataflow.schedule(%arg0, %arg1, %arg2, %arg3) : memref<16xf32>, memref<16xf32>, memref<16xf32>, memref<16xf32> {
+  ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>, %arg6: memref<16xf32>, %arg7: memref<16xf32>):
+    %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<16xf32>
+    %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<16xf32>
+    hls.dataflow.node(%arg4) -> (%0, %1) {inputTaps = [0 : i32]} : (memref<16xf32>) -> (memref<16xf32>, memref<16xf32>) {
+    ^bb0(%arg8: memref<16xf32>, %arg9: memref<16xf32>, %arg10: memref<16xf32>):
+      affine.for %arg11 = 0 to 16 {
+        %2 = affine.load %arg8[%arg11] : memref<16xf32>
+        affine.store %2, %arg9[%arg11] : memref<16xf32>
+        affine.store %2, %arg10[%arg11] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg5) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg8: memref<16xf32>, %arg9: memref<16xf32>):
+      affine.for %arg10 = 0 to 16 {
+        %2 = affine.load %arg8[%arg10] : memref<16xf32>
+        affine.store %2, %arg9[%arg10] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%0, %1) -> (%arg6) {inputTaps = [0 : i32, 0 : i32]} : (memref<16xf32>, memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg8: memref<16xf32>, %arg9: memref<16xf32>, %arg10: memref<16xf32>):
+      affine.for %arg11 = 0 to 16 {
+        %2 = affine.load %arg8[%arg11] : memref<16xf32>
+        %3 = affine.load %arg9[%arg11] : memref<16xf32>
+        %4 = arith.addf %2, %3 : f32
+        affine.store %4, %arg10[%arg11] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%1) -> (%arg7) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg8: memref<16xf32>, %arg9: memref<16xf32>):
+      affine.for %arg10 = 0 to 16 {
+        %2 = affine.load %arg8[%arg10] : memref<16xf32>
+        affine.store %2, %arg9[%arg10] : memref<16xf32>
+      }
+    }
+  }
+  return
+}
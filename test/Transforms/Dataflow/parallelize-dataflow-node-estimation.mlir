@@ -0,0 +1,44 @@
+// RUN: scalehls-opt -scalehls-parallelize-dataflow-node="max-unroll-factor=3 correlation-aware=false" %s | FileCheck %s --check-prefix=COUNT
+// RUN: scalehls-opt -scalehls-parallelize-dataflow-node="max-unroll-factor=3 correlation-aware=false target-spec=%S/../Directive/config.json" %s | FileCheck %s --check-prefix=ESTIMATE
+
+// The first node has a smaller trip count but a much longer latency due to the
+// chained divisions. The complexity analysis favors unrolling the second node,
+// while the estimated latencies favor unrolling the first node. The estimation
+// attributes are removed afterwards.
+
+// COUNT: hls.dataflow.node
+// COUNT: affine.for %{{.*}} = 0 to 16 step 2 {
+// COUNT: hls.dataflow.node
+// COUNT: affine.for %{{.*}} = 0 to 32 step 4 {
+
+// ESTIMATE-NOT: timing
+// ESTIMATE: hls.dataflow.node
+// ESTIMATE: affine.for %{{.*}} = 0 to 16 step 4 {
+// ESTIMATE: hls.dataflow.node
+// ESTIMATE: affine.for %{{.*}} = 0 to 32 {
+// ESTIMATE-NOT: timing
+func.func @test_estimation(%arg0: memref<16xf32>, %arg1: memref<16xf32>, %arg2: memref<32xi32>, %arg3: memref<32xi32>) {
+  hls.dataflow.schedule(%arg0, %arg1, %arg2, %arg3) : memref<16xf32>, memref<16xf32>, memref<32xi32>, memref<32xi32> {
+  ^bb0(%arg4: memref<16xf32>, %arg5: memref<16xf32>, %arg6: memref<32xi32>, %arg7: memref<32xi32>):
+    hls.dataflow.node(%arg4) -> (%arg5) {inputTaps = [0 : i32]} : (memref<16xf32>) -> memref<16xf32> {
+    ^bb0(%arg8: memref<16xf32>, %arg9: memref<16xf32>):
+      affine.for %arg10 = 0 to 16 {
+        %0 = affine.load %arg8[%arg10] : memref<16xf32>
+        %1 = arith.divf %0, %0 : f32
+        %2 = arith.divf %1, %0 : f32
+        %3 = arith.divf %2, %0 : f32
+        %4 = arith.divf %3, %0 : f32
+        affine.store %4, %arg9[%arg10] : memref<16xf32>
+      }
+    }
+    hls.dataflow.node(%arg6) -> (%arg7) {inputTaps = [0 : i32]} : (memref<32xi32>) -> memref<32xi32> {
+    ^bb0(%arg8: memref<32xi32>, %arg9: memref<32xi32>):
+      affine.for %arg10 = 0 to 32 {
+        %0 = affine.load %arg8[%arg10] : memref<32xi32>
+        %1 = arith.addi %0, %0 : i32
+        affine.store %1, %arg9[%arg10] : memref<32xi32>
+      }
+    }
+  }
+  return
+}
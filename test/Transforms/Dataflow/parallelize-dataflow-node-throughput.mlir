@@ -0,0 +1,34 @@
+// RUN: sed 's/"dsp": 220/"dsp": 20/' %S/../Directive/config.json > %t.json
+// RUN: scalehls-opt -scalehls-parallelize-dataflow-node="max-unroll-factor=16 correlation-aware=false throughput-aware=true target-spec=%t.json" %s | FileCheck %s
+
+// Each node holds a multiplier of 3 DSPs and the budget is 22 DSPs with the
+// margin. The lowest feasible target interval is reached by unrolling the first
+// node, which is eight times slower, by 4, while the second node is not
+// unrolled. Unrolling the first node by 8 would exceed the budget.
+
+// CHECK: hls.dataflow.node
+// CHECK: affine.for %{{.*}} = 0 to 64 step 4 {
+// CHECK: hls.dataflow.node
+// CHECK: affine.for %{{.*}} = 0 to 8 {
+func.func @test_throughput(%arg0: memref<64xf32>, %arg1: memref<64xf32>, %arg2: memref<8xf32>, %arg3: memref<8xf32>) {
+  hls.dataflow.schedule(%arg0, %arg1, %arg2, %arg3) : memref<64xf32>, memref<64xf32>, memref<8xf32>, memref<8xf32> {
+  ^bb0(%arg4: memref<64xf32>, %arg5: memref<64xf32>, %arg6: memref<8xf32>, %arg7: memref<8xf32>):
+    hls.dataflow.node(%arg4) -> (%arg5) {inputTaps = [0 : i32]} : (memref<64xf32>) -> memref<64xf32> {
+    ^bb0(%arg8: memref<64xf32>, %arg9: memref<64xf32>):
+      affine.for %arg10 = 0 to 64 {
+        %0 = affine.load %arg8[%arg10] : memref<64xf32>
+        %1 = arith.mulf %0, %0 : f32
+        affine.store %1, %arg9[%arg10] : memref<64xf32>
+      }
+    }
+    hls.dataflow.node(%arg6) -> (%arg7) {inputTaps = [0 : i32]} : (memref<8xf32>) -> memref<8xf32> {
+    ^bb0(%arg8: memref<8xf32>, %arg9: memref<8xf32>):
+      affine.for %arg10 = 0 to 8 {
+        %0 = affine.load %arg8[%arg10] : memref<8xf32>
+        %1 = arith.mulf %0, %0 : f32
+        affine.store %1, %arg9[%arg10] : memref<8xf32>
+      }
+    }
+  }
+  return
+}
@@ -0,0 +1,39 @@
+// RUN: scalehls-opt -scalehls-place-dataflow-buffer="capacity-aware target-spec=%S/../Directive/config.json" -verify-diagnostics %s | FileCheck %s
+
+// CHECK-LABEL: func.func @test_capacity
+// CHECK: hls.dataflow.buffer {depth = 1 : i32} : memref<1024xi32, {{.*}}bram_t2p>>
+// CHECK: hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32, {{.*}}dram>>
+// CHECK: hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32, {{.*}}bram_t2p>>
+// CHECK: hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32, {{.*}}uram_t2p>>
+
+// expected-remark@+1 {{buffer placement: 3/4 buffers on-chip, bram 236/280, uram 32/48}}
+func.func @test_capacity(%arg0: memref<131072xi32>) {
+  %c0_i32 = arith.constant 0 : i32
+  %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<1024xi32>
+  %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32>
+  %2 = hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32>
+  %3 = hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32>
+  affine.for %arg1 = 0 to 64 {
+    affine.for %arg2 = 0 to 1024 {
+      %4 = affine.load %0[%arg2] : memref<1024xi32>
+      %5 = arith.addi %4, %4 : i32
+      affine.store %5, %0[%arg2] : memref<1024xi32>
+    }
+  }
+  affine.for %arg1 = 0 to 131072 {
+    affine.store %c0_i32, %1[%arg1] : memref<131072xi32>
+    affine.store %c0_i32, %2[%arg1] : memref<131072xi32>
+    affine.store %c0_i32, %3[%arg1] : memref<131072xi32>
+  }
+  affine.for %arg1 = 0 to 131072 {
+    %4 = affine.load %2[%arg1] : memref<131072xi32>
+    %5 = affine.load %3[%arg1] : memref<131072xi32>
+    %6 = arith.addi %4, %5 : i32
+    affine.store %6, %arg0[%arg1] : memref<131072xi32>
+  }
+  affine.for %arg1 = 0 to 131072 {
+    %4 = affine.load %3[%arg1] : memref<131072xi32>
+    affine.store %4, %arg0[%arg1] : memref<131072xi32>
+  }
+  return
+}
@@ -0,0 +1,108 @@
+// RUN: scalehls-opt -scalehls-schedule-dataflow-node="strategy=asap" %s | FileCheck %s
+// RUN: scalehls-opt -scalehls-schedule-dataflow-node="strategy=latency target-spec=%S/../Directive/config.json" %s | FileCheck %s --check-prefix=LATENCY
+// RUN: scalehls-opt -scalehls-schedule-dataflow-node="report target-spec=%S/../Directive/config.json" %s 2>&1 >/dev/null | FileCheck %s --check-prefix=REPORT
+
+// CHECK-LABEL: func.func @test_strategy
+// CHECK: hls.dataflow.node() -> (%0) {inputTaps = [], level = 2 : i32}
+// CHECK: hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32], level = 1 : i32}
+// CHECK: hls.dataflow.node() -> (%2) {inputTaps = [], level = 2 : i32}
+// CHECK: hls.dataflow.node(%1, %2) -> (%arg1) {inputTaps = [0 : i32, 0 : i32], level = 0 : i32}
+
+// REPORT: remark: level 2: 1 nodes, max latency {{[0-9]+}}
+// REPORT: remark: level 1: 2 nodes, max latency {{[0-9]+}}
+// REPORT: remark: level 0: 1 nodes, max latency {{[0-9]+}}
+// REPORT: remark: critical path latency {{[0-9]+}}, 0 unscheduled nodes
+func.func @test_strategy(%arg0: memref<256xi32>) {
+  hls.dataflow.schedule(%arg0) : memref<256xi32> {
+  ^bb0(%arg1: memref<256xi32>):
+    %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    %2 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    hls.dataflow.node() -> (%0) {inputTaps = []} : () -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>):
+      %c0_i32 = arith.constant 0 : i32
+      affine.for %arg3 = 0 to 256 {
+        affine.store %c0_i32, %arg2[%arg3] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32]} : (memref<256xi32>) -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>, %arg3: memref<256xi32>):
+      affine.for %arg4 = 0 to 256 {
+        %3 = affine.load %arg2[%arg4] : memref<256xi32>
+        affine.store %3, %arg3[%arg4] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node() -> (%2) {inputTaps = []} : () -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>):
+      %c1_i32 = arith.constant 1 : i32
+      affine.for %arg3 = 0 to 256 {
+        affine.store %c1_i32, %arg2[%arg3] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node(%1, %2) -> (%arg1) {inputTaps = [0 : i32, 0 : i32]} : (memref<256xi32>, memref<256xi32>) -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>, %arg3: memref<256xi32>, %arg4: memref<256xi32>):
+      affine.for %arg5 = 0 to 256 {
+        %3 = affine.load %arg2[%arg5] : memref<256xi32>
+        %4 = affine.load %arg3[%arg5] : memref<256xi32>
+        %5 = arith.addi %3, %4 : i32
+        affine.store %5, %arg4[%arg5] : memref<256xi32>
+      }
+    }
+  }
+  return
+}
+
+// The short node writing %0 takes level 2 in both strategies. The latency
+// strategy then moves the node writing %2 from its ASAP level 2 down to level
+// 1, where it is hidden behind the long node writing %1.
+
+// CHECK-LABEL: func.func @test_latency
+// CHECK: hls.dataflow.node() -> (%2) {inputTaps = [], level = 2 : i32}
+// CHECK: hls.dataflow.node() -> (%0) {inputTaps = [], level = 2 : i32}
+// CHECK: hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32], level = 1 : i32}
+// CHECK: hls.dataflow.node(%1, %2) -> (%arg1) {inputTaps = [0 : i32, 0 : i32], level = 0 : i32}
+
+// LATENCY-LABEL: func.func @test_latency
+// LATENCY: hls.dataflow.node() -> (%2) {inputTaps = [], level = 1 : i32}
+// LATENCY: hls.dataflow.node() -> (%0) {inputTaps = [], level = 2 : i32}
+// LATENCY: hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32], level = 1 : i32}
+// LATENCY: hls.dataflow.node(%1, %2) -> (%arg1) {inputTaps = [0 : i32, 0 : i32], level = 0 : i32}
+func.func @test_latency(%arg0: memref<256xi32>) {
+  hls.dataflow.schedule(%arg0) : memref<256xi32> {
+  ^bb0(%arg1: memref<256xi32>):
+    %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    %2 = hls.dataflow.buffer {depth = 1 : i32} : memref<256xi32>
+    hls.dataflow.node() -> (%2) {inputTaps = []} : () -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>):
+      %c1_i32 = arith.constant 1 : i32
+      affine.for %arg3 = 0 to 256 {
+        affine.store %c1_i32, %arg2[%arg3] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node() -> (%0) {inputTaps = []} : () -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>):
+      %c0_i32 = arith.constant 0 : i32
+      affine.store %c0_i32, %arg2[0] : memref<256xi32>
+    }
+    hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32]} : (memref<256xi32>) -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>, %arg3: memref<256xi32>):
+      affine.for %arg4 = 0 to 256 {
+        %3 = affine.load %arg2[0] : memref<256xi32>
+        %4 = arith.muli %3, %3 : i32
+        %5 = arith.addi %4, %3 : i32
+        affine.store %5, %arg3[%arg4] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node(%1, %2) -> (%arg1) {inputTaps = [0 : i32, 0 : i32]} : (memref<256xi32>, memref<256xi32>) -> memref<256xi32> {
+    ^bb0(%arg2: memref<256xi32>, %arg3: memref<256xi32>, %arg4: memref<256xi32>):
+      affine.for %arg5 = 0 to 256 {
+        %3 = affine.load %arg2[%arg5] : memref<256xi32>
+        %4 = affine.load %arg3[%arg5] : memref<256xi32>
+        %5 = arith.addi %3, %4 : i32
+        affine.store %5, %arg4[%arg5] : memref<256xi32>
+      }
+    }
+  }
+  return
+}
@@ -0,0 +1,66 @@
+// RUN: scalehls-opt -scalehls-size-dataflow-depth="target-spec=%S/../Directive/config.json" -verify-diagnostics %s | FileCheck %s
+
+// CHECK-LABEL: func.func @test_buffer
+// CHECK: hls.dataflow.buffer {depth = 2 : i32} : memref<1024xi32>
+
+// expected-remark@+1 {{dataflow depth sizing changed BRAM utilization from 8 to 4}}
+func.func @test_buffer(%arg0: memref<1024xi32>) {
+  hls.dataflow.schedule(%arg0) : memref<1024xi32> {
+  ^bb0(%arg1: memref<1024xi32>):
+    %0 = hls.dataflow.buffer {depth = 4 : i32} : memref<1024xi32>
+    hls.dataflow.node() -> (%0) {inputTaps = [], level = 2 : i32} : () -> memref<1024xi32> {
+    ^bb0(%arg2: memref<1024xi32>):
+      %c0_i32 = arith.constant 0 : i32
+      affine.for %arg3 = 0 to 1024 {
+        affine.store %c0_i32, %arg2[%arg3] : memref<1024xi32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg1) {inputTaps = [1 : i32], level = 0 : i32} : (memref<1024xi32>) -> memref<1024xi32> {
+    ^bb0(%arg2: memref<1024xi32>, %arg3: memref<1024xi32>):
+      affine.for %arg4 = 0 to 1024 {
+        %1 = affine.load %arg2[%arg4] : memref<1024xi32>
+        affine.store %1, %arg3[%arg4] : memref<1024xi32>
+      }
+    }
+  }
+  return
+}
+
+// The producer pushes 16 tokens into the stream, while the consumer starts two
+// stages later, after the longer copy node is done. Therefore, the stream is
+// deepened to hold all tokens, which is still implemented with SRLs.
+
+// CHECK-LABEL: func.func @test_stream
+// CHECK: hls.dataflow.stream {depth = 16 : i32} : <i32, 16>
+// CHECK: ^bb0(%{{.*}}: memref<16xi32>, %{{.*}}: !hls.stream<i32, 16>):
+// CHECK: ^bb0(%{{.*}}: !hls.stream<i32, 16>, %{{.*}}: memref<16xi32>):
+
+// expected-remark@+1 {{dataflow depth sizing changed BRAM utilization from 0 to 0}}
+func.func @test_stream(%arg0: memref<16xi32>, %arg1: memref<256xi32>, %arg2: memref<256xi32>, %arg3: memref<16xi32>) {
+  hls.dataflow.schedule(%arg0, %arg1, %arg2, %arg3) : memref<16xi32>, memref<256xi32>, memref<256xi32>, memref<16xi32> {
+  ^bb0(%arg4: memref<16xi32>, %arg5: memref<256xi32>, %arg6: memref<256xi32>, %arg7: memref<16xi32>):
+    %0 = hls.dataflow.stream {depth = 1 : i32} : <i32, 1>
+    hls.dataflow.node(%arg4) -> (%0) {inputTaps = [0 : i32], level = 2 : i32} : (memref<16xi32>) -> !hls.stream<i32, 1> {
+    ^bb0(%arg8: memref<16xi32>, %arg9: !hls.stream<i32, 1>):
+      affine.for %arg10 = 0 to 16 {
+        %1 = affine.load %arg8[%arg10] : memref<16xi32>
+        hls.dataflow.stream_write %arg9, %1 : <i32, 1>, i32
+      }
+    }
+    hls.dataflow.node(%arg5) -> (%arg6) {inputTaps = [0 : i32], level = 1 : i32} : (memref<256xi32>) -> memref<256xi32> {
+    ^bb0(%arg8: memref<256xi32>, %arg9: memref<256xi32>):
+      affine.for %arg10 = 0 to 256 {
+        %1 = affine.load %arg8[%arg10] : memref<256xi32>
+        affine.store %1, %arg9[%arg10] : memref<256xi32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg7) {inputTaps = [0 : i32], level = 0 : i32} : (!hls.stream<i32, 1>) -> memref<16xi32> {
+    ^bb0(%arg8: !hls.stream<i32, 1>, %arg9: memref<16xi32>):
+      affine.for %arg10 = 0 to 16 {
+        %1 = hls.dataflow.stream_read %arg8 : (!hls.stream<i32, 1>) -> i32
+        affine.store %1, %arg9[%arg10] : memref<16xi32>
+      }
+    }
+  }
+  return
+}
@@ -0,0 +1,23 @@
+// RUN: scalehls-opt -scalehls-array-partition="qor-aware=true target-spec=%S/config.json" %s 2>&1 | FileCheck %s
+
+// CHECK: remark: array partition: none, bram=0, functions=2
+// CHECK: remark: array partition: #hls.partition<[cyclic], [2]>, bram=0, functions=2
+// CHECK: remark: array partition search: latency
+
+func.func @sub(%arg0: memref<64xi32, #hls.mem<bram_s2p>>, %arg1: memref<32xi32, #hls.mem<bram_s2p>>) {
+  affine.for %arg2 = 0 to 32 {
+    %0 = affine.load %arg0[%arg2 * 2] : memref<64xi32, #hls.mem<bram_s2p>>
+    %1 = affine.load %arg0[%arg2 * 2 + 1] : memref<64xi32, #hls.mem<bram_s2p>>
+    %2 = arith.addi %0, %1 : i32
+    affine.store %2, %arg1[%arg2] : memref<32xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// CHECK-LABEL: func.func @forward
+// CHECK: hls.dataflow.buffer {depth = 1 : i32} : memref<64xi32, {{.*}}lutram_2p>>
+func.func @forward(%arg0: memref<32xi32, #hls.mem<bram_s2p>>) attributes {top_func} {
+  %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<64xi32, #hls.mem<bram_s2p>>
+  call @sub(%0, %arg0) : (memref<64xi32, #hls.mem<bram_s2p>>, memref<32xi32, #hls.mem<bram_s2p>>) -> ()
+  return
+}
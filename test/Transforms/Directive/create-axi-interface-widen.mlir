@@ -0,0 +1,22 @@
+// RUN: scalehls-opt -scalehls-create-axi-interface %s | FileCheck %s
+
+// The widened bitwidths of external buffers are propagated to their AXI ports.
+
+// CHECK-LABEL: func.func @forward
+// CHECK-SAME: (%arg0: !hls.axi<memref<64xi32, #hls.mem<dram>>>, %arg1: !hls.axi<memref<64xi32, #hls.mem<dram>>>, %arg2: !hls.axi<memref<64xi32, #hls.mem<dram>>>, %arg3: !hls.axi<memref<64xi32, #hls.mem<dram>>>)
+// CHECK-DAG: hls.axi.port %{{.*}}, %arg0 {max_widen_bitwidth = 512 : i64}
+// CHECK-DAG: hls.axi.port %{{.*}}, %arg1 :
+// CHECK-DAG: hls.axi.port %{{.*}}, %arg2 {max_widen_bitwidth = 256 : i64}
+// CHECK-DAG: hls.axi.port %{{.*}}, %arg3 {max_widen_bitwidth = 256 : i64}
+func.func @forward(%arg0: memref<64xi32, #hls.mem<dram>> {hls.max_widen_bitwidth = 512 : i64}, %arg1: memref<64xi32, #hls.mem<dram>>) attributes {top_func} {
+  %0 = hls.dataflow.buffer {depth = 1 : i32, max_widen_bitwidth = 256 : i64} : memref<64xi32, #hls.mem<dram>>
+  affine.for %arg2 = 0 to 64 {
+    %1 = affine.load %arg0[%arg2] : memref<64xi32, #hls.mem<dram>>
+    affine.store %1, %0[%arg2] : memref<64xi32, #hls.mem<dram>>
+  }
+  affine.for %arg2 = 0 to 64 {
+    %1 = affine.load %0[%arg2] : memref<64xi32, #hls.mem<dram>>
+    affine.store %1, %arg1[%arg2] : memref<64xi32, #hls.mem<dram>>
+  }
+  return
+}
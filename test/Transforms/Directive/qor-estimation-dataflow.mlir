@@ -0,0 +1,39 @@
+// RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" %s | FileCheck %s
+
+// The interval of the schedule is the interval of its slowest node, which is
+// the copy node.
+// CHECK: hls.dataflow.schedule({{.*}}) attributes {{.*}}timing = #hls.time<{{[0-9]+}} -> {{[0-9]+}}, latency = {{[0-9]+}}, interval = [[II:[0-9]+]]>}
+
+// The producer pushes 16 tokens into the stream, while the consumer starts two
+// stages later, after the longer copy node is done. Therefore, all tokens must
+// be buffered in the stream.
+// CHECK: hls.dataflow.stream {{.*}}required_depth = 16 : i32
+// CHECK: hls.dataflow.node({{.*}}level = 1 : i32, {{.*}}timing = #hls.time<{{[0-9]+}} -> {{[0-9]+}}, latency = {{[0-9]+}}, interval = [[II]]>}
+func.func @test_schedule(%arg0: memref<16xi32, #hls.mem<bram_t2p>>, %arg1: memref<256xi32, #hls.mem<bram_t2p>>, %arg2: memref<256xi32, #hls.mem<bram_t2p>>, %arg3: memref<16xi32, #hls.mem<bram_t2p>>) attributes {top_func} {
+  hls.dataflow.schedule(%arg0, %arg1, %arg2, %arg3) : memref<16xi32, #hls.mem<bram_t2p>>, memref<256xi32, #hls.mem<bram_t2p>>, memref<256xi32, #hls.mem<bram_t2p>>, memref<16xi32, #hls.mem<bram_t2p>> {
+  ^bb0(%arg4: memref<16xi32, #hls.mem<bram_t2p>>, %arg5: memref<256xi32, #hls.mem<bram_t2p>>, %arg6: memref<256xi32, #hls.mem<bram_t2p>>, %arg7: memref<16xi32, #hls.mem<bram_t2p>>):
+    %0 = hls.dataflow.stream {depth = 1 : i32} : <i32, 1>
+    hls.dataflow.node(%arg4) -> (%0) {inputTaps = [0 : i32], level = 2 : i32} : (memref<16xi32, #hls.mem<bram_t2p>>) -> !hls.stream<i32, 1> {
+    ^bb0(%arg8: memref<16xi32, #hls.mem<bram_t2p>>, %arg9: !hls.stream<i32, 1>):
+      affine.for %arg10 = 0 to 16 {
+        %1 = affine.load %arg8[%arg10] : memref<16xi32, #hls.mem<bram_t2p>>
+        hls.dataflow.stream_write %arg9, %1 : <i32, 1>, i32
+      }
+    }
+    hls.dataflow.node(%arg5) -> (%arg6) {inputTaps = [0 : i32], level = 1 : i32} : (memref<256xi32, #hls.mem<bram_t2p>>) -> memref<256xi32, #hls.mem<bram_t2p>> {
+    ^bb0(%arg8: memref<256xi32, #hls.mem<bram_t2p>>, %arg9: memref<256xi32, #hls.mem<bram_t2p>>):
+      affine.for %arg10 = 0 to 256 {
+        %1 = affine.load %arg8[%arg10] : memref<256xi32, #hls.mem<bram_t2p>>
+        affine.store %1, %arg9[%arg10] : memref<256xi32, #hls.mem<bram_t2p>>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg7) {inputTaps = [0 : i32], level = 0 : i32} : (!hls.stream<i32, 1>) -> memref<16xi32, #hls.mem<bram_t2p>> {
+    ^bb0(%arg8: !hls.stream<i32, 1>, %arg9: memref<16xi32, #hls.mem<bram_t2p>>):
+      affine.for %arg10 = 0 to 16 {
+        %1 = hls.dataflow.stream_read %arg8 : (!hls.stream<i32, 1>) -> i32
+        affine.store %1, %arg9[%arg10] : memref<16xi32, #hls.mem<bram_t2p>>
+      }
+    }
+  }
+  return
+}
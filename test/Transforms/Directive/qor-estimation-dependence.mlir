@@ -0,0 +1,51 @@
+// RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" -split-input-file %s > %t.mlir
+// RUN: FileCheck %s --input-file=%t.mlir
+
+// The load-store and store-load loops have the same structure except for the
+// order of the accesses, therefore their dependence checks share the cached
+// results once being estimated together. Each loop must be estimated the same
+// as being estimated alone, regardless of the schedule begin and end.
+// RUN: %PYTHON -c "import re, sys; chunks = [[re.sub(r'#hls.time<\d+ -> \d+, ', '', l) for l in c.splitlines() if 'loop_directive' in l] for c in open(sys.argv[1]).read().split('// -----')]; assert len(chunks[0]) == 2 and chunks[0] == chunks[1] + chunks[2]" %t.mlir
+
+// CHECK-LABEL: func.func @test_dependence
+// CHECK-COUNT-2: loop_directive = #hls.loop<pipeline = true
+// CHECK-LABEL: func.func @test_load_store
+// CHECK: loop_directive = #hls.loop<pipeline = true
+// CHECK-LABEL: func.func @test_store_load
+// CHECK: loop_directive = #hls.loop<pipeline = true
+
+func.func @test_dependence(%arg0: memref<16xi32, #hls.mem<bram_s2p>>, %arg1: memref<16xi32, #hls.mem<bram_s2p>>, %arg2: i32) attributes {top_func} {
+  affine.for %arg3 = 0 to 16 {
+    %0 = affine.load %arg0[%arg3] : memref<16xi32, #hls.mem<bram_s2p>>
+    %1 = arith.addi %0, %arg2 : i32
+    affine.store %1, %arg0[%arg3] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  affine.for %arg3 = 0 to 16 {
+    affine.store %arg2, %arg1[%arg3] : memref<16xi32, #hls.mem<bram_s2p>>
+    %0 = affine.load %arg1[%arg3] : memref<16xi32, #hls.mem<bram_s2p>>
+    %1 = arith.addi %0, %arg2 : i32
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// -----
+
+func.func @test_load_store(%arg0: memref<16xi32, #hls.mem<bram_s2p>>, %arg1: i32) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 {
+    %0 = affine.load %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+    %1 = arith.addi %0, %arg1 : i32
+    affine.store %1, %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// -----
+
+func.func @test_store_load(%arg0: memref<16xi32, #hls.mem<bram_s2p>>, %arg1: i32) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 {
+    affine.store %arg1, %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+    %0 = affine.load %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+    %1 = arith.addi %0, %arg1 : i32
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
@@ -0,0 +1,14 @@
+// RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" %s | FileCheck %s
+
+// CHECK: func.func @test_memory
+// CHECK-SAME: resource = #hls.res<lut = {{[0-9]+}}, dsp = 0, bram = 0, uram = 32>
+func.func @test_memory() -> (i32, i32) attributes {top_func} {
+  %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<131072xi32, #hls.mem<uram_t2p>>
+  %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<64xi32, #hls.mem<lutram_2p>>
+
+  // CHECK: affine.load %0[0] {{.*}}latency = 2, interval = 1>} : memref<131072xi32, #hls.mem<uram_t2p>>
+  // CHECK: affine.load %1[0] {{.*}}latency = 1, interval = 1>} : memref<64xi32, #hls.mem<lutram_2p>>
+  %2 = affine.load %0[0] : memref<131072xi32, #hls.mem<uram_t2p>>
+  %3 = affine.load %1[0] : memref<64xi32, #hls.mem<lutram_2p>>
+  return %2, %3 : i32, i32
+}
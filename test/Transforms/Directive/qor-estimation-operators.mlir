@@ -0,0 +1,17 @@
+// RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" %s | FileCheck %s
+
+// CHECK: func.func @test_int(%arg0: i8, %arg1: i8, %arg2: i32, %arg3: i32) -> (i8, i32, i32)
+// CHECK-SAME: resource = #hls.res<lut = 77, dsp = 3, bram = 0>
+func.func @test_int(%arg0: i8, %arg1: i8, %arg2: i32, %arg3: i32) -> (i8, i32, i32) attributes {top_func} {
+  %c2_i32 = arith.constant 2 : i32
+
+  // CHECK: arith.muli %arg0, %arg1 {timing = #hls.time<{{.*}}, latency = 0, interval = 0>} : i8
+  // CHECK: arith.addi %0, %arg1 {timing = #hls.time<{{.*}}, latency = 0, interval = 0>} : i8
+  // CHECK: arith.muli %arg2, %arg3 {timing = #hls.time<{{.*}}, latency = 1, interval = 1>} : i32
+  // CHECK: arith.shli %arg2, %c2_i32 {timing = #hls.time<{{.*}}, latency = 0, interval = 0>} : i32
+  %0 = arith.muli %arg0, %arg1 : i8
+  %1 = arith.addi %0, %arg1 : i8
+  %2 = arith.muli %arg2, %arg3 : i32
+  %3 = arith.shli %arg2, %c2_i32 : i32
+  return %1, %2, %3 : i8, i32, i32
+}
@@ -0,0 +1,66 @@
+// RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" %s | FileCheck %s
+
+// Each iteration reads four elements of a BRAM_S2P memory, which has one read
+// port in each partition. Therefore, the resource-bound II is the number of
+// reads falling on the same partition.
+
+// CHECK-LABEL: func.func @test_none
+// CHECK: loop_info = #hls.info<flatten_trip_count = 4, iter_latency = {{[0-9]+}}, min_ii = 4>
+func.func @test_none(%arg0: memref<16xi32, #hls.mem<bram_s2p>>, %arg1: memref<16xi32, #hls.mem<bram_s2p>>) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 step 4 {
+    %0 = affine.load %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+    %1 = affine.load %arg0[%arg2 + 1] : memref<16xi32, #hls.mem<bram_s2p>>
+    %2 = affine.load %arg0[%arg2 + 2] : memref<16xi32, #hls.mem<bram_s2p>>
+    %3 = affine.load %arg0[%arg2 + 3] : memref<16xi32, #hls.mem<bram_s2p>>
+    %4 = arith.addi %0, %1 : i32
+    %5 = arith.addi %2, %3 : i32
+    %6 = arith.addi %4, %5 : i32
+    affine.store %6, %arg1[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// CHECK-LABEL: func.func @test_cyclic_2
+// CHECK: loop_info = #hls.info<flatten_trip_count = 4, iter_latency = {{[0-9]+}}, min_ii = 2>
+func.func @test_cyclic_2(%arg0: memref<16xi32, #hls.partition<[cyclic], [2]>, #hls.mem<bram_s2p>>, %arg1: memref<16xi32, #hls.mem<bram_s2p>>) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 step 4 {
+    %0 = affine.load %arg0[%arg2] : memref<16xi32, #hls.partition<[cyclic], [2]>, #hls.mem<bram_s2p>>
+    %1 = affine.load %arg0[%arg2 + 1] : memref<16xi32, #hls.partition<[cyclic], [2]>, #hls.mem<bram_s2p>>
+    %2 = affine.load %arg0[%arg2 + 2] : memref<16xi32, #hls.partition<[cyclic], [2]>, #hls.mem<bram_s2p>>
+    %3 = affine.load %arg0[%arg2 + 3] : memref<16xi32, #hls.partition<[cyclic], [2]>, #hls.mem<bram_s2p>>
+    %4 = arith.addi %0, %1 : i32
+    %5 = arith.addi %2, %3 : i32
+    %6 = arith.addi %4, %5 : i32
+    affine.store %6, %arg1[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// CHECK-LABEL: func.func @test_cyclic_4
+// CHECK: loop_info = #hls.info<flatten_trip_count = 4, iter_latency = {{[0-9]+}}, min_ii = 1>
+func.func @test_cyclic_4(%arg0: memref<16xi32, #hls.partition<[cyclic], [4]>, #hls.mem<bram_s2p>>, %arg1: memref<16xi32, #hls.mem<bram_s2p>>) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 step 4 {
+    %0 = affine.load %arg0[%arg2] : memref<16xi32, #hls.partition<[cyclic], [4]>, #hls.mem<bram_s2p>>
+    %1 = affine.load %arg0[%arg2 + 1] : memref<16xi32, #hls.partition<[cyclic], [4]>, #hls.mem<bram_s2p>>
+    %2 = affine.load %arg0[%arg2 + 2] : memref<16xi32, #hls.partition<[cyclic], [4]>, #hls.mem<bram_s2p>>
+    %3 = affine.load %arg0[%arg2 + 3] : memref<16xi32, #hls.partition<[cyclic], [4]>, #hls.mem<bram_s2p>>
+    %4 = arith.addi %0, %1 : i32
+    %5 = arith.addi %2, %3 : i32
+    %6 = arith.addi %4, %5 : i32
+    affine.store %6, %arg1[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
+
+// Each iteration writes two elements of a BRAM_S2P memory, which has one write
+// port in each partition.
+
+// CHECK-LABEL: func.func @test_write
+// CHECK: loop_info = #hls.info<flatten_trip_count = 8, iter_latency = {{[0-9]+}}, min_ii = 2>
+func.func @test_write(%arg0: memref<16xi32, #hls.mem<bram_s2p>>, %arg1: i32) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 step 2 {
+    affine.store %arg1, %arg0[%arg2] : memref<16xi32, #hls.mem<bram_s2p>>
+    affine.store %arg1, %arg0[%arg2 + 1] : memref<16xi32, #hls.mem<bram_s2p>>
+  } {loop_directive = #hls.loop<pipeline = true, target_ii = 1, dataflow = false, flatten = false>}
+  return
+}
@@ -1,7 +1,7 @@
 // RUN: scalehls-opt -scalehls-qor-estimation="target-spec=%S/config.json" %s | FileCheck %s
 
 // CHECK: module {
-// CHECK:   func.func @test_syrk(%arg0: f32, %arg1: f32, %arg2: memref<16x16xf32, #map, #hls.mem<bram_s2p>>, %arg3: memref<16x16xf32, #map1, #hls.mem<bram_s2p>>) attributes {func_directive = #hls.func<pipeline = false, target_interval = 1, dataflow = false>, resource = #hls.res<lut = 0, dsp = 11, bram = 0>, timing = #hls.time<0 -> 4119, latency = 4119, interval = 4119>, top_func} {
+// CHECK:   func.func @test_syrk(%arg0: f32, %arg1: f32, %arg2: memref<16x16xf32, #map, #hls.mem<bram_s2p>>, %arg3: memref<16x16xf32, #map1, #hls.mem<bram_s2p>>) attributes {func_directive = #hls.func<pipeline = false, target_interval = 1, dataflow = false>, resource = #hls.res<lut = 439, dsp = 11, bram = 0>, timing = #hls.time<0 -> 4119, latency = 4119, interval = 4119>, top_func} {
 // CHECK:     affine.for %arg4 = 0 to 16 step 2 {
 // CHECK:       affine.for %arg5 = 0 to 16 {
 // CHECK:         affine.for %arg6 = 0 to 16 {
@@ -0,0 +1,38 @@
+// RUN: scalehls-opt -scalehls-affine-loop-fusion="fusion-compute-tolerance=100.0" %s | FileCheck %s --check-prefix=FUSED
+// RUN: scalehls-opt -scalehls-affine-loop-fusion="fusion-compute-tolerance=100.0 qor-aware=true target-spec=%S/../Directive/config.json" %s | FileCheck %s --check-prefix=QOR
+
+// Fusing the producer into the consumer privatizes the buffer into two
+// elements, but computes each element of the producer twice. As the chained
+// divisions dominate the latency, the QoR-aware fusion rejects the fusion and
+// leaves no estimation attributes behind.
+
+// FUSED: memref<2xf32>
+
+// QOR-NOT: memref<2xf32>
+// QOR: %[[BUF:.*]] = hls.dataflow.buffer {depth = 1 : i32} : memref<64xf32>
+// QOR: affine.for %[[I:.*]] = 0 to 64 {
+// QOR: affine.store %{{.*}}, %[[BUF]][%[[I]]] : memref<64xf32>
+// QOR: affine.for %[[J:.*]] = 0 to 63 {
+// QOR: affine.load %[[BUF]][%[[J]]] : memref<64xf32>
+// QOR-NOT: timing
+// QOR-NOT: partition_indices
+func.func @test_fusion_qor(%arg0: memref<64xf32>, %arg1: memref<63xf32>) {
+  hls.dataflow.dispatch {
+    hls.dataflow.task {
+      %0 = hls.dataflow.buffer {depth = 1 : i32} : memref<64xf32>
+      affine.for %arg2 = 0 to 64 {
+        %1 = affine.load %arg0[%arg2] : memref<64xf32>
+        %2 = arith.divf %1, %1 : f32
+        %3 = arith.divf %2, %1 : f32
+        affine.store %3, %0[%arg2] : memref<64xf32>
+      }
+      affine.for %arg2 = 0 to 63 {
+        %1 = affine.load %0[%arg2] : memref<64xf32>
+        %2 = affine.load %0[%arg2 + 1] : memref<64xf32>
+        %3 = arith.addf %1, %2 : f32
+        affine.store %3, %arg1[%arg2] : memref<63xf32>
+      }
+    }
+  }
+  return
+}
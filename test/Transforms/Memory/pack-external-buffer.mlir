@@ -0,0 +1,32 @@
+// RUN: scalehls-opt -scalehls-pack-external-buffer="bus-width=512" -verify-diagnostics %s | FileCheck %s
+// RUN: scalehls-opt -scalehls-pack-external-buffer="bus-width=512" -scalehls-buffer-vectorize -verify-diagnostics %s | FileCheck %s --check-prefix=VECTOR
+
+// CHECK-LABEL: func.func @test_pack
+// CHECK-SAME: %arg0: memref<64x64xi32, #hls.mem<dram>> {hls.max_widen_bitwidth = 512 : i64, hls.tile_layout = #hls.tile<[64, 64], [1, 16]>}
+// CHECK-SAME: %arg1: memref<64x64xi32, #hls.mem<dram>> {hls.max_widen_bitwidth = 512 : i64}
+// CHECK-SAME: %arg2: memref<64x64xi32, #hls.mem<dram>>)
+// CHECK: affine.for %{{.*}} = 0 to 64 {
+// CHECK-NEXT: affine.for %{{.*}} = 0 to 64 step 16 {
+// CHECK-COUNT-16: affine.load %arg0
+
+// Each packed word of %arg0 is loaded once and all its elements are extracted.
+// VECTOR-LABEL: func.func @test_pack
+// VECTOR: affine.for %{{.*}} = 0 to 64 step 16 {
+// VECTOR-NEXT: affine.load {{.*}} : memref<64x4xvector<16xi32>
+// VECTOR-COUNT-16: vector.extractelement
+// VECTOR-NOT: vector.extractelement
+// VECTOR-NOT: memref<64x4xvector<16xi32>
+// VECTOR: return
+
+// expected-remark@+1 {{external buffer packing: 2/3 buffers packed to 512 bits}}
+func.func @test_pack(%arg0: memref<64x64xi32, #hls.mem<dram>>, %arg1: memref<64x64xi32, #hls.mem<dram>>, %arg2: memref<64x64xi32, #hls.mem<dram>>) {
+  affine.for %arg3 = 0 to 64 {
+    affine.for %arg4 = 0 to 64 {
+      %0 = affine.load %arg0[%arg3, %arg4] : memref<64x64xi32, #hls.mem<dram>>
+      %1 = affine.load %arg2[%arg4, %arg3] : memref<64x64xi32, #hls.mem<dram>>
+      %2 = arith.addi %0, %1 : i32
+      affine.store %2, %arg1[%arg3, %arg4] : memref<64x64xi32, #hls.mem<dram>>
+    }
+  }
+  return
+}
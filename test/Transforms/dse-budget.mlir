@@ -0,0 +1,12 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/ csv-path=%t/ target-spec=%S/Inputs/dse-budget.json" %S/Inputs/dse-gemm.mlir > %t/output.mlir
+
+// The DSP budget of 10 is relaxed by 10% and rounded up. Design points out of
+// the budget are still evaluated and dumped as non-pareto points, but are never
+// pareto points of the loop or function design space.
+// RUN: %PYTHON -c "import math, sys; budget = math.ceil(10 * 1.1); ls = open(sys.argv[1]).read().split(); dsp = ls[0].split(',').index('dsp'); rows = [l.split(',') for l in ls[1:]]; assert any(r[-1] == 'pareto' for r in rows); assert all(int(r[dsp]) <= budget for r in rows if r[-1] == 'pareto'); assert any(int(r[dsp]) > budget for r in rows)" %t/test_dse_loop_0_space.csv
+// RUN: %PYTHON -c "import math, sys; budget = math.ceil(10 * 1.1); ls = open(sys.argv[1]).read().split(); dsp = ls[0].split(',').index('dsp'); rows = [l.split(',') for l in ls[1:]]; assert rows and all(int(r[dsp]) <= budget for r in rows)" %t/test_dse_space.csv
+
+// The applied design point is the first function pareto point, which is in the
+// budget as checked above.
+// RUN: %PYTHON -c "import re, sys; ls = open(sys.argv[1]).read().split(); ii = ls[1].split(',')[ls[0].split(',').index('b0ii')]; assert re.findall(r'pipeline = true, target_ii = (\d+)', open(sys.argv[2]).read()) == [ii]" %t/test_dse_space.csv %t/output.mlir
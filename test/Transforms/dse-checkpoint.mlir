@@ -0,0 +1,39 @@
+// RUN: rm -rf %t && mkdir -p %t/cold %t/resume
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/cold/ csv-path=%t/cold/ target-spec=%S/Inputs/dse-checkpoint.json" %S/Inputs/dse-gemm.mlir > %t/cold.mlir
+
+// A checkpoint with an incomplete last line is restored without the line.
+// RUN: cp %t/cold/dse_checkpoint.jsonl %t/resume/dse_checkpoint.jsonl
+// RUN: %PYTHON -c "import sys; p = sys.argv[1]; d = open(p).read(); open(p, 'w').write(d[:-5])" %t/resume/dse_checkpoint.jsonl
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/resume/ csv-path=%t/resume/ target-spec=%S/Inputs/dse-checkpoint.json resume=true" %S/Inputs/dse-gemm.mlir 2> %t/resume.err > %t/resume.mlir
+// RUN: FileCheck %s --check-prefix=TRUNCATED --allow-empty --input-file=%t/resume.err
+// RUN: diff %t/cold/test_dse_loop_0_space.csv %t/resume/test_dse_loop_0_space.csv
+// RUN: diff %t/cold.mlir %t/resume.mlir
+
+// A non-integer digit is rejected and the exploration starts from scratch.
+// RUN: %PYTHON -c "import json, sys; r = [json.loads(l) for l in open(sys.argv[1])]; r[1]['row'][0] = 'x'; open(sys.argv[2], 'w').write(''.join(json.dumps(x) + '\\n' for x in r))" %t/cold/dse_checkpoint.jsonl %t/resume/dse_checkpoint.jsonl
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/resume/ csv-path=%t/resume/ target-spec=%S/Inputs/dse-checkpoint.json resume=true" %S/Inputs/dse-gemm.mlir 2> %t/resume.err > %t/resume.mlir
+// RUN: FileCheck %s --check-prefix=NON-INTEGER --input-file=%t/resume.err
+// RUN: diff %t/cold.mlir %t/resume.mlir
+
+// A digit out of the range of tile config digits is rejected.
+// RUN: %PYTHON -c "import json, sys; r = [json.loads(l) for l in open(sys.argv[1])]; r[1]['row'][0] = 65534; open(sys.argv[2], 'w').write(''.join(json.dumps(x) + '\\n' for x in r))" %t/cold/dse_checkpoint.jsonl %t/resume/dse_checkpoint.jsonl
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/resume/ csv-path=%t/resume/ target-spec=%S/Inputs/dse-checkpoint.json resume=true" %S/Inputs/dse-gemm.mlir 2> %t/resume.err > %t/resume.mlir
+// RUN: FileCheck %s --check-prefix=OUT-OF-RANGE --input-file=%t/resume.err
+
+// Rows with inconsistent numbers of digits are rejected.
+// RUN: %PYTHON -c "import json, sys; r = [json.loads(l) for l in open(sys.argv[1])]; r[2]['row'].insert(0, 0); open(sys.argv[2], 'w').write(''.join(json.dumps(x) + '\\n' for x in r))" %t/cold/dse_checkpoint.jsonl %t/resume/dse_checkpoint.jsonl
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/resume/ csv-path=%t/resume/ target-spec=%S/Inputs/dse-checkpoint.json resume=true" %S/Inputs/dse-gemm.mlir 2> %t/resume.err > %t/resume.mlir
+// RUN: FileCheck %s --check-prefix=WRONG-LENGTH --input-file=%t/resume.err
+
+// Rows mismatching the depth of the loop band are dropped with a warning.
+// RUN: %PYTHON -c "import json, sys; r = [json.loads(l) for l in open(sys.argv[1])]; [x['row'].insert(0, 0) for x in r[1:]]; open(sys.argv[2], 'w').write(''.join(json.dumps(x) + '\\n' for x in r))" %t/cold/dse_checkpoint.jsonl %t/resume/dse_checkpoint.jsonl
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/resume/ csv-path=%t/resume/ target-spec=%S/Inputs/dse-checkpoint.json resume=true" %S/Inputs/dse-gemm.mlir 2> %t/resume.err > %t/resume.mlir
+// RUN: FileCheck %s --check-prefix=WRONG-DEPTH --input-file=%t/resume.err
+// RUN: diff %t/cold.mlir %t/resume.mlir
+
+// TRUNCATED-NOT: no valid checkpoint
+// NON-INTEGER: no valid checkpoint is found (line 2: expected integers in the row)
+// OUT-OF-RANGE: no valid checkpoint is found (line 2: digit 65534 is out of range)
+// WRONG-LENGTH: no valid checkpoint is found (line 3: expected 3 digits in the row of band "test_dse_loop_0")
+// WRONG-DEPTH-NOT: no valid checkpoint
+// WRONG-DEPTH: warning: checkpoint records of loop band 0 do not match the loop band and are dropped
@@ -0,0 +1,41 @@
+// RUN: rm -rf %t && mkdir -p %t/serial %t/parallel
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/serial/ csv-path=%t/serial/ target-spec=%S/Inputs/dse-emit-hlscpp-1.json" %s > /dev/null
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/parallel/ csv-path=%t/parallel/ target-spec=%S/Inputs/dse-emit-hlscpp-2.json" %s > /dev/null
+// RUN: FileCheck %s --input-file=%t/serial/test_dse_pareto_0.cpp
+// RUN: FileCheck %s --check-prefix=MLIR --input-file=%t/serial/test_dse_pareto_0.mlir
+
+// The pareto designs exported in parallel are identical to the serial ones.
+// RUN: diff %t/serial/test_dse_pareto_0.cpp %t/parallel/test_dse_pareto_0.cpp
+// RUN: diff %t/serial/test_dse_pareto_0.mlir %t/parallel/test_dse_pareto_0.mlir
+
+// Each pareto design is exported as the whole module, where the other functions
+// of the module are kept along with the optimized top function.
+// CHECK-DAG: void helper(
+// CHECK-DAG: void test_dse(
+// CHECK-DAG: #pragma HLS pipeline II=
+
+// MLIR-DAG: func.func @helper(
+// MLIR-DAG: func.func @test_dse(
+
+// The exploration fails if the pareto designs cannot be exported.
+// RUN: not scalehls-opt -scalehls-dse="output-path=%t/missing/ csv-path=%t/serial/ target-spec=%S/Inputs/dse-emit-hlscpp-1.json" %s 2>&1 | FileCheck %s --check-prefix=EXPORT
+// EXPORT: error: failed to export pareto designs to path "{{.*}}missing/"
+
+func.func @helper(%arg0: memref<16xf32>, %arg1: memref<16xf32>) {
+  affine.for %arg2 = 0 to 16 {
+    %0 = affine.load %arg0[%arg2] : memref<16xf32>
+    affine.store %0, %arg1[%arg2] : memref<16xf32>
+  }
+  return
+}
+
+func.func @test_dse(%arg0: memref<16x16xf32>, %arg1: memref<16x16xf32>) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 {
+    affine.for %arg3 = 0 to 16 {
+      %0 = affine.load %arg0[%arg2, %arg3] : memref<16x16xf32>
+      %1 = arith.mulf %0, %0 : f32
+      affine.store %1, %arg1[%arg2, %arg3] : memref<16x16xf32>
+    }
+  }
+  return
+}
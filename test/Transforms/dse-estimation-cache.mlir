@@ -0,0 +1,36 @@
+// The estimation cache is located with a path relative to the working
+// directory in the target spec.
+// RUN: rm -rf %t && mkdir -p %t/cold %t/truncated %t/warm
+// RUN: cd %t && scalehls-opt -scalehls-dse="output-path=%t/cold/ csv-path=%t/cold/ target-spec=%S/Inputs/dse-estimation-cache.json" %S/Inputs/dse-gemm.mlir > %t/cold.mlir
+// RUN: scalehls-dse-convert --estimation-cache %t/qor.cache -o %t/cold.csv
+// RUN: FileCheck %s --check-prefix=RECORDS --input-file=%t/cold.csv
+
+// Drop the last bytes of the cache file to emulate a killed exploration, which
+// leaves an incomplete record at the end of the file.
+// RUN: %PYTHON -c "import os; p = '%t/qor.cache'; os.truncate(p, os.path.getsize(p) - 5)"
+// RUN: not scalehls-dse-convert --estimation-cache %t/qor.cache 2>&1 | FileCheck %s --check-prefix=INCOMPLETE
+
+// The incomplete record is dropped on load, and the record re-estimated
+// afterwards must be appended at the record boundary.
+// RUN: cd %t && scalehls-opt -scalehls-dse="output-path=%t/truncated/ csv-path=%t/truncated/ target-spec=%S/Inputs/dse-estimation-cache.json" %S/Inputs/dse-gemm.mlir > %t/truncated.mlir
+// RUN: scalehls-dse-convert --estimation-cache %t/qor.cache -o %t/truncated.csv
+// RUN: diff %t/cold.csv %t/truncated.csv
+
+// A warm exploration hits all records and appends nothing.
+// RUN: cd %t && scalehls-opt -scalehls-dse="output-path=%t/warm/ csv-path=%t/warm/ target-spec=%S/Inputs/dse-estimation-cache.json" %S/Inputs/dse-gemm.mlir > %t/warm.mlir
+// RUN: scalehls-dse-convert --estimation-cache %t/qor.cache -o %t/warm.csv
+// RUN: diff %t/cold.csv %t/warm.csv
+
+// RUN: diff %t/cold/test_dse_loop_0_space.csv %t/truncated/test_dse_loop_0_space.csv
+// RUN: diff %t/cold/test_dse_loop_0_space.csv %t/warm/test_dse_loop_0_space.csv
+// RUN: diff %t/cold.mlir %t/truncated.mlir
+// RUN: diff %t/cold.mlir %t/warm.mlir
+// RUN: FileCheck %s --input-file=%t/warm/test_dse_loop_0_space.csv
+
+// RECORDS: key,latency,interval,dsp,bram,uram,lut
+// RECORDS-NEXT: {{^[0-9a-f]{32}(,-?[0-9]+){6}$}}
+
+// INCOMPLETE: failed to read estimation records from "{{.*}}qor.cache"
+
+// CHECK: l0,l1,l2,ii,cycle,dsp,bram,uram,lut,type
+// CHECK: ,pareto
@@ -0,0 +1,13 @@
+// RUN: rm -rf %t && mkdir -p %t/full %t/incremental
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/full/ csv-path=%t/full/ target-spec=%S/Inputs/dse.json" %S/Inputs/dse-two-bands.mlir > %t/full.mlir
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/incremental/ csv-path=%t/incremental/ target-spec=%S/Inputs/dse-incremental.json" %S/Inputs/dse-two-bands.mlir > %t/incremental.mlir
+
+// The function design points are estimated incrementally when the loop design
+// spaces are combined, which must result in the same timing and resource as
+// the full estimation of each function design point.
+// RUN: diff %t/full/test_dse_space.csv %t/incremental/test_dse_space.csv
+// RUN: diff %t/full.mlir %t/incremental.mlir
+// RUN: FileCheck %s --input-file=%t/incremental/test_dse_space.csv
+
+// CHECK: b0l0,b0l1,b0l2,b0ii,b1l0,b1l1,b1ii,cycle,dsp,bram,uram,lut,type
+// CHECK: ,pareto
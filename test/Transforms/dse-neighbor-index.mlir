@@ -0,0 +1,46 @@
+// RUN: rm -rf %t && mkdir -p %t/d0.5 %t/d1.5 %t/d2
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/d0.5/ csv-path=%t/d0.5/ target-spec=%S/Inputs/dse-distance-0.5.json" %s > /dev/null
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/d1.5/ csv-path=%t/d1.5/ target-spec=%S/Inputs/dse-distance-1.5.json" %s > /dev/null
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/d2/ csv-path=%t/d2/ target-spec=%S/Inputs/dse-distance-2.json" %s > /dev/null
+
+// Only the tile config without any unrolling is evaluated in the
+// initialization, and the neighbor search evaluates one closest neighbor of a
+// pareto point in each iteration. The tile configs are printed in an ascending
+// order.
+// RUN: %PYTHON -c "import sys; ls = open(sys.argv[1]).read().split(); n = ls[0].split(',').index('ii'); print(sorted({tuple(map(int, l.split(',')[:n])) for l in ls[1:]}))" %t/d0.5/test_neighbor_1d_loop_0_space.csv | FileCheck %s --check-prefix=D05-1D
+// RUN: %PYTHON -c "import sys; ls = open(sys.argv[1]).read().split(); n = ls[0].split(',').index('ii'); print(sorted({tuple(map(int, l.split(',')[:n])) for l in ls[1:]}))" %t/d0.5/test_neighbor_2d_loop_0_space.csv | FileCheck %s --check-prefix=D05-2D
+// RUN: %PYTHON -c "import sys; ls = open(sys.argv[1]).read().split(); n = ls[0].split(',').index('ii'); print(sorted({tuple(map(int, l.split(',')[:n])) for l in ls[1:]}))" %t/d1.5/test_neighbor_2d_loop_0_space.csv | FileCheck %s --check-prefix=D15-2D
+// RUN: %PYTHON -c "import sys; ls = open(sys.argv[1]).read().split(); n = ls[0].split(',').index('ii'); print(sorted({tuple(map(int, l.split(',')[:n])) for l in ls[1:]}))" %t/d2/test_neighbor_1d_loop_0_space.csv | FileCheck %s --check-prefix=D20-1D
+
+// No neighbor exists within a distance of 0.5.
+// D05-1D: {{^}}[(1,)]{{$}}
+// D05-2D: {{^}}[(1, 1)]{{$}}
+
+// The neighbors at a distance of 1 are preferred over the diagonal neighbor
+// at a distance of 1.414.
+// D15-2D: {{^}}[(1, 1), ({{(1, 2)|(2, 1)}})]{{$}}
+
+// The neighbor at a distance of 1 is preferred over the one at a distance of
+// 2. In the second iteration, tile size 4 is the only closest neighbor of both
+// estimated tile configs.
+// D20-1D: {{^}}[(1,), (2,), (4,)]{{$}}
+
+func.func @test_neighbor_1d(%arg0: memref<16xf32>, %arg1: memref<16xf32>) attributes {top_func} {
+  affine.for %arg2 = 0 to 16 {
+    %0 = affine.load %arg0[%arg2] : memref<16xf32>
+    %1 = arith.mulf %0, %0 : f32
+    affine.store %1, %arg1[%arg2] : memref<16xf32>
+  }
+  return
+}
+
+func.func @test_neighbor_2d(%arg0: memref<4x4xf32>, %arg1: memref<4x4xf32>) attributes {top_func} {
+  affine.for %arg2 = 0 to 4 {
+    affine.for %arg3 = 0 to 4 {
+      %0 = affine.load %arg0[%arg2, %arg3] : memref<4x4xf32>
+      %1 = arith.mulf %0, %0 : f32
+      affine.store %1, %arg1[%arg2, %arg3] : memref<4x4xf32>
+    }
+  }
+  return
+}
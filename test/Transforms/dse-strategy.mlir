@@ -0,0 +1,25 @@
+// RUN: rm -rf %t && mkdir -p %t/neighbor-0 %t/neighbor-1 %t/annealing-0 %t/annealing-1 %t/annealing-seed-2 %t/nsga2-0 %t/nsga2-1
+
+// Each search strategy explores the same design points given the same seed.
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/neighbor-0/ csv-path=%t/neighbor-0/ target-spec=%S/Inputs/dse-neighbor.json" %S/Inputs/dse-gemm.mlir > %t/neighbor-0.mlir
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/neighbor-1/ csv-path=%t/neighbor-1/ target-spec=%S/Inputs/dse-neighbor.json" %S/Inputs/dse-gemm.mlir > %t/neighbor-1.mlir
+// RUN: diff %t/neighbor-0/test_dse_loop_0_space.csv %t/neighbor-1/test_dse_loop_0_space.csv
+// RUN: diff %t/neighbor-0.mlir %t/neighbor-1.mlir
+
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/annealing-0/ csv-path=%t/annealing-0/ target-spec=%S/Inputs/dse-annealing.json" %S/Inputs/dse-gemm.mlir > %t/annealing-0.mlir
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/annealing-1/ csv-path=%t/annealing-1/ target-spec=%S/Inputs/dse-annealing.json" %S/Inputs/dse-gemm.mlir > %t/annealing-1.mlir
+// RUN: diff %t/annealing-0/test_dse_loop_0_space.csv %t/annealing-1/test_dse_loop_0_space.csv
+// RUN: diff %t/annealing-0.mlir %t/annealing-1.mlir
+
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/nsga2-0/ csv-path=%t/nsga2-0/ target-spec=%S/Inputs/dse-nsga2.json" %S/Inputs/dse-gemm.mlir > %t/nsga2-0.mlir
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/nsga2-1/ csv-path=%t/nsga2-1/ target-spec=%S/Inputs/dse-nsga2.json" %S/Inputs/dse-gemm.mlir > %t/nsga2-1.mlir
+// RUN: diff %t/nsga2-0/test_dse_loop_0_space.csv %t/nsga2-1/test_dse_loop_0_space.csv
+// RUN: diff %t/nsga2-0.mlir %t/nsga2-1.mlir
+
+// A different seed leads to a different walk through the design space.
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/annealing-seed-2/ csv-path=%t/annealing-seed-2/ target-spec=%S/Inputs/dse-annealing-seed-2.json" %S/Inputs/dse-gemm.mlir > /dev/null
+// RUN: not diff %t/annealing-0/test_dse_loop_0_space.csv %t/annealing-seed-2/test_dse_loop_0_space.csv > /dev/null
+
+// RUN: FileCheck %s --input-file=%t/nsga2-0/test_dse_loop_0_space.csv
+// CHECK: l0,l1,l2,ii,cycle,dsp,bram,uram,lut,type
+// CHECK: ,pareto
@@ -0,0 +1,19 @@
+// RUN: rm -rf %t && mkdir -p %t/serial %t/parallel
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/serial/ csv-path=%t/serial/ target-spec=%S/Inputs/dse-threads-1.json" %S/Inputs/dse-gemm.mlir > %t/serial.mlir
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/parallel/ csv-path=%t/parallel/ target-spec=%S/Inputs/dse-threads-4.json" %S/Inputs/dse-gemm.mlir > %t/parallel.mlir
+// RUN: diff %t/serial/test_dse_loop_0_space.csv %t/parallel/test_dse_loop_0_space.csv
+// RUN: diff %t/serial/test_dse_space.csv %t/parallel/test_dse_space.csv
+// RUN: diff %t/serial.mlir %t/parallel.mlir
+// RUN: FileCheck %s --input-file=%t/serial/test_dse_loop_0_space.csv
+
+// The serial and parallel evaluation of tile configs must explore the same
+// design points and converge to the same pareto frontiers, as the number of
+// tile configs evaluated in each iteration is given by "batch_size" rather than
+// the number of threads. The 56 tile configs whose parallelism is not larger
+// than 32 are evaluated in the initialization, and the exploration must stop
+// before the design space is exhausted, such that the explored tile configs
+// depend on the batches.
+// RUN: %PYTHON -c "import sys; rows = [l.split(',') for l in open(sys.argv[1]).read().split()[1:]]; n = len({tuple(r[:3]) for r in rows}); total = sum(1 for a in range(6) for b in range(6) for c in range(6) if a + b + c <= 10); assert 56 + 8 < n < total, n" %t/serial/test_dse_loop_0_space.csv
+
+// CHECK: l0,l1,l2,ii,cycle,dsp,bram,uram,lut,type
+// CHECK: ,pareto
@@ -0,0 +1,50 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/ csv-path=%t/ target-spec=%S/Inputs/dse-init-only.json" %s > /dev/null
+
+// Tile configs are decoded from the digits of the valid tile sizes of each
+// loop, and only the tile configs whose parallelism is not larger than 4 are
+// enumerated in an ascending order, where the first loop is the least
+// significant digit.
+// RUN: %PYTHON -c "import sys; seen = []; [seen.append(r[:2]) for r in (l.split(',') for l in open(sys.argv[1]).read().split()) if r[-1] == 'non-pareto' and r[:2] not in seen]; print('\n'.join(','.join(c) for c in seen))" %t/test_tile_config_2d_loop_0_space.csv | FileCheck %s --check-prefix=ENUM-2D
+
+// ENUM-2D:      1,1
+// ENUM-2D-NEXT: 2,1
+// ENUM-2D-NEXT: 3,1
+// ENUM-2D-NEXT: 1,2
+// ENUM-2D-NEXT: 2,2
+// ENUM-2D-NEXT: 1,4
+// ENUM-2D-NOT:  {{.}}
+
+func.func @test_tile_config_2d(%arg0: memref<6x4xf32>, %arg1: memref<6x4xf32>) attributes {top_func} {
+  affine.for %arg2 = 0 to 6 {
+    affine.for %arg3 = 0 to 4 {
+      %0 = affine.load %arg0[%arg2, %arg3] : memref<6x4xf32>
+      %1 = arith.mulf %0, %0 : f32
+      affine.store %1, %arg1[%arg2, %arg3] : memref<6x4xf32>
+    }
+  }
+  return
+}
+
+// The enumeration is pruned with the parallelism, thus a deep loop band only
+// visits the 28 tile configs in bound rather than the whole design space.
+// RUN: %PYTHON -c "import sys, math; c = {tuple(map(int, r[:6])) for r in (l.split(',') for l in open(sys.argv[1]).read().split()[1:])}; assert len(c) == 28 and all(math.prod(x) <= 4 for x in c), c" %t/test_tile_config_6d_loop_0_space.csv
+
+func.func @test_tile_config_6d(%arg0: memref<4x4x4x4x4x4xf32>, %arg1: memref<4x4x4x4x4x4xf32>) attributes {top_func} {
+  affine.for %arg2 = 0 to 4 {
+    affine.for %arg3 = 0 to 4 {
+      affine.for %arg4 = 0 to 4 {
+        affine.for %arg5 = 0 to 4 {
+          affine.for %arg6 = 0 to 4 {
+            affine.for %arg7 = 0 to 4 {
+              %0 = affine.load %arg0[%arg2, %arg3, %arg4, %arg5, %arg6, %arg7] : memref<4x4x4x4x4x4xf32>
+              %1 = arith.mulf %0, %0 : f32
+              affine.store %1, %arg1[%arg2, %arg3, %arg4, %arg5, %arg6, %arg7] : memref<4x4x4x4x4x4xf32>
+            }
+          }
+        }
+      }
+    }
+  }
+  return
+}
@@ -41,6 +41,7 @@ llvm_config.use_default_substitutions()
 # subdirectories contain auxiliary inputs for various tests in their parent
 # directories.
 config.excludes = [
+    'Inputs',
     'CMakeLists.txt',
     'README.txt',
     'lit.cfg.py'
@@ -67,7 +68,10 @@ tool_dirs = [config.scalehls_tools_dir, config.polygeist_tools_dir,
              config.mlir_tools_dir, config.llvm_tools_dir]
 tools = [
     'pyscalehls.py',
+    'scalehls-dse-convert',
     'scalehls-opt',
+    'scalehls-run',
+    'scalehls-sim',
     'scalehls-translate',
     'cgeist'
 ]
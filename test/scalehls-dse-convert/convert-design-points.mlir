@@ -0,0 +1,20 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: scalehls-opt -scalehls-dse="output-path=%t/ csv-path=%t/ target-spec=%S/../Transforms/Inputs/dse.json" %S/../Transforms/Inputs/dse-gemm.mlir > /dev/null
+// RUN: scalehls-dse-convert %t/test_dse_loop_0_points.bin -o %t/points.csv
+// RUN: FileCheck %s --input-file=%t/points.csv
+
+// CHECK: l0,l1,l2,ii,cycle,dsp,bram,uram,lut
+// CHECK-NEXT: {{^[0-9]+(,[0-9]+){8}$}}
+
+// An incomplete chunk at the end of the file, e.g., left by a killed
+// exploration, is ignored.
+// RUN: %PYTHON -c "import os; p = '%t/test_dse_loop_0_points.bin'; os.truncate(p, os.path.getsize(p) - 3)"
+// RUN: scalehls-dse-convert %t/test_dse_loop_0_points.bin | FileCheck %s --check-prefix=TRUNCATED
+// TRUNCATED: l0,l1,l2,ii,cycle,dsp,bram,uram,lut
+
+// RUN: not scalehls-dse-convert %t/missing.bin 2>&1 | FileCheck %s --check-prefix=MISSING
+// MISSING: failed to read design points from "{{.*}}missing.bin"
+
+// The exploration fails if the design points cannot be streamed to disk.
+// RUN: not scalehls-opt -scalehls-dse="output-path=%t/ csv-path=%t/missing/ target-spec=%S/../Transforms/Inputs/dse.json" %S/../Transforms/Inputs/dse-gemm.mlir 2>&1 | FileCheck %s --check-prefix=WRITER
+// WRITER: error: failed to open file "{{.*}}missing/test_dse_loop_0_points.bin" for streaming design points
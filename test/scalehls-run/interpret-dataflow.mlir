@@ -0,0 +1,67 @@
+// RUN: scalehls-run %s -reference=%s -reference-top-func=golden -profile | FileCheck %s
+// RUN: not scalehls-run %s -reference=%s -reference-top-func=mismatch | FileCheck %s --check-prefix=FAIL
+
+// CHECK:      Memory profiles:
+// CHECK-NEXT:   argument #0: 16 loads, 0 stores
+// CHECK-NEXT:   argument #1: 0 loads, 8 stores
+// CHECK-NEXT:   hls.dataflow.stream at line {{[0-9]+}}: 16 loads, 16 stores, peak occupancy 16
+// CHECK-NEXT:   hls.dataflow.buffer at line {{[0-9]+}}: 8 loads, 8 stores
+// CHECK:      PASS: outputs match the reference
+
+// FAIL: argument #1 lane {{[0-9]+}}: got {{-?[0-9]+}}, expected {{-?[0-9]+}}
+// FAIL: FAIL: {{[0-9]+}} mismatched lanes
+func.func @forward(%arg0: memref<16xi8>, %arg1: memref<8xi16>) attributes {top_func} {
+  hls.dataflow.schedule(%arg0, %arg1) : memref<16xi8>, memref<8xi16> {
+  ^bb0(%arg2: memref<16xi8>, %arg3: memref<8xi16>):
+    %0 = hls.dataflow.stream {depth = 16 : i32} : <i8, 16>
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32]} : (memref<16xi8>) -> !hls.stream<i8, 16> {
+    ^bb0(%arg4: memref<16xi8>, %arg5: !hls.stream<i8, 16>):
+      affine.for %arg6 = 0 to 16 {
+        %2 = affine.load %arg4[%arg6] : memref<16xi8>
+        hls.dataflow.stream_write %arg5, %2 : <i8, 16>, i8
+      }
+    }
+    %1 = hls.dataflow.buffer {depth = 1 : i32} : memref<8xi16>
+    hls.dataflow.node(%0) -> (%1) {inputTaps = [0 : i32]} : (!hls.stream<i8, 16>) -> memref<8xi16> {
+    ^bb0(%arg4: !hls.stream<i8, 16>, %arg5: memref<8xi16>):
+      affine.for %arg6 = 0 to 8 {
+        %2 = hls.dataflow.stream_read %arg4 : (!hls.stream<i8, 16>) -> i8
+        %3 = hls.dataflow.stream_read %arg4 : (!hls.stream<i8, 16>) -> i8
+        %4 = "hls.prim.mul"(%2, %3) : (i8, i8) -> i16
+        affine.store %4, %arg5[%arg6] : memref<8xi16>
+      }
+    }
+    hls.dataflow.node(%1) -> (%arg3) {inputTaps = [0 : i32]} : (memref<8xi16>) -> memref<8xi16> {
+    ^bb0(%arg4: memref<8xi16>, %arg5: memref<8xi16>):
+      affine.for %arg6 = 0 to 8 {
+        %2 = affine.load %arg4[%arg6] : memref<8xi16>
+        affine.store %2, %arg5[%arg6] : memref<8xi16>
+      }
+    }
+  }
+  return
+}
+
+func.func @golden(%arg0: memref<16xi8>, %arg1: memref<8xi16>) {
+  affine.for %arg2 = 0 to 8 {
+    %0 = affine.load %arg0[%arg2 * 2] : memref<16xi8>
+    %1 = affine.load %arg0[%arg2 * 2 + 1] : memref<16xi8>
+    %2 = arith.extsi %0 : i8 to i16
+    %3 = arith.extsi %1 : i8 to i16
+    %4 = arith.muli %2, %3 : i16
+    affine.store %4, %arg1[%arg2] : memref<8xi16>
+  }
+  return
+}
+
+func.func @mismatch(%arg0: memref<16xi8>, %arg1: memref<8xi16>) {
+  affine.for %arg2 = 0 to 8 {
+    %0 = affine.load %arg0[%arg2 * 2] : memref<16xi8>
+    %1 = affine.load %arg0[%arg2 * 2 + 1] : memref<16xi8>
+    %2 = arith.extsi %0 : i8 to i16
+    %3 = arith.extsi %1 : i8 to i16
+    %4 = arith.addi %2, %3 : i16
+    affine.store %4, %arg1[%arg2] : memref<8xi16>
+  }
+  return
+}
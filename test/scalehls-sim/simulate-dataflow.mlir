@@ -0,0 +1,28 @@
+// RUN: scalehls-sim -target-spec=%S/../Transforms/Directive/config.json -frames=4 %s | FileCheck %s
+
+// CHECK: Frames: 4, latency: {{[0-9]+}} cycles, interval: {{[0-9]+}} cycles
+// CHECK-NOT: Deadlock
+// CHECK: #0{{ +}}2{{ +}}
+// CHECK: #1{{ +}}0{{ +}}
+// CHECK: Bottleneck: node #1
+func.func @forward(%arg0: memref<1024xi32>) attributes {top_func} {
+  hls.dataflow.schedule(%arg0) : memref<1024xi32> {
+  ^bb0(%arg1: memref<1024xi32>):
+    %0 = hls.dataflow.buffer {depth = 2 : i32} : memref<1024xi32>
+    hls.dataflow.node() -> (%0) {inputTaps = [], level = 2 : i32} : () -> memref<1024xi32> {
+    ^bb0(%arg2: memref<1024xi32>):
+      %c0_i32 = arith.constant 0 : i32
+      affine.for %arg3 = 0 to 256 {
+        affine.store %c0_i32, %arg2[%arg3] : memref<1024xi32>
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg1) {inputTaps = [0 : i32], level = 0 : i32} : (memref<1024xi32>) -> memref<1024xi32> {
+    ^bb0(%arg2: memref<1024xi32>, %arg3: memref<1024xi32>):
+      affine.for %arg4 = 0 to 1024 {
+        %1 = affine.load %arg2[%arg4] : memref<1024xi32>
+        affine.store %1, %arg3[%arg4] : memref<1024xi32>
+      }
+    }
+  }
+  return
+}
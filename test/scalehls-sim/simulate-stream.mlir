@@ -0,0 +1,39 @@
+// RUN: scalehls-sim -target-spec=%S/../Transforms/Directive/config.json -frames=4 %s | FileCheck %s
+
+// The producer pushes 16 tokens into a stream of depth 2, while the consumer
+// pops the tokens much slower due to the chained divisions. The producer is
+// blocked in the middle of its frames, which are stretched to the pace of the
+// consumer. The consumer is still occupied for the most cycles and reported as
+// the bottleneck.
+
+// CHECK: Frames: 4, latency: {{[0-9]+}} cycles, interval: {{[0-9]+}} cycles
+// CHECK-NOT: Deadlock
+// CHECK: Node{{ +}}Level{{ +}}Latency{{ +}}Interval{{ +}}Busy{{ +}}Stalled{{ +}}Starved{{ +}}Blocked{{ +}}Util
+// CHECK: #0{{ +}}1{{ +}}{{[0-9]+ +[0-9]+ +[0-9]+ +[1-9][0-9]* +[0-9]+ +[1-9][0-9]*}}
+// CHECK: #1{{ +}}0{{ +}}
+// CHECK: Bottleneck: node #1
+func.func @forward(%arg0: memref<16xf32>, %arg1: memref<16xf32>) attributes {top_func} {
+  hls.dataflow.schedule(%arg0, %arg1) : memref<16xf32>, memref<16xf32> {
+  ^bb0(%arg2: memref<16xf32>, %arg3: memref<16xf32>):
+    %0 = hls.dataflow.stream {depth = 2 : i32} : <f32, 2>
+    hls.dataflow.node(%arg2) -> (%0) {inputTaps = [0 : i32], level = 1 : i32} : (memref<16xf32>) -> !hls.stream<f32, 2> {
+    ^bb0(%arg4: memref<16xf32>, %arg5: !hls.stream<f32, 2>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = affine.load %arg4[%arg6] : memref<16xf32>
+        hls.dataflow.stream_write %arg5, %1 : <f32, 2>, f32
+      }
+    }
+    hls.dataflow.node(%0) -> (%arg3) {inputTaps = [0 : i32], level = 0 : i32} : (!hls.stream<f32, 2>) -> memref<16xf32> {
+    ^bb0(%arg4: !hls.stream<f32, 2>, %arg5: memref<16xf32>):
+      affine.for %arg6 = 0 to 16 {
+        %1 = hls.dataflow.stream_read %arg4 : (!hls.stream<f32, 2>) -> f32
+        %2 = arith.divf %1, %1 : f32
+        %3 = arith.divf %2, %1 : f32
+        %4 = arith.divf %3, %1 : f32
+        %5 = arith.divf %4, %1 : f32
+        affine.store %5, %arg5[%arg6] : memref<16xf32>
+      }
+    }
+  }
+  return
+}
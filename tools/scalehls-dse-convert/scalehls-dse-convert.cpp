@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Support/FileUtilities.h"
+#include "scalehls/Transforms/Explorer.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    inputFilename(cl::Positional,
+                  cl::desc("<design point file or estimation cache file>"),
+                  cl::Required);
+
+static cl::opt<std::string> outputFilename("o", cl::desc("Output CSV file"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static cl::opt<bool>
+    estimationCache("estimation-cache",
+                    cl::desc("Convert an estimation cache file written by the "
+                             "DSE rather than a design point file"),
+                    cl::init(false));
+
+/// Convert the estimation cache file to a CSV file with a header row, where
+/// each row is the key and the estimated QoR of a record.
+static mlir::LogicalResult convertEstimationCacheToCsv(StringRef filePath,
+                                                       raw_ostream &os) {
+  std::string csv = "key,latency,interval,dsp,bram,uram,lut\n";
+  auto result = mlir::scalehls::readEstimationCache(
+      filePath, [&](StringRef key, mlir::scalehls::EstimationRecord record) {
+        raw_string_ostream(csv)
+            << key << "," << record.latency << "," << record.interval << ","
+            << record.dsp << "," << record.bram << "," << record.uram << ","
+            << record.lut << "\n";
+      });
+  if (mlir::succeeded(result))
+    os << csv;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "ScaleHLS DSE Design Point Conversion Tool\n");
+
+  std::string errorMessage;
+  auto output = mlir::openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  if (estimationCache) {
+    if (mlir::failed(
+            convertEstimationCacheToCsv(inputFilename, output->os()))) {
+      errs() << "failed to read estimation records from \"" << inputFilename
+             << "\"\n";
+      return 1;
+    }
+  } else if (mlir::failed(mlir::scalehls::convertDesignPointsToCsv(
+                 inputFilename, output->os()))) {
+    errs() << "failed to read design points from \"" << inputFilename
+           << "\"\n";
+    return 1;
+  }
+
+  output->keep();
+  return 0;
+}
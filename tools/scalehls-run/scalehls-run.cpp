@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/AsmState.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+#include "scalehls/InitAllDialects.h"
+#include "scalehls/Transforms/Interpreter.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+using namespace mlir;
+using namespace scalehls;
+
+static cl::opt<std::string> inputFilename(cl::Positional,
+                                          cl::desc("<input file>"),
+                                          cl::init("-"));
+
+static cl::opt<std::string> outputFilename("o", cl::desc("Output report file"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static cl::opt<std::string> referenceFilename(
+    "reference", cl::desc("Reference module producing the golden outputs"),
+    cl::value_desc("filename"), cl::init(""));
+
+static cl::opt<std::string>
+    topFunc("top-func",
+            cl::desc("The top function if no function is marked as top"),
+            cl::init("forward"));
+
+static cl::opt<std::string> referenceTopFunc(
+    "reference-top-func",
+    cl::desc("The top function of the reference if different from the input"),
+    cl::init(""));
+
+static cl::opt<unsigned>
+    seed("seed", cl::desc("Seed of the random function arguments"),
+         cl::init(0));
+
+static cl::opt<double>
+    tolerance("tolerance",
+              cl::desc("Relative tolerance of float comparisons"),
+              cl::init(1e-4));
+
+static cl::opt<bool>
+    printProfile("profile",
+                 cl::desc("Print the access profile of each memory object"),
+                 cl::init(false));
+
+/// Parse the module from the file, which is owned by the source manager.
+static OwningOpRef<ModuleOp> parseModule(StringRef filename,
+                                         SourceMgr &sourceMgr,
+                                         MLIRContext &context) {
+  std::string errorMessage;
+  auto input = openInputFile(filename, &errorMessage);
+  if (!input) {
+    errs() << errorMessage << "\n";
+    return nullptr;
+  }
+  sourceMgr.AddNewSourceBuffer(std::move(input), SMLoc());
+  return parseSourceFile<ModuleOp>(sourceMgr, ParserConfig(&context));
+}
+
+/// Return the function marked as top, or the function with the top function
+/// name if no function is marked.
+static func::FuncOp getTopFunc(ModuleOp module) {
+  for (auto func : module.getOps<func::FuncOp>())
+    if (hasTopFuncAttr(func))
+      return func;
+  return module.lookupSymbol<func::FuncOp>(topFunc);
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "ScaleHLS IR Interpreter\n");
+
+  std::string errorMessage;
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  DialectRegistry registry;
+  registerAllDialects(registry);
+  MLIRContext context(registry);
+
+  SourceMgr sourceMgr;
+  SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context);
+  auto module = parseModule(inputFilename, sourceMgr, context);
+  if (!module)
+    return 1;
+  auto func = getTopFunc(*module);
+  if (!func) {
+    errs() << "top function is not found\n";
+    return 1;
+  }
+
+  auto result = interpretFunc(func, seed);
+  if (failed(result))
+    return 1;
+  if (printProfile)
+    printMemoryProfiles(result.value(), output->os());
+
+  // Interpret the reference module with the same random arguments, and check
+  // the arguments and results of the input module against it.
+  if (!referenceFilename.empty()) {
+    auto reference = parseModule(referenceFilename, sourceMgr, context);
+    if (!reference)
+      return 1;
+    auto referenceFunc =
+        referenceTopFunc.empty()
+            ? getTopFunc(*reference)
+            : reference->lookupSymbol<func::FuncOp>(referenceTopFunc);
+    if (!referenceFunc) {
+      errs() << "top function of the reference is not found\n";
+      return 1;
+    }
+
+    auto golden = interpretFunc(referenceFunc, seed);
+    if (failed(golden))
+      return 1;
+    auto mismatchNum = compareInterpretResults(result.value(), golden.value(),
+                                               tolerance, output->os());
+    if (mismatchNum) {
+      output->os() << "FAIL: " << mismatchNum << " mismatched lanes\n";
+      output->keep();
+      return 1;
+    }
+    output->os() << "PASS: outputs match the reference\n";
+  }
+
+  output->keep();
+  return 0;
+}
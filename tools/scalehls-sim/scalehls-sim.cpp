@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2020-2021 The ScaleHLS Authors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/AsmState.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+#include "scalehls/InitAllDialects.h"
+#include "scalehls/Transforms/Simulator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+using namespace mlir;
+using namespace scalehls;
+
+static cl::opt<std::string> inputFilename(cl::Positional,
+                                          cl::desc("<input file>"),
+                                          cl::init("-"));
+
+static cl::opt<std::string> outputFilename("o", cl::desc("Output report file"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static cl::opt<std::string>
+    targetSpec("target-spec",
+               cl::desc("Target backend specifications and configurations"),
+               cl::value_desc("filename"), cl::init("./config.json"));
+
+static cl::opt<unsigned>
+    frameNum("frames", cl::desc("Number of frames fed to each schedule"),
+             cl::init(2));
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "ScaleHLS Dataflow Simulator\n");
+
+  std::string errorMessage;
+  auto input = openInputFile(inputFilename, &errorMessage);
+  if (!input) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  DialectRegistry registry;
+  registerAllDialects(registry);
+  MLIRContext context(registry);
+
+  SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(std::move(input), SMLoc());
+  SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context);
+  auto module = parseSourceFile<ModuleOp>(sourceMgr, ParserConfig(&context));
+  if (!module)
+    return 1;
+
+  TargetSpec spec;
+  if (!spec.load(targetSpec))
+    return 1;
+
+  // Simulate the outermost dataflow schedules of the top function. Schedules
+  // nested in dataflow nodes are covered by the estimated node timing.
+  auto estimator = spec.createEstimator();
+  for (auto func : module->getOps<func::FuncOp>()) {
+    if (!hasTopFuncAttr(func))
+      continue;
+
+    auto result = func.walk<WalkOrder::PreOrder>([&](ScheduleOp schedule) {
+      auto simResult = simulateSchedule(schedule, *estimator, frameNum);
+      if (failed(simResult))
+        return WalkResult::interrupt();
+      printSimulationReport(simResult.value(), output->os());
+      return WalkResult::skip();
+    });
+    if (result.wasInterrupted())
+      return 1;
+  }
+
+  output->keep();
+  return 0;
+}